@@ -0,0 +1,739 @@
+/*
+ * Curve Optimizer auto-tuner (see co_tune.h).
+ *
+ * One lane thread per CCD walks its cores: a baseline step at the original
+ * margin, a binary search between the original and margin_min, then a
+ * longer confirmation at the most negative pass plus backoff (moving up a
+ * step at a time if that fails). The calling thread samples the PM table
+ * and the kernel's machine-check reports for all lanes.
+ *
+ * The workload runs in a forked child so an unstable core that faults or
+ * corrupts the child's state costs a step, not the tuner.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "co_tune.h"
+#include "pm_checkpoint.h"
+#include "pm_limiter.h"
+
+#define MAX_CPUS            1024
+#define STATE_HEADER        "# smu_debug_tool co-tune checkpoint v1"
+#define MONITOR_MS          100
+#define HANG_GRACE_MS       3000    /* child past its deadline by this much: hung */
+#define STRETCH_MIN_SAMPLES 20
+#define WORK_N              512     /* doubles: stays in L1 */
+#define WORK_REPS           4000
+
+#define EXIT_MISMATCH       3
+#define EXIT_AFFINITY       4
+
+/* ─── Validation workload ─── */
+
+/*
+ * Dependent FP multiply-add and divide chains mixed into an integer hash.
+ * Deterministic: the same build gives the same result on every core, so
+ * one reference computed before tuning checks every chunk.
+ */
+static uint64_t work_chunk(void)
+{
+    double a[WORK_N];
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < WORK_N; i++)
+        a[i] = 1.0 + i * 1e-3;
+    for (int rep = 0; rep < WORK_REPS; rep++) {
+        for (int i = 0; i < WORK_N; i++) {
+            double x = a[i] * 1.0000001 + a[(i + 7) & (WORK_N - 1)] * 1e-7;
+            uint64_t bits;
+
+            if ((i & 63) == 0)
+                x = x / (1.0 + a[(i + 31) & (WORK_N - 1)] * 1e-9);
+            a[i] = x;
+            memcpy(&bits, &x, sizeof(bits));
+            h = (h ^ bits) * 0x100000001b3ULL;
+            h = (h << 13) | (h >> 51);
+        }
+    }
+    return h;
+}
+
+/* Child: pinned to cpu, run chunks until ms have passed. */
+static void __attribute__((noreturn)) work_child(int cpu, unsigned int ms, uint64_t ref)
+{
+    cpu_set_t set;
+    double end;
+
+    signal(SIGINT, SIG_IGN);            /* Ctrl-C is the tuner's to handle */
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        _exit(EXIT_AFFINITY);
+    end = pm_now_sec() + ms / 1000.0;
+    do {
+        if (work_chunk() != ref)
+            _exit(EXIT_MISMATCH);
+    } while (pm_now_sec() < end);
+    _exit(0);
+}
+
+/* ─── Machine-check sources ─── */
+
+typedef struct {
+    int            kmsg;            /* /dev/kmsg, -1 if unavailable */
+    int            col_cpu[MAX_CPUS];
+    unsigned int   ncols;
+    unsigned long  irq[MAX_CPUS];   /* /proc/interrupts MCE row */
+    unsigned long  hw[MAX_CPUS];    /* kernel "Hardware Error" lines naming the CPU */
+    unsigned long  hw_any;          /* ... naming no CPU */
+} mce_t;
+
+static void mce_poll_irq(mce_t *m)
+{
+    char line[8192];
+    FILE *fp = fopen("/proc/interrupts", "r");
+
+    if (!fp)
+        return;
+    if (fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        int cpu, n;
+
+        m->ncols = 0;
+        while (m->ncols < MAX_CPUS && sscanf(p, " CPU%d%n", &cpu, &n) == 1) {
+            m->col_cpu[m->ncols++] = cpu;
+            p += n;
+        }
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        unsigned long v;
+        int n;
+
+        while (*p == ' ')
+            p++;
+        if (strncmp(p, "MCE:", 4) != 0)
+            continue;
+        p += 4;
+        for (unsigned int i = 0; i < m->ncols && sscanf(p, " %lu%n", &v, &n) == 1; i++) {
+            if (m->col_cpu[i] >= 0 && m->col_cpu[i] < MAX_CPUS)
+                m->irq[m->col_cpu[i]] = v;
+            p += n;
+        }
+        break;
+    }
+    fclose(fp);
+}
+
+static void mce_poll_kmsg(mce_t *m)
+{
+    char rec[2048];
+    ssize_t n;
+
+    if (m->kmsg < 0)
+        return;
+    while ((n = read(m->kmsg, rec, sizeof(rec) - 1)) != 0) {
+        const char *msg, *p;
+        int cpu;
+
+        if (n < 0) {
+            if (errno == EPIPE)         /* overwritten records; keep reading */
+                continue;
+            break;                      /* EAGAIN: caught up */
+        }
+        rec[n] = '\0';
+        msg = strchr(rec, ';');
+        msg = msg ? msg + 1 : rec;
+        if (!strstr(msg, "Hardware Error") && !strstr(msg, "Machine check") &&
+            !strstr(msg, "machine check"))
+            continue;
+        p = strstr(msg, "CPU ");
+        if (p && sscanf(p, "CPU %d", &cpu) == 1 && cpu >= 0 && cpu < MAX_CPUS)
+            m->hw[cpu]++;
+        else
+            m->hw_any++;
+    }
+}
+
+static void mce_open(mce_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->kmsg = open("/dev/kmsg", O_RDONLY | O_NONBLOCK);
+    if (m->kmsg >= 0)
+        lseek(m->kmsg, 0, SEEK_END);
+    mce_poll_irq(m);
+}
+
+static unsigned long mce_count(const mce_t *m, const pm_rank_topo_t *t, int core)
+{
+    unsigned long n = m->hw_any;
+
+    for (unsigned int j = 0; j < t->nthreads[core]; j++) {
+        int cpu = t->cpu[core][j];
+        n += m->irq[cpu] + m->hw[cpu];
+    }
+    return n;
+}
+
+/* ─── Shared state ─── */
+
+typedef enum { PH_BASELINE, PH_SEARCH, PH_CONFIRM } phase_t;
+
+static const char *phase_name[] = { "baseline", "search", "confirm" };
+
+typedef struct tuner tuner_t;
+
+typedef struct {
+    tuner_t     *t;
+    unsigned int id;
+    int          cores[CO_TUNE_MAX_CORES];
+    unsigned int ncores;
+    /* step in flight, under t->lock */
+    int          core, margin;      /* core -1: idle */
+    phase_t      phase;
+    double       t_start;
+    unsigned int ms;
+    double       f_sum;             /* unlimited clock samples of the core */
+    unsigned int f_n;
+} lane_t;
+
+struct tuner {
+    const co_tune_opts_t *o;
+    co_tune_result_t *r;
+    pthread_mutex_t lock;
+    lane_t       lanes[CO_TUNE_MAX_LANES];
+    unsigned int nlanes;
+    unsigned int test_ms, confirm_ms;
+    int          step;
+    char         params[192];
+    uint64_t     ref;
+    mce_t        mce;
+    pm_limiter_t limiter;
+    unsigned char *buf;
+    volatile int stop;
+    unsigned int lanes_done;
+    int          touched[CO_TUNE_MAX_CORES];
+    unsigned long long loaded;      /* cores restored from the checkpoint */
+};
+
+static void logf_locked(tuner_t *t, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void logf_locked(tuner_t *t, const char *fmt, ...)
+{
+    char line[256];
+    va_list ap;
+
+    if (!t->o->log)
+        return;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    t->o->log(t->o->ctx, line);
+}
+
+/* ─── Checkpoint ─── */
+
+static int state_save(tuner_t *t)
+{
+    const co_tune_opts_t *o = t->o;
+    pm_ckpt_t ck;
+
+    if (!o->state_path)
+        return 0;
+    if (pm_ckpt_begin(&ck, o->state_path, STATE_HEADER, t->params) != 0)
+        return -1;
+    fprintf(ck.fp, "# core status orig good bad final baseline_done baseline_mhz final_mhz "
+            "tests fails\n");
+    for (unsigned int c = 0; c < o->ncores; c++) {
+        const co_tune_core_t *k = &t->r->core[c];
+        if (!k->tests && k->status == CO_TUNE_PENDING)
+            continue;
+        fprintf(ck.fp, "core %u %d %d %d %d %d %d %.9g %.9g %u %u\n", c, (int)k->status, k->orig,
+                k->good, k->bad, k->final, k->baseline_done, k->baseline_mhz, k->final_mhz,
+                k->tests, k->fails);
+    }
+    /* A step still running when the machine went down counts as failed on resume */
+    for (unsigned int i = 0; i < t->nlanes; i++) {
+        if (t->lanes[i].core >= 0)
+            fprintf(ck.fp, "inflight %d %d\n", t->lanes[i].core, t->lanes[i].margin);
+    }
+    return pm_ckpt_commit(&ck);
+}
+
+static void mark_fail(co_tune_core_t *k, int margin, const char *why)
+{
+    k->fails++;
+    snprintf(k->last_fail, sizeof(k->last_fail), "%s", why);
+    if (!k->baseline_done || margin >= k->orig) {
+        k->status = CO_TUNE_SKIPPED;
+        k->final = k->orig;
+    } else if (margin > k->bad) {
+        k->bad = margin;
+    }
+}
+
+/* One "core" or "inflight" record; 1 if a core was restored. */
+static int state_line(void *ctx, const char *line)
+{
+    tuner_t *t = ctx;
+    co_tune_core_t k;
+    unsigned int c;
+    int status, m;
+
+    memset(&k, 0, sizeof(k));
+    if (sscanf(line, "core %u %d %d %d %d %d %d %f %f %u %u", &c, &status, &k.orig,
+               &k.good, &k.bad, &k.final, &k.baseline_done, &k.baseline_mhz,
+               &k.final_mhz, &k.tests, &k.fails) == 11 && c < t->o->ncores) {
+        k.status = (co_tune_status_t)status;
+        t->r->core[c] = k;
+        t->loaded |= 1ULL << c;
+        return 1;
+    }
+    if (sscanf(line, "inflight %u %d", &c, &m) == 2 && c < t->o->ncores) {
+        t->r->core[c].tests++;
+        mark_fail(&t->r->core[c], m, "machine lost during step");
+    }
+    return 0;
+}
+
+static unsigned int state_load(tuner_t *t)
+{
+    return pm_ckpt_load(t->o->state_path, STATE_HEADER, t->params, state_line, t);
+}
+
+/* ─── Lanes ─── */
+
+static int set_co_locked(tuner_t *t, int core, int margin)
+{
+    t->touched[core] = 1;
+    return t->o->set_co(t->o->ctx, core, margin);
+}
+
+/* Next step for core k; 0 when the core is finished. */
+static int next_step(const tuner_t *t, const co_tune_core_t *k, int *margin, phase_t *ph)
+{
+    const co_tune_opts_t *o = t->o;
+    int span, cand;
+
+    if (k->status != CO_TUNE_PENDING)
+        return 0;
+    if (!k->baseline_done) {
+        *margin = k->orig;
+        *ph = PH_BASELINE;
+        return 1;
+    }
+    span = k->good - k->bad;
+    if (span > t->step) {
+        int n = span / t->step / 2;
+        *margin = k->good - (n > 0 ? n : 1) * t->step;
+        if (*margin > k->bad) {
+            *ph = PH_SEARCH;
+            return 1;
+        }
+    }
+    cand = k->good + o->backoff;
+    if (cand <= k->bad)
+        cand = k->bad + t->step;
+    if (cand > k->orig)
+        cand = k->orig;
+    *margin = cand;
+    *ph = PH_CONFIRM;
+    return 1;
+}
+
+/* Run one step. 1 pass, 0 fail (why filled), -2 stopped. */
+static int run_step(lane_t *l, int core, int margin, phase_t ph, float *mhz, char *why,
+                    size_t why_len)
+{
+    tuner_t *t = l->t;
+    const co_tune_opts_t *o = t->o;
+    const pm_rank_topo_t *topo = o->topo;
+    unsigned int ms = ph == PH_CONFIRM ? t->confirm_ms : t->test_ms;
+    unsigned int nthr = o->smt ? topo->nthreads[core] : 1;
+    pid_t pid[PM_RANK_MAX_THREADS];
+    int st[PM_RANK_MAX_THREADS], alive = 0;
+    unsigned long mce0;
+    double deadline;
+    int rc = 1;
+
+    *mhz = NAN;
+    why[0] = '\0';
+    pthread_mutex_lock(&t->lock);
+    if (set_co_locked(t, core, margin) != 0) {
+        pthread_mutex_unlock(&t->lock);
+        snprintf(why, why_len, "CO set failed");
+        return 0;
+    }
+    l->core = core;
+    l->margin = margin;
+    l->phase = ph;
+    l->ms = ms;
+    l->f_sum = 0;
+    l->f_n = 0;
+    l->t_start = pm_now_sec();
+    mce0 = mce_count(&t->mce, topo, core);
+    state_save(t);
+    pthread_mutex_unlock(&t->lock);
+
+    for (unsigned int j = 0; j < nthr; j++) {
+        pid[j] = fork();
+        if (pid[j] == 0)
+            work_child(topo->cpu[core][j], ms, t->ref);
+        st[j] = -1;
+        if (pid[j] > 0)
+            alive++;
+    }
+    if (alive < (int)nthr) {
+        snprintf(why, why_len, "fork failed");
+        rc = 0;
+    }
+
+    deadline = pm_now_sec() + (ms + HANG_GRACE_MS) / 1000.0;
+    while (alive > 0) {
+        struct timespec ts = { 0, 20 * 1000000L };
+
+        for (unsigned int j = 0; j < nthr; j++) {
+            int ws;
+            if (pid[j] > 0 && st[j] == -1 && waitpid(pid[j], &ws, WNOHANG) == pid[j]) {
+                st[j] = ws;
+                alive--;
+            }
+        }
+        if (alive == 0)
+            break;
+        if (t->stop || pm_now_sec() > deadline) {
+            for (unsigned int j = 0; j < nthr; j++) {
+                if (pid[j] > 0 && st[j] == -1) {
+                    kill(pid[j], SIGKILL);
+                    waitpid(pid[j], &st[j], 0);
+                }
+            }
+            if (t->stop)
+                rc = -2;
+            else if (rc == 1) {
+                snprintf(why, why_len, "workload hung");
+                rc = 0;
+            }
+            break;
+        }
+        nanosleep(&ts, NULL);
+    }
+
+    for (unsigned int j = 0; j < nthr && rc == 1; j++) {
+        if (WIFSIGNALED(st[j])) {
+            snprintf(why, why_len, "workload crashed (%s)", strsignal(WTERMSIG(st[j])));
+            rc = 0;
+        } else if (WIFEXITED(st[j]) && WEXITSTATUS(st[j]) == EXIT_MISMATCH) {
+            snprintf(why, why_len, "wrong result on CPU %d", topo->cpu[core][j]);
+            rc = 0;
+        } else if (WIFEXITED(st[j]) && WEXITSTATUS(st[j]) == EXIT_AFFINITY) {
+            snprintf(why, why_len, "cannot pin to CPU %d", topo->cpu[core][j]);
+            rc = 0;
+        } else if (!WIFEXITED(st[j]) || WEXITSTATUS(st[j]) != 0) {
+            snprintf(why, why_len, "workload failed");
+            rc = 0;
+        }
+    }
+
+    pthread_mutex_lock(&t->lock);
+    if (rc == 1 && mce_count(&t->mce, topo, core) != mce0) {
+        snprintf(why, why_len, "machine check reported");
+        rc = 0;
+    }
+    if (l->f_n >= STRETCH_MIN_SAMPLES)
+        *mhz = (float)(l->f_sum / l->f_n);
+    if (rc == 1 && ph != PH_BASELINE && !isnan(*mhz) && !isnan(t->r->core[core].baseline_mhz) &&
+        *mhz < t->r->core[core].baseline_mhz * (1.f - CO_TUNE_STRETCH_PCT / 100.f)) {
+        snprintf(why, why_len, "clock stretch (%.0f < %.0f MHz)", *mhz,
+                 t->r->core[core].baseline_mhz);
+        rc = 0;
+    }
+    /* Failed or stopped: straight back to the known-good margin */
+    if (rc != 1)
+        set_co_locked(t, core, t->r->core[core].orig);
+    l->core = -1;
+    pthread_mutex_unlock(&t->lock);
+    return rc;
+}
+
+static void *lane_thread(void *p)
+{
+    lane_t *l = p;
+    tuner_t *t = l->t;
+    co_tune_result_t *r = t->r;
+
+    for (unsigned int i = 0; i < l->ncores && !t->stop; i++) {
+        int c = l->cores[i], margin;
+        co_tune_core_t *k = &r->core[c];
+        phase_t ph;
+
+        while (!t->stop && next_step(t, k, &margin, &ph)) {
+            char why[64];
+            float mhz;
+            int rc = run_step(l, c, margin, ph, &mhz, why, sizeof(why));
+
+            if (rc == -2)
+                break;
+            pthread_mutex_lock(&t->lock);
+            k->tests++;
+            if (rc == 1) {
+                if (ph == PH_BASELINE) {
+                    k->baseline_done = 1;
+                    k->baseline_mhz = mhz;
+                    k->good = margin;
+                } else if (ph == PH_SEARCH) {
+                    k->good = margin;
+                } else {
+                    k->final = margin;
+                    k->final_mhz = mhz;
+                    k->status = CO_TUNE_DONE;
+                }
+                if (isnan(mhz))
+                    logf_locked(t, "core %d: %s %+d pass", c, phase_name[ph], margin);
+                else
+                    logf_locked(t, "core %d: %s %+d pass (%.0f MHz)", c, phase_name[ph],
+                                margin, mhz);
+            } else {
+                mark_fail(k, margin, why);
+                logf_locked(t, "core %d: %s %+d FAIL: %s; back to %+d", c, phase_name[ph],
+                            margin, why, k->orig);
+            }
+            if (k->status == CO_TUNE_DONE)
+                logf_locked(t, "core %d: tuned to %+d (original %+d)", c, k->final, k->orig);
+            else if (k->status == CO_TUNE_SKIPPED)
+                logf_locked(t, "core %d: unstable at its original margin; left at %+d", c,
+                            k->orig);
+            if (state_save(t) != 0)
+                logf_locked(t, "checkpoint %s: %s", t->o->state_path, strerror(errno));
+            pthread_mutex_unlock(&t->lock);
+        }
+
+        /* Finished cores go back to their original margin while others are tested */
+        pthread_mutex_lock(&t->lock);
+        set_co_locked(t, c, k->orig);
+        pthread_mutex_unlock(&t->lock);
+    }
+    pthread_mutex_lock(&t->lock);
+    t->lanes_done++;
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+/* ─── Monitor (calling thread) ─── */
+
+static void monitor_sample(tuner_t *t)
+{
+    const pm_schema_t *sc = t->o->schema;
+    pm_limiter_state_t st;
+
+    mce_poll_irq(&t->mce);
+    mce_poll_kmsg(&t->mce);
+    if (!sc || !t->o->read_pm || t->o->read_pm(t->o->ctx, t->buf, t->o->table_size) != 0)
+        return;
+    pm_limiter_classify(&t->limiter, t->buf, &st);
+    if (st.engaged)                     /* limited clocks say nothing about stability */
+        return;
+    for (unsigned int i = 0; i < t->nlanes; i++) {
+        lane_t *l = &t->lanes[i];
+        float f;
+
+        if (l->core < 0)
+            continue;
+        f = pm_get_at(sc, t->buf, PMF_CORE_FREQEFF, (unsigned)t->o->topo->slot[l->core]);
+        if (!isnan(f) && f > 0.f) {
+            l->f_sum += f;
+            l->f_n++;
+        }
+    }
+}
+
+static void monitor_status(tuner_t *t, char *buf, size_t len)
+{
+    size_t n = 0;
+    double now = pm_now_sec();
+
+    buf[0] = '\0';
+    for (unsigned int i = 0; i < t->nlanes && n < len; i++) {
+        const lane_t *l = &t->lanes[i];
+
+        if (l->core < 0)
+            continue;
+        n += (size_t)snprintf(buf + n, len - n, "%score %d %s %+d %.0f/%us", n ? " | " : "",
+                              l->core, phase_name[l->phase], l->margin, now - l->t_start,
+                              l->ms / 1000);
+    }
+}
+
+/* ─── Entry points ─── */
+
+int co_tune_run(const co_tune_opts_t *o, co_tune_result_t *r)
+{
+    tuner_t *t;
+    unsigned int ngroups = 0, group_of[CO_TUNE_MAX_CORES];
+    pthread_t tid[CO_TUNE_MAX_LANES];
+    unsigned int started = 0;
+    unsigned long long unknown = 0;
+    double last_status = 0;
+    int rc = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (!o->set_co || !o->topo || o->ncores == 0 || o->ncores > CO_TUNE_MAX_CORES ||
+        o->ncores > o->topo->ncores)
+        return -1;
+    t = calloc(1, sizeof(*t));
+    if (!t)
+        return -1;
+    t->o = o;
+    t->r = r;
+    t->step = o->step > 0 ? o->step : 1;
+    t->test_ms = o->test_ms ? o->test_ms : 30000;
+    t->confirm_ms = o->confirm_ms ? o->confirm_ms : 2 * t->test_ms;
+    pthread_mutex_init(&t->lock, NULL);
+    snprintf(t->params, sizeof(t->params),
+             "version 0x%06X cores %u min %d step %d backoff %d test %u confirm %u smt %d",
+             o->version, o->ncores, o->margin_min, t->step, o->backoff, t->test_ms,
+             t->confirm_ms, o->smt);
+
+    for (unsigned int c = 0; c < o->ncores; c++) {
+        co_tune_core_t *k = &r->core[c];
+        int m = 0;
+
+        if (!o->get_co || o->get_co(o->ctx, (int)c, &m) != 0) {
+            m = o->orig_margin;
+            unknown |= 1ULL << c;
+        }
+        k->orig = k->good = k->final = m;
+        k->bad = o->margin_min - 1;
+        k->baseline_mhz = k->final_mhz = NAN;
+    }
+    if (o->state_path && !o->fresh)
+        r->resumed = state_load(t);
+
+    /* No revert target, no tuning: the checkpoint's originals count */
+    unknown &= ~t->loaded & (o->select ? o->select : ~0ULL);
+    if (unknown) {
+        r->orig_unknown = 1;
+        if (!o->assume_orig) {
+            r->reverted = 1;
+            pthread_mutex_destroy(&t->lock);
+            free(t);
+            return -1;
+        }
+    }
+
+    /* Lanes: one per CCD group, groups dealt round-robin when capped */
+    for (unsigned int c = 0; c < o->ncores; c++) {
+        group_of[c] = o->group_cores ? (unsigned int)o->topo->slot[c] / o->group_cores : 0;
+        if (group_of[c] + 1 > ngroups)
+            ngroups = group_of[c] + 1;
+    }
+    t->nlanes = o->lanes && o->lanes < ngroups ? o->lanes : ngroups;
+    if (t->nlanes > CO_TUNE_MAX_LANES)
+        t->nlanes = CO_TUNE_MAX_LANES;
+    for (unsigned int i = 0; i < t->nlanes; i++) {
+        t->lanes[i].t = t;
+        t->lanes[i].id = i;
+        t->lanes[i].core = -1;
+    }
+    for (unsigned int c = 0; c < o->ncores; c++) {
+        lane_t *l = &t->lanes[group_of[c] % t->nlanes];
+
+        if (o->select && !(o->select & (1ULL << c)))
+            continue;
+        l->cores[l->ncores++] = (int)c;
+    }
+
+    t->ref = work_chunk();
+    t->buf = o->schema ? calloc(o->table_size, 1) : NULL;
+    if (o->schema)
+        pm_limiter_init(&t->limiter, o->schema, o->topo->ncores, o->topo->slot);
+    mce_open(&t->mce);
+
+    for (unsigned int i = 0; i < t->nlanes; i++) {
+        if (t->lanes[i].ncores == 0)
+            continue;
+        if (pthread_create(&tid[started], NULL, lane_thread, &t->lanes[i]) != 0) {
+            t->stop = 1;
+            rc = -1;
+            break;
+        }
+        started++;
+    }
+
+    for (;;) {
+        struct timespec ts = { 0, MONITOR_MS * 1000000L };
+        int finished;
+
+        nanosleep(&ts, NULL);
+        if (o->running && !*o->running && !t->stop) {
+            t->stop = 1;
+            rc = -2;
+        }
+        pthread_mutex_lock(&t->lock);
+        monitor_sample(t);
+        if (o->progress && pm_now_sec() - last_status >= 1.0) {
+            char status[512];
+            monitor_status(t, status, sizeof(status));
+            o->progress(o->ctx, status);
+            last_status = pm_now_sec();
+        }
+        finished = t->lanes_done == started;
+        pthread_mutex_unlock(&t->lock);
+        if (finished)
+            break;
+    }
+    for (unsigned int i = 0; i < started; i++)
+        pthread_join(tid[i], NULL);
+
+    /* Everything back to where it started */
+    r->reverted = 1;
+    for (unsigned int c = 0; c < o->ncores; c++) {
+        if (t->touched[c] && o->set_co(o->ctx, (int)c, r->core[c].orig) != 0)
+            r->reverted = 0;
+    }
+
+    if (rc == 0) {
+        for (unsigned int c = 0; c < o->ncores; c++) {
+            if ((!o->select || (o->select & (1ULL << c))) &&
+                r->core[c].status == CO_TUNE_PENDING)
+                rc = -1;
+        }
+    }
+    if (rc == 0 && o->state_path)
+        unlink(o->state_path);
+    else if (o->state_path)
+        state_save(t);
+
+    if (t->mce.kmsg >= 0)
+        close(t->mce.kmsg);
+    free(t->buf);
+    pthread_mutex_destroy(&t->lock);
+    free(t);
+    return rc;
+}
+
+void co_tune_profile(const co_tune_opts_t *o, const co_tune_result_t *r, pbo_profile_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    for (unsigned int c = 0; c < o->ncores && c < PBO_MAX_CORES; c++) {
+        const co_tune_core_t *k = &r->core[c];
+        if (k->status == CO_TUNE_DONE || k->status == CO_TUNE_SKIPPED) {
+            p->co_mask |= 1ULL << c;
+            p->co[c] = k->final;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Curve Optimizer auto-tuner.
+ *
+ * Searches each core's most negative stable CO margin. Every step sets the
+ * margin, runs a pinned validation workload on the core in a child process
+ * (fixed FP/integer kernel, every chunk checked against a result computed
+ * before any margin was changed) and watches for the child crashing or
+ * hanging, kernel machine-check reports for the core's CPUs, and the core's
+ * effective clock dropping under the baseline (clock stretching). A failed
+ * step puts the core back on its original margin at once.
+ *
+ * Cores on different CCDs are thermally independent and are tested in
+ * parallel, one per CCD. With a state file every step is checkpointed,
+ * including the one in flight: a step that took the machine down counts as
+ * a failure when the run is resumed.
+ */
+#ifndef CO_TUNE_H
+#define CO_TUNE_H
+
+#include <signal.h>
+
+#include "pbo_profile.h"
+#include "pm_rank.h"
+#include "pm_schema.h"
+
+#define CO_TUNE_MAX_CORES   PM_RANK_MAX_CORES
+#define CO_TUNE_MAX_LANES   16
+
+/* Effective clock this far under the baseline, while no limit is engaged, fails a step. */
+#define CO_TUNE_STRETCH_PCT 3.0f
+
+typedef enum {
+    CO_TUNE_PENDING = 0,
+    CO_TUNE_DONE,           /* final margin confirmed */
+    CO_TUNE_SKIPPED,        /* failed at its original margin; left alone */
+} co_tune_status_t;
+
+typedef struct {
+    co_tune_status_t status;
+    int          orig;              /* margin before tuning (revert target) */
+    int          good, bad;         /* most negative pass, least negative fail */
+    int          final;             /* good + backoff, confirmed */
+    int          baseline_done;
+    float        baseline_mhz;      /* unlimited mean clock at orig, NAN if unknown */
+    float        final_mhz;
+    unsigned int tests, fails;
+    char         last_fail[64];     /* reason of the latest failed step */
+} co_tune_core_t;
+
+typedef struct {
+    const pm_schema_t *schema;      /* NULL: no clock or limit checks */
+    unsigned int table_size;
+    unsigned int version;           /* PM table version, for the state file */
+    const pm_rank_topo_t *topo;     /* core index -> logical CPUs and PM/SMU slot */
+    unsigned int ncores;
+    unsigned int group_cores;       /* slots per CCD; 0 = one group */
+    unsigned long long select;      /* cores to tune (bit per core), 0 = all */
+    unsigned int lanes;             /* parallel groups, 0 = one per group */
+    int          margin_min;        /* most negative margin to try */
+    int          step;              /* search granularity (0 = 1) */
+    int          backoff;           /* added to the most negative pass */
+    unsigned int test_ms;           /* per search step (0 = 30000) */
+    unsigned int confirm_ms;        /* final margin (0 = 2 * test_ms) */
+    int          smt;               /* load every SMT thread, not just the first */
+    int          assume_orig;       /* where CO GET fails, take orig_margin as the original */
+    int          orig_margin;
+    const char  *state_path;        /* NULL = not resumable */
+    int          fresh;
+    /* SMU access by core index; serialized by the tuner. 0 on success. */
+    int  (*set_co)(void *ctx, int core, int margin);
+    int  (*get_co)(void *ctx, int core, int *margin);
+    int  (*read_pm)(void *ctx, void *buf, unsigned int size);
+    /* Step results and notes, one line each; called with the tuner's lock held. */
+    void (*log)(void *ctx, const char *line);
+    /* About once a second from the calling thread. */
+    void (*progress)(void *ctx, const char *status);
+    volatile sig_atomic_t *running;
+    void *ctx;
+} co_tune_opts_t;
+
+typedef struct {
+    co_tune_core_t core[CO_TUNE_MAX_CORES];
+    unsigned int   resumed;         /* cores with progress from the checkpoint */
+    int            orig_unknown;    /* CO GET failed: orig_margin assumed, or the run refused */
+    int            reverted;        /* every core is back on its original margin */
+} co_tune_result_t;
+
+/*
+ * Tune the selected cores, then put every touched core back on its original
+ * margin. 0 done, -1 error, -2 interrupted (progress stays checkpointed).
+ * Without a readable original (CO GET, or the checkpoint) for every selected
+ * core, nothing is touched and -1 comes back with orig_unknown set, unless
+ * assume_orig is given. The checkpoint is removed once every selected core
+ * is finished.
+ */
+int co_tune_run(const co_tune_opts_t *o, co_tune_result_t *r);
+
+/* Profile with the final margin of every finished core. */
+void co_tune_profile(const co_tune_opts_t *o, const co_tune_result_t *r, pbo_profile_t *p);
+
+#endif
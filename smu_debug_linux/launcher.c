@@ -8,7 +8,12 @@
 
 static int wants_gui(int argc, char **argv)
 {
+    /* "run -- cmd -g" must not start the GUI */
+    if (smu_find_command(argc, argv))
+        return 0;
     for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0)
+            break;
         if (strcmp(argv[i], "--gui") == 0 || strcmp(argv[i], "-g") == 0)
             return 1;
     }
@@ -17,6 +22,7 @@ static int wants_gui(int argc, char **argv)
 
 int main(int argc, char **argv)
 {
+    const smu_command_t *cmd = smu_find_command(argc, argv);
     smu_obj_t *o;
     int elev;
     int gui = wants_gui(argc, argv);
@@ -29,6 +35,11 @@ int main(int argc, char **argv)
 #endif
 
     smu_restore_env(&argc, argv);
+
+    /* Offline analysis: no elevation, no SMU */
+    if (cmd && cmd->offline)
+        return cmd->main(argc - 1, argv + 1);
+
     smu_setup_signals();
     elev = smu_elevate_if_necessary(argc, argv);
     if (elev <= 0)
@@ -40,6 +51,7 @@ int main(int argc, char **argv)
         fprintf(stderr, "  sudo modprobe ryzen_smu\n");
         return 1;
     }
+    smu_select_platform();
 
 #ifdef HAVE_GTK
     if (gui)
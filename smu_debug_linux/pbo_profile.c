@@ -0,0 +1,382 @@
+/*
+ * PBO profiles and transactional apply (see pbo_profile.h).
+ */
+
+#include <time.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pbo_profile.h"
+
+static const char *limit_names[PBO_LIM_COUNT] = { "PPT", "TDC", "EDC", "THM", "Scalar" };
+static const char *limit_keys[PBO_LIM_COUNT] = { "ppt", "tdc", "edc", "thm", "scalar" };
+static const unsigned int limit_max[PBO_LIM_COUNT] = { 1000, 1000, 1000, 115, 10 };
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+const char *pbo_limit_name(pbo_limit_id l)
+{
+    return (unsigned)l < PBO_LIM_COUNT ? limit_names[l] : "?";
+}
+
+const char *pbo_limit_key(pbo_limit_id l)
+{
+    return (unsigned)l < PBO_LIM_COUNT ? limit_keys[l] : "?";
+}
+
+unsigned int pbo_limit_max(pbo_limit_id l)
+{
+    return (unsigned)l < PBO_LIM_COUNT ? limit_max[l] : 0;
+}
+
+void pbo_item_label(const pbo_item_t *it, char *buf, size_t len)
+{
+    if (it->kind == PBO_ITEM_CO)
+        snprintf(buf, len, "CO core %d", it->index);
+    else if (it->kind == PBO_ITEM_FMAX)
+        snprintf(buf, len, "FMax");
+    else
+        snprintf(buf, len, "%s", pbo_limit_name((pbo_limit_id)it->index));
+}
+
+/* ─── File format ─── */
+
+static int parse_long(const char *s, long *v)
+{
+    char *end;
+
+    if (!s)
+        return -1;
+    *v = strtol(s, &end, 10);
+    return end != s && *end == '\0' ? 0 : -1;
+}
+
+int pbo_profile_load(const char *path, pbo_profile_t *p, char *err, size_t errlen)
+{
+    char line[256];
+    unsigned int ln = 0;
+    FILE *fp = fopen(path, "r");
+
+    memset(p, 0, sizeof(*p));
+    if (!fp) {
+        snprintf(err, errlen, "%s: cannot open", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        char *key, *a, *b, *extra, *save = NULL;
+        long v, core;
+
+        ln++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        key = strtok_r(line, " \t", &save);
+        if (!key)
+            continue;
+        a = strtok_r(NULL, " \t", &save);
+        b = strtok_r(NULL, " \t", &save);
+        extra = strtok_r(NULL, " \t", &save);
+
+        if (strcmp(key, "co") == 0 && !extra) {
+            if (parse_long(b, &v) != 0 || v < PBO_CO_MIN || v > PBO_CO_MAX) {
+                snprintf(err, errlen, "%s:%u: CO margin must be %d..%d", path, ln,
+                         PBO_CO_MIN, PBO_CO_MAX);
+                goto fail;
+            }
+            if (a && strcmp(a, "all") == 0) {
+                p->co_all = 1;
+                for (int c = 0; c < PBO_MAX_CORES; c++) {
+                    if (!(p->co_mask & (1ULL << c)))
+                        p->co[c] = (int)v;
+                }
+                continue;
+            }
+            if (parse_long(a, &core) != 0 || core < 0 || core >= PBO_MAX_CORES) {
+                snprintf(err, errlen, "%s:%u: bad core '%s'", path, ln, a ? a : "");
+                goto fail;
+            }
+            p->co_mask |= 1ULL << core;
+            p->co[core] = (int)v;
+            continue;
+        }
+        if (b) {
+            snprintf(err, errlen, "%s:%u: too many fields", path, ln);
+            goto fail;
+        }
+        if (strcmp(key, "fmax") == 0) {
+            if (parse_long(a, &v) != 0 || v < 0 || v > PBO_FMAX_MAX) {
+                snprintf(err, errlen, "%s:%u: FMax must be 0..%d MHz", path, ln, PBO_FMAX_MAX);
+                goto fail;
+            }
+            p->has_fmax = 1;
+            p->fmax_mhz = (unsigned int)v;
+            continue;
+        }
+        for (int l = 0; l < PBO_LIM_COUNT; l++) {
+            if (strcmp(key, limit_keys[l]) != 0)
+                continue;
+            if (parse_long(a, &v) != 0 || v <= 0 || v > (long)limit_max[l]) {
+                snprintf(err, errlen, "%s:%u: %s must be 1..%u", path, ln, limit_names[l],
+                         limit_max[l]);
+                goto fail;
+            }
+            p->lim_mask |= 1u << l;
+            p->limit[l] = (unsigned int)v;
+            key = NULL;
+            break;
+        }
+        if (key) {
+            snprintf(err, errlen, "%s:%u: unknown setting '%s'", path, ln, key);
+            goto fail;
+        }
+    }
+    fclose(fp);
+    if (!p->co_mask && !p->co_all && !p->has_fmax && !p->lim_mask) {
+        snprintf(err, errlen, "%s: no settings", path);
+        return -1;
+    }
+    return 0;
+
+fail:
+    fclose(fp);
+    return -1;
+}
+
+int pbo_profile_save(const char *path, const pbo_profile_t *p, const char *header)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (!fp)
+        return -1;
+    if (header)
+        fprintf(fp, "# %s\n", header);
+    fprintf(fp, "# co <core> <margin> | fmax <MHz> | ppt <W> | tdc <A> | edc <A> | thm <C> | "
+            "scalar <x>\n");
+    for (int l = 0; l < PBO_LIM_COUNT; l++) {
+        if (p->lim_mask & (1u << l))
+            fprintf(fp, "%s %u\n", limit_keys[l], p->limit[l]);
+    }
+    if (p->has_fmax)
+        fprintf(fp, "fmax %u\n", p->fmax_mhz);
+    for (int c = 0; c < PBO_MAX_CORES; c++) {
+        if (p->co_mask & (1ULL << c))
+            fprintf(fp, "co %d %d\n", c, p->co[c]);
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/* ─── Apply ─── */
+
+static int item_get(const pbo_ops_t *ops, const pbo_item_t *it, long *v)
+{
+    int rc = -1;
+
+    if (it->kind == PBO_ITEM_CO) {
+        int m = 0;
+        rc = ops->get_co ? ops->get_co(ops->ctx, it->index, &m) : -1;
+        *v = m;
+    } else if (it->kind == PBO_ITEM_FMAX) {
+        unsigned int mhz = 0;
+        rc = ops->get_fmax ? ops->get_fmax(ops->ctx, &mhz) : -1;
+        *v = (long)mhz;
+    } else {
+        unsigned int x = 0;
+        rc = ops->get_limit ? ops->get_limit(ops->ctx, (pbo_limit_id)it->index, &x) : -1;
+        *v = (long)x;
+    }
+    return rc;
+}
+
+static int item_set(const pbo_ops_t *ops, const pbo_item_t *it, long v)
+{
+    if (it->kind == PBO_ITEM_CO)
+        return ops->set_co ? ops->set_co(ops->ctx, it->index, (int)v) : -1;
+    if (it->kind == PBO_ITEM_FMAX)
+        return ops->set_fmax ? ops->set_fmax(ops->ctx, (unsigned int)v) : -1;
+    return ops->set_limit ? ops->set_limit(ops->ctx, (pbo_limit_id)it->index, (unsigned int)v)
+                          : -1;
+}
+
+/* FMax 0 hands the limit back to firmware, which then reports its own value. */
+static int item_verifiable(const pbo_item_t *it, long target)
+{
+    return !(it->kind == PBO_ITEM_FMAX && target == 0);
+}
+
+static void add_item(pbo_apply_result_t *r, pbo_item_kind kind, int index, long target)
+{
+    pbo_item_t *it = &r->item[r->n++];
+
+    memset(it, 0, sizeof(*it));
+    it->kind = kind;
+    it->index = index;
+    it->target = target;
+    it->before = it->after = -1;
+}
+
+static int fail(pbo_apply_result_t *r, const pbo_item_t *it, const char *what)
+{
+    char label[32];
+
+    pbo_item_label(it, label, sizeof(label));
+    snprintf(r->error, sizeof(r->error), "%s: %s", label, what);
+    return -1;
+}
+
+/* Put every item that was sent back to its snapshot. 0 if all verified. */
+static int rollback(const pbo_ops_t *ops, pbo_apply_result_t *r)
+{
+    int ok = 1;
+
+    r->rolled_back = 1;
+    for (unsigned int i = r->n; i-- > 0;) {
+        pbo_item_t *it = &r->item[i];
+        long v;
+
+        if (!it->changed)
+            continue;
+        if (item_set(ops, it, it->before) != 0 ||
+            (item_verifiable(it, it->before) &&
+             (item_get(ops, it, &v) != 0 || v != it->before)))
+            ok = 0;
+        else
+            it->after = it->before;
+    }
+    r->rollback_ok = ok;
+    return ok ? -1 : -2;
+}
+
+int pbo_profile_check(const pbo_profile_t *p, int co_min, int co_max, unsigned int fmax_max,
+                      char *err, size_t errlen)
+{
+    for (int c = 0; c < PBO_MAX_CORES; c++) {
+        if (!(p->co_mask & (1ULL << c)) && !p->co_all)
+            continue;
+        if (p->co[c] < co_min || p->co[c] > co_max) {
+            snprintf(err, errlen, "CO margin %d (core %d) is outside %d..%d on this CPU",
+                     p->co[c], c, co_min, co_max);
+            return -1;
+        }
+    }
+    if (p->has_fmax && p->fmax_mhz > fmax_max) {
+        snprintf(err, errlen, "FMax %u MHz is over %u MHz on this CPU", p->fmax_mhz, fmax_max);
+        return -1;
+    }
+    return 0;
+}
+
+static void plan_limits(const pbo_profile_t *p, pbo_apply_result_t *r)
+{
+    for (int l = 0; l < PBO_LIM_COUNT; l++) {
+        if (p->lim_mask & (1u << l))
+            add_item(r, PBO_ITEM_LIMIT, l, (long)p->limit[l]);
+    }
+}
+
+int pbo_apply(const pbo_ops_t *ops, const pbo_profile_t *p, unsigned int flags,
+              pbo_apply_result_t *r)
+{
+    int restore = (flags & PBO_APPLY_RESTORE) != 0;
+    int verify = !(flags & (PBO_APPLY_NO_VERIFY | PBO_APPLY_RESTORE));
+    double t0 = now_ms();
+    int rc = 0;
+
+    memset(r, 0, sizeof(*r));
+
+    /* Plan: limits, then CO, then FMax (boost rises last). A restore goes the
+     * other way: FMax and CO take effect at once, a limit set may wait for the
+     * PM table, and what the platform lacks is skipped rather than refused. */
+    if (p->lim_mask && !restore && (!ops->set_limit || (verify && !ops->get_limit))) {
+        snprintf(r->error, sizeof(r->error), "power limits are not supported on this CPU");
+        return -3;
+    }
+    if (restore && p->has_fmax)
+        add_item(r, PBO_ITEM_FMAX, 0, (long)p->fmax_mhz);
+    if (!restore)
+        plan_limits(p, r);
+    for (unsigned int c = 0; c < PBO_MAX_CORES; c++) {
+        if (!(p->co_mask & (1ULL << c)) && !(p->co_all && c < ops->ncores))
+            continue;
+        if (c >= ops->ncores && restore)
+            break;
+        if (c >= ops->ncores) {
+            snprintf(r->error, sizeof(r->error), "profile sets core %u; this CPU has %u cores",
+                     c, ops->ncores);
+            return -3;
+        }
+        add_item(r, PBO_ITEM_CO, (int)c, p->co[c]);
+    }
+    if (restore && ops->set_limit)
+        plan_limits(p, r);
+    if (!restore && p->has_fmax)
+        add_item(r, PBO_ITEM_FMAX, 0, (long)p->fmax_mhz);
+
+    /* Snapshot: without it there is nothing to roll back to */
+    if (verify) {
+        for (unsigned int i = 0; i < r->n; i++) {
+            pbo_item_t *it = &r->item[i];
+            if (item_get(ops, it, &it->before) != 0) {
+                fail(r, it, "read failed; cannot snapshot (apply without verification to force)");
+                r->ms = now_ms() - t0;
+                return -3;
+            }
+            it->known = 1;
+        }
+    }
+    if (flags & PBO_APPLY_DRY_RUN) {
+        for (unsigned int i = 0; i < r->n; i++)
+            r->nchanged += !r->item[i].known || r->item[i].before != r->item[i].target;
+        r->ms = now_ms() - t0;
+        return 0;
+    }
+
+    /* A restore carries on past a failed item: every other one still helps */
+    for (unsigned int i = 0; i < r->n && (rc == 0 || restore); i++) {
+        pbo_item_t *it = &r->item[i];
+
+        if (it->known && it->before == it->target) {
+            it->after = it->before;
+            it->ok = 1;
+            continue;
+        }
+        it->changed = 1;
+        r->nchanged++;
+        if (item_set(ops, it, it->target) == 0)
+            it->ok = restore;
+        else if (r->nfailed++ == 0)
+            rc = fail(r, it, "set failed");
+    }
+    if (restore) {
+        r->ms = now_ms() - t0;
+        return rc ? -2 : 0;
+    }
+    for (unsigned int i = 0; i < r->n && rc == 0; i++) {
+        pbo_item_t *it = &r->item[i];
+
+        if (!it->changed)
+            continue;
+        if (!verify || !item_verifiable(it, it->target)) {
+            it->ok = 1;
+            continue;
+        }
+        if (item_get(ops, it, &it->after) != 0)
+            rc = fail(r, it, "readback failed");
+        else if (it->after != it->target) {
+            char why[64];
+            snprintf(why, sizeof(why), "readback %ld, expected %ld", it->after, it->target);
+            rc = fail(r, it, why);
+        } else
+            it->ok = 1;
+    }
+    if (rc != 0 && verify)
+        rc = rollback(ops, r);
+    else if (rc != 0)
+        rc = -2;                        /* nothing to roll back to */
+    r->ms = now_ms() - t0;
+    return rc;
+}
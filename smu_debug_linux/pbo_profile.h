@@ -0,0 +1,106 @@
+/*
+ * PBO profiles: per-core Curve Optimizer margins, FMax and power limits,
+ * and a transactional apply.
+ *
+ * Text format, one setting per line, '#' starts a comment:
+ *
+ *   co <core> <margin>      CO margin for one core (-60..10; see pbo_profile_check)
+ *   co all <margin>         every core
+ *   fmax <MHz>              boost limit (0 = firmware default)
+ *   ppt <W> | tdc <A> | edc <A> | thm <C> | scalar <x>
+ *
+ * Apply snapshots the current value of everything the profile touches,
+ * sets only what differs, reads every change back and, on any failure,
+ * restores the snapshot. CO and FMax go back to back; how long a limit set
+ * takes is up to ops->set_limit (the tool waits up to 250 ms for the PM
+ * table to show it, since firmware may clamp it).
+ */
+#ifndef PBO_PROFILE_H
+#define PBO_PROFILE_H
+
+#include <stddef.h>
+
+#define PBO_MAX_CORES   64
+/* Format bounds, the widest any CPU accepts; pbo_profile_check narrows them */
+#define PBO_CO_MIN      (-60)
+#define PBO_CO_MAX      10
+#define PBO_FMAX_MAX    6000
+
+typedef enum {
+    PBO_LIM_PPT, PBO_LIM_TDC, PBO_LIM_EDC, PBO_LIM_THM, PBO_LIM_SCALAR, PBO_LIM_COUNT
+} pbo_limit_id;
+
+typedef struct {
+    unsigned long long co_mask;         /* cores with a margin */
+    int                co_all;          /* "co all": every core up to ops->ncores */
+    int                co[PBO_MAX_CORES];
+    int                has_fmax;
+    unsigned int       fmax_mhz;
+    unsigned int       lim_mask;        /* bit per pbo_limit_id */
+    unsigned int       limit[PBO_LIM_COUNT];
+} pbo_profile_t;
+
+/* SMU access. get_limit/set_limit may be NULL (no limit support). 0 on success. */
+typedef struct {
+    int  (*get_co)(void *ctx, int core, int *margin);
+    int  (*set_co)(void *ctx, int core, int margin);
+    int  (*get_fmax)(void *ctx, unsigned int *mhz);
+    int  (*set_fmax)(void *ctx, unsigned int mhz);
+    int  (*get_limit)(void *ctx, pbo_limit_id l, unsigned int *value);
+    int  (*set_limit)(void *ctx, pbo_limit_id l, unsigned int value);
+    unsigned int ncores;
+    void *ctx;
+} pbo_ops_t;
+
+typedef enum { PBO_ITEM_LIMIT, PBO_ITEM_CO, PBO_ITEM_FMAX } pbo_item_kind;
+
+typedef struct {
+    pbo_item_kind kind;
+    int           index;                /* core or pbo_limit_id */
+    long          before, target, after;
+    int           known;                /* before was read */
+    int           changed;              /* a set was sent */
+    int           ok;                   /* set and readback (or unchanged) */
+} pbo_item_t;
+
+#define PBO_APPLY_DRY_RUN   0x1         /* snapshot and plan only */
+#define PBO_APPLY_NO_VERIFY 0x2         /* no snapshot, readback or rollback */
+#define PBO_APPLY_RESTORE   0x4         /* emergency: FMax, CO, then limits; no snapshot,
+                                           readback or rollback; keeps going past failures */
+
+typedef struct {
+    pbo_item_t   item[PBO_LIM_COUNT + PBO_MAX_CORES + 1];
+    unsigned int n;
+    unsigned int nchanged;
+    unsigned int nfailed;               /* sets that failed (PBO_APPLY_RESTORE: all tried) */
+    int          rolled_back;
+    int          rollback_ok;
+    double       ms;                    /* wall time of snapshot, apply and verify */
+    char         error[160];
+} pbo_apply_result_t;
+
+/* 0 ok; -1 with "path:line: reason" in err. */
+int  pbo_profile_load(const char *path, pbo_profile_t *p, char *err, size_t errlen);
+/* header: optional comment line(s) without '#'. 0 ok. */
+int  pbo_profile_save(const char *path, const pbo_profile_t *p, const char *header);
+/* Values outside one CPU's CO range or FMax cap: 0 ok; -1 with the reason in err. */
+int  pbo_profile_check(const pbo_profile_t *p, int co_min, int co_max, unsigned int fmax_max,
+                       char *err, size_t errlen);
+
+/*
+ * 0 applied and verified (or nothing to change); -1 failed and rolled back;
+ * -2 failed and the rollback failed too (or, restoring, nfailed items did not
+ * take); -3 refused before any change (invalid profile for this CPU, snapshot
+ * failed, unsupported setting).
+ */
+int  pbo_apply(const pbo_ops_t *ops, const pbo_profile_t *p, unsigned int flags,
+               pbo_apply_result_t *r);
+
+const char *pbo_limit_name(pbo_limit_id l);
+/* Profile key ("ppt") and largest accepted value (W, A, C or x). */
+const char *pbo_limit_key(pbo_limit_id l);
+unsigned int pbo_limit_max(pbo_limit_id l);
+/* "CO core 3", "FMax", "PPT" */
+void pbo_item_label(const pbo_item_t *it, char *buf, size_t len);
+
+#endif
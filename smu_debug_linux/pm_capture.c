@@ -0,0 +1,111 @@
+/*
+ * PM table history ring and capture writer (see pm_capture.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pm_capture.h"
+
+int pm_ring_init(pm_ring_t *r, unsigned int nfloats, unsigned int capacity)
+{
+    memset(r, 0, sizeof(*r));
+    if (nfloats == 0 || capacity == 0)
+        return -1;
+    r->data = malloc((size_t)nfloats * capacity * sizeof(float));
+    r->time = malloc((size_t)capacity * sizeof(double));
+    if (!r->data || !r->time) {
+        pm_ring_free(r);
+        return -1;
+    }
+    r->nfloats = nfloats;
+    r->capacity = capacity;
+    return 0;
+}
+
+void pm_ring_free(pm_ring_t *r)
+{
+    free(r->data);
+    free(r->time);
+    memset(r, 0, sizeof(*r));
+}
+
+float *pm_ring_push(pm_ring_t *r, double t)
+{
+    unsigned int slot = (unsigned int)(r->seq % r->capacity);
+
+    r->time[slot] = t;
+    r->seq++;
+    return r->data + (size_t)slot * r->nfloats;
+}
+
+const float *pm_ring_get(const pm_ring_t *r, unsigned long long seq, double *t)
+{
+    unsigned int slot;
+
+    if (seq >= r->seq || seq < pm_ring_first(r))
+        return NULL;
+    slot = (unsigned int)(seq % r->capacity);
+    if (t)
+        *t = r->time[slot];
+    return r->data + (size_t)slot * r->nfloats;
+}
+
+int pm_ring_copy(pm_ring_t *dst, const pm_ring_t *src, unsigned long long from,
+                 unsigned long long to)
+{
+    if (from < pm_ring_first(src))
+        from = pm_ring_first(src);
+    if (to > src->seq)
+        to = src->seq;
+    if (pm_ring_init(dst, src->nfloats, to > from ? (unsigned int)(to - from) : 1) != 0)
+        return -1;
+    for (unsigned long long q = from; q < to; q++) {
+        double t = 0;
+        const float *v = pm_ring_get(src, q, &t);
+
+        memcpy(pm_ring_push(dst, t), v, (size_t)src->nfloats * sizeof(float));
+    }
+    return 0;
+}
+
+int pm_capture_write_csv(FILE *fp, const pm_ring_t *r, unsigned long long from,
+                         unsigned long long to, double t0, const pm_schema_t *s,
+                         const char *comment)
+{
+    char label[24];
+    const char *c = comment;
+
+    if (from < pm_ring_first(r))
+        from = pm_ring_first(r);
+    if (to > r->seq)
+        to = r->seq;
+
+    /* Prefix each comment line with '#' */
+    while (c && *c) {
+        size_t n = strcspn(c, "\n");
+        fprintf(fp, "# %.*s\n", (int)n, c);
+        c += n;
+        if (*c == '\n')
+            c++;
+    }
+
+    fputs("t_ms", fp);
+    for (unsigned int i = 0; i < r->nfloats; i++) {
+        if (pm_schema_index_label(s, i, label, sizeof(label)))
+            fprintf(fp, ",%s", label);
+        else
+            fprintf(fp, ",pm[%u]", i);
+    }
+    fputc('\n', fp);
+
+    for (unsigned long long q = from; q < to; q++) {
+        double t = t0;
+        const float *v = pm_ring_get(r, q, &t);
+        fprintf(fp, "%.3f", (t - t0) * 1000.0);
+        for (unsigned int i = 0; i < r->nfloats; i++)
+            fprintf(fp, ",%g", v[i]);
+        fputc('\n', fp);
+    }
+    return ferror(fp) ? -1 : 0;
+}
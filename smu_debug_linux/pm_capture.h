@@ -0,0 +1,55 @@
+/*
+ * Fixed-size PM table history ring and capture file writer.
+ *
+ * The ring is sized once (pre-trigger + post-trigger samples) and never
+ * reallocates; samples are addressed by a running sequence number so a
+ * trigger position stays valid while newer samples keep arriving.
+ */
+#ifndef PM_CAPTURE_H
+#define PM_CAPTURE_H
+
+#include <stdio.h>
+
+#include "pm_schema.h"
+
+typedef struct {
+    unsigned int        nfloats;    /* floats per sample */
+    unsigned int        capacity;   /* samples */
+    float              *data;       /* capacity * nfloats */
+    double             *time;       /* seconds, monotonic */
+    unsigned long long  seq;        /* samples pushed so far */
+} pm_ring_t;
+
+int  pm_ring_init(pm_ring_t *r, unsigned int nfloats, unsigned int capacity);
+void pm_ring_free(pm_ring_t *r);
+
+/* Slot for the next sample; fill it, it is committed immediately. */
+float *pm_ring_push(pm_ring_t *r, double t);
+
+/* Oldest sequence number still held. */
+static inline unsigned long long pm_ring_first(const pm_ring_t *r)
+{
+    return r->seq > r->capacity ? r->seq - r->capacity : 0;
+}
+
+/* Sample by sequence number; NULL if overwritten or not yet written. */
+const float *pm_ring_get(const pm_ring_t *r, unsigned long long seq, double *t);
+
+/*
+ * Copy samples [from, to) into a new ring sized to hold exactly those, with
+ * sequence numbers restarting at 0, so it can be written while the source
+ * keeps sampling. 0 on success.
+ */
+int  pm_ring_copy(pm_ring_t *dst, const pm_ring_t *src, unsigned long long from,
+                  unsigned long long to);
+
+/*
+ * Write samples [from, to) as CSV: '#' header lines (comment, may be
+ * multi-line), then "t_ms,<field names>" with time relative to t0.
+ * Columns use schema names where known, pm[N] otherwise. 0 on success.
+ */
+int pm_capture_write_csv(FILE *fp, const pm_ring_t *r, unsigned long long from,
+                         unsigned long long to, double t0, const pm_schema_t *s,
+                         const char *comment);
+
+#endif
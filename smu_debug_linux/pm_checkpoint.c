@@ -0,0 +1,64 @@
+/*
+ * Checkpoint files for long runs (see pm_checkpoint.h).
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pm_checkpoint.h"
+
+int pm_ckpt_begin(pm_ckpt_t *c, const char *path, const char *header, const char *params)
+{
+    c->path = path;
+    snprintf(c->tmp, sizeof(c->tmp), "%s.tmp", path);
+    c->fp = fopen(c->tmp, "w");
+    if (!c->fp)
+        return -1;
+    fprintf(c->fp, "%s\n%s\n", header, params);
+    return 0;
+}
+
+int pm_ckpt_commit(pm_ckpt_t *c)
+{
+    int bad = fflush(c->fp) != 0 || fsync(fileno(c->fp)) != 0;
+
+    if (fclose(c->fp) != 0 || bad || rename(c->tmp, c->path) != 0) {
+        unlink(c->tmp);
+        c->fp = NULL;
+        return -1;
+    }
+    c->fp = NULL;
+    return 0;
+}
+
+unsigned int pm_ckpt_load(const char *path, const char *header, const char *params,
+                          pm_ckpt_line_fn fn, void *ctx)
+{
+    char line[512];
+    unsigned int n = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (!fp)
+        return 0;
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, header, strlen(header)) != 0 ||
+        !fgets(line, sizeof(line), fp) || strcspn(line, "\n") != strlen(params) ||
+        strncmp(line, params, strlen(params)) != 0) {
+        fclose(fp);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] != '#')
+            n += fn(ctx, line) > 0;
+    }
+    fclose(fp);
+    return n;
+}
+
+double pm_now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
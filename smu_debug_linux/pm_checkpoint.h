@@ -0,0 +1,39 @@
+/*
+ * Checkpoint files for long runs (rank, co-tune).
+ *
+ * A checkpoint is text: a header line naming the tool and format version, a
+ * parameters line, then one record per line. It is written to PATH.tmp,
+ * synced and renamed over PATH, so a crash or power loss leaves either the
+ * old file or the new one. A checkpoint whose header or parameters differ
+ * from the run's is ignored: the run starts over.
+ */
+#ifndef PM_CHECKPOINT_H
+#define PM_CHECKPOINT_H
+
+#include <stdio.h>
+
+typedef struct {
+    FILE       *fp;
+    const char *path;
+    char        tmp[4096 + 8];
+} pm_ckpt_t;
+
+/* Open PATH.tmp and write the header and parameters; 0 ok, -1. */
+int  pm_ckpt_begin(pm_ckpt_t *c, const char *path, const char *header, const char *params);
+/* Sync and rename over the path; 0 ok, -1 (PATH is left as it was). */
+int  pm_ckpt_commit(pm_ckpt_t *c);
+
+/* Record callback: 1 if the line counts as restored, 0 if not. */
+typedef int (*pm_ckpt_line_fn)(void *ctx, const char *line);
+
+/*
+ * Feed each record of a matching checkpoint to fn. Returns the number fn
+ * counted; 0 if the file is absent, unreadable or from another run.
+ */
+unsigned int pm_ckpt_load(const char *path, const char *header, const char *params,
+                          pm_ckpt_line_fn fn, void *ctx);
+
+/* CLOCK_MONOTONIC, seconds: step timing in the checkpointed runs. */
+double pm_now_sec(void);
+
+#endif
@@ -0,0 +1,842 @@
+/*
+ * A/B comparison of run reports and PM captures (see pm_compare.h).
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pm_compare.h"
+#include "pm_limiter.h"
+#include "pm_schema.h"
+#include "pm_session.h"
+#include "pm_stats.h"
+
+#define CMP_BOOTSTRAP_MAX   20000   /* combined samples; above this use MW / Welch */
+#define CMP_MAX_CORES       64
+#define CMP_JSON_DEPTH      64
+
+static const struct {
+    const char *key, *label;
+    int sense;
+} metrics[PM_CMP_COUNT] = {
+    [PM_CMP_ELAPSED]     = { "ElapsedS",     "Elapsed (s)",      -1 },
+    [PM_CMP_ENERGY]      = { "EnergyJ",      "Energy (J)",       -1 },
+    [PM_CMP_POWER]       = { "PowerAvgW",    "Power avg (W)",    -1 },
+    [PM_CMP_POWER_PEAK]  = { "PowerPeakW",   "Power peak (W)",   -1 },
+    [PM_CMP_CLOCK]       = { "ClockAvgMHz",  "Clock avg (MHz)",  +1 },
+    [PM_CMP_CLOCK_PEAK]  = { "ClockPeakMHz", "Clock peak (MHz)", +1 },
+    [PM_CMP_TEMP]        = { "TempAvgC",     "THM avg (C)",      -1 },
+    [PM_CMP_TEMP_PEAK]   = { "TempPeakC",    "THM peak (C)",     -1 },
+    [PM_CMP_CORE_TEMP]   = { "CoreTempMaxC", "Core temp max (C)", -1 },
+    [PM_CMP_PPT]         = { "PptLimitPct",  "At PPT (%)",        0 },
+    [PM_CMP_TDC]         = { "TdcLimitPct",  "At TDC (%)",        0 },
+    [PM_CMP_EDC]         = { "EdcLimitPct",  "At EDC (%)",        0 },
+    [PM_CMP_THM]         = { "ThmLimitPct",  "At THM (%)",        0 },
+    [PM_CMP_FIT]         = { "FitLimitPct",  "At FIT (%)",        0 },
+    [PM_CMP_PROCHOT]     = { "ProchotPct",   "PROCHOT (%)",       0 },
+    [PM_CMP_CEILING]     = { "CeilingPct",   "At ceiling (%)",    0 },
+    [PM_CMP_SCORE]       = { "Score",        "Score",            +1 },
+    [PM_CMP_SCORE_PER_W] = { "ScorePerW",    "Score per W",      +1 },
+};
+
+const char *pm_cmp_metric_key(pm_cmp_metric m)
+{
+    return (unsigned)m < PM_CMP_COUNT ? metrics[m].key : "?";
+}
+
+const char *pm_cmp_metric_label(pm_cmp_metric m)
+{
+    return (unsigned)m < PM_CMP_COUNT ? metrics[m].label : "?";
+}
+
+int pm_cmp_metric_sense(pm_cmp_metric m)
+{
+    return (unsigned)m < PM_CMP_COUNT ? metrics[m].sense : 0;
+}
+
+void pm_cmp_set_init(pm_cmp_set_t *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+void pm_cmp_set_free(pm_cmp_set_t *s)
+{
+    for (int m = 0; m < PM_CMP_COUNT; m++)
+        free(s->m[m].v);
+    memset(s, 0, sizeof(*s));
+}
+
+static int samples_push(pm_cmp_samples_t *s, double v)
+{
+    if (isnan(v))
+        return 0;
+    if (s->n == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 256;
+        double *nv = realloc(s->v, cap * sizeof(*nv));
+        if (!nv)
+            return -1;
+        s->v = nv;
+        s->cap = cap;
+    }
+    s->v[s->n++] = v;
+    return 0;
+}
+
+/* ─── Minimal JSON reader (our own reports only need numbers and objects) ─── */
+
+typedef enum { J_NULL, J_BOOL, J_NUM, J_STR, J_ARR, J_OBJ } jtype_t;
+
+typedef struct jval {
+    jtype_t       type;
+    double        num;
+    char         *str;
+    struct jval  *items;
+    char        **keys;
+    size_t        n;
+} jval_t;
+
+typedef struct {
+    const char *p, *end;
+    int         err;
+} jparser_t;
+
+static void jfree(jval_t *v)
+{
+    for (size_t i = 0; i < v->n; i++) {
+        jfree(&v->items[i]);
+        if (v->keys)
+            free(v->keys[i]);
+    }
+    free(v->items);
+    free(v->keys);
+    free(v->str);
+}
+
+static void jskip(jparser_t *j)
+{
+    while (j->p < j->end && isspace((unsigned char)*j->p))
+        j->p++;
+}
+
+static char *jstring(jparser_t *j)
+{
+    size_t cap = 32, n = 0;
+    char *s = malloc(cap);
+
+    if (!s || j->p >= j->end || *j->p != '"')
+        goto fail;
+    j->p++;
+    while (j->p < j->end && *j->p != '"') {
+        char c = *j->p++;
+        if (c == '\\' && j->p < j->end) {
+            c = *j->p++;
+            switch (c) {
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u':
+                /* Only ASCII escapes matter here; anything else becomes '?' */
+                if (j->end - j->p < 4)
+                    goto fail;
+                {
+                    char hex[5] = { j->p[0], j->p[1], j->p[2], j->p[3], 0 };
+                    unsigned long cp = strtoul(hex, NULL, 16);
+                    c = cp < 0x80 ? (char)cp : '?';
+                }
+                j->p += 4;
+                break;
+            default: break;     /* \" \\ \/ */
+            }
+        }
+        if (n + 2 > cap) {
+            char *ns = realloc(s, cap *= 2);
+            if (!ns)
+                goto fail;
+            s = ns;
+        }
+        s[n++] = c;
+    }
+    if (j->p >= j->end)
+        goto fail;
+    j->p++;
+    s[n] = '\0';
+    return s;
+fail:
+    free(s);
+    j->err = 1;
+    return NULL;
+}
+
+static void jparse(jparser_t *j, jval_t *v, int depth)
+{
+    memset(v, 0, sizeof(*v));
+    jskip(j);
+    if (j->p >= j->end || depth > CMP_JSON_DEPTH) {
+        j->err = 1;
+        return;
+    }
+    if (*j->p == '{' || *j->p == '[') {
+        int obj = *j->p == '{';
+        size_t cap = 0;
+        char close = obj ? '}' : ']';
+
+        v->type = obj ? J_OBJ : J_ARR;
+        j->p++;
+        jskip(j);
+        if (j->p < j->end && *j->p == close) {
+            j->p++;
+            return;
+        }
+        while (!j->err) {
+            char *key = NULL;
+            if (obj) {
+                jskip(j);
+                key = jstring(j);
+                jskip(j);
+                if (j->err || j->p >= j->end || *j->p != ':') {
+                    free(key);
+                    j->err = 1;
+                    return;
+                }
+                j->p++;
+            }
+            if (v->n == cap) {
+                jval_t *ni;
+                cap = cap ? cap * 2 : 8;
+                ni = realloc(v->items, cap * sizeof(*ni));
+                if (ni)
+                    v->items = ni;
+                if (obj) {
+                    char **nk = realloc(v->keys, cap * sizeof(*nk));
+                    if (nk)
+                        v->keys = nk;
+                    if (!nk)
+                        ni = NULL;
+                }
+                if (!ni) {
+                    free(key);
+                    j->err = 1;
+                    return;
+                }
+            }
+            if (obj)
+                v->keys[v->n] = key;
+            jparse(j, &v->items[v->n++], depth + 1);
+            jskip(j);
+            if (j->p < j->end && *j->p == ',') {
+                j->p++;
+                continue;
+            }
+            if (j->p < j->end && *j->p == close) {
+                j->p++;
+                return;
+            }
+            j->err = 1;
+        }
+        return;
+    }
+    if (*j->p == '"') {
+        v->type = J_STR;
+        v->str = jstring(j);
+        return;
+    }
+    if (j->end - j->p >= 4 && strncmp(j->p, "null", 4) == 0) {
+        v->type = J_NULL;
+        j->p += 4;
+        return;
+    }
+    if (j->end - j->p >= 4 && strncmp(j->p, "true", 4) == 0) {
+        v->type = J_BOOL;
+        v->num = 1;
+        j->p += 4;
+        return;
+    }
+    if (j->end - j->p >= 5 && strncmp(j->p, "false", 5) == 0) {
+        v->type = J_BOOL;
+        j->p += 5;
+        return;
+    }
+    {
+        char *e;
+        v->type = J_NUM;
+        v->num = strtod(j->p, &e);
+        if (e == j->p)
+            j->err = 1;
+        j->p = e;
+    }
+}
+
+static const jval_t *jget(const jval_t *o, const char *key)
+{
+    if (!o || o->type != J_OBJ)
+        return NULL;
+    for (size_t i = 0; i < o->n; i++) {
+        if (strcmp(o->keys[i], key) == 0)
+            return &o->items[i];
+    }
+    return NULL;
+}
+
+static double jnum(const jval_t *o, const char *key)
+{
+    const jval_t *v = jget(o, key);
+    return v && v->type == J_NUM ? v->num : NAN;
+}
+
+/* One run: a "run" report root, or an element of a bench report's "Runs". */
+static int add_run(pm_cmp_set_t *s, const jval_t *run)
+{
+    const jval_t *sum = jget(run, "Summary"), *lim = jget(sum, "LimitResidencyPct");
+    const jval_t *cls = jget(sum, "LimiterPct");
+    double power = jnum(sum, "PowerAvgW"), score = jnum(run, "Score");
+    int rc = 0;
+
+    if (!sum)
+        return -1;
+    rc |= samples_push(&s->m[PM_CMP_ELAPSED], jnum(run, "ElapsedS"));
+    rc |= samples_push(&s->m[PM_CMP_ENERGY], jnum(sum, "EnergyJ"));
+    rc |= samples_push(&s->m[PM_CMP_POWER], power);
+    rc |= samples_push(&s->m[PM_CMP_POWER_PEAK], jnum(sum, "PowerPeakW"));
+    rc |= samples_push(&s->m[PM_CMP_CLOCK], jnum(sum, "ClockAvgMHz"));
+    rc |= samples_push(&s->m[PM_CMP_CLOCK_PEAK], jnum(sum, "ClockPeakMHz"));
+    rc |= samples_push(&s->m[PM_CMP_TEMP], jnum(sum, "TempAvgC"));
+    rc |= samples_push(&s->m[PM_CMP_TEMP_PEAK], jnum(sum, "TempPeakC"));
+    for (int l = 0; l < PM_LIM_COUNT; l++)
+        rc |= samples_push(&s->m[PM_CMP_PPT + l], jnum(lim, pm_limit_name((pm_limit_id)l)));
+    rc |= samples_push(&s->m[PM_CMP_CEILING], jnum(cls, pm_limiter_class_name(PM_LIM_NONE)));
+    rc |= samples_push(&s->m[PM_CMP_SCORE], score);
+    rc |= samples_push(&s->m[PM_CMP_SCORE_PER_W], power > 0 ? score / power : NAN);
+    return rc;
+}
+
+static int load_report(pm_cmp_set_t *s, const char *path, const char *text, size_t len,
+                       char *err, size_t errlen)
+{
+    jparser_t j = { text, text + len, 0 };
+    const jval_t *runs;
+    jval_t root;
+    int rc = 0, n = 0;
+
+    jparse(&j, &root, 0);
+    if (j.err || root.type != J_OBJ) {
+        snprintf(err, errlen, "%s: not valid JSON", path);
+        jfree(&root);
+        return -1;
+    }
+    runs = jget(&root, "Runs");
+    if (runs && runs->type == J_ARR) {
+        for (size_t i = 0; i < runs->n && rc == 0; i++) {
+            const jval_t *w = jget(&runs->items[i], "Warmup");
+            if (w && w->type == J_BOOL && w->num)
+                continue;
+            rc = add_run(s, &runs->items[i]);
+            n++;
+        }
+    } else if (jget(&root, "Summary")) {
+        rc = add_run(s, &root);
+        n = 1;
+    } else {
+        snprintf(err, errlen, "%s: not a run or bench report", path);
+        rc = -1;
+    }
+    if (rc == 0 && n == 0) {
+        snprintf(err, errlen, "%s: report has no measured runs", path);
+        rc = -1;
+    } else if (rc != 0 && !err[0]) {
+        snprintf(err, errlen, "%s: malformed run entry", path);
+    }
+    jfree(&root);
+    return rc;
+}
+
+/* ─── Capture CSV: parsed in parallel byte ranges ─── */
+
+typedef struct {
+    int     ncols;
+    int     power, thm;                     /* column indices, -1 if absent */
+    int     power_field;
+    int     lim_val[PM_LIM_COUNT], lim_max[PM_LIM_COUNT];
+    int     freq[CMP_MAX_CORES], c0[CMP_MAX_CORES], temp[CMP_MAX_CORES];
+    int     nfreq, nc0, ntemp;
+    float   scale[PMF_COUNT];
+    unsigned char *need;                    /* per column: parsed at all */
+} csv_map_t;
+
+typedef struct {
+    const csv_map_t  *map;
+    const char       *start, *end;
+    pm_cmp_samples_t  m[PM_CMP_COUNT];
+    int               err;
+} csv_chunk_t;
+
+static int csv_field_col(const char *name, int *index)
+{
+    char base[48];
+    const char *br = strchr(name, '[');
+    size_t n = br ? (size_t)(br - name) : strlen(name);
+
+    if (n >= sizeof(base))
+        return -1;
+    memcpy(base, name, n);
+    base[n] = '\0';
+    *index = br ? atoi(br + 1) : 0;
+    return pm_field_by_name(base);
+}
+
+static void csv_mark(csv_map_t *map, int col)
+{
+    if (col >= 0)
+        map->need[col] = 1;
+}
+
+static int csv_map_header(csv_map_t *map, const char *line, const char *eol,
+                          const pm_schema_t *sch)
+{
+    int col = 0, socket = -1, ppt = -1;
+
+    memset(map, 0, sizeof(*map));
+    map->power = map->thm = -1;
+    for (int l = 0; l < PM_LIM_COUNT; l++)
+        map->lim_val[l] = map->lim_max[l] = -1;
+    for (int f = 0; f < PMF_COUNT; f++)
+        map->scale[f] = sch ? sch->loc[f].scale : 1.0f;
+
+    while (line < eol) {
+        char name[64];
+        const char *comma = memchr(line, ',', (size_t)(eol - line));
+        size_t n = (size_t)((comma ? comma : eol) - line);
+        int f, idx = -1;
+
+        if (n >= sizeof(name))
+            n = sizeof(name) - 1;
+        memcpy(name, line, n);
+        name[n] = '\0';
+        name[strcspn(name, "\r")] = '\0';
+        f = col > 0 ? csv_field_col(name, &idx) : -1;
+
+        if (f == PMF_SOCKET_POWER)
+            socket = col;
+        else if (f == PMF_PPT_VALUE)
+            ppt = col;
+        if (f == PMF_THM_VALUE)
+            map->thm = col;
+        for (int l = 0; l < PM_LIM_COUNT && f >= 0; l++) {
+            if (f == pm_limit_value_field((pm_limit_id)l))
+                map->lim_val[l] = col;
+            if (f == pm_limit_limit_field((pm_limit_id)l))
+                map->lim_max[l] = col;
+        }
+        if (f == PMF_CORE_FREQEFF && idx >= 0 && idx < CMP_MAX_CORES && idx == map->nfreq)
+            map->freq[map->nfreq++] = col;
+        if (f == PMF_CORE_C0 && idx >= 0 && idx < CMP_MAX_CORES && idx == map->nc0)
+            map->c0[map->nc0++] = col;
+        if (f == PMF_CORE_TEMP && idx >= 0 && idx < CMP_MAX_CORES && idx == map->ntemp)
+            map->temp[map->ntemp++] = col;
+
+        col++;
+        if (!comma)
+            break;
+        line = comma + 1;
+    }
+    map->ncols = col;
+    map->power = socket >= 0 ? socket : ppt;
+    map->power_field = socket >= 0 ? PMF_SOCKET_POWER : PMF_PPT_VALUE;
+
+    /* Most columns are never looked at; rows skip them without converting */
+    map->need = calloc((size_t)map->ncols, 1);
+    if (!map->need)
+        return -1;
+    csv_mark(map, map->power);
+    csv_mark(map, map->thm);
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        csv_mark(map, map->lim_val[l]);
+        csv_mark(map, map->lim_max[l]);
+    }
+    for (int c = 0; c < map->nfreq; c++)
+        csv_mark(map, map->freq[c]);
+    for (int c = 0; c < map->nc0; c++)
+        csv_mark(map, map->c0[c]);
+    for (int c = 0; c < map->ntemp; c++)
+        csv_mark(map, map->temp[c]);
+    return 0;
+}
+
+static void csv_row(const csv_map_t *map, const double *v, pm_cmp_samples_t *m, int *err)
+{
+    const float *sc = map->scale;
+    int rc = 0, have_lim = 0, engaged = 0, loaded = 0;
+
+    if (map->power >= 0)
+        rc |= samples_push(&m[PM_CMP_POWER], v[map->power] * sc[map->power_field]);
+    if (map->thm >= 0)
+        rc |= samples_push(&m[PM_CMP_TEMP], v[map->thm] * sc[PMF_THM_VALUE]);
+    if (map->nfreq) {
+        double sum = 0, peak = 0;
+        int active = 0;
+        for (int c = 0; c < map->nfreq; c++) {
+            double f = v[map->freq[c]] * sc[PMF_CORE_FREQEFF];
+            if (f > peak)
+                peak = f;
+            if (c < map->nc0 && v[map->c0[c]] * sc[PMF_CORE_C0] < PM_ACTIVE_C0_PCT)
+                continue;
+            sum += f;
+            active++;
+        }
+        rc |= samples_push(&m[PM_CMP_CLOCK_PEAK], peak);
+        if (active)
+            rc |= samples_push(&m[PM_CMP_CLOCK], sum / active);
+    }
+    if (map->ntemp) {
+        double peak = -INFINITY;
+        for (int c = 0; c < map->ntemp; c++) {
+            double t = v[map->temp[c]] * sc[PMF_CORE_TEMP];
+            if (t > peak)
+                peak = t;
+        }
+        rc |= samples_push(&m[PM_CMP_CORE_TEMP], peak);
+    }
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        int vf = pm_limit_value_field((pm_limit_id)l), lf = pm_limit_limit_field((pm_limit_id)l);
+        int on;
+
+        if (map->lim_val[l] < 0 || (lf >= 0 && map->lim_max[l] < 0))
+            continue;
+        on = pm_limit_engaged((pm_limit_id)l, (float)(v[map->lim_val[l]] * sc[vf]),
+                              lf >= 0 ? (float)(v[map->lim_max[l]] * sc[lf]) : NAN);
+        rc |= samples_push(&m[PM_CMP_PPT + l], on ? 100.0 : 0.0);
+        have_lim = 1;
+        engaged |= on;
+    }
+    /* Boost ceiling: loaded with no limiter engaged (see pm_limiter.h); an
+     * unknown load does not count as the ceiling */
+    for (int c = 0; c < map->nc0 && !loaded; c++)
+        loaded = v[map->c0[c]] * sc[PMF_CORE_C0] >= PM_LOAD_C0_PCT;
+    if (!map->nc0 && map->lim_val[PM_LIM_PPT] >= 0 && map->lim_max[PM_LIM_PPT] >= 0)
+        loaded = pm_load_from_ppt((float)(v[map->lim_val[PM_LIM_PPT]] * sc[PMF_PPT_VALUE]),
+                                  (float)(v[map->lim_max[PM_LIM_PPT]] * sc[PMF_PPT_LIMIT])) > 0;
+    if (have_lim)
+        rc |= samples_push(&m[PM_CMP_CEILING], !engaged && loaded ? 100.0 : 0.0);
+    if (rc)
+        *err = 1;
+}
+
+static void *csv_worker(void *arg)
+{
+    csv_chunk_t *ch = arg;
+    const csv_map_t *map = ch->map;
+    double *v = malloc((size_t)map->ncols * sizeof(*v));
+    const char *p = ch->start;
+
+    if (!v) {
+        ch->err = 1;
+        return NULL;
+    }
+    while (p < ch->end && !ch->err) {
+        const char *eol = memchr(p, '\n', (size_t)(ch->end - p));
+        if (!eol)
+            eol = ch->end;
+        if (*p != '#' && eol > p) {
+            const char *q = p;
+            for (int c = 0; c < map->ncols; c++) {
+                char *e;
+                if (!map->need[c]) {
+                    const char *comma = memchr(q, ',', (size_t)(eol - q));
+                    q = comma ? comma + 1 : eol;
+                    continue;
+                }
+                /* strtod would skip a newline, so empty fields are handled first */
+                if (q >= eol || *q == ',' || *q == '\r') {
+                    v[c] = NAN;
+                } else {
+                    v[c] = strtod(q, &e);
+                    if (e == q || e > eol)
+                        v[c] = NAN;
+                    else
+                        q = e;
+                }
+                while (q < eol && *q != ',')
+                    q++;
+                if (q < eol)
+                    q++;
+            }
+            csv_row(map, v, ch->m, &ch->err);
+        }
+        p = eol + 1;
+    }
+    free(v);
+    return NULL;
+}
+
+/* Per-row metrics a capture reduces by maximum; the rest by mean. */
+static int capture_peak(int m)
+{
+    return m == PM_CMP_CLOCK_PEAK || m == PM_CMP_CORE_TEMP;
+}
+
+static int load_capture(pm_cmp_set_t *s, const char *path, const char *text, size_t len,
+                        unsigned int threads, char *err, size_t errlen)
+{
+    const char *p = text, *end = text + len, *hdr, *hdr_eol, *data;
+    const pm_schema_t *sch = NULL;
+    unsigned int version = 0;
+    csv_chunk_t *ch;
+    pthread_t *tids;
+    unsigned char *spawned;
+    csv_map_t map;
+    int rc = 0;
+
+    /* '#' preamble; the capture writer records "PM table 0x......" */
+    while (p < end && *p == '#') {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        const char *v = memmem(p, (size_t)((eol ? eol : end) - p), "PM table 0x", 11);
+        if (v)
+            version = (unsigned int)strtoul(v + 9, NULL, 16);
+        p = eol ? eol + 1 : end;
+    }
+    hdr = p;
+    hdr_eol = memchr(hdr, '\n', (size_t)(end - hdr));
+    if (!hdr_eol || strncmp(hdr, "t_ms,", 5) != 0) {
+        snprintf(err, errlen, "%s: not a PM capture CSV (no t_ms header)", path);
+        return -1;
+    }
+    if (version)
+        sch = pm_schema_lookup(version, UINT_MAX);
+    if (!sch)
+        fprintf(stderr, "compare: %s: layout unknown, values taken unscaled.\n", path);
+    if (csv_map_header(&map, hdr, hdr_eol, sch) != 0) {
+        snprintf(err, errlen, "%s: out of memory", path);
+        return -1;
+    }
+    if (map.power < 0 && map.thm < 0 && map.nfreq == 0) {
+        snprintf(err, errlen, "%s: no named power, temperature or clock columns", path);
+        free(map.need);
+        return -1;
+    }
+    data = hdr_eol + 1;
+
+    if (threads < 1)
+        threads = 1;
+    if ((size_t)(end - data) < (size_t)threads * 65536)
+        threads = (unsigned int)((end - data) / 65536) + 1;
+    ch = calloc(threads, sizeof(*ch));
+    tids = calloc(threads, sizeof(*tids));
+    spawned = calloc(threads, 1);
+    if (!ch || !tids || !spawned) {
+        free(ch);
+        free(tids);
+        free(spawned);
+        free(map.need);
+        snprintf(err, errlen, "%s: out of memory", path);
+        return -1;
+    }
+
+    /* Chunks own the rows that start inside them */
+    for (unsigned int t = 0; t < threads; t++) {
+        const char *a = data + (size_t)(end - data) * t / threads;
+        const char *b = data + (size_t)(end - data) * (t + 1) / threads;
+        if (t > 0) {
+            const char *nl = memchr(a - 1, '\n', (size_t)(end - (a - 1)));
+            a = nl ? nl + 1 : end;
+        }
+        if (t + 1 < threads) {
+            const char *nl = memchr(b - 1, '\n', (size_t)(end - (b - 1)));
+            b = nl ? nl + 1 : end;
+        }
+        ch[t].map = &map;
+        ch[t].start = a;
+        ch[t].end = b > a ? b : a;
+    }
+    for (unsigned int t = 1; t < threads; t++)
+        spawned[t] = pthread_create(&tids[t], NULL, csv_worker, &ch[t]) == 0;
+    csv_worker(&ch[0]);
+    for (unsigned int t = 1; t < threads; t++) {
+        if (spawned[t])
+            pthread_join(tids[t], NULL);
+        else
+            csv_worker(&ch[t]);
+    }
+
+    /* Rows of one capture are one autocorrelated series, not independent
+     * samples: the file contributes a single per-run value per metric */
+    for (int m = 0; m < PM_CMP_COUNT; m++) {
+        double sum = 0, peak = -INFINITY;
+        size_t n = 0;
+
+        for (unsigned int t = 0; t < threads; t++) {
+            for (size_t i = 0; i < ch[t].m[m].n; i++) {
+                sum += ch[t].m[m].v[i];
+                if (ch[t].m[m].v[i] > peak)
+                    peak = ch[t].m[m].v[i];
+            }
+            n += ch[t].m[m].n;
+        }
+        if (n && rc == 0 && samples_push(&s->m[m], capture_peak(m) ? peak : sum / n) != 0)
+            rc = -1;
+        if (n && rc == 0 && m == PM_CMP_POWER)
+            rc = samples_push(&s->m[PM_CMP_POWER_PEAK], peak);
+        if (n && rc == 0 && m == PM_CMP_TEMP)
+            rc = samples_push(&s->m[PM_CMP_TEMP_PEAK], peak);
+    }
+    for (unsigned int t = 0; t < threads; t++) {
+        if (ch[t].err)
+            rc = -1;
+        for (int m = 0; m < PM_CMP_COUNT; m++)
+            free(ch[t].m[m].v);
+    }
+    if (rc)
+        snprintf(err, errlen, "%s: out of memory", path);
+    free(ch);
+    free(tids);
+    free(spawned);
+    free(map.need);
+    return rc;
+}
+
+int pm_cmp_load(pm_cmp_set_t *s, const char *path, unsigned int threads,
+                char *err, size_t errlen)
+{
+    pm_cmp_source kind;
+    struct stat st;
+    const char *text;
+    size_t len;
+    int fd, rc;
+
+    err[0] = '\0';
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        snprintf(err, errlen, "%s: %s", path, fd < 0 ? strerror(errno) : "empty file");
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    len = (size_t)st.st_size;
+    text = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        snprintf(err, errlen, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+    madvise((void *)text, len, MADV_SEQUENTIAL);
+
+    {
+        const char *q = text;
+        while (q < text + len && isspace((unsigned char)*q))
+            q++;
+        kind = q < text + len && *q == '{' ? PM_CMP_SRC_SUMMARY : PM_CMP_SRC_CAPTURE;
+    }
+    if (s->source != PM_CMP_SRC_NONE && s->source != kind) {
+        snprintf(err, errlen, "%s: cannot mix run reports and captures on one side", path);
+        munmap((void *)text, len);
+        return -1;
+    }
+    rc = kind == PM_CMP_SRC_SUMMARY ? load_report(s, path, text, len, err, errlen)
+                                    : load_capture(s, path, text, len, threads, err, errlen);
+    munmap((void *)text, len);
+    if (rc == 0) {
+        s->source = kind;
+        s->files++;
+    }
+    return rc;
+}
+
+/* ─── Comparison ─── */
+
+typedef struct {
+    const pm_cmp_set_t  *a, *b;
+    const pm_cmp_opts_t *o;
+    pm_cmp_result_t     *out;
+    int                  next;      /* metric queue, atomically advanced */
+} cmp_job_t;
+
+static double mean_of(const double *v, size_t n)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += v[i];
+    return n ? sum / n : NAN;
+}
+
+static void cmp_metric(const cmp_job_t *job, int m)
+{
+    const pm_cmp_samples_t *sa = &job->a->m[m], *sb = &job->b->m[m];
+    const pm_cmp_opts_t *o = job->o;
+    pm_cmp_result_t *r = &job->out[m];
+    int small = sa->n + sb->n <= CMP_BOOTSTRAP_MAX;
+    int boot_p = o->test == PM_CMP_TEST_BOOTSTRAP || (o->test == PM_CMP_TEST_AUTO && small);
+    double bp = NAN;
+
+    memset(r, 0, sizeof(*r));
+    r->na = sa->n;
+    r->nb = sb->n;
+    r->mean_a = mean_of(sa->v, sa->n);
+    r->mean_b = mean_of(sb->v, sb->n);
+    r->delta = r->mean_b - r->mean_a;
+    r->delta_pct = r->mean_a != 0 ? 100.0 * r->delta / fabs(r->mean_a) : NAN;
+    r->ci_lo = r->ci_hi = r->p = r->u = NAN;
+    if (sa->n == 0 || sb->n == 0)
+        return;
+
+    if (!boot_p) {
+        r->p = pm_stats_mann_whitney(sa->v, sa->n, sb->v, sb->n, &r->u);
+        r->test = "mann-whitney";
+    }
+    if (small || o->test == PM_CMP_TEST_BOOTSTRAP) {
+        pm_stats_bootstrap_delta(sa->v, sa->n, sb->v, sb->n, o->resamples,
+                                 o->seed + (unsigned long long)m * 0x9E37ULL,
+                                 &r->ci_lo, &r->ci_hi, &bp);
+        r->ci = "bootstrap";
+    } else {
+        pm_stats_welch_delta(sa->v, sa->n, sb->v, sb->n, &r->ci_lo, &r->ci_hi);
+        r->ci = "welch";
+    }
+    if (boot_p) {
+        r->p = bp;
+        r->test = "bootstrap";
+    }
+    if (sa->n < 2 || sb->n < 2)
+        r->p = NAN;
+    r->significant = !isnan(r->p) && r->p < o->alpha;
+}
+
+static void *cmp_worker(void *arg)
+{
+    cmp_job_t *job = arg;
+    int m;
+
+    while ((m = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < PM_CMP_COUNT)
+        cmp_metric(job, m);
+    return NULL;
+}
+
+void pm_cmp_run(const pm_cmp_set_t *a, const pm_cmp_set_t *b, const pm_cmp_opts_t *o,
+                pm_cmp_result_t out[PM_CMP_COUNT])
+{
+    cmp_job_t job = { a, b, o, out, 0 };
+    unsigned int threads = o->threads < 1 ? 1 : o->threads;
+    pthread_t tids[PM_CMP_COUNT];
+    int spawned[PM_CMP_COUNT] = { 0 };
+
+    if (threads > PM_CMP_COUNT)
+        threads = PM_CMP_COUNT;
+    for (unsigned int t = 1; t < threads; t++)
+        spawned[t] = pthread_create(&tids[t], NULL, cmp_worker, &job) == 0;
+    cmp_worker(&job);
+    for (unsigned int t = 1; t < threads; t++) {
+        if (spawned[t])
+            pthread_join(tids[t], NULL);
+    }
+}
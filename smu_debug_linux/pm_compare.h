@@ -0,0 +1,81 @@
+/*
+ * A/B comparison of telemetry from this tool.
+ *
+ * Each side is a set of inputs: run/bench JSON reports (one sample per
+ * run) or PM capture CSVs (one sample per file: the mean of its rows, the
+ * maximum for peaks; rows of one capture are not independent). Per metric,
+ * the sides are compared by mean delta with a confidence interval and a
+ * two-sample test (Mann-Whitney U or bootstrap). Large captures are parsed
+ * in parallel chunks; metrics are tested in parallel.
+ */
+#ifndef PM_COMPARE_H
+#define PM_COMPARE_H
+
+#include <stddef.h>
+
+typedef enum {
+    PM_CMP_ELAPSED, PM_CMP_ENERGY, PM_CMP_POWER, PM_CMP_POWER_PEAK,
+    PM_CMP_CLOCK, PM_CMP_CLOCK_PEAK, PM_CMP_TEMP, PM_CMP_TEMP_PEAK, PM_CMP_CORE_TEMP,
+    PM_CMP_PPT, PM_CMP_TDC, PM_CMP_EDC, PM_CMP_THM, PM_CMP_FIT, PM_CMP_PROCHOT,
+    PM_CMP_CEILING,
+    PM_CMP_SCORE, PM_CMP_SCORE_PER_W,
+    PM_CMP_COUNT
+} pm_cmp_metric;
+
+typedef enum {
+    PM_CMP_SRC_NONE, PM_CMP_SRC_SUMMARY, PM_CMP_SRC_CAPTURE
+} pm_cmp_source;
+
+typedef struct {
+    double *v;
+    size_t  n, cap;
+} pm_cmp_samples_t;
+
+typedef struct {
+    pm_cmp_source    source;
+    unsigned int     files;
+    pm_cmp_samples_t m[PM_CMP_COUNT];
+} pm_cmp_set_t;
+
+void pm_cmp_set_init(pm_cmp_set_t *s);
+void pm_cmp_set_free(pm_cmp_set_t *s);
+
+/* Add a run/bench JSON report or a capture CSV to s. 0, or -1 with err set.
+ * A set holds one kind of input only. */
+int pm_cmp_load(pm_cmp_set_t *s, const char *path, unsigned int threads,
+                char *err, size_t errlen);
+
+typedef enum {
+    PM_CMP_TEST_AUTO,           /* bootstrap for small sets, Mann-Whitney for large */
+    PM_CMP_TEST_MW,
+    PM_CMP_TEST_BOOTSTRAP
+} pm_cmp_test;
+
+typedef struct {
+    pm_cmp_test         test;
+    unsigned int        resamples;
+    double              alpha;
+    unsigned int        threads;
+    unsigned long long  seed;
+} pm_cmp_opts_t;
+
+typedef struct {
+    size_t      na, nb;
+    double      mean_a, mean_b, delta, delta_pct;
+    double      ci_lo, ci_hi;       /* 95% interval of delta */
+    double      p;
+    double      u;                  /* Mann-Whitney U of side A, NAN if not run */
+    const char *test;               /* "mann-whitney" / "bootstrap" */
+    const char *ci;                 /* "bootstrap" / "welch" */
+    int         significant;        /* p < alpha */
+} pm_cmp_result_t;
+
+void pm_cmp_run(const pm_cmp_set_t *a, const pm_cmp_set_t *b, const pm_cmp_opts_t *o,
+                pm_cmp_result_t out[PM_CMP_COUNT]);
+
+const char *pm_cmp_metric_key(pm_cmp_metric m);     /* JSON key, "ClockAvgMHz" */
+const char *pm_cmp_metric_label(pm_cmp_metric m);   /* table label */
+/* +1 higher is better, -1 lower is better, 0 neither */
+int pm_cmp_metric_sense(pm_cmp_metric m);
+
+#endif
@@ -0,0 +1,667 @@
+/*
+ * Derived PM metrics (see pm_expr.h).
+ *
+ * The compiler is a recursive-descent parser that emits bytecode directly
+ * and tracks, per stack slot, whether the value is scalar or per-core. The
+ * evaluator keeps the same flag at run time so scalar-only programs touch a
+ * single lane, and mixed operations broadcast the scalar side.
+ */
+
+#include <math.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "pm_expr.h"
+
+#define MAX_STACK   32
+#define MAX_NAME    32
+
+enum {
+    OP_CONST,       /* k */
+    OP_LOAD,        /* a = float index, k = scale */
+    OP_LOAD_CORE,   /* a = base index, b = stride (floats), n = count, k = scale */
+    OP_METRIC,      /* a = metric, whole value */
+    OP_METRIC_AT,   /* a = metric, b = element */
+    OP_LANE,        /* core index */
+    OP_NEG, OP_NOT, OP_ABS, OP_SQRT,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV,
+    OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE, OP_AND, OP_OR,
+    OP_MIN, OP_MAX,
+    OP_SELECT,      /* c ? a : b */
+    OP_CLAMP,
+    OP_RSUM, OP_RAVG, OP_RMIN, OP_RMAX,
+};
+
+typedef struct {
+    unsigned char  op;
+    unsigned char  n;
+    unsigned short a;
+    unsigned int   b;
+    float          k;
+} insn_t;
+
+typedef struct {
+    char          name[MAX_NAME];
+    insn_t       *code;
+    unsigned int  ncode;
+    unsigned int  width;
+    float        *val;          /* PM_EXPR_LANES floats */
+} metric_t;
+
+struct pm_expr_set {
+    const pm_schema_t *schema;
+    unsigned int       nidx;
+    unsigned int       lanes;
+    metric_t          *m;
+    unsigned int       count, cap;
+};
+
+/* ─── Compiler ─── */
+
+typedef struct {
+    const pm_expr_set_t *set;
+    const char *src, *p;
+    insn_t     *code;
+    unsigned int ncode, cap;
+    unsigned char vec[MAX_STACK];   /* static per-slot shape */
+    int         depth;
+    char       *err;
+    size_t      errlen;
+    int         failed;
+} cc_t;
+
+static void cc_error(cc_t *c, const char *msg)
+{
+    if (!c->failed)
+        snprintf(c->err, c->errlen, "%s at column %d", msg, (int)(c->p - c->src) + 1);
+    c->failed = 1;
+}
+
+static void skip_ws(cc_t *c)
+{
+    while (isspace((unsigned char)*c->p))
+        c->p++;
+}
+
+static int accept(cc_t *c, const char *tok)
+{
+    size_t n = strlen(tok);
+
+    skip_ws(c);
+    if (strncmp(c->p, tok, n) != 0)
+        return 0;
+    /* '<' must not swallow "<=", '!' not "!=", etc. */
+    if (n == 1 && strchr("<>!=", tok[0]) && c->p[1] == '=')
+        return 0;
+    c->p += n;
+    return 1;
+}
+
+static void expect(cc_t *c, const char *tok)
+{
+    if (!accept(c, tok)) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "expected '%s'", tok);
+        cc_error(c, msg);
+    }
+}
+
+static int ident(cc_t *c, char *out, size_t len)
+{
+    size_t n = 0;
+
+    skip_ws(c);
+    if (!isalpha((unsigned char)*c->p) && *c->p != '_')
+        return 0;
+    while ((isalnum((unsigned char)*c->p) || *c->p == '_') && n + 1 < len)
+        out[n++] = *c->p++;
+    out[n] = '\0';
+    return 1;
+}
+
+/* Emit and update the static stack shape: pops, then pushes one slot. */
+static void emit(cc_t *c, unsigned char op, int pops, unsigned a, unsigned b,
+                 unsigned char n, float k, int vec_out)
+{
+    int vec = vec_out;
+
+    if (c->failed)
+        return;
+    for (int i = 0; i < pops; i++)
+        vec |= c->vec[c->depth - 1 - i];
+    if (vec_out < 0)                                    /* reduction: scalar result */
+        vec = 0;
+    c->depth -= pops;
+    if (c->depth >= MAX_STACK) {
+        cc_error(c, "expression too deep");
+        return;
+    }
+    c->vec[c->depth++] = (unsigned char)vec;
+
+    if (c->ncode == c->cap) {
+        unsigned int cap = c->cap ? c->cap * 2 : 16;
+        insn_t *nc = realloc(c->code, cap * sizeof(*nc));
+        if (!nc) {
+            cc_error(c, "out of memory");
+            return;
+        }
+        c->code = nc;
+        c->cap = cap;
+    }
+    c->code[c->ncode++] = (insn_t){ op, n, (unsigned short)a, b, k };
+}
+
+static void parse_expr(cc_t *c);
+
+/* "[k]" -> k, "[i]" -> -1, no bracket -> -2 */
+static long parse_subscript(cc_t *c)
+{
+    char *end;
+    long k;
+
+    if (!accept(c, "["))
+        return -2;
+    if (accept(c, "i")) {
+        expect(c, "]");
+        return -1;
+    }
+    skip_ws(c);
+    k = strtol(c->p, &end, 0);
+    if (end == c->p || k < 0) {
+        cc_error(c, "expected index");
+        return 0;
+    }
+    c->p = end;
+    expect(c, "]");
+    return k;
+}
+
+static void parse_call(cc_t *c, const char *fn)
+{
+    int nargs = 0;
+
+    if (!accept(c, ")")) {
+        do {
+            parse_expr(c);
+            nargs++;
+        } while (!c->failed && accept(c, ","));
+        expect(c, ")");
+    }
+    if (c->failed)
+        return;
+
+#define FN(name, argc) (strcasecmp(fn, name) == 0 && nargs == (argc))
+    if (FN("min", 2))        emit(c, OP_MIN, 2, 0, 0, 0, 0, 0);
+    else if (FN("max", 2))   emit(c, OP_MAX, 2, 0, 0, 0, 0, 0);
+    else if (FN("min", 1))   emit(c, OP_RMIN, 1, 0, 0, 0, 0, -1);
+    else if (FN("max", 1))   emit(c, OP_RMAX, 1, 0, 0, 0, 0, -1);
+    else if (FN("sum", 1))   emit(c, OP_RSUM, 1, 0, 0, 0, 0, -1);
+    else if (FN("avg", 1))   emit(c, OP_RAVG, 1, 0, 0, 0, 0, -1);
+    else if (FN("abs", 1))   emit(c, OP_ABS, 1, 0, 0, 0, 0, 0);
+    else if (FN("sqrt", 1))  emit(c, OP_SQRT, 1, 0, 0, 0, 0, 0);
+    else if (FN("clamp", 3)) emit(c, OP_CLAMP, 3, 0, 0, 0, 0, 0);
+    else cc_error(c, "unknown function or wrong argument count");
+#undef FN
+}
+
+static void parse_primary(cc_t *c)
+{
+    char name[48], *end;
+    double v;
+    long sub;
+    int f, m;
+
+    if (accept(c, "(")) {
+        parse_expr(c);
+        expect(c, ")");
+        return;
+    }
+
+    skip_ws(c);
+    v = strtod(c->p, &end);
+    if (end != c->p && (isdigit((unsigned char)*c->p) || *c->p == '.')) {
+        c->p = end;
+        emit(c, OP_CONST, 0, 0, 0, 0, (float)v, 0);
+        return;
+    }
+
+    if (!ident(c, name, sizeof(name))) {
+        cc_error(c, "expected value");
+        return;
+    }
+
+    if (accept(c, "(")) {
+        parse_call(c, name);
+        return;
+    }
+    if (strcmp(name, "i") == 0) {
+        emit(c, OP_LANE, 0, 0, 0, 0, 0, 1);
+        return;
+    }
+    if (strcmp(name, "ncores") == 0) {
+        emit(c, OP_CONST, 0, 0, 0, 0, (float)c->set->lanes, 0);
+        return;
+    }
+    if (strcmp(name, "pm") == 0) {
+        sub = parse_subscript(c);
+        if (sub < 0 || (unsigned long)sub >= c->set->nidx)
+            cc_error(c, "pm[] needs a constant index inside the table");
+        else
+            emit(c, OP_LOAD, 0, (unsigned)sub, 0, 0, 1.f, 0);
+        return;
+    }
+
+    m = pm_expr_find(c->set, name);
+    if (m >= 0) {
+        const metric_t *mt = &c->set->m[m];
+        sub = parse_subscript(c);
+        if (sub >= 0 && (unsigned long)sub >= mt->width)
+            cc_error(c, "metric index out of range");
+        else if (sub >= 0)
+            emit(c, OP_METRIC_AT, 0, (unsigned)m, (unsigned)sub, 0, 0, 0);
+        else
+            emit(c, OP_METRIC, 0, (unsigned)m, 0, 0, 0, mt->width > 1);
+        return;
+    }
+
+    f = pm_field_by_name(name);
+    if (f < 0) {
+        cc_error(c, "unknown name");
+        return;
+    }
+    if (!pm_has(c->set->schema, (pm_field_id)f)) {
+        cc_error(c, "field not in this PM table layout");
+        return;
+    }
+    {
+        const pm_field_loc_t *l = &c->set->schema->loc[f];
+        sub = parse_subscript(c);
+        if (sub >= 0 && (unsigned long)sub >= l->count)
+            cc_error(c, "field index out of range");
+        else if (sub >= 0 || l->count == 1)
+            emit(c, OP_LOAD, 0, (l->offset + (sub > 0 ? (unsigned)sub : 0u) * l->stride) / 4u,
+                 0, 0, l->scale, 0);
+        else
+            emit(c, OP_LOAD_CORE, 0, l->offset / 4u, l->stride / 4u, l->count, l->scale, 1);
+    }
+}
+
+static void parse_unary(cc_t *c)
+{
+    if (accept(c, "-")) {
+        parse_unary(c);
+        emit(c, OP_NEG, 1, 0, 0, 0, 0, 0);
+    } else if (accept(c, "!")) {
+        parse_unary(c);
+        emit(c, OP_NOT, 1, 0, 0, 0, 0, 0);
+    } else if (accept(c, "+")) {
+        parse_unary(c);
+    } else {
+        parse_primary(c);
+    }
+}
+
+static void parse_mul(cc_t *c)
+{
+    parse_unary(c);
+    while (!c->failed) {
+        if (accept(c, "*"))      { parse_unary(c); emit(c, OP_MUL, 2, 0, 0, 0, 0, 0); }
+        else if (accept(c, "/")) { parse_unary(c); emit(c, OP_DIV, 2, 0, 0, 0, 0, 0); }
+        else break;
+    }
+}
+
+static void parse_add(cc_t *c)
+{
+    parse_mul(c);
+    while (!c->failed) {
+        if (accept(c, "+"))      { parse_mul(c); emit(c, OP_ADD, 2, 0, 0, 0, 0, 0); }
+        else if (accept(c, "-")) { parse_mul(c); emit(c, OP_SUB, 2, 0, 0, 0, 0, 0); }
+        else break;
+    }
+}
+
+static void parse_cmp(cc_t *c)
+{
+    static const struct { const char *tok; unsigned char op; } ops[] = {
+        { "<=", OP_LE }, { ">=", OP_GE }, { "==", OP_EQ }, { "!=", OP_NE },
+        { "<", OP_LT },  { ">", OP_GT },
+    };
+
+    parse_add(c);
+    while (!c->failed) {
+        size_t k;
+        for (k = 0; k < sizeof(ops) / sizeof(ops[0]); k++) {
+            if (accept(c, ops[k].tok))
+                break;
+        }
+        if (k == sizeof(ops) / sizeof(ops[0]))
+            break;
+        parse_add(c);
+        emit(c, ops[k].op, 2, 0, 0, 0, 0, 0);
+    }
+}
+
+static void parse_and(cc_t *c)
+{
+    parse_cmp(c);
+    while (!c->failed && accept(c, "&&")) {
+        parse_cmp(c);
+        emit(c, OP_AND, 2, 0, 0, 0, 0, 0);
+    }
+}
+
+static void parse_or(cc_t *c)
+{
+    parse_and(c);
+    while (!c->failed && accept(c, "||")) {
+        parse_and(c);
+        emit(c, OP_OR, 2, 0, 0, 0, 0, 0);
+    }
+}
+
+static void parse_expr(cc_t *c)
+{
+    parse_or(c);
+    if (!c->failed && accept(c, "?")) {
+        parse_expr(c);
+        expect(c, ":");
+        parse_expr(c);
+        emit(c, OP_SELECT, 3, 0, 0, 0, 0, 0);
+    }
+}
+
+/* ─── Evaluator ─── */
+
+typedef struct {
+    float v[PM_EXPR_LANES];
+    int   vec;
+} slot_t;
+
+/* Element-wise binary op over a and b into a, broadcasting a scalar side. */
+#define BINOP(EXPR)                                                         \
+    do {                                                                    \
+        slot_t *A = &st[sp - 2], *B = &st[sp - 1];                          \
+        if (!A->vec && !B->vec) {                                           \
+            float x = A->v[0], y = B->v[0];                                 \
+            A->v[0] = (EXPR);                                               \
+        } else if (!B->vec) {                                               \
+            float y = B->v[0];                                              \
+            for (unsigned j = 0; j < lanes; j++) { float x = A->v[j]; A->v[j] = (EXPR); } \
+        } else if (!A->vec) {                                               \
+            float x0 = A->v[0];                                             \
+            for (unsigned j = 0; j < lanes; j++) { float x = x0, y = B->v[j]; A->v[j] = (EXPR); } \
+        } else {                                                            \
+            for (unsigned j = 0; j < lanes; j++) { float x = A->v[j], y = B->v[j]; A->v[j] = (EXPR); } \
+        }                                                                   \
+        A->vec |= B->vec;                                                   \
+        sp--;                                                               \
+    } while (0)
+
+#define UNOP(EXPR)                                                          \
+    do {                                                                    \
+        slot_t *A = &st[sp - 1];                                            \
+        unsigned n = A->vec ? lanes : 1;                                    \
+        for (unsigned j = 0; j < n; j++) { float x = A->v[j]; A->v[j] = (EXPR); } \
+    } while (0)
+
+static void run(const pm_expr_set_t *set, const metric_t *mt, const float *tab)
+{
+    slot_t st[MAX_STACK];
+    unsigned int sp = 0, lanes = set->lanes;
+
+    for (unsigned int pc = 0; pc < mt->ncode; pc++) {
+        const insn_t *in = &mt->code[pc];
+        slot_t *T = &st[sp];
+
+        switch (in->op) {
+        case OP_CONST:
+            T->v[0] = in->k; T->vec = 0; sp++;
+            break;
+        case OP_LOAD:
+            T->v[0] = tab[in->a] * in->k; T->vec = 0; sp++;
+            break;
+        case OP_LOAD_CORE:
+            for (unsigned j = 0; j < lanes; j++)
+                T->v[j] = j < in->n ? tab[in->a + j * in->b] * in->k : NAN;
+            T->vec = 1; sp++;
+            break;
+        case OP_METRIC: {
+            const metric_t *src = &set->m[in->a];
+            memcpy(T->v, src->val, (src->width > 1 ? lanes : 1) * sizeof(float));
+            T->vec = src->width > 1; sp++;
+            break;
+        }
+        case OP_METRIC_AT:
+            T->v[0] = set->m[in->a].val[in->b]; T->vec = 0; sp++;
+            break;
+        case OP_LANE:
+            for (unsigned j = 0; j < lanes; j++)
+                T->v[j] = (float)j;
+            T->vec = 1; sp++;
+            break;
+        case OP_NEG:  UNOP(-x); break;
+        case OP_NOT:  UNOP(x == 0.f ? 1.f : 0.f); break;
+        case OP_ABS:  UNOP(fabsf(x)); break;
+        case OP_SQRT: UNOP(sqrtf(x)); break;
+        case OP_ADD:  BINOP(x + y); break;
+        case OP_SUB:  BINOP(x - y); break;
+        case OP_MUL:  BINOP(x * y); break;
+        case OP_DIV:  BINOP(x / y); break;
+        case OP_LT:   BINOP((float)(x < y)); break;
+        case OP_GT:   BINOP((float)(x > y)); break;
+        case OP_LE:   BINOP((float)(x <= y)); break;
+        case OP_GE:   BINOP((float)(x >= y)); break;
+        case OP_EQ:   BINOP((float)(x == y)); break;
+        case OP_NE:   BINOP((float)(x != y)); break;
+        case OP_AND:  BINOP((float)(x != 0.f && y != 0.f)); break;
+        case OP_OR:   BINOP((float)(x != 0.f || y != 0.f)); break;
+        case OP_MIN:  BINOP(y < x ? y : x); break;
+        case OP_MAX:  BINOP(y > x ? y : x); break;
+        case OP_SELECT:
+        case OP_CLAMP: {
+            slot_t *A = &st[sp - 3], *B = &st[sp - 2], *C = &st[sp - 1];
+            int vec = A->vec | B->vec | C->vec;
+            unsigned n = vec ? lanes : 1;
+            for (unsigned j = 0; j < n; j++) {
+                float a = A->v[A->vec ? j : 0], b = B->v[B->vec ? j : 0], c = C->v[C->vec ? j : 0];
+                if (in->op == OP_SELECT)
+                    A->v[j] = a != 0.f ? b : c;
+                else
+                    A->v[j] = a < b ? b : a > c ? c : a;
+            }
+            A->vec = vec;
+            sp -= 2;
+            break;
+        }
+        case OP_RSUM: case OP_RAVG: case OP_RMIN: case OP_RMAX: {
+            slot_t *A = &st[sp - 1];
+            unsigned n = A->vec ? lanes : 1, cnt = 0;
+            float acc = in->op == OP_RMIN ? INFINITY : in->op == OP_RMAX ? -INFINITY : 0.f;
+            for (unsigned j = 0; j < n; j++) {
+                float x = A->v[j];
+                if (isnan(x))
+                    continue;
+                cnt++;
+                if (in->op == OP_RMIN)      acc = x < acc ? x : acc;
+                else if (in->op == OP_RMAX) acc = x > acc ? x : acc;
+                else                        acc += x;
+            }
+            if (cnt == 0)
+                acc = NAN;
+            else if (in->op == OP_RAVG)
+                acc /= (float)cnt;
+            A->v[0] = acc;
+            A->vec = 0;
+            break;
+        }
+        }
+    }
+
+    if (mt->width > 1)
+        memcpy(mt->val, st[0].v, lanes * sizeof(float));
+    else
+        mt->val[0] = st[0].v[0];
+}
+
+/* ─── Public API ─── */
+
+pm_expr_set_t *pm_expr_new(const pm_schema_t *s, unsigned int table_size, unsigned int ncores)
+{
+    pm_expr_set_t *set = calloc(1, sizeof(*set));
+
+    if (!set)
+        return NULL;
+    set->schema = s;
+    set->nidx = table_size / 4;
+    set->lanes = ncores == 0 ? 1 : ncores > PM_EXPR_LANES ? PM_EXPR_LANES : ncores;
+    return set;
+}
+
+void pm_expr_free(pm_expr_set_t *set)
+{
+    if (!set)
+        return;
+    for (unsigned int m = 0; m < set->count; m++) {
+        free(set->m[m].code);
+        free(set->m[m].val);
+    }
+    free(set->m);
+    free(set);
+}
+
+int pm_expr_add(pm_expr_set_t *set, const char *def, char *err, size_t errlen)
+{
+    cc_t c = { 0 };
+    char name[MAX_NAME];
+    metric_t *mt;
+
+    c.set = set;
+    c.src = c.p = def;
+    c.err = err;
+    c.errlen = errlen;
+
+    if (!ident(&c, name, sizeof(name)) || !accept(&c, "=")) {
+        cc_error(&c, "expected 'name = expression'");
+        return -1;
+    }
+    if (pm_expr_find(set, name) >= 0 || pm_field_by_name(name) >= 0 ||
+        strcmp(name, "i") == 0 || strcmp(name, "ncores") == 0 || strcmp(name, "pm") == 0) {
+        cc_error(&c, "name already defined");
+        return -1;
+    }
+
+    parse_expr(&c);
+    skip_ws(&c);
+    if (!c.failed && *c.p)
+        cc_error(&c, "unexpected text");
+    if (!c.failed && c.depth != 1)
+        cc_error(&c, "malformed expression");
+    if (c.failed) {
+        free(c.code);
+        return -1;
+    }
+
+    if (set->count == set->cap) {
+        unsigned int cap = set->cap ? set->cap * 2 : 16;
+        metric_t *nm = realloc(set->m, cap * sizeof(*nm));
+        if (!nm) {
+            free(c.code);
+            snprintf(err, errlen, "out of memory");
+            return -1;
+        }
+        set->m = nm;
+        set->cap = cap;
+    }
+    mt = &set->m[set->count];
+    memset(mt, 0, sizeof(*mt));
+    snprintf(mt->name, sizeof(mt->name), "%s", name);
+    mt->code = c.code;
+    mt->ncode = c.ncode;
+    mt->width = c.vec[0] ? set->lanes : 1;
+    mt->val = calloc(PM_EXPR_LANES, sizeof(float));
+    if (!mt->val) {
+        free(c.code);
+        snprintf(err, errlen, "out of memory");
+        return -1;
+    }
+    for (unsigned int j = 0; j < PM_EXPR_LANES; j++)
+        mt->val[j] = NAN;
+    set->count++;
+    return 0;
+}
+
+int pm_expr_load_file(pm_expr_set_t *set, const char *path, char *err, size_t errlen)
+{
+    char line[512], msg[128];
+    int lineno = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (!fp) {
+        snprintf(err, errlen, "%s: cannot open", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line, *hash = strchr(line, '#');
+
+        lineno++;
+        if (hash)
+            *hash = '\0';
+        line[strcspn(line, "\r\n")] = '\0';
+        while (isspace((unsigned char)*p))
+            p++;
+        if (!*p)
+            continue;
+        if (pm_expr_add(set, p, msg, sizeof(msg)) != 0) {
+            snprintf(err, errlen, "%s:%d: %s", path, lineno, msg);
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+void pm_expr_eval(pm_expr_set_t *set, const void *table)
+{
+    for (unsigned int m = 0; m < set->count; m++)
+        run(set, &set->m[m], table);
+}
+
+unsigned int pm_expr_count(const pm_expr_set_t *set)
+{
+    return set ? set->count : 0;
+}
+
+int pm_expr_find(const pm_expr_set_t *set, const char *name)
+{
+    for (unsigned int m = 0; set && m < set->count; m++) {
+        if (strcmp(set->m[m].name, name) == 0)
+            return (int)m;
+    }
+    return -1;
+}
+
+const char *pm_expr_name(const pm_expr_set_t *set, unsigned int m)
+{
+    return set->m[m].name;
+}
+
+unsigned int pm_expr_width(const pm_expr_set_t *set, unsigned int m)
+{
+    return set->m[m].width;
+}
+
+const float *pm_expr_values(const pm_expr_set_t *set, unsigned int m)
+{
+    return set->m[m].val;
+}
+
+float pm_expr_get(const pm_expr_set_t *set, const char *name)
+{
+    int m = pm_expr_find(set, name);
+    return m < 0 ? NAN : set->m[m].val[0];
+}
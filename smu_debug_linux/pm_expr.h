@@ -0,0 +1,55 @@
+/*
+ * Derived PM metrics: "name = expression" formulas over PM table fields.
+ *
+ * Formulas are parsed once and compiled against a pm_schema_t into a small
+ * stack bytecode; field names become float indices at compile time. A metric
+ * that touches a per-core array without a constant index (CORE_CC6 or
+ * CORE_CC6[i]) is a per-core metric: its program runs once over all cores as
+ * lanes, each op being a flat loop over a float vector.
+ *
+ * Grammar (C precedence, all arithmetic in float, comparisons yield 0/1):
+ *   expr    := cond ['?' expr ':' expr]
+ *   primary := number | FIELD | FIELD[k] | FIELD[i] | pm[k] | metric | metric[k]
+ *            | i | ncores | func(args) | '(' expr ')'
+ *   func    := min/max (2 args: element-wise; 1 arg: over cores), sum, avg,
+ *              abs, sqrt, clamp(x, lo, hi)
+ * Reductions skip NaN lanes (cores the layout does not cover). Metrics can
+ * use metrics defined before them.
+ */
+#ifndef PM_EXPR_H
+#define PM_EXPR_H
+
+#include <stddef.h>
+
+#include "pm_schema.h"
+
+#define PM_EXPR_LANES  64       /* max cores per per-core metric */
+
+typedef struct pm_expr_set pm_expr_set_t;
+
+/* ncores: lanes for per-core metrics (clamped to PM_EXPR_LANES). */
+pm_expr_set_t *pm_expr_new(const pm_schema_t *s, unsigned int table_size, unsigned int ncores);
+void pm_expr_free(pm_expr_set_t *set);
+
+/* Compile "name = expr". 0 on success, -1 with a message in err. */
+int pm_expr_add(pm_expr_set_t *set, const char *def, char *err, size_t errlen);
+
+/* One definition per line, '#' comments. Stops at the first error
+ * ("file:line: message" in err). */
+int pm_expr_load_file(pm_expr_set_t *set, const char *path, char *err, size_t errlen);
+
+/* Evaluate every metric against one raw PM table snapshot. */
+void pm_expr_eval(pm_expr_set_t *set, const void *table);
+
+unsigned int pm_expr_count(const pm_expr_set_t *set);
+int          pm_expr_find(const pm_expr_set_t *set, const char *name);
+const char  *pm_expr_name(const pm_expr_set_t *set, unsigned int m);
+/* 1 for scalar metrics, ncores for per-core metrics. */
+unsigned int pm_expr_width(const pm_expr_set_t *set, unsigned int m);
+/* Values from the last pm_expr_eval(); pm_expr_width() elements. */
+const float *pm_expr_values(const pm_expr_set_t *set, unsigned int m);
+
+/* Scalar value (element 0) of a named metric, NAN if unknown. */
+float pm_expr_get(const pm_expr_set_t *set, const char *name);
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ * Closed-loop boost governor (see pm_governor.h).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pm_governor.h"
+
+static const char *metric_names[PM_GOV_M_COUNT] = {
+    [PM_GOV_M_HEADROOM]   = "headroom",
+    [PM_GOV_M_PPT]        = "ppt",
+    [PM_GOV_M_TDC]        = "tdc",
+    [PM_GOV_M_EDC]        = "edc",
+    [PM_GOV_M_THM]        = "thm",
+    [PM_GOV_M_THM_MARGIN] = "thm_margin",
+    [PM_GOV_M_ACTIVE]     = "active",
+    [PM_GOV_M_LOAD]       = "load",
+    [PM_GOV_M_CLOCK]      = "clock",
+};
+
+static const char *op_names[] = { "<", "<=", ">", ">=" };
+
+const char *pm_gov_metric_name(pm_gov_metric_t m)
+{
+    return (unsigned)m < PM_GOV_M_COUNT ? metric_names[m] : "?";
+}
+
+void pm_gov_rule_format(const pm_gov_rule_t *r, char *buf, size_t len)
+{
+    snprintf(buf, len, "%s %s %g %+d", pm_gov_metric_name(r->metric), op_names[r->op],
+             r->value, r->delta_mhz);
+}
+
+/* ─── Configuration ─── */
+
+void pm_gov_defaults(pm_gov_config_t *c, unsigned int min_mhz, unsigned int max_mhz)
+{
+    memset(c, 0, sizeof(*c));
+    c->law = PM_GOV_PID;
+    c->min_mhz = min_mhz;
+    c->max_mhz = max_mhz;
+    c->quantum_mhz = 25;
+    c->hysteresis_mhz = 50;
+    c->max_step_mhz = 200;
+    c->min_write_ms = 500;
+    c->idle_max = 1;
+    c->target_headroom = 5.f;
+    c->kp = 10.f;
+    c->ki = 20.f;
+    c->kd = 0.f;
+}
+
+/* Back off hard near a limit, creep up with room to spare, hold in between. */
+void pm_gov_default_rules(pm_gov_config_t *c)
+{
+    static const pm_gov_rule_t def[] = {
+        { PM_GOV_M_THM_MARGIN, PM_GOV_LT, 1.f, -100 },
+        { PM_GOV_M_HEADROOM,   PM_GOV_LT, 1.f, -50 },
+        { PM_GOV_M_HEADROOM,   PM_GOV_LT, 3.f, -10 },
+        { PM_GOV_M_HEADROOM,   PM_GOV_GT, 15.f, 25 },
+        { PM_GOV_M_HEADROOM,   PM_GOV_GT, 7.f, 5 },
+    };
+
+    memcpy(c->rules, def, sizeof(def));
+    c->nrules = sizeof(def) / sizeof(def[0]);
+}
+
+int pm_gov_load_rules(const char *path, pm_gov_config_t *c, char *err, size_t errlen)
+{
+    char line[256];
+    unsigned int ln = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (!fp) {
+        snprintf(err, errlen, "%s: cannot open", path);
+        return -1;
+    }
+    c->nrules = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char metric[32], op[4], tail;
+        pm_gov_rule_t r;
+        int m = -1, o = -1, n;
+
+        ln++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        if (sscanf(line, " %c", &tail) != 1)
+            continue;
+        n = sscanf(line, " %31s %3s %f %d %c", metric, op, &r.value, &r.delta_mhz, &tail);
+        for (int i = 0; i < PM_GOV_M_COUNT; i++) {
+            if (n >= 1 && strcmp(metric, metric_names[i]) == 0)
+                m = i;
+        }
+        for (int i = 0; i < 4; i++) {
+            if (n >= 2 && strcmp(op, op_names[i]) == 0)
+                o = i;
+        }
+        if (n != 4 || m < 0 || o < 0 || abs(r.delta_mhz) > 1000) {
+            snprintf(err, errlen, "%s:%u: expected '<metric> <op> <value> <delta MHz>'",
+                     path, ln);
+            fclose(fp);
+            return -1;
+        }
+        if (c->nrules == PM_GOV_MAX_RULES) {
+            snprintf(err, errlen, "%s:%u: more than %d rules", path, ln, PM_GOV_MAX_RULES);
+            fclose(fp);
+            return -1;
+        }
+        r.metric = (pm_gov_metric_t)m;
+        r.op = (pm_gov_op_t)o;
+        c->rules[c->nrules++] = r;
+    }
+    fclose(fp);
+    if (c->nrules == 0) {
+        snprintf(err, errlen, "%s: no rules", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* ─── Inputs ─── */
+
+void pm_gov_inputs(const pm_limiter_t *lim, const void *tab, pm_gov_inputs_t *in)
+{
+    static const int map[] = { PM_GOV_M_PPT, PM_GOV_M_TDC, PM_GOV_M_EDC, PM_GOV_M_THM };
+    const pm_schema_t *sc = lim->schema;
+    pm_limiter_state_t st;
+    float worst = NAN, clk = 0.f;
+    unsigned int active = 0;
+
+    for (int i = 0; i < PM_GOV_M_COUNT; i++)
+        in->m[i] = NAN;
+    pm_limiter_classify(lim, tab, &st);
+    in->primary = st.primary;
+
+    for (int l = PM_LIM_PPT; l <= PM_LIM_THM; l++) {
+        in->m[map[l]] = st.pct[l];
+        if (!isnan(st.pct[l]) && (isnan(worst) || st.pct[l] > worst))
+            worst = st.pct[l];
+    }
+    in->m[PM_GOV_M_HEADROOM] = 100.f - worst;
+    in->m[PM_GOV_M_THM_MARGIN] = pm_get(sc, tab, PMF_THM_LIMIT) - pm_get(sc, tab, PMF_THM_VALUE);
+
+    if (lim->ncores) {
+        in->m[PM_GOV_M_LOAD] = 0.f;
+        /* Limiter slots: fused-off cores leave gaps in the arrays */
+        for (unsigned int i = 0; i < lim->ncores; i++) {
+            unsigned int k = (unsigned int)lim->slot[i];
+            float c0 = pm_get_at(sc, tab, PMF_CORE_C0, k);
+
+            if (c0 > in->m[PM_GOV_M_LOAD])
+                in->m[PM_GOV_M_LOAD] = c0;
+            if (c0 < PM_LOAD_C0_PCT)
+                continue;
+            active++;
+            clk += pm_get_at(sc, tab, PMF_CORE_FREQEFF, k);
+        }
+        in->m[PM_GOV_M_ACTIVE] = (float)active;
+        if (active)
+            in->m[PM_GOV_M_CLOCK] = clk / active;
+    }
+}
+
+/* ─── Control ─── */
+
+void pm_gov_init(pm_gov_t *g, const pm_gov_config_t *c, unsigned int applied_mhz)
+{
+    memset(g, 0, sizeof(*g));
+    g->cfg = *c;
+    if (!g->cfg.quantum_mhz)
+        g->cfg.quantum_mhz = 25;
+    g->applied_mhz = applied_mhz;
+    g->u = applied_mhz;
+    g->t_write = -1e9;
+}
+
+void pm_gov_committed(pm_gov_t *g, double t, unsigned int mhz)
+{
+    g->applied_mhz = mhz;
+    g->t_write = t;
+    g->writes++;
+}
+
+static int rule_match(const pm_gov_rule_t *r, const pm_gov_inputs_t *in)
+{
+    float v = in->m[r->metric];
+
+    if (isnan(v))
+        return 0;
+    switch (r->op) {
+    case PM_GOV_LT: return v < r->value;
+    case PM_GOV_LE: return v <= r->value;
+    case PM_GOV_GT: return v > r->value;
+    default:        return v >= r->value;
+    }
+}
+
+void pm_gov_step(pm_gov_t *g, double t, const pm_gov_inputs_t *in, pm_gov_decision_t *d)
+{
+    const pm_gov_config_t *c = &g->cfg;
+    double dt = g->nerr ? t - g->t_prev : 0.0;
+    unsigned int q;
+    long diff;
+
+    memset(d, 0, sizeof(*d));
+    d->rule = -1;
+    g->t_prev = t;
+
+    if (c->idle_max && in->m[PM_GOV_M_ACTIVE] == 0.f) {
+        /* Nothing to protect; the next burst starts at full boost */
+        g->u = c->max_mhz;
+        g->nerr = 0;
+        d->reason = "idle";
+    } else if (c->law == PM_GOV_PID) {
+        float e = in->m[PM_GOV_M_HEADROOM] - c->target_headroom;
+
+        d->reason = "pid";
+        if (isnan(e)) {
+            d->reason = "no data";
+        } else {
+            /* Velocity form: clamping u is the anti-windup */
+            double du = c->ki * e * dt;
+            if (g->nerr >= 1)
+                du += c->kp * (e - g->e1);
+            if (g->nerr >= 2 && dt > 0)
+                du += c->kd * (e - 2 * g->e1 + g->e2) / dt;
+            g->u += du;
+            g->e2 = g->e1;
+            g->e1 = e;
+            if (g->nerr < 2)
+                g->nerr++;
+        }
+    } else {
+        d->reason = "hold";
+        for (unsigned int i = 0; i < c->nrules; i++) {
+            if (rule_match(&c->rules[i], in)) {
+                g->u += c->rules[i].delta_mhz;
+                d->rule = (int)i;
+                d->reason = "rule";
+                break;
+            }
+        }
+    }
+    if (g->u < c->min_mhz)
+        g->u = c->min_mhz;
+    if (g->u > c->max_mhz)
+        g->u = c->max_mhz;
+
+    q = (unsigned int)(lround(g->u / c->quantum_mhz) * c->quantum_mhz);
+    if (q < c->min_mhz)
+        q = c->min_mhz;
+    if (q > c->max_mhz)
+        q = c->max_mhz;
+    d->proposed = q;
+    d->target = g->applied_mhz;
+
+    diff = (long)q - (long)g->applied_mhz;
+    /* Hysteresis, except to reach a bound (otherwise max_mhz could be unreachable) */
+    if (diff == 0 || (labs(diff) < (long)c->hysteresis_mhz && q != c->min_mhz && q != c->max_mhz)) {
+        if (diff != 0)
+            d->reason = "deadband";
+        return;
+    }
+    if ((t - g->t_write) * 1000.0 < c->min_write_ms) {
+        d->reason = "rate";
+        return;
+    }
+    if (c->max_step_mhz && labs(diff) > (long)c->max_step_mhz)
+        diff = diff > 0 ? (long)c->max_step_mhz : -(long)c->max_step_mhz;
+    d->target = (unsigned int)((long)g->applied_mhz + diff);
+    d->write = 1;
+}
@@ -0,0 +1,106 @@
+/*
+ * Closed-loop boost governor.
+ *
+ * Each PM sample is reduced to a few inputs (headroom to the tightest of
+ * PPT/TDC/EDC/THM, per-limit use, active cores) and a control law moves an
+ * internal boost-limit set-point: a PID on headroom, or a rule table of
+ * "metric op value delta" lines where the first match wins. The set-point is
+ * quantized, and a write is proposed only when it leaves the hysteresis band
+ * around the applied FMax, no sooner than min_write_ms after the last write,
+ * and by at most max_step_mhz at a time.
+ *
+ * The governor never touches the SMU itself: the caller writes the proposed
+ * value and reports it back with pm_gov_committed().
+ */
+#ifndef PM_GOVERNOR_H
+#define PM_GOVERNOR_H
+
+#include <stddef.h>
+
+#include "pm_limiter.h"
+#include "pm_schema.h"
+
+#define PM_GOV_MAX_RULES    32
+
+typedef enum { PM_GOV_PID, PM_GOV_RULES } pm_gov_law_t;
+
+typedef enum {
+    PM_GOV_M_HEADROOM,      /* 100 - highest of the PPT/TDC/EDC/THM percentages */
+    PM_GOV_M_PPT,           /* % of limit */
+    PM_GOV_M_TDC,
+    PM_GOV_M_EDC,
+    PM_GOV_M_THM,
+    PM_GOV_M_THM_MARGIN,    /* C below the thermal limit */
+    PM_GOV_M_ACTIVE,        /* cores at or above PM_LOAD_C0_PCT */
+    PM_GOV_M_LOAD,          /* busiest core's C0 % */
+    PM_GOV_M_CLOCK,         /* mean clock of active cores, MHz */
+    PM_GOV_M_COUNT
+} pm_gov_metric_t;
+
+typedef enum { PM_GOV_LT, PM_GOV_LE, PM_GOV_GT, PM_GOV_GE } pm_gov_op_t;
+
+typedef struct {
+    pm_gov_metric_t metric;
+    pm_gov_op_t     op;
+    float           value;
+    int             delta_mhz;      /* per sample */
+} pm_gov_rule_t;
+
+typedef struct {
+    pm_gov_law_t law;
+    unsigned int min_mhz, max_mhz;  /* safe bounds of the set-point */
+    unsigned int quantum_mhz;       /* 0 = 25 */
+    unsigned int hysteresis_mhz;    /* no write for a smaller change */
+    unsigned int max_step_mhz;      /* largest change per write (0 = no cap) */
+    unsigned int min_write_ms;      /* SMU write rate limit */
+    int          idle_max;          /* no active core: go to max_mhz */
+    /* PID on headroom: error = headroom - target (percent) */
+    float        target_headroom;
+    float        kp;                /* MHz per % */
+    float        ki;                /* MHz per % per s */
+    float        kd;                /* MHz s per % */
+    pm_gov_rule_t rules[PM_GOV_MAX_RULES];
+    unsigned int nrules;
+} pm_gov_config_t;
+
+typedef struct {
+    float m[PM_GOV_M_COUNT];        /* NAN when the layout lacks the field */
+    int   primary;                  /* pm_limiter class of the sample */
+} pm_gov_inputs_t;
+
+typedef struct {
+    unsigned int proposed;          /* quantized set-point */
+    unsigned int target;            /* what to write (rate-capped), if write */
+    int          write;
+    const char  *reason;            /* "pid", "rule", "hold", "idle", "deadband", "rate" */
+    int          rule;              /* matched rule index, -1 */
+} pm_gov_decision_t;
+
+typedef struct {
+    pm_gov_config_t cfg;
+    unsigned int applied_mhz;       /* last value written */
+    double       u;                 /* continuous set-point */
+    float        e1, e2;            /* previous errors (PID) */
+    int          nerr;
+    double       t_prev, t_write;
+    unsigned long writes;
+} pm_gov_t;
+
+/* Defaults: PID, 5% headroom, 25 MHz quantum, 50 MHz hysteresis, 200 MHz step, 500 ms. */
+void pm_gov_defaults(pm_gov_config_t *c, unsigned int min_mhz, unsigned int max_mhz);
+/* Built-in rule table (used by the rules law when no file is loaded). */
+void pm_gov_default_rules(pm_gov_config_t *c);
+/* Rule file: "<metric> <op> <value> <delta>" per line, '#' comments. 0 ok, -1 with err. */
+int  pm_gov_load_rules(const char *path, pm_gov_config_t *c, char *err, size_t errlen);
+
+void pm_gov_init(pm_gov_t *g, const pm_gov_config_t *c, unsigned int applied_mhz);
+void pm_gov_inputs(const pm_limiter_t *lim, const void *table, pm_gov_inputs_t *in);
+void pm_gov_step(pm_gov_t *g, double t, const pm_gov_inputs_t *in, pm_gov_decision_t *d);
+/* The caller wrote mhz at time t. */
+void pm_gov_committed(pm_gov_t *g, double t, unsigned int mhz);
+
+const char *pm_gov_metric_name(pm_gov_metric_t m);
+/* "headroom < 2 -100" */
+void pm_gov_rule_format(const pm_gov_rule_t *r, char *buf, size_t len);
+
+#endif
@@ -0,0 +1,915 @@
+/*
+ * PM table layout inference (see pm_infer.h).
+ *
+ * Schedule: idle lead-in, then for each physical core an on-phase (its spin
+ * thread busy) followed by a half-length cool-down, then all cores together,
+ * then an idle tail. One-at-a-time stimulus makes the per-core indicator
+ * signals orthogonal, which is what separates CORE_x[3] from CORE_x[4].
+ *
+ * Samples are stored row-major (one PM snapshot per row). Each correlation
+ * worker owns a contiguous slice of float indices and walks the rows once,
+ * so no locking is needed and the slice stays in cache.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pm_infer.h"
+
+/* Fixed reference columns; per-core columns follow. */
+enum { REF_TCTL, REF_PKG_W, REF_LOAD, REF_FIXED };
+#define REF_FREQ(c)  (REF_FIXED + 3 * (c))
+#define REF_BUSY(c)  (REF_FIXED + 3 * (c) + 1)
+#define REF_STIM(c)  (REF_FIXED + 3 * (c) + 2)
+
+#define MAX_CPUS        1024
+#define PHASE_ALL       (-2)
+#define PHASE_IDLE      (-1)
+#define MIN_SCORE       0.30f
+#define CANDIDATES_PER  4
+
+/* ─── Kernel sensors ─── */
+
+typedef struct {
+    char   tctl_path[300];
+    char   rapl_path[300];
+    double rapl_max_uj;
+    double rapl_prev_uj;
+    double prev_t;
+    unsigned int ncpu;                       /* logical CPUs seen */
+    int    cpu_core[MAX_CPUS];               /* logical CPU -> core index, -1 offline */
+    unsigned int ncores;
+    int    core_cpu[PM_INFER_MAX_CORES];     /* first logical CPU of each core */
+    unsigned char stim[PM_INFER_MAX_CORES];  /* its stimulus thread is running */
+    unsigned long long prev_busy[MAX_CPUS], prev_total[MAX_CPUS];
+    unsigned int sources;
+} sensors_t;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int read_double(const char *path, double *out)
+{
+    FILE *fp = fopen(path, "r");
+    int ok;
+
+    if (!fp)
+        return -1;
+    ok = fscanf(fp, "%lf", out) == 1;
+    fclose(fp);
+    return ok ? 0 : -1;
+}
+
+static int read_word(const char *path, char *buf, size_t len)
+{
+    FILE *fp = fopen(path, "r");
+
+    if (!fp)
+        return -1;
+    if (!fgets(buf, (int)len, fp)) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+static void find_hwmon(sensors_t *s)
+{
+    char path[300], name[64];
+    DIR *d = opendir("/sys/class/hwmon");
+    struct dirent *e;
+
+    if (!d)
+        return;
+    while ((e = readdir(d))) {
+        if (e->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "/sys/class/hwmon/%s/name", e->d_name);
+        if (read_word(path, name, sizeof(name)) != 0)
+            continue;
+        if (strcmp(name, "k10temp") == 0 || strcmp(name, "zenpower") == 0) {
+            snprintf(s->tctl_path, sizeof(s->tctl_path),
+                     "/sys/class/hwmon/%s/temp1_input", e->d_name);
+            s->sources |= PM_INFER_SRC_HWMON;
+            break;
+        }
+    }
+    closedir(d);
+}
+
+static void find_rapl(sensors_t *s)
+{
+    char path[300], name[64];
+    DIR *d = opendir("/sys/class/powercap");
+    struct dirent *e;
+
+    if (!d)
+        return;
+    while ((e = readdir(d))) {
+        if (e->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "/sys/class/powercap/%s/name", e->d_name);
+        if (read_word(path, name, sizeof(name)) != 0 || strncmp(name, "package", 7) != 0)
+            continue;
+        snprintf(s->rapl_path, sizeof(s->rapl_path),
+                 "/sys/class/powercap/%s/energy_uj", e->d_name);
+        snprintf(path, sizeof(path), "/sys/class/powercap/%s/max_energy_range_uj", e->d_name);
+        if (read_double(path, &s->rapl_max_uj) != 0)
+            s->rapl_max_uj = 0;
+        if (read_double(s->rapl_path, &s->rapl_prev_uj) == 0)
+            s->sources |= PM_INFER_SRC_RAPL;
+        else
+            s->rapl_path[0] = '\0';
+        break;
+    }
+    closedir(d);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Physical cores ordered by (package, die, core_id): the order PM arrays use. */
+static void find_topology(sensors_t *s, unsigned int max_cores)
+{
+    static unsigned long long keys[MAX_CPUS], uniq[MAX_CPUS];
+    char path[128];
+    unsigned int nuniq = 0;
+
+    s->ncpu = 0;
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        double pkg = 0, die = 0, core;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+        if (access(path, F_OK) != 0)
+            break;
+        s->ncpu = cpu + 1;
+        s->cpu_core[cpu] = -1;
+        keys[cpu] = ~0ULL;
+        /* Offline CPUs keep their directory but lose topology/: skip the gap */
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        if (read_double(path, &core) != 0)
+            continue;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        read_double(path, &pkg);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/die_id", cpu);
+        read_double(path, &die);
+        keys[cpu] = ((unsigned long long)pkg << 40) | ((unsigned long long)die << 20) |
+                    (unsigned long long)core;
+        uniq[nuniq++] = keys[cpu];
+    }
+
+    qsort(uniq, nuniq, sizeof(uniq[0]), cmp_u64);
+    s->ncores = 0;
+    for (unsigned int i = 0; i < nuniq; i++) {
+        if (i > 0 && uniq[i] == uniq[i - 1])
+            continue;
+        uniq[s->ncores++] = uniq[i];
+    }
+    if (max_cores && s->ncores > max_cores)
+        s->ncores = max_cores;
+    if (s->ncores > PM_INFER_MAX_CORES)
+        s->ncores = PM_INFER_MAX_CORES;
+
+    for (unsigned int c = 0; c < s->ncores; c++)
+        s->core_cpu[c] = -1;
+    for (unsigned int cpu = 0; cpu < s->ncpu; cpu++) {
+        for (unsigned int c = 0; c < s->ncores; c++) {
+            if (keys[cpu] != uniq[c])
+                continue;
+            s->cpu_core[cpu] = (int)c;
+            if (s->core_cpu[c] < 0)
+                s->core_cpu[c] = (int)cpu;
+            break;
+        }
+    }
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
+             s->ncores ? s->core_cpu[0] : 0);
+    if (s->ncores && access(path, R_OK) == 0)
+        s->sources |= PM_INFER_SRC_CPUFREQ;
+}
+
+/* Per-CPU busy fraction since the previous call, as a percentage. */
+static void read_proc_stat(sensors_t *s, double *busy_pct)
+{
+    char line[512];
+    FILE *fp = fopen("/proc/stat", "r");
+
+    for (unsigned int cpu = 0; cpu < s->ncpu; cpu++)
+        busy_pct[cpu] = 0;
+    if (!fp)
+        return;
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned int cpu;
+        unsigned long long v[8] = { 0 }, total = 0, busy;
+
+        if (strncmp(line, "cpu", 3) != 0 || line[3] < '0' || line[3] > '9')
+            continue;
+        if (sscanf(line + 3, "%u %llu %llu %llu %llu %llu %llu %llu %llu", &cpu,
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 5 ||
+            cpu >= s->ncpu)
+            continue;
+        for (int i = 0; i < 8; i++)
+            total += v[i];
+        busy = total - v[3] - v[4];                     /* minus idle, iowait */
+        if (total > s->prev_total[cpu])
+            busy_pct[cpu] = 100.0 * (double)(busy - s->prev_busy[cpu]) /
+                            (double)(total - s->prev_total[cpu]);
+        s->prev_busy[cpu] = busy;
+        s->prev_total[cpu] = total;
+    }
+    fclose(fp);
+    s->sources |= PM_INFER_SRC_PROCSTAT;
+}
+
+static void sensors_sample(sensors_t *s, double *ref, int phase)
+{
+    static double busy[MAX_CPUS];
+    double t = now_sec(), v, load = 0;
+    char path[128];
+    unsigned int online = 0;
+
+    ref[REF_TCTL] = read_double(s->tctl_path, &v) == 0 ? v / 1000.0 : 0;
+
+    ref[REF_PKG_W] = 0;
+    if (s->rapl_path[0] && read_double(s->rapl_path, &v) == 0) {
+        double d = v - s->rapl_prev_uj;
+        if (d < 0 && s->rapl_max_uj > 0)
+            d += s->rapl_max_uj;                        /* counter wrapped */
+        if (t > s->prev_t)
+            ref[REF_PKG_W] = d / 1e6 / (t - s->prev_t);
+        s->rapl_prev_uj = v;
+    }
+    s->prev_t = t;
+
+    read_proc_stat(s, busy);
+    for (unsigned int c = 0; c < s->ncores; c++) {
+        ref[REF_FREQ(c)] = 0;
+        ref[REF_BUSY(c)] = 0;
+        ref[REF_STIM(c)] = s->stim[c] && (phase == (int)c || phase == PHASE_ALL) ? 1.0 : 0.0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
+                 s->core_cpu[c]);
+        if (read_double(path, &v) == 0)
+            ref[REF_FREQ(c)] = v / 1000.0;              /* kHz -> MHz */
+    }
+    for (unsigned int cpu = 0; cpu < s->ncpu; cpu++) {
+        int c = s->cpu_core[cpu];
+        if (c < 0)
+            continue;
+        online++;
+        load += busy[cpu];
+        /* Core C0 follows its busiest thread */
+        if (busy[cpu] > ref[REF_BUSY(c)])
+            ref[REF_BUSY(c)] = busy[cpu];
+    }
+    ref[REF_LOAD] = online ? load / online : 0;
+}
+
+/* ─── Stimulus ─── */
+
+typedef struct {
+    int cpu;
+    int core;
+    volatile int *phase;
+    volatile int *stop;
+} stim_arg_t;
+
+static void *stim_thread(void *p)
+{
+    stim_arg_t *a = p;
+    cpu_set_t set;
+    volatile double x = 1.0;
+    struct timespec nap = { 0, 2000000 };
+
+    CPU_ZERO(&set);
+    CPU_SET(a->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    while (!__atomic_load_n(a->stop, __ATOMIC_RELAXED)) {
+        int ph = __atomic_load_n(a->phase, __ATOMIC_RELAXED);
+        if (ph == a->core || ph == PHASE_ALL) {
+            for (int i = 0; i < 100000; i++)
+                x = x * 1.0000001 + 1e-9;
+        } else {
+            nanosleep(&nap, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* ─── Parallel correlation ─── */
+
+typedef struct {
+    const float  *pm;           /* [n][nidx] */
+    const double *ref;          /* [n][nref], mean-centered */
+    const double *ref_sd;       /* [nref] */
+    unsigned int  n, nidx, nref, i0, i1;
+    float        *corr;         /* [nidx][nref] */
+    float        *mean, *min, *max;
+    unsigned char *constant;    /* [nidx] */
+    int           failed;       /* out of memory */
+} corr_job_t;
+
+static void *corr_worker(void *p)
+{
+    corr_job_t *j = p;
+    unsigned int w = j->i1 - j->i0;
+    double *sum = calloc(w, sizeof(double));
+    double *sq = calloc(w, sizeof(double));
+    double *sxy = calloc((size_t)w * j->nref, sizeof(double));
+    unsigned char *bad = calloc(w, 1);
+
+    if (!sum || !sq || !sxy || !bad) {
+        /* Leave the slice defined (constant, uncorrelated) and fail the run */
+        memset(j->corr + (size_t)j->i0 * j->nref, 0, (size_t)w * j->nref * sizeof(float));
+        for (unsigned int i = j->i0; i < j->i1; i++) {
+            j->mean[i] = j->min[i] = j->max[i] = 0.f;
+            j->constant[i] = 1;
+        }
+        j->failed = 1;
+        goto out;
+    }
+
+    for (unsigned int k = 0; k < w; k++) {
+        j->min[j->i0 + k] = INFINITY;
+        j->max[j->i0 + k] = -INFINITY;
+    }
+
+    for (unsigned int t = 0; t < j->n; t++) {
+        const float *row = j->pm + (size_t)t * j->nidx + j->i0;
+        const double *rr = j->ref + (size_t)t * j->nref;
+        for (unsigned int k = 0; k < w; k++) {
+            double x = row[k];
+            double *acc = sxy + (size_t)k * j->nref;
+            if (!isfinite(x) || fabs(x) > 1e9) {
+                bad[k] = 1;
+                continue;
+            }
+            sum[k] += x;
+            sq[k] += x * x;
+            if (x < j->min[j->i0 + k]) j->min[j->i0 + k] = (float)x;
+            if (x > j->max[j->i0 + k]) j->max[j->i0 + k] = (float)x;
+            for (unsigned int r = 0; r < j->nref; r++)
+                acc[r] += x * rr[r];
+        }
+    }
+
+    for (unsigned int k = 0; k < w; k++) {
+        unsigned int i = j->i0 + k;
+        double mean = sum[k] / j->n;
+        double var = sq[k] / j->n - mean * mean;
+        float *c = j->corr + (size_t)i * j->nref;
+
+        j->mean[i] = (float)mean;
+        j->constant[i] = !bad[k] && j->max[i] == j->min[i];
+        for (unsigned int r = 0; r < j->nref; r++) {
+            /* ref is centered, so sum(x * ref) / n is the covariance */
+            if (bad[k] || var <= 1e-12 || j->ref_sd[r] <= 1e-12)
+                c[r] = 0;
+            else
+                c[r] = (float)(sxy[(size_t)k * j->nref + r] / j->n /
+                               (sqrt(var) * j->ref_sd[r]));
+        }
+    }
+out:
+    free(sum);
+    free(sq);
+    free(sxy);
+    free(bad);
+    return NULL;
+}
+
+static int correlate(const float *pm, double *ref, unsigned int n, unsigned int nidx,
+                     unsigned int nref, unsigned int nthreads, float *corr,
+                     float *mean, float *min, float *max, unsigned char *constant)
+{
+    double *ref_sd = calloc(nref, sizeof(double));
+    corr_job_t *jobs;
+    pthread_t *tids;
+    unsigned char *spawned;
+    int failed = 0;
+
+    if (!ref_sd)
+        return -1;
+
+    /* Center references once so workers only accumulate x * ref */
+    for (unsigned int r = 0; r < nref; r++) {
+        double m = 0, v = 0;
+        for (unsigned int t = 0; t < n; t++)
+            m += ref[(size_t)t * nref + r];
+        m /= n;
+        for (unsigned int t = 0; t < n; t++) {
+            double d = ref[(size_t)t * nref + r] - m;
+            ref[(size_t)t * nref + r] = d;
+            v += d * d;
+        }
+        ref_sd[r] = sqrt(v / n);
+    }
+
+    if (nthreads == 0)
+        nthreads = 1;
+    if (nthreads > nidx)
+        nthreads = nidx;
+    jobs = calloc(nthreads, sizeof(*jobs));
+    tids = calloc(nthreads, sizeof(*tids));
+    spawned = calloc(nthreads, 1);
+    if (!jobs || !tids || !spawned) {
+        free(ref_sd);
+        free(jobs);
+        free(tids);
+        free(spawned);
+        return -1;
+    }
+
+    for (unsigned int w = 0; w < nthreads; w++) {
+        corr_job_t *j = &jobs[w];
+        j->pm = pm; j->ref = ref; j->ref_sd = ref_sd;
+        j->n = n; j->nidx = nidx; j->nref = nref;
+        j->i0 = (unsigned int)((unsigned long long)nidx * w / nthreads);
+        j->i1 = (unsigned int)((unsigned long long)nidx * (w + 1) / nthreads);
+        j->corr = corr; j->mean = mean; j->min = min; j->max = max;
+        j->constant = constant;
+        if (w > 0)
+            spawned[w] = pthread_create(&tids[w], NULL, corr_worker, j) == 0;
+    }
+    /* Slice 0 (and any slice whose thread failed to start) runs here */
+    for (unsigned int w = 0; w < nthreads; w++) {
+        if (!spawned[w])
+            corr_worker(&jobs[w]);
+    }
+    for (unsigned int w = 1; w < nthreads; w++) {
+        if (spawned[w])
+            pthread_join(tids[w], NULL);
+    }
+    for (unsigned int w = 0; w < nthreads; w++)
+        failed |= jobs[w].failed;
+
+    free(ref_sd);
+    free(jobs);
+    free(tids);
+    free(spawned);
+    return failed ? -1 : 0;
+}
+
+/* ─── Field matching ─── */
+
+typedef struct {
+    float  score;
+    short  field;
+    short  elem;
+    unsigned int idx;
+    float  scale;
+} cand_t;
+
+typedef struct {
+    const float *corr, *mean, *min, *max;
+    const unsigned char *constant;
+    const double *ref_mean;      /* uncentered means of each reference */
+    unsigned int nidx, nref;
+} stats_t;
+
+/* 1 inside [lo, hi], fading linearly to 0 at [lo - fade, hi + fade]. */
+static float window(double v, double lo, double hi, double fade)
+{
+    if (v >= lo && v <= hi)
+        return 1.f;
+    if (v < lo)
+        return v <= lo - fade ? 0.f : (float)(1.0 - (lo - v) / fade);
+    return v >= hi + fade ? 0.f : (float)(1.0 - (v - hi) / fade);
+}
+
+/* Plausibility of index i as field f against reference r; sets *scale. */
+static float plausible(const stats_t *st, pm_field_id f, unsigned int i, unsigned int r,
+                       float *scale)
+{
+    double m = st->mean[i], lo = st->min[i], hi = st->max[i], rm = st->ref_mean[r];
+
+    *scale = 1.f;
+    switch (f) {
+    case PMF_THM_VALUE:
+        return window(m - rm, -5, 5, 15);
+    case PMF_SOCKET_POWER:
+        return rm > 1 ? window(m / rm, 0.7, 1.3, 0.5) : 0.f;
+    case PMF_CORE_FREQEFF:
+        if (rm <= 0 || m <= 0)
+            return 0.f;
+        if (m < 10) {                                   /* GHz */
+            *scale = 1000.f;
+            m *= 1000.0;
+        }
+        return window(m / rm, 0.8, 1.25, 0.3);
+    case PMF_CORE_C0:
+        return lo >= -0.5 && hi <= 100.5 ? window(m - rm, -15, 15, 25) : 0.f;
+    case PMF_CORE_POWER:
+        return lo >= -0.1 && hi <= 60 && hi > 0.3 ? 1.f : 0.f;
+    case PMF_CORE_TEMP:
+        return lo > 15 && hi < 115 ? window(m - st->ref_mean[REF_TCTL], -25, 10, 10) : 0.f;
+    default:
+        return 0.f;
+    }
+}
+
+static int cmp_cand(const void *a, const void *b)
+{
+    float x = ((const cand_t *)a)->score, y = ((const cand_t *)b)->score;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+/* Keep the best CANDIDATES_PER indices for (f, elem) against reference r. */
+static unsigned int collect(const stats_t *st, pm_field_id f, int elem, unsigned int r,
+                            cand_t *out)
+{
+    cand_t best[CANDIDATES_PER];
+    unsigned int nbest = 0;
+
+    for (unsigned int i = 0; i < st->nidx; i++) {
+        float corr = st->corr[(size_t)i * st->nref + r], scale;
+        float score;
+
+        if (st->constant[i] || corr <= MIN_SCORE)
+            continue;
+        score = corr * plausible(st, f, i, r, &scale);
+        if (score <= MIN_SCORE)
+            continue;
+        if (nbest < CANDIDATES_PER) {
+            best[nbest++] = (cand_t){ score, (short)f, (short)elem, i, scale };
+        } else if (score > best[CANDIDATES_PER - 1].score) {
+            best[CANDIDATES_PER - 1] = (cand_t){ score, (short)f, (short)elem, i, scale };
+        } else {
+            continue;
+        }
+        qsort(best, nbest, sizeof(best[0]), cmp_cand);
+    }
+    memcpy(out, best, nbest * sizeof(best[0]));
+    return nbest;
+}
+
+static const pm_field_id core_fields[] = {
+    PMF_CORE_FREQEFF, PMF_CORE_C0, PMF_CORE_POWER, PMF_CORE_TEMP,
+};
+
+static const char *evidence_for(pm_field_id f)
+{
+    switch (f) {
+    case PMF_THM_VALUE:     return "k10temp Tctl";
+    case PMF_SOCKET_POWER:  return "RAPL package power";
+    case PMF_CORE_FREQEFF:  return "cpufreq scaling_cur_freq";
+    case PMF_CORE_C0:       return "/proc/stat busy";
+    default:                return "per-core stimulus";
+    }
+}
+
+static unsigned int ref_for(pm_field_id f, unsigned int c)
+{
+    switch (f) {
+    case PMF_THM_VALUE:     return REF_TCTL;
+    case PMF_SOCKET_POWER:  return REF_PKG_W;
+    case PMF_CORE_FREQEFF:  return REF_FREQ(c);
+    case PMF_CORE_C0:       return REF_BUSY(c);
+    default:                return REF_STIM(c);
+    }
+}
+
+/* Fit per-core hits to offset + k * stride; returns matched element count. */
+static unsigned int fit_array(const unsigned int *idx, const float *score, unsigned int ncores,
+                              unsigned int nidx, pm_field_loc_t *loc, float *conf)
+{
+    unsigned int off[PM_INFER_MAX_CORES], n = 0, best_match = 0;
+    float best_sum = 0;
+
+    for (unsigned int c = 0; c < ncores; c++) {
+        if (score[c] > 0)
+            off[n++] = idx[c] * 4;
+    }
+    if (n == 0)
+        return 0;
+    qsort(off, n, sizeof(off[0]), cmp_u32);
+
+    /* Try every (base, stride) implied by a pair of hits; keep the best cover. */
+    for (unsigned int a = 0; a < n; a++) {
+        for (unsigned int b = a; b < n; b++) {
+            unsigned int stride = b == a ? 4 : (off[b] - off[a]) / (b - a);
+            unsigned int match = 0;
+            float sum = 0;
+
+            if (stride == 0 || stride % 4 || stride > 255 ||
+                (b != a && (off[b] - off[a]) % (b - a)))
+                continue;
+            for (unsigned int c = 0; c < ncores; c++) {
+                unsigned int o;
+                if (score[c] <= 0)
+                    continue;
+                o = idx[c] * 4;
+                if (o >= off[a] && (o - off[a]) % stride == 0 &&
+                    (o - off[a]) / stride < ncores) {
+                    match++;
+                    sum += score[c];
+                }
+            }
+            if (match > best_match || (match == best_match && sum > best_sum)) {
+                best_match = match;
+                best_sum = sum;
+                loc->offset = (unsigned short)off[a];
+                loc->stride = (unsigned char)stride;
+            }
+        }
+    }
+
+    loc->count = (unsigned char)ncores;
+    while (loc->count > 1 && loc->offset + (loc->count - 1u) * loc->stride + 4 > nidx * 4)
+        loc->count--;
+    *conf = best_sum / (float)ncores;
+    return best_match;
+}
+
+static void match_fields(const stats_t *st, unsigned int ncores, unsigned int sources,
+                         pm_infer_result_t *r)
+{
+    unsigned int nf = 2 + (unsigned int)(sizeof(core_fields) / sizeof(core_fields[0])) * ncores;
+    cand_t *cands = calloc((size_t)nf * CANDIDATES_PER, sizeof(cand_t));
+    unsigned char *used = calloc(st->nidx, 1);
+    unsigned int ncand = 0;
+    unsigned int hit_idx[PMF_COUNT][PM_INFER_MAX_CORES];
+    float hit_score[PMF_COUNT][PM_INFER_MAX_CORES], hit_scale[PMF_COUNT];
+
+    if (!cands || !used)
+        goto out;
+    memset(hit_score, 0, sizeof(hit_score));
+    for (int f = 0; f < PMF_COUNT; f++)
+        hit_scale[f] = 1.f;
+
+    if (sources & PM_INFER_SRC_HWMON)
+        ncand += collect(st, PMF_THM_VALUE, 0, REF_TCTL, cands + ncand);
+    if (sources & PM_INFER_SRC_RAPL)
+        ncand += collect(st, PMF_SOCKET_POWER, 0, REF_PKG_W, cands + ncand);
+    for (unsigned int k = 0; k < sizeof(core_fields) / sizeof(core_fields[0]); k++) {
+        pm_field_id f = core_fields[k];
+        if (f == PMF_CORE_FREQEFF && !(sources & PM_INFER_SRC_CPUFREQ))
+            continue;
+        if (f == PMF_CORE_TEMP && !(sources & PM_INFER_SRC_HWMON))
+            continue;
+        for (unsigned int c = 0; c < ncores; c++)
+            ncand += collect(st, f, (int)c, ref_for(f, c), cands + ncand);
+    }
+
+    /* Greedy: strongest evidence first, one field per index. */
+    qsort(cands, ncand, sizeof(cands[0]), cmp_cand);
+    for (unsigned int k = 0; k < ncand; k++) {
+        cand_t *c = &cands[k];
+        if (used[c->idx] || hit_score[c->field][c->elem] > 0)
+            continue;
+        used[c->idx] = 1;
+        hit_idx[c->field][c->elem] = c->idx;
+        hit_score[c->field][c->elem] = c->score;
+        hit_scale[c->field] = c->scale;
+    }
+
+    for (int f = 0; f < PMF_COUNT; f++) {
+        pm_field_loc_t *loc = &r->schema.loc[f];
+        int per_core = 0;
+        for (unsigned int k = 0; k < sizeof(core_fields) / sizeof(core_fields[0]); k++)
+            per_core |= core_fields[k] == (pm_field_id)f;
+
+        if (per_core) {
+            float conf = 0;
+            if (fit_array(hit_idx[f], hit_score[f], ncores, st->nidx, loc, &conf) == 0)
+                continue;
+            loc->scale = hit_scale[f];
+            r->field[f].confidence = conf;
+        } else if (hit_score[f][0] > 0) {
+            loc->offset = (unsigned short)(hit_idx[f][0] * 4);
+            loc->count = 1;
+            loc->stride = 4;
+            loc->scale = hit_scale[f];
+            r->field[f].confidence = hit_score[f][0];
+        } else {
+            continue;
+        }
+        r->field[f].evidence = evidence_for((pm_field_id)f);
+        if (loc->offset + (loc->count - 1u) * loc->stride + 4 > r->schema.size)
+            r->schema.size = loc->offset + (loc->count - 1u) * loc->stride + 4;
+    }
+out:
+    free(cands);
+    free(used);
+}
+
+/* ─── Driver ─── */
+
+int pm_infer_run(const pm_infer_opts_t *o, pm_infer_result_t *r)
+{
+    static sensors_t sens;
+    unsigned int phase_ms = o->phase_ms ? o->phase_ms : 1500;
+    unsigned int sample_ms = o->sample_ms ? o->sample_ms : 100;
+    unsigned int nidx = o->table_size / 4, nref, nphases, max_samples, n = 0;
+    unsigned int nthreads = o->threads;
+    volatile int phase = PHASE_IDLE, stop = 0;
+    stim_arg_t args[PM_INFER_MAX_CORES];
+    pthread_t stim[PM_INFER_MAX_CORES];
+    float *pm = NULL, *corr = NULL, *mean = NULL, *min = NULL, *max = NULL;
+    double *ref = NULL, *ref_mean = NULL;
+    unsigned char *constant = NULL;
+    struct timespec next;
+    int rc = -1;
+
+    memset(r, 0, sizeof(*r));
+    r->schema.name = "Inferred";
+    if (!o->read_pm || nidx == 0)
+        return -1;
+
+    memset(&sens, 0, sizeof(sens));
+    find_hwmon(&sens);
+    find_rapl(&sens);
+    find_topology(&sens, o->max_cores);
+    if (sens.ncores == 0)
+        return -1;
+    r->cores = sens.ncores;
+
+    nref = REF_FIXED + 3 * sens.ncores;
+    /* lead-in, per-core on + cool-down, all-core, tail */
+    nphases = 3 + 2 * sens.ncores;
+    max_samples = (phase_ms * (3 + sens.ncores) + (phase_ms / 2) * sens.ncores) / sample_ms +
+                  nphases + 1;
+
+    pm = malloc((size_t)max_samples * nidx * sizeof(float));
+    ref = calloc((size_t)max_samples * nref, sizeof(double));
+    if (!pm || !ref)
+        goto out;
+
+    /* A core whose thread did not start gets no phase and no stimulus label */
+    for (unsigned int c = 0; c < sens.ncores; c++) {
+        args[c] = (stim_arg_t){ sens.core_cpu[c], (int)c, &phase, &stop };
+        sens.stim[c] = pthread_create(&stim[c], NULL, stim_thread, &args[c]) == 0;
+    }
+
+    {
+        double scratch[REF_FIXED + 3 * PM_INFER_MAX_CORES];
+        sensors_sample(&sens, scratch, PHASE_IDLE);    /* prime deltas */
+    }
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (unsigned int p = 0; p < nphases && n < max_samples; p++) {
+        int ph;
+        unsigned int len;
+        char label[32];
+
+        if (p == 0 || p == nphases - 1) {
+            ph = PHASE_IDLE; len = phase_ms;
+            snprintf(label, sizeof(label), "idle");
+        } else if (p == nphases - 2) {
+            ph = PHASE_ALL; len = phase_ms;
+            snprintf(label, sizeof(label), "all cores");
+        } else if ((p - 1) % 2 == 0) {
+            ph = (int)((p - 1) / 2); len = phase_ms;
+            snprintf(label, sizeof(label), "core %d", ph);
+        } else {
+            ph = PHASE_IDLE; len = phase_ms / 2;
+            snprintf(label, sizeof(label), "cool-down");
+        }
+        if (p > 0 && p < nphases - 2 && !sens.stim[(p - 1) / 2])
+            continue;
+        __atomic_store_n(&phase, ph, __ATOMIC_RELAXED);
+
+        for (unsigned int el = 0; el < len && n < max_samples; el += sample_ms) {
+            next.tv_nsec += (long)sample_ms * 1000000L;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+            if (o->running && !*o->running) {
+                rc = -2;
+                goto stop_stim;
+            }
+            if (o->read_pm(o->ctx, pm + (size_t)n * nidx, o->table_size) != 0)
+                continue;
+            sensors_sample(&sens, ref + (size_t)n * nref, ph);
+            n++;
+            if (o->progress)
+                o->progress(o->ctx, label, n, max_samples);
+        }
+    }
+    rc = 0;
+
+stop_stim:
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (unsigned int c = 0; c < sens.ncores; c++) {
+        if (sens.stim[c])
+            pthread_join(stim[c], NULL);
+    }
+    if (rc != 0)
+        goto out;
+    rc = -1;
+    if (n < 8)
+        goto out;
+
+    r->samples = n;
+    r->sources = sens.sources;
+
+    corr = malloc((size_t)nidx * nref * sizeof(float));
+    mean = malloc(nidx * sizeof(float));
+    min = malloc(nidx * sizeof(float));
+    max = malloc(nidx * sizeof(float));
+    constant = calloc(nidx, 1);
+    ref_mean = calloc(nref, sizeof(double));
+    if (!corr || !mean || !min || !max || !constant || !ref_mean)
+        goto out;
+
+    for (unsigned int t = 0; t < n; t++) {
+        for (unsigned int k = 0; k < nref; k++)
+            ref_mean[k] += ref[(size_t)t * nref + k] / n;
+    }
+
+    if (o->progress)
+        o->progress(o->ctx, "correlating", n, n);
+    if (nthreads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 0 ? (unsigned int)cpus : 1;
+    }
+    if (correlate(pm, ref, n, nidx, nref, nthreads, corr, mean, min, max, constant) != 0)
+        goto out;
+
+    for (unsigned int i = 0; i < nidx; i++)
+        r->constant_indices += constant[i];
+
+    {
+        stats_t st = { corr, mean, min, max, constant, ref_mean, nidx, nref };
+        match_fields(&st, sens.ncores, sens.sources, r);
+    }
+    rc = 0;
+
+out:
+    free(pm);
+    free(ref);
+    free(corr);
+    free(mean);
+    free(min);
+    free(max);
+    free(constant);
+    free(ref_mean);
+    return rc;
+}
+
+void pm_infer_merge(const pm_infer_result_t *r, const pm_schema_t *base, float min_conf,
+                    pm_schema_t *out, float *conf_out)
+{
+    static char name[32];
+    char label[24];
+
+    if (base) {
+        *out = *base;
+        snprintf(name, sizeof(name), "%s + inferred", base->name);
+    } else {
+        memset(out, 0, sizeof(*out));
+        snprintf(name, sizeof(name), "Inferred");
+    }
+    out->name = name;
+
+    for (int f = 0; f < PMF_COUNT; f++) {
+        const pm_field_loc_t *l = &r->schema.loc[f];
+        int clash = 0;
+
+        if (conf_out)
+            conf_out[f] = pm_has(base, (pm_field_id)f) ? 1.f : 0.f;
+        if (pm_has(base, (pm_field_id)f) || !l->count ||
+            r->field[f].confidence < min_conf)
+            continue;
+        for (unsigned int e = 0; e < l->count && !clash; e++)
+            clash = pm_schema_index_label(base, (l->offset + e * l->stride) / 4u,
+                                          label, sizeof(label));
+        if (clash)
+            continue;
+
+        out->loc[f] = *l;
+        if (conf_out)
+            conf_out[f] = r->field[f].confidence;
+        if (l->offset + (l->count - 1u) * l->stride + 4 > out->size)
+            out->size = l->offset + (l->count - 1u) * l->stride + 4;
+    }
+}
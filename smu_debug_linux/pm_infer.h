@@ -0,0 +1,68 @@
+/*
+ * PM table layout inference.
+ *
+ * Loads one physical core at a time with a pinned spin thread while sampling
+ * the raw PM table next to kernel sensors (k10temp Tctl, cpufreq
+ * scaling_cur_freq, powercap/RAPL package energy, /proc/stat per-CPU busy).
+ * Every float index is then correlated against every reference signal on a
+ * pool of worker threads, and the best plausible index per field becomes a
+ * proposal with a 0..1 confidence. Per-core hits are fitted to one
+ * offset/count/stride array. Results merge into a pm_schema_t, so they can be
+ * registered for the session or saved as a field map.
+ */
+#ifndef PM_INFER_H
+#define PM_INFER_H
+
+#include <signal.h>
+
+#include "pm_schema.h"
+
+#define PM_INFER_MAX_CORES  64
+
+/* Reference sources found on this system (pm_infer_result_t.sources) */
+#define PM_INFER_SRC_HWMON     0x1
+#define PM_INFER_SRC_CPUFREQ   0x2
+#define PM_INFER_SRC_RAPL      0x4
+#define PM_INFER_SRC_PROCSTAT  0x8
+
+typedef struct {
+    unsigned int table_size;    /* PM table bytes */
+    unsigned int phase_ms;      /* stimulus on-time per core (0 = 1500) */
+    unsigned int sample_ms;     /* sampling period (0 = 100) */
+    unsigned int max_cores;     /* cores to stimulate (0 = all) */
+    unsigned int threads;       /* correlation workers (0 = online CPUs) */
+    /* Read one PM table snapshot into buf; 0 on success. */
+    int  (*read_pm)(void *ctx, void *buf, unsigned int size);
+    /* Optional progress: phase label and sample counts. */
+    void (*progress)(void *ctx, const char *phase, unsigned int done, unsigned int total);
+    /* Optional: abort when *running becomes 0 (e.g. SIGINT). */
+    volatile sig_atomic_t *running;
+    void *ctx;
+} pm_infer_opts_t;
+
+typedef struct {
+    float        confidence;    /* 0 = not found */
+    const char  *evidence;      /* reference signal that matched */
+} pm_infer_field_t;
+
+typedef struct {
+    pm_schema_t       schema;   /* inferred fields only */
+    pm_infer_field_t  field[PMF_COUNT];
+    unsigned int      samples;
+    unsigned int      cores;            /* physical cores stimulated */
+    unsigned int      constant_indices; /* floats that never changed */
+    unsigned int      sources;          /* PM_INFER_SRC_* */
+} pm_infer_result_t;
+
+/* Run stimulus, sampling and correlation. 0 on success, -1 on error, -2 if cancelled. */
+int pm_infer_run(const pm_infer_opts_t *o, pm_infer_result_t *r);
+
+/*
+ * base (may be NULL) plus inferred fields with confidence >= min_conf that
+ * base does not already name and that do not overlap indices base names.
+ * conf_out (optional, PMF_COUNT) gets 1 for base fields, confidence otherwise.
+ */
+void pm_infer_merge(const pm_infer_result_t *r, const pm_schema_t *base, float min_conf,
+                    pm_schema_t *out, float *conf_out);
+
+#endif
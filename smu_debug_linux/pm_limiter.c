@@ -0,0 +1,168 @@
+/*
+ * Limiter attribution (see pm_limiter.h).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pm_limiter.h"
+
+/* A limiter counts as engaged within 5% of its limit (THM: within 1 C). */
+#define LIMIT_ENGAGED   0.95f
+#define THM_ENGAGED_C   1.0f
+
+static const struct {
+    const char *name;
+    int value, limit;
+    const char *hint;
+} limiters[PM_LIM_COUNT] = {
+    [PM_LIM_PPT]     = { "PPT", PMF_PPT_VALUE, PMF_PPT_LIMIT, "package power: raise PPT" },
+    [PM_LIM_TDC]     = { "TDC", PMF_TDC_VALUE, PMF_TDC_LIMIT, "sustained current: raise TDC" },
+    [PM_LIM_EDC]     = { "EDC", PMF_EDC_VALUE, PMF_EDC_LIMIT,
+                         "peak current: raise EDC or lower voltage with CO" },
+    [PM_LIM_THM]     = { "THM", PMF_THM_VALUE, PMF_THM_LIMIT, "temperature: improve cooling" },
+    [PM_LIM_FIT]     = { "FIT", PMF_FIT_VALUE, PMF_FIT_LIMIT,
+                         "silicon reliability: lower voltage with CO" },
+    [PM_LIM_PROCHOT] = { "PROCHOT", PMF_PROCHOT, -1,
+                         "external throttle: check VRM and board temperatures" },
+};
+
+const char *pm_limit_name(pm_limit_id l)
+{
+    return (unsigned)l < PM_LIM_COUNT ? limiters[l].name : "?";
+}
+
+const char *pm_limiter_class_name(int cls)
+{
+    if (cls == PM_LIM_NONE)
+        return "None";
+    if (cls == PM_LIM_IDLE)
+        return "Idle";
+    if (cls == PM_LIM_UNKNOWN)
+        return "Unknown";
+    return pm_limit_name((pm_limit_id)cls);
+}
+
+const char *pm_limiter_hint(int cls)
+{
+    if (cls == PM_LIM_NONE)
+        return "boost ceiling: raise FMax or tune CO";
+    if (cls == PM_LIM_IDLE)
+        return "idle";
+    if (cls == PM_LIM_UNKNOWN)
+        return "load unknown: no per-core C0 and package power below half of PPT";
+    return (unsigned)cls < PM_LIM_COUNT ? limiters[cls].hint : "";
+}
+
+int pm_limit_value_field(pm_limit_id l)
+{
+    return (unsigned)l < PM_LIM_COUNT ? limiters[l].value : -1;
+}
+
+int pm_limit_limit_field(pm_limit_id l)
+{
+    return (unsigned)l < PM_LIM_COUNT ? limiters[l].limit : -1;
+}
+
+int pm_load_from_ppt(float value, float limit)
+{
+    return !isnan(value) && limit > 0.f && value >= limit * PM_LOAD_PPT_PCT / 100.f ? 1 : -1;
+}
+
+int pm_limit_engaged(pm_limit_id l, float v, float m)
+{
+    if (l == PM_LIM_PROCHOT)
+        return !isnan(v) && v > 0.f;
+    if (isnan(v) || isnan(m) || m <= 0.f)
+        return 0;
+    return l == PM_LIM_THM ? v >= m - THM_ENGAGED_C : v >= m * LIMIT_ENGAGED;
+}
+
+void pm_limiter_init(pm_limiter_t *c, const pm_schema_t *schema, unsigned int ncores,
+                     const int *slot)
+{
+    memset(c, 0, sizeof(*c));
+    c->schema = schema;
+    c->ncores = pm_core_slots(schema, PMF_CORE_C0, slot, ncores, c->slot);
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        if (pm_has(schema, (pm_field_id)limiters[l].value) &&
+            (limiters[l].limit < 0 || pm_has(schema, (pm_field_id)limiters[l].limit)))
+            c->avail |= 1u << l;
+    }
+}
+
+void pm_limiter_classify(const pm_limiter_t *c, const void *tab, pm_limiter_state_t *st)
+{
+    const pm_schema_t *sc = c->schema;
+    float best = -INFINITY;
+    int loaded = 0;                     /* 1 loaded, 0 idle, -1 unknown */
+
+    st->engaged = 0;
+    st->primary = PM_LIM_NONE;
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        float v, m;
+
+        st->pct[l] = NAN;
+        if (!(c->avail & (1u << l)))
+            continue;
+        v = pm_get(sc, tab, (pm_field_id)limiters[l].value);
+        m = limiters[l].limit >= 0 ? pm_get(sc, tab, (pm_field_id)limiters[l].limit) : NAN;
+        if (l == PM_LIM_PROCHOT)
+            st->pct[l] = v > 0.f ? 100.f : 0.f;
+        else if (m > 0.f)
+            st->pct[l] = v / m * 100.f;
+        if (!pm_limit_engaged((pm_limit_id)l, v, m))
+            continue;
+        st->engaged |= 1u << l;
+
+        /* PROCHOT overrides everything; otherwise the tightest limit wins */
+        if (l == PM_LIM_PROCHOT) {
+            st->primary = l;
+            best = INFINITY;
+        } else if (st->pct[l] > best) {
+            st->primary = l;
+            best = st->pct[l];
+        }
+    }
+
+    if (st->engaged)
+        return;
+    if (c->ncores) {
+        for (unsigned int i = 0; i < c->ncores && !loaded; i++)
+            loaded = pm_get_at(sc, tab, PMF_CORE_C0, (unsigned int)c->slot[i]) >= PM_LOAD_C0_PCT;
+    } else {
+        loaded = pm_load_from_ppt(pm_get(sc, tab, PMF_PPT_VALUE), pm_get(sc, tab, PMF_PPT_LIMIT));
+    }
+    if (loaded == 0)
+        st->primary = PM_LIM_IDLE;
+    else if (loaded < 0)
+        st->primary = PM_LIM_UNKNOWN;
+}
+
+void pm_limiter_acc_add(pm_limiter_acc_t *a, const pm_limiter_state_t *st, double dt)
+{
+    if (dt <= 0)
+        return;
+    a->seconds += dt;
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        if (st->engaged & (1u << l))
+            a->engaged_s[l] += dt;
+    }
+    a->class_s[st->primary] += dt;
+}
+
+void pm_limiter_format(unsigned int engaged, char *buf, size_t len)
+{
+    size_t n = 0;
+
+    if (len == 0)
+        return;
+    buf[0] = '\0';
+    for (int l = 0; l < PM_LIM_COUNT && n < len; l++) {
+        if (engaged & (1u << l))
+            n += (size_t)snprintf(buf + n, len - n, "%s%s", n ? "+" : "", limiters[l].name);
+    }
+    if (!engaged)
+        snprintf(buf, len, "-");
+}
@@ -0,0 +1,81 @@
+/*
+ * Limiter attribution: which firmware limit is capping boost.
+ *
+ * Each PM snapshot is classified into the set of engaged limiters and one
+ * primary class: the engaged limiter nearest (or furthest past) its cap,
+ * "None" when the CPU is loaded but nothing is engaged (boost is at the
+ * FMax / voltage-frequency ceiling), "Idle", or "Unknown" when the layout
+ * gives no way to tell load from idle. Residency per class is accumulated
+ * over time.
+ */
+#ifndef PM_LIMITER_H
+#define PM_LIMITER_H
+
+#include <stddef.h>
+
+#include "pm_schema.h"
+
+typedef enum {
+    PM_LIM_PPT, PM_LIM_TDC, PM_LIM_EDC, PM_LIM_THM, PM_LIM_FIT, PM_LIM_PROCHOT,
+    PM_LIM_COUNT
+} pm_limit_id;
+
+/* Primary classes beyond the limiters themselves */
+#define PM_LIM_NONE     PM_LIM_COUNT            /* loaded, nothing engaged */
+#define PM_LIM_IDLE     (PM_LIM_COUNT + 1)
+#define PM_LIM_UNKNOWN  (PM_LIM_COUNT + 2)      /* nothing engaged, load unknown */
+#define PM_LIM_CLASSES  (PM_LIM_COUNT + 3)
+
+/* A sample is under load when any core spends at least this much in C0. */
+#define PM_LOAD_C0_PCT  50.0f
+
+/* Without per-core C0, package power at this share of PPT or more counts as
+ * load; below it, light load and idle look alike and the sample is Unknown. */
+#define PM_LOAD_PPT_PCT 50.0f
+
+typedef struct {
+    const pm_schema_t *schema;
+    unsigned int       ncores;
+    int                slot[PM_MAX_CORES];  /* PMF_CORE_C0 index of each core */
+    unsigned int       avail;       /* bit per pm_limit_id the layout reports */
+} pm_limiter_t;
+
+typedef struct {
+    unsigned int engaged;           /* bit per pm_limit_id */
+    int          primary;           /* pm_limit_id, PM_LIM_NONE or PM_LIM_IDLE */
+    float        pct[PM_LIM_COUNT]; /* value as % of limit; NAN if not reported */
+} pm_limiter_state_t;
+
+typedef struct {
+    double seconds;
+    double engaged_s[PM_LIM_COUNT]; /* limiters overlap */
+    double class_s[PM_LIM_CLASSES]; /* sums to seconds */
+} pm_limiter_acc_t;
+
+/* slot: PM array index of each core (see pm_core_slots), NULL if dense. */
+void pm_limiter_init(pm_limiter_t *c, const pm_schema_t *schema, unsigned int ncores,
+                     const int *slot);
+void pm_limiter_classify(const pm_limiter_t *c, const void *table, pm_limiter_state_t *st);
+
+/* Account the interval dt to st (rectangular: the state held for dt). */
+void pm_limiter_acc_add(pm_limiter_acc_t *a, const pm_limiter_state_t *st, double dt);
+
+/* Whether a limiter counts as engaged: within 5% of the limit, THM within
+ * 1 C, PROCHOT asserted (limit unused). */
+int pm_limit_engaged(pm_limit_id l, float value, float limit);
+
+/* Package-level load from PPT (value, limit): 1 loaded, -1 unknown. */
+int pm_load_from_ppt(float value, float limit);
+
+/* Fields holding a limiter's value and limit (limit -1 for PROCHOT). */
+int pm_limit_value_field(pm_limit_id l);
+int pm_limit_limit_field(pm_limit_id l);
+
+const char *pm_limit_name(pm_limit_id l);       /* "PPT", ... */
+const char *pm_limiter_class_name(int cls);     /* limiter name, "None", "Idle", "Unknown" */
+const char *pm_limiter_hint(int cls);           /* what would lift the cap */
+
+/* "PPT+THM", or "-" for none */
+void pm_limiter_format(unsigned int engaged, char *buf, size_t len);
+
+#endif
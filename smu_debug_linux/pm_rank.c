@@ -0,0 +1,503 @@
+/*
+ * Preferred-core ranking (see pm_rank.h).
+ *
+ * Per core: cool-down (idle, its tail gives the idle package power), then
+ * load with one spin thread pinned to the core's first logical CPU. The
+ * sampling thread is kept off the loaded core so it does not steal cycles
+ * or add a second thread's worth of current.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pm_checkpoint.h"
+#include "pm_rank.h"
+
+#define MAX_CPUS            1024
+#define STATE_HEADER        "# smu_debug_tool rank checkpoint v1"
+#define LOADED_C0_PCT       90.0f   /* below this the spin thread was not running */
+#define BACKGROUND_C0_PCT   20.0f   /* other cores above this: something else ran */
+
+static int read_long(const char *path, long *out)
+{
+    FILE *fp = fopen(path, "r");
+    int ok;
+
+    if (!fp)
+        return -1;
+    ok = fscanf(fp, "%ld", out) == 1;
+    fclose(fp);
+    return ok ? 0 : -1;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* ─── Topology ─── */
+
+unsigned int pm_rank_topology(pm_rank_topo_t *t, unsigned int max_cores)
+{
+    static unsigned long long keys[MAX_CPUS], uniq[MAX_CPUS];
+    unsigned int ncpu = 0, nuniq = 0;
+    char path[128];
+
+    memset(t, 0, sizeof(*t));
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        long pkg = 0, die = 0, core;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+        if (access(path, F_OK) != 0)
+            break;
+        ncpu = cpu + 1;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        keys[cpu] = ~0ULL;
+        if (read_long(path, &core) != 0)
+            continue;                                   /* offline */
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        read_long(path, &pkg);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/die_id", cpu);
+        read_long(path, &die);
+        keys[cpu] = ((unsigned long long)pkg << 40) | ((unsigned long long)die << 20) |
+                    (unsigned long long)core;
+        uniq[nuniq++] = keys[cpu];
+    }
+
+    qsort(uniq, nuniq, sizeof(uniq[0]), cmp_u64);
+    for (unsigned int i = 0; i < nuniq; i++) {
+        if (i > 0 && uniq[i] == uniq[i - 1])
+            continue;
+        uniq[t->ncores++] = uniq[i];
+    }
+    t->nfound = t->ncores;
+    if (max_cores && t->ncores > max_cores)
+        t->ncores = max_cores;
+    if (t->ncores > PM_RANK_MAX_CORES)
+        t->ncores = PM_RANK_MAX_CORES;
+
+    for (unsigned int c = 0; c < t->ncores; c++)
+        t->slot[c] = (int)c;
+    for (unsigned int cpu = 0; cpu < ncpu; cpu++) {
+        for (unsigned int c = 0; c < t->ncores; c++) {
+            if (keys[cpu] != uniq[c])
+                continue;
+            if (t->nthreads[c] < PM_RANK_MAX_THREADS)
+                t->cpu[c][t->nthreads[c]++] = (int)cpu;
+            break;
+        }
+    }
+    return t->ncores;
+}
+
+/* amd-pstate preferred-core ranking, else the ACPI CPPC highest_perf. */
+static int kernel_cppc(int cpu)
+{
+    char path[128];
+    long v;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpufreq/policy%d/amd_pstate_prefcore_ranking", cpu);
+    if (read_long(path, &v) == 0)
+        return (int)v;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/acpi_cppc/highest_perf", cpu);
+    if (read_long(path, &v) == 0)
+        return (int)v;
+    return -1;
+}
+
+/* ─── Checkpoint ─── */
+
+static void state_params(const pm_rank_opts_t *o, unsigned int ncores, unsigned int load_ms,
+                         unsigned int warm_ms, unsigned int cool_ms, char *buf, size_t len)
+{
+    snprintf(buf, len, "version 0x%06X cores %u load %u warm %u cool %u",
+             o->version, ncores, load_ms, warm_ms, cool_ms);
+}
+
+static int state_save(const char *path, const char *params, const pm_rank_result_t *r)
+{
+    pm_ckpt_t ck;
+
+    if (pm_ckpt_begin(&ck, path, STATE_HEADER, params) != 0)
+        return -1;
+    fprintf(ck.fp, "# core samples freq peak volt power temp temp_peak c0 others_c0 "
+            "cppc_pm cppc_kernel disturbed\n");
+    for (unsigned int c = 0; c < r->topo.ncores; c++) {
+        const pm_rank_core_t *k = &r->core[c];
+        if (!k->done)
+            continue;
+        fprintf(ck.fp, "core %u %u %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %d %d\n",
+                c, k->samples, k->freq_mhz, k->freq_peak_mhz, k->volt, k->power_w,
+                k->temp_c, k->temp_peak_c, k->c0_pct, k->others_c0_pct, k->cppc_pm,
+                k->cppc_kernel, k->disturbed);
+    }
+    return pm_ckpt_commit(&ck);
+}
+
+/* One "core" record; 1 if it restores a core not yet done. */
+static int state_line(void *ctx, const char *line)
+{
+    pm_rank_result_t *r = ctx;
+    pm_rank_core_t k;
+    unsigned int c;
+    int fresh;
+
+    memset(&k, 0, sizeof(k));
+    if (sscanf(line, "core %u %u %f %f %f %f %f %f %f %f %f %d %d", &c, &k.samples,
+               &k.freq_mhz, &k.freq_peak_mhz, &k.volt, &k.power_w, &k.temp_c,
+               &k.temp_peak_c, &k.c0_pct, &k.others_c0_pct, &k.cppc_pm,
+               &k.cppc_kernel, &k.disturbed) != 13 || c >= r->topo.ncores)
+        return 0;
+    k.done = 1;
+    fresh = !r->core[c].done;
+    r->core[c] = k;
+    return fresh;
+}
+
+/* Cores from a checkpoint taken with the same parameters; count restored. */
+static unsigned int state_load(const char *path, const char *params, pm_rank_result_t *r)
+{
+    return pm_ckpt_load(path, STATE_HEADER, params, state_line, r);
+}
+
+/* ─── Measurement ─── */
+
+typedef struct {
+    int cpu;
+    volatile int stop;
+} spin_arg_t;
+
+static void *spin_thread(void *p)
+{
+    spin_arg_t *a = p;
+    cpu_set_t set;
+    volatile double x = 1.0;
+
+    CPU_ZERO(&set);
+    CPU_SET(a->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    while (!__atomic_load_n(&a->stop, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < 100000; i++)
+            x = x * 1.0000001 + 1e-9;
+    }
+    return NULL;
+}
+
+/* Keep the caller off core c (no-op on a single-core system). */
+static void avoid_core(const pm_rank_topo_t *t, unsigned int c, const cpu_set_t *all)
+{
+    cpu_set_t set = *all;
+
+    for (unsigned int i = 0; i < t->nthreads[c]; i++)
+        CPU_CLR(t->cpu[c][i], &set);
+    if (CPU_COUNT(&set) > 0)
+        sched_setaffinity(0, sizeof(set), &set);
+}
+
+static void tick(struct timespec *next, unsigned int ms)
+{
+    next->tv_nsec += (long)ms * 1000000L;
+    while (next->tv_nsec >= 1000000000L) {
+        next->tv_nsec -= 1000000000L;
+        next->tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL);
+}
+
+typedef struct {
+    const pm_rank_opts_t *o;
+    unsigned int load_ms, warm_ms, cool_ms, sample_ms;
+    unsigned int done_ms, total_ms;     /* progress over all pending cores */
+    unsigned char *buf;
+} measure_t;
+
+static int measure_core(measure_t *m, const pm_rank_topo_t *t, unsigned int c,
+                        pm_rank_core_t *k)
+{
+    const pm_rank_opts_t *o = m->o;
+    const pm_schema_t *sc = o->schema;
+    unsigned int ncores = t->ncores, slot = (unsigned int)t->slot[c];
+    double idle_sum = 0, f_sum = 0, v_sum = 0, p_sum = 0, t_sum = 0, c0_sum = 0, oc0_sum = 0;
+    unsigned int idle_n = 0, n = 0, v_n = 0, p_n = 0;
+    int have_cpow = pm_count(sc, PMF_CORE_POWER) > slot;
+    int have_cvolt = pm_count(sc, PMF_CORE_VOLTAGE) > slot;
+    spin_arg_t spin = { t->cpu[c][0], 0 };
+    pthread_t tid;
+    struct timespec next;
+    double t0;
+    int rc = 0;
+
+    memset(k, 0, sizeof(*k));
+    k->freq_peak_mhz = k->temp_peak_c = -INFINITY;
+
+    /* Cool-down; the second half is the idle package power baseline */
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (unsigned int el = 0; el < m->cool_ms; el += m->sample_ms) {
+        tick(&next, m->sample_ms);
+        if (o->running && !*o->running)
+            return -2;
+        if (el >= m->cool_ms / 2 && o->read_pm(o->ctx, m->buf, o->table_size) == 0) {
+            float p = pm_get(sc, m->buf, PMF_SOCKET_POWER);
+            if (!isnan(p)) {
+                idle_sum += p;
+                idle_n++;
+            }
+        }
+        if (o->progress)
+            o->progress(o->ctx, c, "cool-down", m->done_ms + el, m->total_ms);
+    }
+    m->done_ms += m->cool_ms;
+
+    if (pthread_create(&tid, NULL, spin_thread, &spin) != 0)
+        return -1;
+    t0 = pm_now_sec();
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (unsigned int el = 0; el < m->load_ms; el += m->sample_ms) {
+        double oc0 = 0;
+        float f, v, p, temp;
+
+        tick(&next, m->sample_ms);
+        if (o->running && !*o->running) {
+            rc = -2;
+            break;
+        }
+        if (o->progress)
+            o->progress(o->ctx, c, "load", m->done_ms + el, m->total_ms);
+        if (o->read_pm(o->ctx, m->buf, o->table_size) != 0)
+            continue;
+
+        f = pm_get_at(sc, m->buf, PMF_CORE_FREQEFF, slot);
+        temp = pm_get_at(sc, m->buf, PMF_CORE_TEMP, slot);
+        if (f > k->freq_peak_mhz)
+            k->freq_peak_mhz = f;
+        if (temp > k->temp_peak_c)
+            k->temp_peak_c = temp;
+        if ((pm_now_sec() - t0) * 1000.0 < m->warm_ms)
+            continue;
+
+        v = have_cvolt ? pm_get_at(sc, m->buf, PMF_CORE_VOLTAGE, slot)
+                       : pm_get(sc, m->buf, PMF_CPU_TELEMETRY_VOLTAGE);
+        p = have_cpow ? pm_get_at(sc, m->buf, PMF_CORE_POWER, slot)
+                      : idle_n ? pm_get(sc, m->buf, PMF_SOCKET_POWER) - (float)(idle_sum / idle_n)
+                               : NAN;
+        f_sum += f;
+        t_sum += temp;
+        c0_sum += pm_get_at(sc, m->buf, PMF_CORE_C0, slot);
+        for (unsigned int i = 0; i < ncores; i++) {
+            if (i != c)
+                oc0 += pm_get_at(sc, m->buf, PMF_CORE_C0, t->slot[i]);
+        }
+        oc0_sum += ncores > 1 ? oc0 / (ncores - 1) : 0;
+        if (!isnan(v)) {
+            v_sum += v;
+            v_n++;
+        }
+        if (!isnan(p)) {
+            p_sum += p;
+            p_n++;
+        }
+        n++;
+    }
+    __atomic_store_n(&spin.stop, 1, __ATOMIC_RELAXED);
+    pthread_join(tid, NULL);
+    m->done_ms += m->load_ms;
+    if (rc != 0)
+        return rc;
+    if (n == 0)
+        return -1;
+
+    k->samples = n;
+    k->freq_mhz = (float)(f_sum / n);
+    k->temp_c = (float)(t_sum / n);
+    k->c0_pct = (float)(c0_sum / n);
+    k->others_c0_pct = (float)(oc0_sum / n);
+    k->volt = v_n ? (float)(v_sum / v_n) : NAN;
+    k->power_w = p_n ? (float)(p_sum / p_n) : NAN;
+    if (isinf(k->temp_peak_c))
+        k->temp_peak_c = NAN;
+    k->cppc_pm = pm_count(sc, PMF_CORE_CPPC_MAX) > slot
+                 ? pm_get_at(sc, m->buf, PMF_CORE_CPPC_MAX, slot) : NAN;
+    k->cppc_kernel = kernel_cppc(t->cpu[c][0]);
+    k->disturbed = (!isnan(k->c0_pct) && k->c0_pct < LOADED_C0_PCT) ||
+                   (!isnan(k->others_c0_pct) && k->others_c0_pct > BACKGROUND_C0_PCT);
+    k->done = 1;
+    return 0;
+}
+
+/* ─── Ranking ─── */
+
+static int cmp_boost(const void *a, const void *b, void *arg)
+{
+    const pm_rank_core_t *k = arg, *x = &k[*(const int *)a], *y = &k[*(const int *)b];
+    float bx = floorf(x->freq_mhz / PM_RANK_TIE_MHZ), by = floorf(y->freq_mhz / PM_RANK_TIE_MHZ);
+    float ex = isnan(x->mhz_per_w) ? -1.f : x->mhz_per_w;
+    float ey = isnan(y->mhz_per_w) ? -1.f : y->mhz_per_w;
+
+    if (bx != by)
+        return bx > by ? -1 : 1;
+    if (ex != ey)
+        return ex > ey ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+static int cmp_eff(const void *a, const void *b, void *arg)
+{
+    const pm_rank_core_t *k = arg, *x = &k[*(const int *)a], *y = &k[*(const int *)b];
+
+    if (x->mhz_per_w != y->mhz_per_w)
+        return x->mhz_per_w > y->mhz_per_w ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+static void rank(pm_rank_result_t *r)
+{
+    unsigned int nb = 0;
+
+    r->neff = 0;
+    for (unsigned int c = 0; c < r->topo.ncores; c++) {
+        pm_rank_core_t *k = &r->core[c];
+        k->mhz_per_w = k->power_w > 0.1f ? k->freq_mhz / k->power_w : NAN;
+        r->by_boost[nb++] = (int)c;
+        if (!isnan(k->mhz_per_w))
+            r->by_eff[r->neff++] = (int)c;
+    }
+    qsort_r(r->by_boost, nb, sizeof(int), cmp_boost, r->core);
+    qsort_r(r->by_eff, r->neff, sizeof(int), cmp_eff, r->core);
+}
+
+int pm_rank_run(const pm_rank_opts_t *o, pm_rank_result_t *r)
+{
+    measure_t m = { o, o->load_ms ? o->load_ms : 6000, o->warm_ms ? o->warm_ms : 1000,
+                    o->cool_ms ? o->cool_ms : 2000, o->sample_ms ? o->sample_ms : 50,
+                    0, 0, NULL };
+    const pm_schema_t *sc = o->schema;
+    char params[160];
+    cpu_set_t all;
+    unsigned int pending = 0;
+    int rc = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (!o->read_pm || !pm_has(sc, PMF_CORE_FREQEFF) || m.warm_ms >= m.load_ms)
+        return -1;
+    if (pm_rank_topology(&r->topo, o->max_cores) == 0)
+        return -1;
+    if (o->slot && o->nslots == r->topo.nfound)
+        memcpy(r->topo.slot, o->slot, r->topo.ncores * sizeof(o->slot[0]));
+    for (unsigned int c = 0; c < r->topo.ncores; c++) {
+        if ((unsigned int)r->topo.slot[c] >= pm_count(sc, PMF_CORE_FREQEFF)) {
+            r->topo.ncores = c;
+            break;
+        }
+    }
+    r->power_src = pm_has(sc, PMF_CORE_POWER) ? "CORE_POWER" :
+                   pm_has(sc, PMF_SOCKET_POWER) ? "SOCKET_POWER-idle" : NULL;
+
+    state_params(o, r->topo.ncores, m.load_ms, m.warm_ms, m.cool_ms, params, sizeof(params));
+    if (o->state_path && !o->fresh)
+        r->resumed = state_load(o->state_path, params, r);
+
+    for (unsigned int c = 0; c < r->topo.ncores; c++)
+        pending += !r->core[c].done;
+    m.total_ms = pending * (m.cool_ms + m.load_ms);
+    m.buf = calloc(o->table_size, 1);
+    if (!m.buf || sched_getaffinity(0, sizeof(all), &all) != 0) {
+        free(m.buf);
+        return -1;
+    }
+
+    for (unsigned int c = 0; c < r->topo.ncores && rc == 0; c++) {
+        if (r->core[c].done)
+            continue;
+        avoid_core(&r->topo, c, &all);
+        rc = measure_core(&m, &r->topo, c, &r->core[c]);
+        if (rc == 0 && o->state_path && state_save(o->state_path, params, r) != 0)
+            rc = -1;
+    }
+    sched_setaffinity(0, sizeof(all), &all);
+    free(m.buf);
+    if (rc != 0)
+        return rc;
+
+    if (o->state_path)
+        unlink(o->state_path);
+    rank(r);
+    return 0;
+}
+
+/* ─── Affinity output ─── */
+
+static unsigned int collect_cpus(const pm_rank_topo_t *t, const int *cores, unsigned int n,
+                                 int all_threads, int *cpus)
+{
+    unsigned int k = 0;
+
+    for (unsigned int i = 0; i < n; i++) {
+        int c = cores[i];
+        for (unsigned int j = 0; j < t->nthreads[c] && (all_threads || j == 0); j++)
+            cpus[k++] = t->cpu[c][j];
+    }
+    for (unsigned int i = 1; i < k; i++) {          /* insertion sort; k is small */
+        int v = cpus[i];
+        unsigned int j = i;
+        while (j > 0 && cpus[j - 1] > v) {
+            cpus[j] = cpus[j - 1];
+            j--;
+        }
+        cpus[j] = v;
+    }
+    return k;
+}
+
+void pm_rank_mask(const pm_rank_topo_t *t, const int *cores, unsigned int n,
+                  int all_threads, char *buf, size_t len)
+{
+    int cpus[PM_RANK_MAX_CORES * PM_RANK_MAX_THREADS];
+    unsigned char nib[MAX_CPUS / 4] = { 0 };
+    unsigned int k = collect_cpus(t, cores, n, all_threads, cpus);
+    int top = 0;
+    size_t w;
+
+    for (unsigned int i = 0; i < k; i++) {
+        nib[cpus[i] / 4] |= (unsigned char)(1u << (cpus[i] % 4));
+        if (cpus[i] / 4 > top)
+            top = cpus[i] / 4;
+    }
+    w = (size_t)snprintf(buf, len, "0x");
+    for (int i = top; i >= 0 && w + 1 < len; i--)
+        buf[w++] = "0123456789abcdef"[nib[i]];
+    if (w < len)
+        buf[w] = '\0';
+}
+
+void pm_rank_cpulist(const pm_rank_topo_t *t, const int *cores, unsigned int n,
+                     int all_threads, char *buf, size_t len)
+{
+    int cpus[PM_RANK_MAX_CORES * PM_RANK_MAX_THREADS];
+    unsigned int k = collect_cpus(t, cores, n, all_threads, cpus);
+    size_t w = 0;
+
+    if (len)
+        buf[0] = '\0';
+    for (unsigned int i = 0; i < k && w < len; ) {
+        unsigned int j = i;
+        while (j + 1 < k && cpus[j + 1] == cpus[j] + 1)
+            j++;
+        if (j > i)
+            w += (size_t)snprintf(buf + w, len - w, "%s%d-%d", w ? "," : "", cpus[i], cpus[j]);
+        else
+            w += (size_t)snprintf(buf + w, len - w, "%s%d", w ? "," : "", cpus[i]);
+        i = j + 1;
+    }
+}
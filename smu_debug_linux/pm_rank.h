@@ -0,0 +1,103 @@
+/*
+ * Preferred-core ranking.
+ *
+ * Runs a pinned single-thread spin load on one physical core at a time,
+ * with an idle cool-down before each, and samples that core's PM fields
+ * (CORE_FREQEFF, CORE_VOLTAGE, CORE_POWER, CORE_TEMP, CORE_CPPC_MAX) plus
+ * the kernel's CPPC ranking. Cores are ranked by sustained boost and by
+ * efficiency (MHz per W); the result maps back to logical CPUs for
+ * affinity masks and cpuset lists.
+ *
+ * With a state file, every finished core is checkpointed; a later run with
+ * the same table version and timing picks up where the last one stopped.
+ */
+#ifndef PM_RANK_H
+#define PM_RANK_H
+
+#include <signal.h>
+#include <stddef.h>
+
+#include "pm_schema.h"
+
+#define PM_RANK_MAX_CORES   64
+#define PM_RANK_MAX_THREADS 4       /* SMT siblings per core */
+
+/* Sustained clocks within this many MHz rank as equal; efficiency breaks ties. */
+#define PM_RANK_TIE_MHZ     25.0f
+
+typedef struct {
+    unsigned int ncores;            /* physical cores, PM array order */
+    unsigned int nfound;            /* cores online before max_cores */
+    int          slot[PM_RANK_MAX_CORES];       /* PM per-core array index */
+    unsigned int nthreads[PM_RANK_MAX_CORES];
+    int          cpu[PM_RANK_MAX_CORES][PM_RANK_MAX_THREADS];
+} pm_rank_topo_t;
+
+typedef struct {
+    int          done;
+    unsigned int samples;           /* after warm-up */
+    float        freq_mhz;          /* sustained: mean after warm-up */
+    float        freq_peak_mhz;
+    float        volt;              /* CORE_VOLTAGE, else CPU_TELEMETRY_VOLTAGE */
+    float        power_w;           /* CORE_POWER, else package power over idle */
+    float        temp_c, temp_peak_c;
+    float        c0_pct;            /* loaded core */
+    float        others_c0_pct;     /* mean of the other cores: background load */
+    float        cppc_pm;           /* CORE_CPPC_MAX, NAN if absent */
+    int          cppc_kernel;       /* prefcore ranking or CPPC highest_perf, -1 */
+    float        mhz_per_w;
+    int          disturbed;         /* loaded core not busy or others busy */
+} pm_rank_core_t;
+
+typedef struct {
+    const pm_schema_t *schema;
+    unsigned int table_size;        /* PM table bytes */
+    unsigned int version;           /* PM table version, for the state file */
+    unsigned int load_ms;           /* load per core (0 = 6000) */
+    unsigned int warm_ms;           /* load excluded from sustained (0 = 1000) */
+    unsigned int cool_ms;           /* idle before each core (0 = 2000) */
+    unsigned int sample_ms;         /* 0 = 50 */
+    unsigned int max_cores;         /* 0 = all */
+    /* PM array slot of each core in topology order (fused-off cores leave
+     * gaps); NULL, or a count other than the cores found, = dense. */
+    const int   *slot;
+    unsigned int nslots;
+    const char  *state_path;        /* checkpoint file; NULL = not resumable */
+    int          fresh;             /* ignore an existing checkpoint */
+    /* Read one PM snapshot into buf; 0 on success. */
+    int  (*read_pm)(void *ctx, void *buf, unsigned int size);
+    /* Optional progress: core being measured, phase label, elapsed/total ms. */
+    void (*progress)(void *ctx, unsigned int core, const char *phase,
+                     unsigned int done_ms, unsigned int total_ms);
+    volatile sig_atomic_t *running;
+    void *ctx;
+} pm_rank_opts_t;
+
+typedef struct {
+    pm_rank_topo_t topo;
+    pm_rank_core_t core[PM_RANK_MAX_CORES];
+    unsigned int   resumed;         /* cores taken from the checkpoint */
+    const char    *power_src;       /* "CORE_POWER" or "SOCKET_POWER-idle", NULL */
+    int            by_boost[PM_RANK_MAX_CORES];     /* core indices, best first */
+    int            by_eff[PM_RANK_MAX_CORES];
+    unsigned int   neff;            /* cores with an efficiency figure */
+} pm_rank_result_t;
+
+/* Online physical cores from sysfs, ordered by (package, die, core_id), with
+ * identity slots. Count, 0 on error. */
+unsigned int pm_rank_topology(pm_rank_topo_t *t, unsigned int max_cores);
+
+/*
+ * Measure every core not already in the checkpoint, then rank. 0 done,
+ * -1 error, -2 interrupted (finished cores stay checkpointed). The
+ * checkpoint is removed once all cores are done.
+ */
+int pm_rank_run(const pm_rank_opts_t *o, pm_rank_result_t *r);
+
+/* Logical CPUs of cores[0..n): all SMT threads, or only the first of each. */
+void pm_rank_mask(const pm_rank_topo_t *t, const int *cores, unsigned int n,
+                  int all_threads, char *buf, size_t len);      /* taskset "0x..." */
+void pm_rank_cpulist(const pm_rank_topo_t *t, const int *cores, unsigned int n,
+                     int all_threads, char *buf, size_t len);   /* cpuset "0-1,16-17" */
+
+#endif
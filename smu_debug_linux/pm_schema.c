@@ -0,0 +1,510 @@
+/*
+ * PM table schema registry (see pm_schema.h).
+ *
+ * Layouts are X-macro tables: S(id, offset, scale) for scalars and
+ * A(id, offset, count, stride, scale) for arrays. Each table is expanded
+ * twice: once into designated initializers of pm_schema_t.loc[], and once
+ * into _Static_asserts that every element is float-aligned and inside the
+ * declared layout size. Matisse offsets are additionally asserted against
+ * the reference struct below.
+ *
+ * Sources: the Matisse struct is from monitor_cpu.c (ryzen_smu). The Zen3
+ * desktop header is shared with Matisse up to MEMCLK_FREQ (ZenStates-Core
+ * uses the same FCLK/UCLK/MCLK offsets for both). Zen4/Zen5 desktop tables
+ * keep the PPT/TDC/THM/FIT/EDC header at 0x000-0x024. APU offsets follow
+ * ryzenadj's table accessors (0x000-0x044). Only fields confirmed across
+ * those references are mapped; everything else stays index/offset.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#include "pm_schema.h"
+
+/* Matisse/CastlePeak PM table version 0x240903 structure */
+typedef struct {
+    float PPT_LIMIT, PPT_VALUE, TDC_LIMIT, TDC_VALUE;
+    float THM_LIMIT, THM_VALUE, FIT_LIMIT, FIT_VALUE;
+    float EDC_LIMIT, EDC_VALUE, VID_LIMIT, VID_VALUE;
+    float PPT_WC, PPT_ACTUAL, TDC_WC, TDC_ACTUAL;
+    float THM_WC, THM_ACTUAL, FIT_WC, FIT_ACTUAL;
+    float EDC_WC, EDC_ACTUAL, VID_WC, VID_ACTUAL;
+    float VDDCR_CPU_POWER, VDDCR_SOC_POWER;
+    float VDDIO_MEM_POWER, VDD18_POWER, ROC_POWER, SOCKET_POWER;
+    float PPT_FREQUENCY, TDC_FREQUENCY, THM_FREQUENCY;
+    float PROCHOT_FREQUENCY, VOLTAGE_FREQUENCY, CCA_FREQUENCY;
+    float FIT_VOLTAGE, FIT_PRE_VOLTAGE, LATCHUP_VOLTAGE;
+    float CPU_SET_VOLTAGE, CPU_TELEMETRY_VOLTAGE;
+    float CPU_TELEMETRY_CURRENT, CPU_TELEMETRY_POWER, CPU_TELEMETRY_POWER_ALT;
+    float SOC_SET_VOLTAGE, SOC_TELEMETRY_VOLTAGE;
+    float SOC_TELEMETRY_CURRENT, SOC_TELEMETRY_POWER;
+    float FCLK_FREQ, FCLK_FREQ_EFF, UCLK_FREQ, MEMCLK_FREQ;
+    float FCLK_DRAM_SETPOINT, FCLK_DRAM_BUSY;
+    float FCLK_GMI_SETPOINT, FCLK_GMI_BUSY;
+    float FCLK_IOHC_SETPOINT, FCLK_IOHC_BUSY;
+    float FCLK_XGMI_SETPOINT, FCLK_XGMI_BUSY;
+    float CCM_READS, CCM_WRITES, IOMS, XGMI;
+    float CS_UMC_READS, CS_UMC_WRITES;
+    float FCLK_RESIDENCY[4], FCLK_FREQ_TABLE[4];
+    float UCLK_FREQ_TABLE[4], MEMCLK_FREQ_TABLE[4], FCLK_VOLTAGE[4];
+    float LCLK_SETPOINT_0, LCLK_BUSY_0, LCLK_FREQ_0, LCLK_FREQ_EFF_0;
+    float LCLK_MAX_DPM_0, LCLK_MIN_DPM_0;
+    float LCLK_SETPOINT_1, LCLK_BUSY_1, LCLK_FREQ_1, LCLK_FREQ_EFF_1;
+    float LCLK_MAX_DPM_1, LCLK_MIN_DPM_1;
+    float LCLK_SETPOINT_2, LCLK_BUSY_2, LCLK_FREQ_2, LCLK_FREQ_EFF_2;
+    float LCLK_MAX_DPM_2, LCLK_MIN_DPM_2;
+    float LCLK_SETPOINT_3, LCLK_BUSY_3, LCLK_FREQ_3, LCLK_FREQ_EFF_3;
+    float LCLK_MAX_DPM_3, LCLK_MIN_DPM_3;
+    float XGMI_SETPOINT, XGMI_BUSY, XGMI_LANE_WIDTH, XGMI_DATA_RATE;
+    float SOC_POWER, SOC_TEMP;
+    float DDR_VDDP_POWER, DDR_VDDIO_MEM_POWER;
+    float GMI2_VDDG_POWER, IO_VDDCR_SOC_POWER;
+    float IOD_VDDIO_MEM_POWER, IO_VDD18_POWER;
+    float TDP, DETERMINISM, V_VDDM, V_VDDP, V_VDDG;
+    float PEAK_TEMP, PEAK_VOLTAGE, AVG_CORE_COUNT, CCLK_LIMIT;
+    float MAX_VOLTAGE, DC_BTC, CSTATE_BOOST, PROCHOT, PC6, PWM;
+    float SOCCLK, SHUBCLK, MP0CLK, MP1CLK, MP5CLK;
+    float SMNCLK, TWIXCLK, WAFLCLK, DPM_BUSY, MP1_BUSY;
+    float CORE_POWER[8], CORE_VOLTAGE[8], CORE_TEMP[8], CORE_FIT[8];
+    float CORE_IDDMAX[8], CORE_FREQ[8], CORE_FREQEFF[8];
+    float CORE_C0[8], CORE_CC1[8], CORE_CC6[8];
+    float CORE_CKS_FDD[8], CORE_CI_FDD[8], CORE_IRM[8], CORE_PSTATE[8];
+    float CORE_CPPC_MAX[8], CORE_CPPC_MIN[8];
+    float CORE_SC_LIMIT[8], CORE_SC_CAC[8], CORE_SC_RESIDENCY[8];
+    float L3_LOGIC_POWER[2], L3_VDDM_POWER[2], L3_TEMP[2], L3_FIT[2];
+    float L3_IDDMAX[2], L3_FREQ[2], L3_CKS_FDD[2];
+    float L3_CCA_THRESHOLD[2], L3_CCA_CAC[2], L3_CCA_ACTIVATION[2];
+    float L3_EDC_LIMIT[2], L3_EDC_CAC[2], L3_EDC_RESIDENCY[2];
+    float MP5_BUSY[1];
+} pm_table_matisse_t;
+
+/* ─── Field metadata ─── */
+
+static const char *const field_names[PMF_COUNT] = {
+#define PM_X_NAME(id, unit) #id,
+    PM_FIELD_LIST(PM_X_NAME)
+#undef PM_X_NAME
+};
+
+static const char *const field_units[PMF_COUNT] = {
+#define PM_X_UNIT(id, unit) unit,
+    PM_FIELD_LIST(PM_X_UNIT)
+#undef PM_X_UNIT
+};
+
+/* ─── Layout tables ─── */
+
+/* Matisse / Castle Peak 0x240903 (Zen2 desktop, up to 8 cores per table) */
+#define LAYOUT_MATISSE_240903(S, A)                          \
+    S(PPT_LIMIT, 0x000, 1.f)   S(PPT_VALUE, 0x004, 1.f)      \
+    S(TDC_LIMIT, 0x008, 1.f)   S(TDC_VALUE, 0x00C, 1.f)      \
+    S(THM_LIMIT, 0x010, 1.f)   S(THM_VALUE, 0x014, 1.f)      \
+    S(FIT_LIMIT, 0x018, 1.f)   S(FIT_VALUE, 0x01C, 1.f)      \
+    S(EDC_LIMIT, 0x020, 1.f)   S(EDC_VALUE, 0x024, 1.f)      \
+    S(VDDCR_CPU_POWER, 0x060, 1.f)                           \
+    S(VDDCR_SOC_POWER, 0x064, 1.f)                           \
+    S(SOCKET_POWER, 0x074, 1.f)                              \
+    S(CPU_SET_VOLTAGE, 0x09C, 1.f)                           \
+    S(CPU_TELEMETRY_VOLTAGE, 0x0A0, 1.f)                     \
+    S(CPU_TELEMETRY_CURRENT, 0x0A4, 1.f)                     \
+    S(CPU_TELEMETRY_POWER, 0x0A8, 1.f)                       \
+    S(SOC_SET_VOLTAGE, 0x0B0, 1.f)                           \
+    S(SOC_TELEMETRY_VOLTAGE, 0x0B4, 1.f)                     \
+    S(SOC_TELEMETRY_CURRENT, 0x0B8, 1.f)                     \
+    S(SOC_TELEMETRY_POWER, 0x0BC, 1.f)                       \
+    S(FCLK_FREQ, 0x0C0, 1.f)   S(FCLK_FREQ_EFF, 0x0C4, 1.f)  \
+    S(UCLK_FREQ, 0x0C8, 1.f)   S(MEMCLK_FREQ, 0x0CC, 1.f)    \
+    S(CS_UMC_READS, 0x100, 1.f)                              \
+    S(CS_UMC_WRITES, 0x104, 1.f)                             \
+    S(SOC_TEMP, 0x1CC, 1.f)    S(TDP, 0x1E8, 1.f)            \
+    S(V_VDDM, 0x1F0, 1.f)      S(V_VDDP, 0x1F4, 1.f)         \
+    S(V_VDDG, 0x1F8, 1.f)      S(PEAK_TEMP, 0x1FC, 1.f)      \
+    S(PEAK_VOLTAGE, 0x200, 1.f)                              \
+    S(CCLK_LIMIT, 0x208, 1000.f)                             \
+    S(PROCHOT, 0x218, 1.f)     S(PC6, 0x21C, 1.f)            \
+    A(CORE_POWER, 0x24C, 8, 4, 1.f)                          \
+    A(CORE_VOLTAGE, 0x26C, 8, 4, 1.f)                        \
+    A(CORE_TEMP, 0x28C, 8, 4, 1.f)                           \
+    A(CORE_FREQ, 0x2EC, 8, 4, 1000.f)                        \
+    A(CORE_FREQEFF, 0x30C, 8, 4, 1000.f)                     \
+    A(CORE_C0, 0x32C, 8, 4, 1.f)                             \
+    A(CORE_CC1, 0x34C, 8, 4, 1.f)                            \
+    A(CORE_CC6, 0x36C, 8, 4, 1.f)                            \
+    A(CORE_CPPC_MAX, 0x40C, 8, 4, 1.f)                       \
+    A(CORE_CPPC_MIN, 0x42C, 8, 4, 1.f)                       \
+    A(L3_TEMP, 0x4BC, 2, 4, 1.f)                             \
+    A(L3_FREQ, 0x4D4, 2, 4, 1000.f)
+#define LAYOUT_MATISSE_240903_SIZE  sizeof(pm_table_matisse_t)
+
+/* Vermeer 0x3808xx/0x3809xx (Zen3 desktop): Zen2 header through MEMCLK_FREQ */
+#define LAYOUT_VERMEER(S, A)                                 \
+    S(PPT_LIMIT, 0x000, 1.f)   S(PPT_VALUE, 0x004, 1.f)      \
+    S(TDC_LIMIT, 0x008, 1.f)   S(TDC_VALUE, 0x00C, 1.f)      \
+    S(THM_LIMIT, 0x010, 1.f)   S(THM_VALUE, 0x014, 1.f)      \
+    S(FIT_LIMIT, 0x018, 1.f)   S(FIT_VALUE, 0x01C, 1.f)      \
+    S(EDC_LIMIT, 0x020, 1.f)   S(EDC_VALUE, 0x024, 1.f)      \
+    S(VDDCR_CPU_POWER, 0x060, 1.f)                           \
+    S(VDDCR_SOC_POWER, 0x064, 1.f)                           \
+    S(SOCKET_POWER, 0x074, 1.f)                              \
+    S(CPU_SET_VOLTAGE, 0x09C, 1.f)                           \
+    S(CPU_TELEMETRY_VOLTAGE, 0x0A0, 1.f)                     \
+    S(CPU_TELEMETRY_CURRENT, 0x0A4, 1.f)                     \
+    S(CPU_TELEMETRY_POWER, 0x0A8, 1.f)                       \
+    S(SOC_SET_VOLTAGE, 0x0B0, 1.f)                           \
+    S(SOC_TELEMETRY_VOLTAGE, 0x0B4, 1.f)                     \
+    S(SOC_TELEMETRY_CURRENT, 0x0B8, 1.f)                     \
+    S(SOC_TELEMETRY_POWER, 0x0BC, 1.f)                       \
+    S(FCLK_FREQ, 0x0C0, 1.f)   S(FCLK_FREQ_EFF, 0x0C4, 1.f)  \
+    S(UCLK_FREQ, 0x0C8, 1.f)   S(MEMCLK_FREQ, 0x0CC, 1.f)
+#define LAYOUT_VERMEER_SIZE  0x0D0
+
+/* Raphael 0x5401xx/0x5402xx, Granite Ridge 0x6201xx/0x6202xx (Zen4/Zen5 desktop) */
+#define LAYOUT_ZEN45_DESKTOP(S, A)                           \
+    S(PPT_LIMIT, 0x000, 1.f)   S(PPT_VALUE, 0x004, 1.f)      \
+    S(TDC_LIMIT, 0x008, 1.f)   S(TDC_VALUE, 0x00C, 1.f)      \
+    S(THM_LIMIT, 0x010, 1.f)   S(THM_VALUE, 0x014, 1.f)      \
+    S(FIT_LIMIT, 0x018, 1.f)   S(FIT_VALUE, 0x01C, 1.f)      \
+    S(EDC_LIMIT, 0x020, 1.f)   S(EDC_VALUE, 0x024, 1.f)
+#define LAYOUT_ZEN45_DESKTOP_SIZE  0x028
+
+/* Cezanne 0x4000xx, Phoenix/Hawk Point 0x4C00xx, Strix Point 0x5D00xx (APU) */
+#define LAYOUT_APU(S, A)                                            \
+    S(STAPM_LIMIT, 0x000, 1.f)      S(STAPM_VALUE, 0x004, 1.f)      \
+    S(PPT_LIMIT_FAST, 0x008, 1.f)   S(PPT_VALUE_FAST, 0x00C, 1.f)   \
+    S(PPT_LIMIT, 0x010, 1.f)        S(PPT_VALUE, 0x014, 1.f)        \
+    S(PPT_LIMIT_APU, 0x018, 1.f)    S(PPT_VALUE_APU, 0x01C, 1.f)    \
+    S(TDC_LIMIT, 0x020, 1.f)        S(TDC_VALUE, 0x024, 1.f)        \
+    S(TDC_LIMIT_SOC, 0x028, 1.f)    S(TDC_VALUE_SOC, 0x02C, 1.f)    \
+    S(EDC_LIMIT, 0x030, 1.f)        S(EDC_VALUE, 0x034, 1.f)        \
+    S(EDC_LIMIT_SOC, 0x038, 1.f)    S(EDC_VALUE_SOC, 0x03C, 1.f)    \
+    S(THM_LIMIT, 0x040, 1.f)        S(THM_VALUE, 0x044, 1.f)
+#define LAYOUT_APU_SIZE  0x048
+
+/* ─── Compile-time checks ─── */
+
+#define PM_CHK_S(id, off, sc) \
+    _Static_assert((off) % 4 == 0 && (off) + 4 <= PM_CHK_SIZE, #id " outside layout");
+#define PM_CHK_A(id, off, n, st, sc) \
+    _Static_assert((off) % 4 == 0 && (st) % 4 == 0 && (n) > 0 && \
+                   (off) + ((n) - 1) * (st) + 4 <= PM_CHK_SIZE, #id " outside layout");
+
+#define PM_CHK_SIZE LAYOUT_MATISSE_240903_SIZE
+LAYOUT_MATISSE_240903(PM_CHK_S, PM_CHK_A)
+#undef PM_CHK_SIZE
+#define PM_CHK_SIZE LAYOUT_VERMEER_SIZE
+LAYOUT_VERMEER(PM_CHK_S, PM_CHK_A)
+#undef PM_CHK_SIZE
+#define PM_CHK_SIZE LAYOUT_ZEN45_DESKTOP_SIZE
+LAYOUT_ZEN45_DESKTOP(PM_CHK_S, PM_CHK_A)
+#undef PM_CHK_SIZE
+#define PM_CHK_SIZE LAYOUT_APU_SIZE
+LAYOUT_APU(PM_CHK_S, PM_CHK_A)
+#undef PM_CHK_SIZE
+
+/* Matisse table offsets must match the reference struct; Vermeer shares them. */
+#define PM_CHK_STRUCT_S(id, off, sc) \
+    _Static_assert(offsetof(pm_table_matisse_t, id) == (off), #id " offset mismatch");
+#define PM_CHK_STRUCT_A(id, off, n, st, sc) \
+    _Static_assert(offsetof(pm_table_matisse_t, id) == (off) && \
+                   sizeof(((pm_table_matisse_t *)0)->id) == (n) * 4u && (st) == 4, \
+                   #id " array mismatch");
+LAYOUT_MATISSE_240903(PM_CHK_STRUCT_S, PM_CHK_STRUCT_A)
+LAYOUT_VERMEER(PM_CHK_STRUCT_S, PM_CHK_STRUCT_A)
+
+/* ─── Schemas ─── */
+
+#define PM_LOC_S(id, off, sc)         [PMF_##id] = { (off), 1, 4, (sc) },
+#define PM_LOC_A(id, off, n, st, sc)  [PMF_##id] = { (off), (n), (st), (sc) },
+
+static const pm_schema_t schema_matisse = {
+    "Matisse", LAYOUT_MATISSE_240903_SIZE, { LAYOUT_MATISSE_240903(PM_LOC_S, PM_LOC_A) }
+};
+static const pm_schema_t schema_vermeer = {
+    "Vermeer", LAYOUT_VERMEER_SIZE, { LAYOUT_VERMEER(PM_LOC_S, PM_LOC_A) }
+};
+static const pm_schema_t schema_raphael = {
+    "Raphael", LAYOUT_ZEN45_DESKTOP_SIZE, { LAYOUT_ZEN45_DESKTOP(PM_LOC_S, PM_LOC_A) }
+};
+static const pm_schema_t schema_granite_ridge = {
+    "Granite Ridge", LAYOUT_ZEN45_DESKTOP_SIZE, { LAYOUT_ZEN45_DESKTOP(PM_LOC_S, PM_LOC_A) }
+};
+static const pm_schema_t schema_cezanne = {
+    "Cezanne", LAYOUT_APU_SIZE, { LAYOUT_APU(PM_LOC_S, PM_LOC_A) }
+};
+static const pm_schema_t schema_phoenix = {
+    "Phoenix", LAYOUT_APU_SIZE, { LAYOUT_APU(PM_LOC_S, PM_LOC_A) }
+};
+static const pm_schema_t schema_strix = {
+    "Strix Point", LAYOUT_APU_SIZE, { LAYOUT_APU(PM_LOC_S, PM_LOC_A) }
+};
+
+static const struct {
+    unsigned int        version;
+    const pm_schema_t  *schema;
+} registry[] = {
+    { 0x240903, &schema_matisse },
+    { 0x380804, &schema_vermeer },
+    { 0x380805, &schema_vermeer },
+    { 0x380904, &schema_vermeer },
+    { 0x380905, &schema_vermeer },
+    { 0x400001, &schema_cezanne },
+    { 0x400002, &schema_cezanne },
+    { 0x400003, &schema_cezanne },
+    { 0x400004, &schema_cezanne },
+    { 0x400005, &schema_cezanne },
+    { 0x4C0003, &schema_phoenix },
+    { 0x4C0004, &schema_phoenix },
+    { 0x4C0005, &schema_phoenix },
+    { 0x4C0006, &schema_phoenix },
+    { 0x4C0007, &schema_phoenix },
+    { 0x4C0008, &schema_phoenix },
+    { 0x4C0009, &schema_phoenix },
+    { 0x540100, &schema_raphael },
+    { 0x540101, &schema_raphael },
+    { 0x540102, &schema_raphael },
+    { 0x540103, &schema_raphael },
+    { 0x540104, &schema_raphael },
+    { 0x540105, &schema_raphael },
+    { 0x540108, &schema_raphael },
+    { 0x540208, &schema_raphael },
+    { 0x5D0008, &schema_strix },
+    { 0x5D0009, &schema_strix },
+    { 0x620105, &schema_granite_ridge },
+    { 0x620205, &schema_granite_ridge },
+};
+
+/* Runtime schemas (field maps); a handful is plenty for one machine. */
+#define PM_SCHEMA_USER_MAX 8
+
+static struct {
+    unsigned int  version;
+    char          name[32];
+    pm_schema_t   schema;
+} user_schemas[PM_SCHEMA_USER_MAX];
+static unsigned int user_count;
+static unsigned int generation;
+
+/* ─── Lookup ─── */
+
+int pm_schema_register(unsigned int version, const pm_schema_t *s)
+{
+    unsigned int i;
+
+    for (i = 0; i < user_count; i++) {
+        if (user_schemas[i].version == version)
+            break;
+    }
+    if (i == PM_SCHEMA_USER_MAX)
+        return -1;
+    user_schemas[i].version = version;
+    snprintf(user_schemas[i].name, sizeof(user_schemas[i].name), "%s",
+             s->name ? s->name : "User map");
+    user_schemas[i].schema = *s;
+    user_schemas[i].schema.name = user_schemas[i].name;
+    if (i == user_count)
+        user_count++;
+    generation++;
+    return 0;
+}
+
+unsigned int pm_schema_generation(void)
+{
+    return generation;
+}
+
+const pm_schema_t *pm_schema_lookup(unsigned int version, unsigned int table_size)
+{
+    for (unsigned int i = 0; i < user_count; i++) {
+        if (user_schemas[i].version == version)
+            return table_size >= user_schemas[i].schema.size ? &user_schemas[i].schema : NULL;
+    }
+    for (size_t i = 0; i < sizeof(registry) / sizeof(registry[0]); i++) {
+        if (registry[i].version == version)
+            return table_size >= registry[i].schema->size ? registry[i].schema : NULL;
+    }
+    return NULL;
+}
+
+int pm_field_by_name(const char *name)
+{
+    for (int f = 0; f < PMF_COUNT; f++) {
+        if (strcasecmp(field_names[f], name) == 0)
+            return f;
+    }
+    return -1;
+}
+
+const char *pm_field_name(pm_field_id f)
+{
+    return (unsigned)f < PMF_COUNT ? field_names[f] : "?";
+}
+
+const char *pm_field_unit(pm_field_id f)
+{
+    return (unsigned)f < PMF_COUNT ? field_units[f] : "";
+}
+
+int pm_schema_resolve(const pm_schema_t *s, const char *name, unsigned int *index_out)
+{
+    char base[48];
+    unsigned int elem = 0;
+    const char *br = strchr(name, '[');
+    size_t len = br ? (size_t)(br - name) : strlen(name);
+    int f;
+
+    if (!s || len == 0 || len >= sizeof(base))
+        return -1;
+    memcpy(base, name, len);
+    base[len] = '\0';
+    if (br && sscanf(br, "[%u]", &elem) != 1)
+        return -1;
+
+    f = pm_field_by_name(base);
+    if (f < 0 || elem >= s->loc[f].count)
+        return -1;
+    *index_out = (s->loc[f].offset + elem * s->loc[f].stride) / 4;
+    return 0;
+}
+
+int pm_schema_index_label(const pm_schema_t *s, unsigned int index, char *buf, size_t len)
+{
+    unsigned int off = index * 4;
+
+    if (len)
+        buf[0] = '\0';
+    if (!s)
+        return 0;
+    for (int f = 0; f < PMF_COUNT; f++) {
+        const pm_field_loc_t *l = &s->loc[f];
+        if (!l->count || off < l->offset)
+            continue;
+        unsigned int rel = off - l->offset;
+        if (rel % l->stride != 0 || rel / l->stride >= l->count)
+            continue;
+        if (l->count == 1)
+            snprintf(buf, len, "%s", field_names[f]);
+        else
+            snprintf(buf, len, "%s[%u]", field_names[f], rel / l->stride);
+        return 1;
+    }
+    return 0;
+}
+
+unsigned int pm_core_slots(const pm_schema_t *s, pm_field_id f, const int *slot,
+                           unsigned int ncores, int out[PM_MAX_CORES])
+{
+    unsigned int n = 0;
+
+    for (unsigned int i = 0; i < ncores && n < PM_MAX_CORES; i++) {
+        int k = slot ? slot[i] : (int)i;
+
+        if (k >= 0 && (unsigned int)k < pm_count(s, f))
+            out[n++] = k;
+    }
+    return n;
+}
+
+/* ─── Field map files ─── */
+
+int pm_schema_load_map(const char *path, unsigned int *version_out, pm_schema_t *out)
+{
+    static char name_buf[32];
+    char line[256];
+    int lineno = 0, bad = 0;
+    unsigned int version = 0, declared = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (!fp)
+        return -1;
+
+    memset(out, 0, sizeof(*out));
+    out->name = "User map";
+
+    while (fgets(line, sizeof(line), fp)) {
+        char key[48], rest[32];
+        unsigned int off, count = 1, stride = 4;
+        float scale = 1.f;
+        char *hash = strchr(line, '#');
+        int n, f;
+
+        lineno++;
+        if (hash)
+            *hash = '\0';
+        if (sscanf(line, "%47s", key) != 1)
+            continue;
+
+        if (strcasecmp(key, "version") == 0) {
+            if (sscanf(line, "%*s %x", &version) != 1) { bad = lineno; break; }
+            continue;
+        }
+        if (strcasecmp(key, "size") == 0) {
+            if (sscanf(line, "%*s %x", &declared) != 1) { bad = lineno; break; }
+            continue;
+        }
+        if (strcasecmp(key, "name") == 0) {
+            if (sscanf(line, "%*s %31[^\n]", rest) != 1) { bad = lineno; break; }
+            snprintf(name_buf, sizeof(name_buf), "%s", rest);
+            out->name = name_buf;
+            continue;
+        }
+
+        f = pm_field_by_name(key);
+        n = sscanf(line, "%*s %x %u %u %f", &off, &count, &stride, &scale);
+        if (f < 0 || n < 1 || n == 2 || off % 4 || stride % 4 || stride == 0 ||
+            count == 0 || count > 255 || stride > 255 || off > 0xFFFF) {
+            bad = lineno;
+            break;
+        }
+        out->loc[f].offset = (unsigned short)off;
+        out->loc[f].count = (unsigned char)count;
+        out->loc[f].stride = (unsigned char)stride;
+        out->loc[f].scale = scale;
+        if (off + (count - 1) * stride + 4 > out->size)
+            out->size = off + (count - 1) * stride + 4;
+    }
+    fclose(fp);
+
+    if (bad)
+        return bad;
+    /* A size line may come before or after the fields; never below what they need */
+    if (declared > out->size)
+        out->size = declared;
+    if (version_out)
+        *version_out = version;
+    return 0;
+}
+
+int pm_schema_save_map(FILE *fp, unsigned int version, const pm_schema_t *s,
+                       const float *conf)
+{
+    fprintf(fp, "# PM table field map (load with SMU_PM_MAP=<file> or menu C)\n");
+    fprintf(fp, "version 0x%06X\n", version);
+    fprintf(fp, "name    %s\n", s->name ? s->name : "User map");
+    fprintf(fp, "size    0x%X\n", s->size);
+    fprintf(fp, "# field                  offset count stride scale\n");
+    for (int f = 0; f < PMF_COUNT; f++) {
+        const pm_field_loc_t *l = &s->loc[f];
+        if (!l->count)
+            continue;
+        fprintf(fp, "%-24s 0x%04X %3u %3u %g", field_names[f], l->offset,
+                l->count, l->stride, l->scale);
+        if (conf)
+            fprintf(fp, "   # confidence %.2f", conf[f]);
+        fputc('\n', fp);
+    }
+
+    /* Same layout as an X-macro body, ready to paste into this file. */
+    fprintf(fp, "#\n# pm_schema.c layout:\n");
+    for (int f = 0; f < PMF_COUNT; f++) {
+        const pm_field_loc_t *l = &s->loc[f];
+        if (!l->count)
+            continue;
+        if (l->count == 1)
+            fprintf(fp, "#   S(%s, 0x%03X, %#gf) \\\n", field_names[f], l->offset, l->scale);
+        else
+            fprintf(fp, "#   A(%s, 0x%03X, %u, %u, %#gf) \\\n", field_names[f], l->offset,
+                    l->count, l->stride, l->scale);
+    }
+    return ferror(fp) ? -1 : 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * PM table schema registry: named fields per pm_table_version.
+ *
+ * Each known table version maps a fixed set of field IDs to a byte offset,
+ * element count/stride (per-core and per-CCD arrays) and a scale factor.
+ * Layouts are built at compile time from X-macro tables in pm_schema.c, so a
+ * field read is one array index plus one load: no name lookups per sample.
+ */
+#ifndef PM_SCHEMA_H
+#define PM_SCHEMA_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+/* X(id, unit): every field any layout may provide. Unit is after scaling. */
+#define PM_FIELD_LIST(X)                                                     \
+    /* Limiters (desktop: PPT/TDC/EDC; APU: slow PPT / VRM current) */     \
+    X(PPT_LIMIT, "W")              X(PPT_VALUE, "W")                       \
+    X(TDC_LIMIT, "A")              X(TDC_VALUE, "A")                       \
+    X(THM_LIMIT, "C")              X(THM_VALUE, "C")                       \
+    X(FIT_LIMIT, "")               X(FIT_VALUE, "")                        \
+    X(EDC_LIMIT, "A")              X(EDC_VALUE, "A")                       \
+    /* APU-only limiters */                                                \
+    X(STAPM_LIMIT, "W")            X(STAPM_VALUE, "W")                     \
+    X(PPT_LIMIT_FAST, "W")         X(PPT_VALUE_FAST, "W")                  \
+    X(PPT_LIMIT_APU, "W")          X(PPT_VALUE_APU, "W")                   \
+    X(TDC_LIMIT_SOC, "A")          X(TDC_VALUE_SOC, "A")                   \
+    X(EDC_LIMIT_SOC, "A")          X(EDC_VALUE_SOC, "A")                   \
+    /* Rails and telemetry */                                              \
+    X(VDDCR_CPU_POWER, "W")        X(VDDCR_SOC_POWER, "W")                 \
+    X(SOCKET_POWER, "W")                                                   \
+    X(CPU_SET_VOLTAGE, "V")        X(CPU_TELEMETRY_VOLTAGE, "V")           \
+    X(CPU_TELEMETRY_CURRENT, "A")  X(CPU_TELEMETRY_POWER, "W")             \
+    X(SOC_SET_VOLTAGE, "V")        X(SOC_TELEMETRY_VOLTAGE, "V")           \
+    X(SOC_TELEMETRY_CURRENT, "A")  X(SOC_TELEMETRY_POWER, "W")             \
+    /* Fabric and memory */                                                \
+    X(FCLK_FREQ, "MHz")            X(FCLK_FREQ_EFF, "MHz")                 \
+    X(UCLK_FREQ, "MHz")            X(MEMCLK_FREQ, "MHz")                   \
+    X(CS_UMC_READS, "GiB/s")       X(CS_UMC_WRITES, "GiB/s")               \
+    /* Package */                                                          \
+    X(SOC_TEMP, "C")               X(TDP, "W")                             \
+    X(V_VDDM, "V")                 X(V_VDDP, "V")      X(V_VDDG, "V")      \
+    X(PEAK_TEMP, "C")              X(PEAK_VOLTAGE, "V")                    \
+    X(CCLK_LIMIT, "MHz")           X(PROCHOT, "")      X(PC6, "%")         \
+    /* Per-core arrays */                                                  \
+    X(CORE_POWER, "W")             X(CORE_VOLTAGE, "V")                    \
+    X(CORE_TEMP, "C")              X(CORE_FREQ, "MHz")                     \
+    X(CORE_FREQEFF, "MHz")         X(CORE_C0, "%")                         \
+    X(CORE_CC1, "%")               X(CORE_CC6, "%")                        \
+    X(CORE_CPPC_MAX, "")           X(CORE_CPPC_MIN, "")                    \
+    /* Per-CCD arrays */                                                   \
+    X(L3_TEMP, "C")                X(L3_FREQ, "MHz")
+
+typedef enum {
+#define PM_X_ENUM(id, unit) PMF_##id,
+    PM_FIELD_LIST(PM_X_ENUM)
+#undef PM_X_ENUM
+    PMF_COUNT
+} pm_field_id;
+
+typedef struct {
+    unsigned short offset;   /* byte offset of element 0 */
+    unsigned char  count;    /* elements; 0 = not present in this layout */
+    unsigned char  stride;   /* bytes between elements */
+    float          scale;    /* raw float * scale = value in field unit */
+} pm_field_loc_t;
+
+typedef struct {
+    const char     *name;    /* e.g. "Matisse", "Granite Ridge" */
+    unsigned int    size;    /* bytes the mapped fields need */
+    pm_field_loc_t  loc[PMF_COUNT];
+} pm_schema_t;
+
+/* Schema for a table version, or NULL if unknown or the table is too small.
+ * Schemas added with pm_schema_register() take precedence over built-ins. */
+const pm_schema_t *pm_schema_lookup(unsigned int version, unsigned int table_size);
+
+/* Register (copy) a runtime schema for a version, e.g. from a field map.
+ * Replaces an earlier registration of the same version. 0 on success. */
+int pm_schema_register(unsigned int version, const pm_schema_t *s);
+
+/* Bumped by every registration; lets callers drop state compiled against
+ * an older layout (registrations reuse the same slot per version). */
+unsigned int pm_schema_generation(void);
+
+/*
+ * Field map files: text, one field per line, '#' starts a comment.
+ *   version 0x380905
+ *   name    Vermeer (inferred)
+ *   size    0x7E4
+ *   THM_VALUE     0x014                 (scalar, scale 1)
+ *   CORE_FREQEFF  0x2F0 8 4 1000        (offset count stride scale)
+ * load returns 0 on success, -1 (errno set) on I/O error, or the first bad
+ * line number; out->name points at static storage until the next load, so
+ * register before loading another map. conf (optional, PMF_COUNT entries)
+ * is written as a comment.
+ */
+int pm_schema_load_map(const char *path, unsigned int *version_out, pm_schema_t *out);
+int pm_schema_save_map(FILE *fp, unsigned int version, const pm_schema_t *s,
+                       const float *conf);
+
+/* Field metadata. pm_field_by_name() is case-insensitive; -1 if unknown. */
+int pm_field_by_name(const char *name);
+const char *pm_field_name(pm_field_id f);
+const char *pm_field_unit(pm_field_id f);
+
+/* "NAME" or "NAME[i]" -> float index into the raw table. 0 on success. */
+int pm_schema_resolve(const pm_schema_t *s, const char *name, unsigned int *index_out);
+
+/* Label ("PPT_VALUE", "CORE_TEMP[3]") for a float index; 0 if unnamed. */
+int pm_schema_index_label(const pm_schema_t *s, unsigned int index, char *buf, size_t len);
+
+/*
+ * Per-core array indices of cores 0..ncores-1 for aggregates (any, mean,
+ * max): slot[i] when the caller has a slot map, since fused-off cores leave
+ * gaps in the arrays, else i. Cores past f's array or PM_MAX_CORES are
+ * dropped; returns how many indices were written to out.
+ */
+#define PM_MAX_CORES    64
+unsigned int pm_core_slots(const pm_schema_t *s, pm_field_id f, const int *slot,
+                           unsigned int ncores, int out[PM_MAX_CORES]);
+
+static inline int pm_has(const pm_schema_t *s, pm_field_id f)
+{
+    return s && s->loc[f].count != 0;
+}
+
+static inline unsigned int pm_count(const pm_schema_t *s, pm_field_id f)
+{
+    return s ? s->loc[f].count : 0;
+}
+
+/* Scaled value of element i, NAN if absent. table is the raw PM buffer. */
+static inline float pm_get_at(const pm_schema_t *s, const void *table,
+                              pm_field_id f, unsigned int i)
+{
+    const pm_field_loc_t *l;
+    float v;
+
+    if (!s || i >= s->loc[f].count)
+        return NAN;
+    l = &s->loc[f];
+    memcpy(&v, (const unsigned char *)table + l->offset + i * l->stride, sizeof(v));
+    return v * l->scale;
+}
+
+static inline float pm_get(const pm_schema_t *s, const void *table, pm_field_id f)
+{
+    return pm_get_at(s, table, f, 0);
+}
+
+#endif
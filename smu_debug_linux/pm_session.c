@@ -0,0 +1,285 @@
+/*
+ * PM session statistics (see pm_session.h).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pm_session.h"
+
+void pm_session_init(pm_session_t *s, const pm_schema_t *schema, unsigned int ncores,
+                     const int *slot, int keep_series)
+{
+    memset(s, 0, sizeof(*s));
+    s->schema = schema;
+    s->keep_series = keep_series;
+    s->nclk = pm_core_slots(schema, PMF_CORE_FREQEFF, slot, ncores, s->clk_slot);
+    /* C-states: cores with all three residencies */
+    for (unsigned int i = 0, n = pm_core_slots(schema, PMF_CORE_C0, slot, ncores, s->cst_slot);
+         i < n; i++) {
+        unsigned int k = (unsigned int)s->cst_slot[i];
+
+        if (k < pm_count(schema, PMF_CORE_CC1) && k < pm_count(schema, PMF_CORE_CC6))
+            s->cst_slot[s->ncst++] = (int)k;
+    }
+
+    /* Package power: socket telemetry, else the (slow) PPT tracker */
+    s->power_field = pm_has(schema, PMF_SOCKET_POWER) ? PMF_SOCKET_POWER :
+                     pm_has(schema, PMF_PPT_VALUE)    ? PMF_PPT_VALUE : -1;
+    pm_limiter_init(&s->limiter, schema, ncores, slot);
+}
+
+void pm_session_free(pm_session_t *s)
+{
+    free(s->phases);
+    free(s->series);
+    memset(s, 0, sizeof(*s));
+}
+
+int pm_session_mark(pm_session_t *s, double t, const char *name)
+{
+    pm_phase_t *ph;
+
+    if (s->nphases == s->phases_cap) {
+        unsigned int cap = s->phases_cap ? s->phases_cap * 2 : 8;
+        pm_phase_t *np = realloc(s->phases, cap * sizeof(*np));
+        if (!np)
+            return -1;
+        s->phases = np;
+        s->phases_cap = cap;
+    }
+    ph = &s->phases[s->nphases++];
+    memset(ph, 0, sizeof(*ph));
+    snprintf(ph->name, sizeof(ph->name), "%s", name);
+    for (char *c = ph->name; *c; c++) {
+        if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20)
+            *c = '_';       /* names go into JSON verbatim */
+    }
+    ph->t_start = s->have_prev ? t - s->t0 : 0;
+    return 0;
+}
+
+static void acc_add(pm_acc_t *a, double dt, float p, float p_prev, float temp,
+                    float clk_avg, float clk_peak, const pm_limiter_state_t *lim,
+                    const float cst[4])
+{
+    a->samples++;
+    if (dt > 0) {
+        a->seconds += dt;
+        if (!isnan(p) && !isnan(p_prev))
+            a->energy_j += 0.5 * ((double)p + p_prev) * dt;
+        pm_limiter_acc_add(&a->lim, lim, dt);
+    }
+    if (!isnan(p) && p > a->power_peak_w)
+        a->power_peak_w = p;
+    if (!isnan(temp)) {
+        a->temp_sum += temp;
+        a->temp_n++;
+        if (temp > a->temp_peak)
+            a->temp_peak = temp;
+    }
+    if (!isnan(clk_avg)) {
+        a->clk_sum_mhz += clk_avg;
+        a->clk_n++;
+    }
+    if (!isnan(clk_peak) && clk_peak > a->clk_peak_mhz)
+        a->clk_peak_mhz = clk_peak;
+    if (!isnan(cst[0])) {
+        a->c0_sum += cst[0];
+        a->cc1_sum += cst[1];
+        a->cc6_sum += cst[2];
+        a->pc6_sum += isnan(cst[3]) ? 0 : cst[3];
+        a->cstate_n++;
+    }
+}
+
+void pm_session_add(pm_session_t *s, double t, const void *tab)
+{
+    const pm_schema_t *sc = s->schema;
+    float p = s->power_field >= 0 ? pm_get(sc, tab, (pm_field_id)s->power_field) : NAN;
+    float temp = pm_get(sc, tab, PMF_THM_VALUE);
+    float clk_avg = NAN, clk_peak = NAN, cst[4] = { NAN, NAN, NAN, NAN };
+    double dt = s->have_prev ? t - s->t_prev : 0;
+
+    if (!s->have_prev) {
+        s->t0 = t;
+        if (s->nphases == 0)
+            pm_session_mark(s, t, "main");
+    }
+
+    if (s->nclk) {
+        double sum = 0;
+        unsigned int active = 0;
+        int have_c0 = pm_has(sc, PMF_CORE_C0);
+
+        clk_peak = 0;
+        for (unsigned int i = 0; i < s->nclk; i++) {
+            unsigned int c = (unsigned int)s->clk_slot[i];
+            float f = pm_get_at(sc, tab, PMF_CORE_FREQEFF, c);
+            if (f > clk_peak)
+                clk_peak = f;
+            if (have_c0 && pm_get_at(sc, tab, PMF_CORE_C0, c) < PM_ACTIVE_C0_PCT)
+                continue;
+            sum += f;
+            active++;
+        }
+        clk_avg = active ? (float)(sum / active) : NAN;
+    }
+    if (s->ncst) {
+        double c0 = 0, c1 = 0, c6 = 0;
+        for (unsigned int i = 0; i < s->ncst; i++) {
+            unsigned int c = (unsigned int)s->cst_slot[i];
+            c0 += pm_get_at(sc, tab, PMF_CORE_C0, c);
+            c1 += pm_get_at(sc, tab, PMF_CORE_CC1, c);
+            c6 += pm_get_at(sc, tab, PMF_CORE_CC6, c);
+        }
+        cst[0] = (float)(c0 / s->ncst);
+        cst[1] = (float)(c1 / s->ncst);
+        cst[2] = (float)(c6 / s->ncst);
+        cst[3] = pm_get(sc, tab, PMF_PC6);
+    }
+    pm_limiter_classify(&s->limiter, tab, &s->lim_now);
+
+    acc_add(&s->total, dt, p, s->p_prev, temp, clk_avg, clk_peak, &s->lim_now, cst);
+    if (s->nphases)
+        acc_add(&s->phases[s->nphases - 1].acc, dt, p, s->p_prev, temp, clk_avg, clk_peak,
+                &s->lim_now, cst);
+
+    if (s->keep_series) {
+        if (s->nseries == s->series_cap) {
+            unsigned long cap = s->series_cap ? s->series_cap * 2 : 1024;
+            pm_series_pt_t *ns = realloc(s->series, cap * sizeof(*ns));
+            if (ns) {
+                s->series = ns;
+                s->series_cap = cap;
+            }
+        }
+        if (s->nseries < s->series_cap)
+            s->series[s->nseries++] = (pm_series_pt_t){
+                (float)(t - s->t0), p, temp, clk_avg, clk_peak };
+    }
+
+    s->t_prev = t;
+    s->p_prev = p;
+    s->have_prev = 1;
+}
+
+double pm_acc_avg_power(const pm_acc_t *a)
+{
+    return a->seconds > 0 ? a->energy_j / a->seconds : NAN;
+}
+
+double pm_acc_avg_clock(const pm_acc_t *a)
+{
+    return a->clk_n ? a->clk_sum_mhz / a->clk_n : NAN;
+}
+
+double pm_acc_avg_temp(const pm_acc_t *a)
+{
+    return a->temp_n ? a->temp_sum / a->temp_n : NAN;
+}
+
+/* ─── JSON ─── */
+
+static void json_num(FILE *fp, double v, int prec)
+{
+    if (isfinite(v))
+        fprintf(fp, "%.*f", prec, v);
+    else
+        fputs("null", fp);
+}
+
+static void write_acc(FILE *fp, const pm_session_t *s, const pm_acc_t *a, const char *ind)
+{
+    int have_power = s->power_field >= 0 && a->seconds > 0;
+    int have_clk = a->clk_n > 0;
+
+    fprintf(fp, "%s\"Seconds\": %.3f,\n", ind, a->seconds);
+    fprintf(fp, "%s\"Samples\": %lu,\n", ind, a->samples);
+    fprintf(fp, "%s\"EnergyJ\": ", ind);
+    json_num(fp, have_power ? a->energy_j : NAN, 3);
+    fprintf(fp, ",\n%s\"PowerAvgW\": ", ind);
+    json_num(fp, have_power ? pm_acc_avg_power(a) : NAN, 3);
+    fprintf(fp, ",\n%s\"PowerPeakW\": ", ind);
+    json_num(fp, have_power ? a->power_peak_w : NAN, 3);
+    fprintf(fp, ",\n%s\"ClockAvgMHz\": ", ind);
+    json_num(fp, pm_acc_avg_clock(a), 1);
+    fprintf(fp, ",\n%s\"ClockPeakMHz\": ", ind);
+    json_num(fp, have_clk ? a->clk_peak_mhz : NAN, 1);
+    fprintf(fp, ",\n%s\"TempAvgC\": ", ind);
+    json_num(fp, pm_acc_avg_temp(a), 2);
+    fprintf(fp, ",\n%s\"TempPeakC\": ", ind);
+    json_num(fp, a->temp_n ? a->temp_peak : NAN, 2);
+    fprintf(fp, ",\n%s\"LimitResidencyPct\": {", ind);
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        int have = (s->limiter.avail & (1u << l)) && a->seconds > 0;
+        fprintf(fp, "%s\"%s\": ", l ? ", " : " ", pm_limit_name((pm_limit_id)l));
+        json_num(fp, have ? 100.0 * a->lim.engaged_s[l] / a->seconds : NAN, 2);
+    }
+    fprintf(fp, " },\n%s\"LimiterPct\": {", ind);
+    for (int c = 0; c < PM_LIM_CLASSES; c++) {
+        fprintf(fp, "%s\"%s\": ", c ? ", " : " ", pm_limiter_class_name(c));
+        json_num(fp, a->seconds > 0 ? 100.0 * a->lim.class_s[c] / a->seconds : NAN, 2);
+    }
+    fprintf(fp, " },\n%s\"CStateResidencyPct\": ", ind);
+    if (a->cstate_n) {
+        fprintf(fp, "{ \"C0\": %.2f, \"CC1\": %.2f, \"CC6\": %.2f, \"PC6\": %.2f }\n",
+                a->c0_sum / a->cstate_n, a->cc1_sum / a->cstate_n,
+                a->cc6_sum / a->cstate_n, a->pc6_sum / a->cstate_n);
+    } else {
+        fputs("null\n", fp);
+    }
+}
+
+void pm_session_write_json(FILE *fp, const pm_session_t *s, const char *indent)
+{
+    char ind2[32], ind3[32];
+
+    snprintf(ind2, sizeof(ind2), "%s  ", indent);
+    snprintf(ind3, sizeof(ind3), "%s    ", indent);
+
+    fprintf(fp, "%s\"PowerSource\": ", indent);
+    if (s->power_field >= 0)
+        fprintf(fp, "\"%s\",\n", pm_field_name((pm_field_id)s->power_field));
+    else
+        fputs("null,\n", fp);
+
+    fprintf(fp, "%s\"Summary\": {\n", indent);
+    write_acc(fp, s, &s->total, ind2);
+    fprintf(fp, "%s},\n", indent);
+
+    fprintf(fp, "%s\"Phases\": [", indent);
+    for (unsigned int i = 0; i < s->nphases; i++) {
+        fprintf(fp, "%s\n%s{\n", i ? "," : "", ind2);
+        fprintf(fp, "%s\"Name\": \"%s\",\n", ind3, s->phases[i].name);
+        fprintf(fp, "%s\"StartS\": %.3f,\n", ind3, s->phases[i].t_start);
+        write_acc(fp, s, &s->phases[i].acc, ind3);
+        fprintf(fp, "%s}", ind2);
+    }
+    if (s->nphases)
+        fprintf(fp, "\n%s", indent);
+    fputc(']', fp);
+
+    if (s->keep_series) {
+        fprintf(fp, ",\n%s\"SeriesColumns\": [\"t_s\", \"power_w\", \"temp_c\", "
+                "\"clock_avg_mhz\", \"clock_peak_mhz\"],\n", indent);
+        fprintf(fp, "%s\"Series\": [", indent);
+        for (unsigned long i = 0; i < s->nseries; i++) {
+            const pm_series_pt_t *p = &s->series[i];
+            fprintf(fp, "%s\n%s[%.4f, ", i ? "," : "", ind2, p->t);
+            json_num(fp, p->power_w, 3);
+            fputs(", ", fp);
+            json_num(fp, p->temp_c, 2);
+            fputs(", ", fp);
+            json_num(fp, p->clk_avg_mhz, 1);
+            fputs(", ", fp);
+            json_num(fp, p->clk_peak_mhz, 1);
+            fputc(']', fp);
+        }
+        if (s->nseries)
+            fprintf(fp, "\n%s", indent);
+        fputc(']', fp);
+    }
+    fputc('\n', fp);
+}
@@ -0,0 +1,85 @@
+/*
+ * PM session statistics: time-integrated energy, clocks, temperature,
+ * limiter attribution and C-state residency over a run, split into phases.
+ *
+ * Feed it raw PM table snapshots with their monotonic timestamps; each
+ * sample accounts for the interval since the previous one (trapezoidal
+ * energy, rectangular residency), so irregular sampling is fine.
+ */
+#ifndef PM_SESSION_H
+#define PM_SESSION_H
+
+#include <stdio.h>
+
+#include "pm_limiter.h"
+#include "pm_schema.h"
+
+/* Cores below this C0 % are asleep and left out of the average clock. */
+#define PM_ACTIVE_C0_PCT    6.0f
+
+typedef struct {
+    double         seconds;
+    unsigned long  samples;
+    double         energy_j;
+    float          power_peak_w;
+    double         clk_sum_mhz;     /* over samples: mean of active cores */
+    unsigned long  clk_n;
+    float          clk_peak_mhz;    /* any core, any sample */
+    double         temp_sum;
+    unsigned long  temp_n;
+    float          temp_peak;
+    pm_limiter_acc_t lim;
+    double         c0_sum, cc1_sum, cc6_sum, pc6_sum;
+    unsigned long  cstate_n;
+} pm_acc_t;
+
+typedef struct {
+    char      name[48];
+    double    t_start;          /* seconds since session start */
+    pm_acc_t  acc;
+} pm_phase_t;
+
+typedef struct {
+    float t, power_w, temp_c, clk_avg_mhz, clk_peak_mhz;
+} pm_series_pt_t;
+
+typedef struct {
+    const pm_schema_t *schema;
+    int             clk_slot[PM_MAX_CORES];     /* PM array index of each core */
+    int             cst_slot[PM_MAX_CORES];
+    unsigned int    nclk, ncst;
+    int             power_field;    /* pm_field_id used for package power, -1 if none */
+    pm_limiter_t    limiter;
+    pm_limiter_state_t lim_now;     /* classification of the latest sample */
+    int             keep_series;
+    double          t0, t_prev;
+    float           p_prev;
+    int             have_prev;
+    pm_acc_t        total;
+    pm_phase_t     *phases;
+    unsigned int    nphases, phases_cap;
+    pm_series_pt_t *series;
+    unsigned long   nseries, series_cap;
+} pm_session_t;
+
+/* slot: PM array index of each core (see pm_core_slots), NULL if dense. */
+void pm_session_init(pm_session_t *s, const pm_schema_t *schema, unsigned int ncores,
+                     const int *slot, int keep_series);
+void pm_session_free(pm_session_t *s);
+
+void pm_session_add(pm_session_t *s, double t, const void *table);
+
+/* Start a new phase at t (the first sample starts an implicit "main" phase). */
+int  pm_session_mark(pm_session_t *s, double t, const char *name);
+
+double pm_acc_avg_power(const pm_acc_t *a);
+double pm_acc_avg_clock(const pm_acc_t *a);
+double pm_acc_avg_temp(const pm_acc_t *a);
+
+/* JSON members (no surrounding braces): "PowerSource", "Summary", "Phases"
+ * and, with keep_series, "Series". Summaries carry "LimitResidencyPct"
+ * (time each limiter was engaged) and "LimiterPct" (time each class was
+ * the primary limiter). Each line is prefixed with indent. */
+void pm_session_write_json(FILE *fp, const pm_session_t *s, const char *indent);
+
+#endif
@@ -0,0 +1,367 @@
+/*
+ * Small-sample statistics and steady-state detection (see pm_stats.h).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pm_stats.h"
+
+#define OUTLIER_MODZ    3.5     /* Iglewicz & Hoaglin */
+
+static const double t95_table[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+double pm_stats_t95(unsigned int df)
+{
+    if (df == 0)
+        return NAN;
+    if (df <= 30)
+        return t95_table[df - 1];
+    return 1.96 + 2.4 / df;     /* within 0.002 of the exact quantile */
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median_sorted(const double *v, unsigned int n)
+{
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+void pm_stats_summarize(const double *x, unsigned int n, pm_stats_t *st,
+                        unsigned char *outlier)
+{
+    double *v, *dev, sum = 0, ss = 0, mad;
+    unsigned int m = 0;
+
+    memset(st, 0, sizeof(*st));
+    st->mean = st->sd = st->ci_lo = st->ci_hi = NAN;
+    st->median = st->min = st->max = NAN;
+    if (outlier)
+        memset(outlier, 0, n);
+
+    v = malloc((n ? n : 1) * sizeof(*v));
+    dev = malloc((n ? n : 1) * sizeof(*dev));
+    if (!v || !dev)
+        goto out;
+
+    for (unsigned int i = 0; i < n; i++) {
+        if (!isnan(x[i])) {
+            v[m++] = x[i];
+            sum += x[i];
+        }
+    }
+    st->n = m;
+    if (m == 0)
+        goto out;
+
+    st->mean = sum / m;
+    for (unsigned int i = 0; i < m; i++)
+        ss += (v[i] - st->mean) * (v[i] - st->mean);
+    qsort(v, m, sizeof(*v), cmp_double);
+    st->min = v[0];
+    st->max = v[m - 1];
+    st->median = median_sorted(v, m);
+    if (m < 2)
+        goto out;
+
+    st->sd = sqrt(ss / (m - 1));
+    st->ci_lo = st->mean - pm_stats_t95(m - 1) * st->sd / sqrt(m);
+    st->ci_hi = st->mean + pm_stats_t95(m - 1) * st->sd / sqrt(m);
+
+    /* Modified z-score; fall back to the mean absolute deviation when
+     * more than half the runs are identical (MAD = 0). */
+    if (m < 3)
+        goto out;
+    for (unsigned int i = 0; i < m; i++)
+        dev[i] = fabs(v[i] - st->median);
+    qsort(dev, m, sizeof(*dev), cmp_double);
+    mad = median_sorted(dev, m);
+    if (mad == 0) {
+        double mean_ad = 0;
+        for (unsigned int i = 0; i < m; i++)
+            mean_ad += dev[i];
+        mad = mean_ad / m * 0.8453;     /* z = (x - med) / (1.2533 * meanAD) */
+    }
+    if (mad == 0)
+        goto out;
+    for (unsigned int i = 0; i < n; i++) {
+        if (isnan(x[i]) || 0.6745 * fabs(x[i] - st->median) / mad <= OUTLIER_MODZ)
+            continue;
+        st->outliers++;
+        if (outlier)
+            outlier[i] = 1;
+    }
+
+out:
+    free(v);
+    free(dev);
+}
+
+/* ─── Two-sample tests ─── */
+
+#define MW_EXACT_MAX    20      /* per side, and only without ties */
+
+typedef struct {
+    double v;
+    int    from_a;
+} mw_item_t;
+
+static int cmp_mw(const void *x, const void *y)
+{
+    double a = ((const mw_item_t *)x)->v, b = ((const mw_item_t *)y)->v;
+    return (a > b) - (a < b);
+}
+
+/* P(U <= u) under H0 by counting rank arrangements (Mann & Whitney recursion). */
+static double mw_exact_cdf(unsigned int n1, unsigned int n2, unsigned int u)
+{
+    unsigned int umax = n1 * n2;
+    double *f = calloc((size_t)(n1 + 1) * (n2 + 1) * (umax + 1), sizeof(double));
+    double total = 0, below = 0;
+
+#define F(i, j, k) f[((size_t)(i) * (n2 + 1) + (j)) * (umax + 1) + (k)]
+    if (!f)
+        return NAN;
+    for (unsigned int i = 0; i <= n1; i++) {
+        for (unsigned int j = 0; j <= n2; j++) {
+            if (i == 0 || j == 0) {
+                F(i, j, 0) = 1;
+                continue;
+            }
+            for (unsigned int k = 0; k <= i * j; k++)
+                F(i, j, k) = (k >= j ? F(i - 1, j, k - j) : 0) + F(i, j - 1, k);
+        }
+    }
+    for (unsigned int k = 0; k <= umax; k++) {
+        total += F(n1, n2, k);
+        if (k <= u)
+            below += F(n1, n2, k);
+    }
+#undef F
+    free(f);
+    return below / total;
+}
+
+double pm_stats_mann_whitney(const double *a, size_t na, const double *b, size_t nb,
+                             double *u)
+{
+    size_t n = na + nb, i = 0;
+    double rank_a = 0, ties = 0, ua, mu, sigma, z, p;
+    mw_item_t *it;
+
+    *u = NAN;
+    if (na == 0 || nb == 0)
+        return NAN;
+    it = malloc(n * sizeof(*it));
+    if (!it)
+        return NAN;
+    for (size_t k = 0; k < na; k++)
+        it[k] = (mw_item_t){ a[k], 1 };
+    for (size_t k = 0; k < nb; k++)
+        it[na + k] = (mw_item_t){ b[k], 0 };
+    qsort(it, n, sizeof(*it), cmp_mw);
+
+    /* Mid-ranks for ties */
+    while (i < n) {
+        size_t j = i;
+        double r;
+        while (j + 1 < n && it[j + 1].v == it[i].v)
+            j++;
+        r = 0.5 * ((double)i + (double)j) + 1.0;
+        for (size_t k = i; k <= j; k++) {
+            if (it[k].from_a)
+                rank_a += r;
+        }
+        if (j > i) {
+            double t = (double)(j - i + 1);
+            ties += t * t * t - t;
+        }
+        i = j + 1;
+    }
+    free(it);
+
+    ua = rank_a - (double)na * (na + 1) / 2.0;
+    *u = ua;
+
+    if (ties == 0 && na <= MW_EXACT_MAX && nb <= MW_EXACT_MAX) {
+        double lo = mw_exact_cdf((unsigned)na, (unsigned)nb, (unsigned)ua);
+        double hi = 1.0 - (ua >= 1 ? mw_exact_cdf((unsigned)na, (unsigned)nb, (unsigned)ua - 1) : 0);
+        p = 2.0 * (lo < hi ? lo : hi);
+        return p > 1.0 ? 1.0 : p;
+    }
+
+    mu = (double)na * nb / 2.0;
+    sigma = sqrt((double)na * nb / 12.0 *
+                 (((double)n + 1) - ties / ((double)n * ((double)n - 1))));
+    if (sigma == 0)
+        return 1.0;
+    z = (fabs(ua - mu) - 0.5) / sigma;
+    if (z < 0)
+        z = 0;
+    return erfc(z / sqrt(2.0));
+}
+
+static inline unsigned long long xorshift64s(unsigned long long *s)
+{
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 0x2545F4914F6CDD1DULL;
+}
+
+static double resample_mean(const double *x, size_t n, unsigned long long *rng)
+{
+    double sum = 0;
+    for (size_t k = 0; k < n; k++)
+        sum += x[xorshift64s(rng) % n];
+    return sum / n;
+}
+
+void pm_stats_bootstrap_delta(const double *a, size_t na, const double *b, size_t nb,
+                              unsigned int resamples, unsigned long long seed,
+                              double *lo, double *hi, double *p)
+{
+    unsigned long long rng = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    unsigned int le0 = 0, ge0 = 0;
+    double *d;
+
+    *lo = *hi = *p = NAN;
+    if (na == 0 || nb == 0 || resamples == 0)
+        return;
+    d = malloc(resamples * sizeof(*d));
+    if (!d)
+        return;
+    for (unsigned int r = 0; r < resamples; r++) {
+        d[r] = resample_mean(b, nb, &rng) - resample_mean(a, na, &rng);
+        le0 += d[r] <= 0;
+        ge0 += d[r] >= 0;
+    }
+    qsort(d, resamples, sizeof(*d), cmp_double);
+    *lo = d[(size_t)(0.025 * (resamples - 1))];
+    *hi = d[(size_t)(0.975 * (resamples - 1) + 0.5)];
+    /* (k + 1) / (B + 1): a finite number of resamples cannot show p = 0 */
+    *p = 2.0 * ((le0 < ge0 ? le0 : ge0) + 1) / (resamples + 1.0);
+    if (*p > 1.0)
+        *p = 1.0;
+    free(d);
+}
+
+void pm_stats_welch_delta(const double *a, size_t na, const double *b, size_t nb,
+                          double *lo, double *hi)
+{
+    double ma = 0, mb = 0, va = 0, vb = 0, se, df, t;
+
+    *lo = *hi = NAN;
+    if (na < 2 || nb < 2)
+        return;
+    for (size_t k = 0; k < na; k++)
+        ma += a[k];
+    for (size_t k = 0; k < nb; k++)
+        mb += b[k];
+    ma /= na;
+    mb /= nb;
+    for (size_t k = 0; k < na; k++)
+        va += (a[k] - ma) * (a[k] - ma);
+    for (size_t k = 0; k < nb; k++)
+        vb += (b[k] - mb) * (b[k] - mb);
+    va /= na - 1;
+    vb /= nb - 1;
+    se = sqrt(va / na + vb / nb);
+    if (se == 0) {
+        *lo = *hi = mb - ma;
+        return;
+    }
+    /* Welch-Satterthwaite degrees of freedom */
+    df = pow(va / na + vb / nb, 2) /
+         (pow(va / na, 2) / (na - 1) + pow(vb / nb, 2) / (nb - 1));
+    t = pm_stats_t95(df > 1e6 ? 1000000u : (unsigned int)df);
+    *lo = mb - ma - t * se;
+    *hi = mb - ma + t * se;
+}
+
+/* ─── Steady-state detector ─── */
+
+void pm_steady_init(pm_steady_t *d, double window_s, float temp_band, float power_band)
+{
+    d->window_s = window_s;
+    d->temp_band = temp_band;
+    d->power_band = power_band;
+    pm_steady_reset(d);
+}
+
+void pm_steady_reset(pm_steady_t *d)
+{
+    d->head = 0;
+    d->count = 0;
+}
+
+void pm_steady_push(pm_steady_t *d, double t, float temp, float power)
+{
+    unsigned int slot = (d->head + d->count) % PM_STEADY_CAP;
+
+    if (d->count == PM_STEADY_CAP) {
+        d->head = (d->head + 1) % PM_STEADY_CAP;
+        d->count--;
+    }
+    d->t[slot] = t;
+    d->temp[slot] = temp;
+    d->power[slot] = power;
+    d->count++;
+
+    /* Keep one sample at or beyond the window start so coverage is measurable */
+    while (d->count > 2) {
+        unsigned int second = (d->head + 1) % PM_STEADY_CAP;
+        if (t - d->t[second] < d->window_s)
+            break;
+        d->head = second;
+        d->count--;
+    }
+}
+
+int pm_steady_check(const pm_steady_t *d, float *temp_mean, float *power_mean)
+{
+    double st[2] = { 0, 0 }, sp[2] = { 0, 0 };
+    unsigned int nt[2] = { 0, 0 }, np[2] = { 0, 0 };
+    double t_first, t_last, t_mid;
+
+    *temp_mean = *power_mean = NAN;
+    if (d->count == 0)
+        return 0;
+
+    t_first = d->t[d->head];
+    t_last = d->t[(d->head + d->count - 1) % PM_STEADY_CAP];
+    t_mid = 0.5 * (t_first + t_last);
+    for (unsigned int k = 0; k < d->count; k++) {
+        unsigned int i = (d->head + k) % PM_STEADY_CAP;
+        int h = d->t[i] >= t_mid;
+        if (!isnan(d->temp[i])) {
+            st[h] += d->temp[i];
+            nt[h]++;
+        }
+        if (!isnan(d->power[i])) {
+            sp[h] += d->power[i];
+            np[h]++;
+        }
+    }
+    if (nt[0] + nt[1])
+        *temp_mean = (float)((st[0] + st[1]) / (nt[0] + nt[1]));
+    if (np[0] + np[1])
+        *power_mean = (float)((sp[0] + sp[1]) / (np[0] + np[1]));
+
+    if (t_last - t_first < d->window_s)
+        return 0;
+    if (nt[0] && nt[1] && fabs(st[0] / nt[0] - st[1] / nt[1]) > d->temp_band)
+        return 0;
+    if (np[0] && np[1] && fabs(sp[0] / np[0] - sp[1] / np[1]) > d->power_band)
+        return 0;
+    return nt[0] + np[0] > 0 && nt[1] + np[1] > 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Small-sample statistics for repeated runs, and a thermal/power
+ * steady-state detector over the live PM stream.
+ */
+#ifndef PM_STATS_H
+#define PM_STATS_H
+
+#include <stddef.h>
+
+typedef struct {
+    unsigned int n;
+    double mean, sd;
+    double ci_lo, ci_hi;        /* 95% confidence interval of the mean (Student t) */
+    double median, min, max;
+    unsigned int outliers;      /* count flagged */
+} pm_stats_t;
+
+/*
+ * Summarise x[0..n). NaN entries are skipped. If outlier is non-NULL it
+ * receives 1 for entries whose modified z-score (median/MAD) exceeds 3.5.
+ */
+void pm_stats_summarize(const double *x, unsigned int n, pm_stats_t *st,
+                        unsigned char *outlier);
+
+/* Two-sided 95% Student t quantile for df degrees of freedom. */
+double pm_stats_t95(unsigned int df);
+
+/*
+ * Mann-Whitney U test, two-sided. Exact for small samples without ties,
+ * normal approximation with tie and continuity correction otherwise.
+ * u is U for sample a. Returns the p-value (NAN if either side is empty).
+ */
+double pm_stats_mann_whitney(const double *a, size_t na, const double *b, size_t nb,
+                             double *u);
+
+/*
+ * Percentile bootstrap of mean(b) - mean(a): 95% interval and a two-sided
+ * p-value (twice the smaller tail beyond zero). Deterministic for a seed.
+ */
+void pm_stats_bootstrap_delta(const double *a, size_t na, const double *b, size_t nb,
+                              unsigned int resamples, unsigned long long seed,
+                              double *lo, double *hi, double *p);
+
+/* Welch 95% interval of mean(b) - mean(a), for samples too large to resample. */
+void pm_stats_welch_delta(const double *a, size_t na, const double *b, size_t nb,
+                          double *lo, double *hi);
+
+/*
+ * Steady state: the mean temperature and power of the older and newer
+ * halves of a sliding window differ by no more than the bands. Drift,
+ * not noise, is what matters; idle package power is spiky.
+ */
+#define PM_STEADY_CAP 4096
+
+typedef struct {
+    double window_s;
+    float  temp_band, power_band;
+    double t[PM_STEADY_CAP];
+    float  temp[PM_STEADY_CAP], power[PM_STEADY_CAP];
+    unsigned int head, count;
+} pm_steady_t;
+
+void pm_steady_init(pm_steady_t *d, double window_s, float temp_band, float power_band);
+void pm_steady_reset(pm_steady_t *d);
+void pm_steady_push(pm_steady_t *d, double t, float temp, float power);
+
+/* 1 once a full window is held and it is flat; window means are returned
+ * either way (NAN with no samples). */
+int pm_steady_check(const pm_steady_t *d, float *temp_mean, float *power_mean);
+
+#endif
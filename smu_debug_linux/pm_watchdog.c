@@ -0,0 +1,182 @@
+/*
+ * Safety watchdog (see pm_watchdog.h).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pm_watchdog.h"
+
+static const struct {
+    const char *name, *unit;
+} checks[PM_WD_COUNT] = {
+    [PM_WD_TEMP]      = { "temp", "C" },
+    [PM_WD_CORE_TEMP] = { "core-temp", "C" },
+    [PM_WD_PROCHOT]   = { "prochot", "" },
+    [PM_WD_VCORE]     = { "vcore", "V" },
+    [PM_WD_CORE_VOLT] = { "core-volt", "V" },
+    [PM_WD_PPT]       = { "ppt", "%" },
+    [PM_WD_TDC]       = { "tdc", "%" },
+    [PM_WD_EDC]       = { "edc", "%" },
+};
+
+const char *pm_wd_check_name(pm_wd_check_t k)
+{
+    return (unsigned)k < PM_WD_COUNT ? checks[k].name : "?";
+}
+
+const char *pm_wd_check_unit(pm_wd_check_t k)
+{
+    return (unsigned)k < PM_WD_COUNT ? checks[k].unit : "";
+}
+
+void pm_wd_defaults(pm_wd_config_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    c->rule[PM_WD_TEMP] = (pm_wd_rule_t){ 1, 95.f, 1000 };
+    c->rule[PM_WD_PROCHOT] = (pm_wd_rule_t){ 1, 0.f, 0 };
+}
+
+int pm_wd_parse_rule(pm_wd_check_t k, const char *spec, pm_wd_rule_t *r)
+{
+    char *end;
+    long ms = 0;
+    float v = 0.f;
+
+    if (k != PM_WD_PROCHOT) {
+        v = strtof(spec, &end);
+        if (end == spec || isnan(v) || v <= 0.f)
+            return -1;
+        if (*end == ':')
+            spec = end + 1;
+        else if (*end == '\0')
+            spec = end;
+        else
+            return -1;
+    }
+    if (*spec) {
+        ms = strtol(spec, &end, 10);
+        if (end == spec || *end || ms < 0 || ms > 60000)
+            return -1;
+    }
+    r->enabled = 1;
+    r->threshold = v;
+    r->persist_ms = (unsigned int)ms;
+    return 0;
+}
+
+static int limit_pct_fields(pm_wd_check_t k, int *value, int *limit)
+{
+    switch (k) {
+    case PM_WD_PPT: *value = PMF_PPT_VALUE; *limit = PMF_PPT_LIMIT; return 1;
+    case PM_WD_TDC: *value = PMF_TDC_VALUE; *limit = PMF_TDC_LIMIT; return 1;
+    case PM_WD_EDC: *value = PMF_EDC_VALUE; *limit = PMF_EDC_LIMIT; return 1;
+    default:        return 0;
+    }
+}
+
+void pm_wd_init(pm_wd_t *w, const pm_wd_config_t *c, const pm_schema_t *schema,
+                unsigned int ncores, const int *slot)
+{
+    memset(w, 0, sizeof(*w));
+    w->cfg = *c;
+    w->schema = schema;
+    w->ntemp = pm_core_slots(schema, PMF_CORE_TEMP, ncores ? slot : NULL,
+                             ncores ? ncores : pm_count(schema, PMF_CORE_TEMP), w->temp_slot);
+    w->nvolt = pm_core_slots(schema, PMF_CORE_VOLTAGE, ncores ? slot : NULL,
+                             ncores ? ncores : pm_count(schema, PMF_CORE_VOLTAGE), w->volt_slot);
+    for (int k = 0; k < PM_WD_COUNT; k++) {
+        int value, limit, ok;
+
+        w->onset[k] = -1.0;
+        if (!c->rule[k].enabled)
+            continue;
+        switch (k) {
+        case PM_WD_TEMP:      ok = pm_has(schema, PMF_THM_VALUE); break;
+        case PM_WD_CORE_TEMP: ok = w->ntemp != 0; break;
+        case PM_WD_PROCHOT:   ok = pm_has(schema, PMF_PROCHOT); break;
+        case PM_WD_VCORE:     ok = pm_has(schema, PMF_CPU_TELEMETRY_VOLTAGE); break;
+        case PM_WD_CORE_VOLT: ok = w->nvolt != 0; break;
+        default:
+            ok = limit_pct_fields((pm_wd_check_t)k, &value, &limit) &&
+                 pm_has(schema, (pm_field_id)value) && pm_has(schema, (pm_field_id)limit);
+            break;
+        }
+        if (ok)
+            w->avail |= 1u << k;
+    }
+}
+
+static float reading(const pm_wd_t *w, pm_wd_check_t k, const void *tab)
+{
+    const pm_schema_t *sc = w->schema;
+    int value, limit;
+
+    switch (k) {
+    case PM_WD_TEMP:      return pm_get(sc, tab, PMF_THM_VALUE);
+    case PM_WD_PROCHOT:   return pm_get(sc, tab, PMF_PROCHOT);
+    case PM_WD_VCORE:     return pm_get(sc, tab, PMF_CPU_TELEMETRY_VOLTAGE);
+    case PM_WD_CORE_TEMP:
+    case PM_WD_CORE_VOLT: {
+        /* Hottest / highest core, at the cores' slots */
+        pm_field_id f = k == PM_WD_CORE_TEMP ? PMF_CORE_TEMP : PMF_CORE_VOLTAGE;
+        const int *slot = k == PM_WD_CORE_TEMP ? w->temp_slot : w->volt_slot;
+        unsigned int n = k == PM_WD_CORE_TEMP ? w->ntemp : w->nvolt;
+        float m = NAN;
+
+        for (unsigned int i = 0; i < n; i++) {
+            float v = pm_get_at(sc, tab, f, (unsigned int)slot[i]);
+            if (!isnan(v) && (isnan(m) || v > m))
+                m = v;
+        }
+        return m;
+    }
+    default: {
+        float v, l;
+
+        if (!limit_pct_fields(k, &value, &limit))
+            return NAN;
+        v = pm_get(sc, tab, (pm_field_id)value);
+        l = pm_get(sc, tab, (pm_field_id)limit);
+        return l > 0.f ? v * 100.f / l : NAN;
+    }
+    }
+}
+
+void pm_wd_sample(pm_wd_t *w, double t, const void *tab, pm_wd_result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    res->tripped = -1;
+    for (int k = 0; k < PM_WD_COUNT; k++) {
+        const pm_wd_rule_t *r = &w->cfg.rule[k];
+        float v = NAN;
+        int over;
+
+        if (w->avail & (1u << k))
+            v = reading(w, (pm_wd_check_t)k, tab);
+        res->value[k] = v;
+        if (isnan(v))
+            continue;
+        over = k == PM_WD_PROCHOT ? v > 0.f : v > r->threshold;
+        if (!over) {
+            if (w->onset[k] >= 0)
+                res->clear_mask |= 1u << k;
+            w->onset[k] = -1.0;
+            continue;
+        }
+        if (w->onset[k] < 0) {
+            w->onset[k] = t;
+            w->peak[k] = v;
+            res->onset_mask |= 1u << k;
+        } else if (v > w->peak[k]) {
+            w->peak[k] = v;
+        }
+        if (res->tripped < 0 && (t - w->onset[k]) * 1000.0 + 1e-6 >= r->persist_ms) {
+            res->tripped = k;
+            res->onset = w->onset[k];
+            res->peak = w->peak[k];
+        }
+    }
+}
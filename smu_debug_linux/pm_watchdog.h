@@ -0,0 +1,74 @@
+/*
+ * Safety watchdog: trips when a PM reading stays past its threshold.
+ *
+ * Each check compares one reading per sample against a threshold. A check
+ * trips once its reading has been past the threshold for persist_ms without
+ * a break (0 = on the first sample). Onset is the first sample of the
+ * unbroken run, so onset-to-trip is the detection latency. The watchdog only
+ * decides; the caller restores the safe settings and times that itself.
+ */
+#ifndef PM_WATCHDOG_H
+#define PM_WATCHDOG_H
+
+#include <stddef.h>
+
+#include "pm_schema.h"
+
+typedef enum {
+    PM_WD_TEMP,         /* THM_VALUE, C */
+    PM_WD_CORE_TEMP,    /* hottest CORE_TEMP, C */
+    PM_WD_PROCHOT,      /* PROCHOT asserted (threshold unused) */
+    PM_WD_VCORE,        /* CPU_TELEMETRY_VOLTAGE, V */
+    PM_WD_CORE_VOLT,    /* highest CORE_VOLTAGE, V */
+    PM_WD_PPT,          /* % of limit */
+    PM_WD_TDC,
+    PM_WD_EDC,
+    PM_WD_COUNT
+} pm_wd_check_t;
+
+typedef struct {
+    int          enabled;
+    float        threshold;     /* trips above (or at, for PROCHOT) */
+    unsigned int persist_ms;
+} pm_wd_rule_t;
+
+typedef struct {
+    pm_wd_rule_t rule[PM_WD_COUNT];
+} pm_wd_config_t;
+
+typedef struct {
+    const pm_schema_t *schema;
+    int                temp_slot[PM_MAX_CORES];     /* PM array index of each core */
+    int                volt_slot[PM_MAX_CORES];
+    unsigned int       ntemp, nvolt;
+    pm_wd_config_t     cfg;
+    unsigned int       avail;           /* bit per check the layout can serve */
+    double             onset[PM_WD_COUNT];  /* < 0: reading within bounds */
+    float              peak[PM_WD_COUNT];   /* worst reading of the current run */
+} pm_wd_t;
+
+typedef struct {
+    float  value[PM_WD_COUNT];          /* this sample, NAN if not reported */
+    unsigned int onset_mask, clear_mask;    /* runs that started / ended */
+    int    tripped;                     /* check, -1 */
+    double onset;                       /* of the tripped check */
+    float  peak;                        /* of the tripped check */
+} pm_wd_result_t;
+
+/* Defaults: temp 95 C for 1000 ms, PROCHOT at once; the rest off. */
+void pm_wd_defaults(pm_wd_config_t *c);
+/* "VALUE[:MS]" for a check; PROCHOT takes "MS". 0 ok, -1 malformed. */
+int  pm_wd_parse_rule(pm_wd_check_t k, const char *spec, pm_wd_rule_t *r);
+
+/* Enabled checks the layout cannot serve are left out of avail. slot: PM
+ * array index of each core (see pm_core_slots), NULL if dense; with ncores 0
+ * every array entry is checked. */
+void pm_wd_init(pm_wd_t *w, const pm_wd_config_t *c, const pm_schema_t *schema,
+                unsigned int ncores, const int *slot);
+/* Evaluate one sample taken at t (seconds); reports the first check that trips. */
+void pm_wd_sample(pm_wd_t *w, double t, const void *table, pm_wd_result_t *res);
+
+const char *pm_wd_check_name(pm_wd_check_t k);     /* "temp", "core-temp", ... */
+const char *pm_wd_check_unit(pm_wd_check_t k);     /* "C", "V", "%", "" */
+
+#endif
@@ -298,6 +298,32 @@ smu_return_val smu_write_smn_addr(smu_obj_t* obj, unsigned int address, unsigned
     return ret == sizeof(buffer) ? SMU_Return_OK : SMU_Return_RWError;
 }
 
+smu_return_val smu_read_smn_block(smu_obj_t* obj, unsigned int base, unsigned int stride,
+    const unsigned int* addresses, unsigned int count, unsigned int* results, unsigned char* ok) {
+    unsigned int i, address, failed = 0;
+
+    // Don't attempt to execute without initialization.
+    if (!obj->init)
+        return SMU_Return_Failed;
+
+    pthread_mutex_lock(&obj->lock[SMU_MUTEX_SMN]);
+
+    // pwrite/pread: the offset is always 0, so no lseek per word.
+    for (i = 0; i < count; i++) {
+        address = addresses ? addresses[i] : base + i * stride;
+        ok[i] = pwrite(obj->fd_smn, &address, sizeof(address), 0) == sizeof(address) &&
+                pread(obj->fd_smn, &results[i], sizeof(results[i]), 0) == sizeof(results[i]);
+        if (!ok[i]) {
+            results[i] = 0xFFFFFFFF;
+            failed++;
+        }
+    }
+
+    pthread_mutex_unlock(&obj->lock[SMU_MUTEX_SMN]);
+
+    return failed ? SMU_Return_RWError : SMU_Return_OK;
+}
+
 smu_return_val smu_send_command(smu_obj_t* obj, unsigned int op, smu_arg_t* args,
     enum smu_mailbox mailbox) {
     unsigned int ret, status, fd_smu_cmd;
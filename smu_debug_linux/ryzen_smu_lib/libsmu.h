@@ -196,6 +196,15 @@ const char* smu_get_fw_version(smu_obj_t* obj);
 smu_return_val smu_read_smn_addr(smu_obj_t* obj, unsigned int address, unsigned int* result);
 smu_return_val smu_write_smn_addr(smu_obj_t* obj, unsigned int address, unsigned int value);
 
+/**
+ * Reads count 32 bit words from the SMN address space under one hold of the SMN lock:
+ * addresses[i] when addresses is not NULL, else base + i * stride.
+ * ok[i] tells whether word i was read; a failed word reads as 0xFFFFFFFF.
+ * Returns SMU_Return_OK when every word was read, SMU_Return_RWError otherwise.
+ */
+smu_return_val smu_read_smn_block(smu_obj_t* obj, unsigned int base, unsigned int stride,
+    const unsigned int* addresses, unsigned int count, unsigned int* results, unsigned char* ok);
+
 /**
  * Sends a command to the SMU.
  * Arguments are sent in the args buffer and are also returned in it.
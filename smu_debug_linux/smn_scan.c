@@ -0,0 +1,255 @@
+/*
+ * SMN range scanner (see smn_scan.h).
+ */
+
+#include <string.h>
+
+#include "smn_scan.h"
+
+#define RUN_MAX     4096    /* words per binary run before it is flushed */
+
+typedef struct {
+    FILE      *out;
+    smn_fmt_t  fmt;
+    uint32_t   run_addr;
+    uint32_t   run_n;
+    uint32_t   run[RUN_MAX];
+} sink_t;
+
+static const char hexd[] = "0123456789ABCDEF";
+
+int smn_fmt_parse(const char *s, smn_fmt_t *fmt)
+{
+    if (strcmp(s, "table") == 0)
+        *fmt = SMN_FMT_TABLE;
+    else if (strcmp(s, "csv") == 0)
+        *fmt = SMN_FMT_CSV;
+    else if (strcmp(s, "bin") == 0)
+        *fmt = SMN_FMT_BIN;
+    else
+        return -1;
+    return 0;
+}
+
+/* "0x" + 8 upper-case hex digits; returns the end */
+static char *put_hex32(char *p, uint32_t v)
+{
+    *p++ = '0';
+    *p++ = 'x';
+    for (int s = 28; s >= 0; s -= 4)
+        *p++ = hexd[(v >> s) & 0xF];
+    return p;
+}
+
+static char *put_str(char *p, const char *s)
+{
+    size_t n = strlen(s);
+
+    memcpy(p, s, n);
+    return p + n;
+}
+
+static void run_flush(sink_t *s)
+{
+    uint32_t h[2] = { s->run_addr, s->run_n };
+
+    if (!s->run_n)
+        return;
+    fwrite(h, sizeof(h), 1, s->out);
+    fwrite(s->run, sizeof(uint32_t), s->run_n, s->out);
+    s->run_n = 0;
+}
+
+static void emit_word(sink_t *s, uint32_t addr, uint32_t v, int ok)
+{
+    char line[96], *p = line;
+
+    switch (s->fmt) {
+    case SMN_FMT_BIN:
+        if (!ok) {
+            run_flush(s);
+            return;
+        }
+        if (s->run_n && (addr != s->run_addr + s->run_n * 4 || s->run_n == RUN_MAX))
+            run_flush(s);
+        if (!s->run_n)
+            s->run_addr = addr;
+        s->run[s->run_n++] = v;
+        return;
+    case SMN_FMT_CSV:
+        p = put_hex32(p, addr);
+        *p++ = ',';
+        if (ok) {
+            p = put_hex32(p, v);
+            *p++ = ',';
+        } else {
+            p = put_str(p, ",read error");
+        }
+        break;
+    case SMN_FMT_TABLE:
+        p = put_str(p, "  ");
+        p = put_hex32(p, addr);
+        if (!ok) {
+            p = put_str(p, "  │ READ ERROR │");
+            break;
+        }
+        p = put_str(p, "  │ ");
+        p = put_hex32(p, v);
+        p = put_str(p, " │ ");
+        for (int i = 31; i >= 0; i--) {
+            *p++ = (char)('0' + ((v >> i) & 1));
+            if (i % 8 == 0 && i > 0)
+                *p++ = ' ';
+        }
+        break;
+    }
+    *p++ = '\n';
+    fwrite(line, 1, (size_t)(p - line), s->out);
+}
+
+static void emit_hole(sink_t *s, uint32_t from, uint32_t to)
+{
+    switch (s->fmt) {
+    case SMN_FMT_BIN:
+        run_flush(s);
+        break;
+    case SMN_FMT_CSV:
+        fprintf(s->out, "0x%08X,,unmapped through 0x%08X\n", from, to);
+        break;
+    case SMN_FMT_TABLE:
+        fprintf(s->out, "  0x%08X  │    hole    │ unmapped through 0x%08X\n", from, to);
+        break;
+    }
+}
+
+static void sink_begin(sink_t *s, const smn_scan_opts_t *o)
+{
+    switch (s->fmt) {
+    case SMN_FMT_BIN: {
+        smn_dump_header_t h;
+
+        if (!o->hdr)
+            break;      /* appending another range */
+        h = *o->hdr;
+        memcpy(h.magic, SMN_DUMP_MAGIC, sizeof(h.magic));
+        h.label[sizeof(h.label) - 1] = '\0';
+        fwrite(&h, sizeof(h), 1, s->out);
+        break;
+    }
+    case SMN_FMT_CSV:
+        fprintf(s->out, "Address,Value,Note\n");
+        break;
+    case SMN_FMT_TABLE:
+        fprintf(s->out, "\nSMN Range Scan: 0x%08X - 0x%08X\n", o->start, o->end);
+        fprintf(s->out, "──────────────┬────────────┬────────────────────────────────────\n");
+        fprintf(s->out, "  Address     │   Value    │   Binary\n");
+        fprintf(s->out, "──────────────┼────────────┼────────────────────────────────────\n");
+        break;
+    }
+}
+
+static void sink_end(sink_t *s)
+{
+    if (s->fmt == SMN_FMT_BIN)
+        run_flush(s);
+    else if (s->fmt == SMN_FMT_TABLE)
+        fprintf(s->out, "──────────────┴────────────┴────────────────────────────────────\n");
+}
+
+/* 1 live, 0 dead (error or all-ones), -1 abort */
+static int probe(smn_block_fn rd, void *ctx, uint64_t addr, smn_scan_stats_t *st)
+{
+    uint32_t v;
+    unsigned char ok;
+
+    if (rd(ctx, (uint32_t)addr, 1, &v, &ok) < 0)
+        return -1;
+    st->words_read++;
+    return ok && v != 0xFFFFFFFF;
+}
+
+/*
+ * a is granule-aligned and the granule before it read dead. Probes granule
+ * heads from a on; returns the first live one (end + 4 if none), -1 on abort.
+ */
+static int64_t find_live(smn_block_fn rd, void *ctx, uint64_t a, uint64_t end, uint64_t g,
+                         smn_scan_stats_t *st)
+{
+    for (; a <= end; a += g) {
+        int r = probe(rd, ctx, a, st);
+
+        if (r)
+            return r < 0 ? -1 : (int64_t)a;
+    }
+    return (int64_t)(end + 4);
+}
+
+int smn_scan(const smn_scan_opts_t *o, smn_block_fn rd, void *ctx, FILE *out,
+             smn_scan_stats_t *st)
+{
+    sink_t s;
+    uint32_t buf[SMN_SCAN_BLOCK];
+    unsigned char ok[SMN_SCAN_BLOCK];
+    uint64_t a = o->start & ~3u, g = o->granule, dead = 0, end;
+    int rc = 0;
+
+    memset(st, 0, sizeof(*st));
+    if (o->end < a)
+        return 0;
+    end = a + (((uint64_t)o->end - a) & ~(uint64_t)3);     /* last word */
+    if (g && (g < 4 || (g & (g - 1))))
+        g = 0;
+
+    s.out = out;
+    s.fmt = o->fmt;
+    s.run_n = 0;
+    sink_begin(&s, o);
+
+    while (a <= end) {
+        unsigned int n;
+
+        if (g && dead >= g && a % g == 0) {
+            int64_t live = find_live(rd, ctx, a, end, g, st);
+
+            if (live < 0) {
+                rc = -1;
+                break;
+            }
+            dead = 0;
+            if ((uint64_t)live > a) {
+                emit_hole(&s, (uint32_t)a, (uint32_t)(live - 4));
+                st->holes++;
+                st->bytes_skipped += (uint64_t)live - a;
+                a = (uint64_t)live;
+                continue;
+            }
+        }
+
+        n = (end - a) / 4 + 1 < SMN_SCAN_BLOCK ? (unsigned int)((end - a) / 4 + 1)
+                                               : SMN_SCAN_BLOCK;
+        if (g && (g - a % g) / 4 < n)
+            n = (unsigned int)((g - a % g) / 4);    /* stop at the granule edge */
+        if (rd(ctx, (uint32_t)a, n, buf, ok) < 0) {
+            rc = -1;
+            break;
+        }
+        st->words_read += n;
+        for (unsigned int i = 0; i < n; i++) {
+            if (!ok[i]) {
+                st->errors++;
+                dead += 4;
+            } else if (buf[i] == 0xFFFFFFFF) {
+                dead += 4;
+            } else {
+                st->words_live++;
+                dead = 0;
+            }
+            emit_word(&s, (uint32_t)(a + i * 4), buf[i], ok[i]);
+        }
+        a += (uint64_t)n * 4;
+    }
+    sink_end(&s);
+    if (fflush(out) != 0 || ferror(out))
+        rc = -1;
+    return rc;
+}
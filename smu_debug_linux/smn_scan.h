@@ -0,0 +1,65 @@
+/*
+ * SMN range scanner.
+ *
+ * Reads a word-aligned SMN range in blocks through a callback and writes it
+ * as a box table, CSV or a compact binary dump. Unmapped space (read errors or
+ * 0xFFFFFFFF) is skipped: once a whole aligned granule reads dead, only the
+ * first word of each following granule is read until one is live, and the
+ * dead stretch is reported as one hole. A granule whose first word is dead is
+ * skipped even if later words are live; a smaller granule narrows that,
+ * granule 0 reads every word.
+ *
+ * Binary dump: an smn_dump_header_t, then runs of
+ *   uint32 addr, uint32 nwords, nwords x uint32 value
+ * in host (little-endian) order. Read errors and holes end a run, so a gap
+ * between runs is space that could not be read.
+ */
+#ifndef SMN_SCAN_H
+#define SMN_SCAN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SMN_DUMP_MAGIC      "SMNDUMP1"
+#define SMN_SCAN_BLOCK      256         /* words per block read */
+
+typedef struct {
+    char     magic[8];                  /* SMN_DUMP_MAGIC, no NUL */
+    uint32_t smu_version;
+    uint32_t codename;
+    int64_t  time;                      /* unix seconds */
+    char     label[40];                 /* NUL-terminated, e.g. "idle" */
+} smn_dump_header_t;                    /* 64 bytes */
+
+/*
+ * Read n words at addr, addr + 4, ... into out; ok[i] = 0 where a read
+ * failed. Returns the number of words attempted (n), or -1 to abort.
+ */
+typedef int (*smn_block_fn)(void *ctx, uint32_t addr, unsigned int n,
+                            uint32_t *out, unsigned char *ok);
+
+typedef enum { SMN_FMT_TABLE, SMN_FMT_CSV, SMN_FMT_BIN } smn_fmt_t;
+
+typedef struct {
+    uint32_t   start, end;              /* inclusive; start is word-aligned */
+    uint32_t   granule;                 /* hole granularity, bytes (power of 2); 0 = no skipping */
+    smn_fmt_t  fmt;
+    const smn_dump_header_t *hdr;       /* SMN_FMT_BIN header (magic is filled in); NULL appends runs */
+} smn_scan_opts_t;
+
+typedef struct {
+    uint64_t     words_read;            /* including probes */
+    uint64_t     words_live;
+    uint64_t     errors;
+    uint64_t     bytes_skipped;
+    unsigned int holes;
+} smn_scan_stats_t;
+
+/* "table", "csv", "bin" -> format; -1 if unknown. */
+int  smn_fmt_parse(const char *s, smn_fmt_t *fmt);
+
+/* Scan and write to out (callers should give it a large buffer). 0 ok, -1 read abort or write error. */
+int  smn_scan(const smn_scan_opts_t *o, smn_block_fn rd, void *ctx, FILE *out,
+              smn_scan_stats_t *st);
+
+#endif
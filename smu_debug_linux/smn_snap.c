@@ -0,0 +1,241 @@
+/*
+ * SMN snapshots and diffs (see smn_snap.h).
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "smn_snap.h"
+
+static int run_cmp(const void *x, const void *y)
+{
+    const smn_run_t *a = x, *b = y;
+
+    return a->addr < b->addr ? -1 : a->addr > b->addr;
+}
+
+int smn_snap_load(const char *path, smn_snap_t *s, char *err, size_t errlen)
+{
+    FILE *fp = fopen(path, "rb");
+    unsigned char *p, *end;
+    unsigned int cap = 0;
+    long size;
+
+    memset(s, 0, sizeof(*s));
+    if (!fp) {
+        snprintf(err, errlen, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0 ||
+        !(s->buf = malloc(size ? (size_t)size : 1)) ||
+        fread(s->buf, 1, (size_t)size, fp) != (size_t)size) {
+        snprintf(err, errlen, "%s: read failed", path);
+        fclose(fp);
+        smn_snap_free(s);
+        return -1;
+    }
+    fclose(fp);
+
+    if ((size_t)size < sizeof(s->hdr) ||
+        memcmp(s->buf, SMN_DUMP_MAGIC, sizeof(s->hdr.magic)) != 0) {
+        snprintf(err, errlen, "%s: not an SMN dump (smn-scan -f bin / smn-snap)", path);
+        smn_snap_free(s);
+        return -1;
+    }
+    memcpy(&s->hdr, s->buf, sizeof(s->hdr));
+    s->hdr.label[sizeof(s->hdr.label) - 1] = '\0';
+
+    p = (unsigned char *)s->buf + sizeof(s->hdr);
+    end = (unsigned char *)s->buf + size;
+    while (p < end) {
+        uint32_t h[2];
+
+        if ((size_t)(end - p) < sizeof(h))
+            break;
+        memcpy(h, p, sizeof(h));
+        p += sizeof(h);
+        if (h[1] == 0 || h[1] > (size_t)(end - p) / 4 || (uint64_t)h[0] + h[1] * 4ull > 0x100000000ull) {
+            snprintf(err, errlen, "%s: corrupt run at 0x%08X", path, h[0]);
+            smn_snap_free(s);
+            return -1;
+        }
+        if (s->nruns == cap) {
+            smn_run_t *r = realloc(s->runs, (cap ? cap * 2 : 64) * sizeof(*r));
+
+            if (!r) {
+                snprintf(err, errlen, "%s: out of memory", path);
+                smn_snap_free(s);
+                return -1;
+            }
+            s->runs = r;
+            cap = cap ? cap * 2 : 64;
+        }
+        /* Runs start 4-byte aligned after the 64-byte header */
+        s->runs[s->nruns++] = (smn_run_t){ h[0], h[1], (const uint32_t *)(void *)p };
+        s->nwords += h[1];
+        p += (size_t)h[1] * 4;
+    }
+    if (p != end) {
+        snprintf(err, errlen, "%s: truncated", path);
+        smn_snap_free(s);
+        return -1;
+    }
+    qsort(s->runs, s->nruns, sizeof(*s->runs), run_cmp);
+
+    /*
+     * Ranges passed to smn-scan may overlap. Trim each run to the words past
+     * the end of the one before, dropping runs that are covered entirely, so
+     * the runs are disjoint and a diff reports every address once, in order.
+     */
+    {
+        unsigned int k = 0;
+        uint64_t end_prev = 0;
+
+        s->nwords = 0;
+        for (unsigned int i = 0; i < s->nruns; i++) {
+            smn_run_t r = s->runs[i];
+            uint64_t e = r.addr + r.n * 4ull;
+
+            if (k && r.addr < end_prev) {
+                uint64_t skip = (end_prev - r.addr + 3) / 4;
+
+                if (skip >= r.n)
+                    continue;
+                r.addr += (uint32_t)skip * 4;
+                r.v += skip;
+                r.n -= (uint32_t)skip;
+            }
+            s->runs[k++] = r;
+            s->nwords += r.n;
+            end_prev = e;
+        }
+        s->nruns = k;
+    }
+    return 0;
+}
+
+void smn_snap_free(smn_snap_t *s)
+{
+    free(s->runs);
+    free(s->buf);
+    memset(s, 0, sizeof(*s));
+}
+
+int smn_snap_get(const smn_snap_t *s, uint32_t addr, uint32_t *v)
+{
+    unsigned int lo = 0, hi = s->nruns;
+
+    /* Last run starting at or below addr */
+    while (lo < hi) {
+        unsigned int mid = (lo + hi) / 2;
+
+        if (s->runs[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return -1;
+    {
+        const smn_run_t *r = &s->runs[lo - 1];
+        uint64_t off = (uint64_t)(addr - r->addr) / 4;
+
+        if ((addr - r->addr) % 4 || off >= r->n)
+            return -1;
+        *v = r->v[off];
+    }
+    return 0;
+}
+
+typedef struct {
+    smn_change_t *v;
+    size_t        n, cap;
+} changes_t;
+
+static int push(changes_t *c, uint32_t addr, uint32_t bits)
+{
+    if (c->n == c->cap) {
+        size_t cap = c->cap ? c->cap * 2 : 256;
+        smn_change_t *v = realloc(c->v, cap * sizeof(*v));
+
+        if (!v)
+            return -1;
+        c->v = v;
+        c->cap = cap;
+    }
+    c->v[c->n++] = (smn_change_t){ addr, bits };
+    return 0;
+}
+
+/* Compare n words; changes are recorded at addr + 4 * index. */
+static int diff_words(const uint32_t *a, const uint32_t *b, size_t n, uint32_t addr,
+                      changes_t *c)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i)),
+                                   _mm_loadu_si128((const __m128i *)(b + i)));
+        __m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i + 4)),
+                                   _mm_loadu_si128((const __m128i *)(b + i + 4)));
+        __m128i x2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i + 8)),
+                                   _mm_loadu_si128((const __m128i *)(b + i + 8)));
+        __m128i x3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i + 12)),
+                                   _mm_loadu_si128((const __m128i *)(b + i + 12)));
+        __m128i any = _mm_or_si128(_mm_or_si128(x0, x1), _mm_or_si128(x2, x3));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) == 0xFFFF)
+            continue;
+        for (size_t k = i; k < i + 16; k++) {
+            if (a[k] != b[k] && push(c, addr + (uint32_t)(k * 4), a[k] ^ b[k]) != 0)
+                return -1;
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] != b[i] && push(c, addr + (uint32_t)(i * 4), a[i] ^ b[i]) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+long smn_snap_diff(const smn_snap_t *a, const smn_snap_t *b, smn_change_t **out,
+                   uint64_t *compared)
+{
+    changes_t c = { NULL, 0, 0 };
+    unsigned int i = 0, j = 0;
+
+    *compared = 0;
+    while (i < a->nruns && j < b->nruns) {
+        const smn_run_t *ra = &a->runs[i], *rb = &b->runs[j];
+        uint64_t ea = ra->addr + ra->n * 4ull, eb = rb->addr + rb->n * 4ull;
+        uint64_t lo = ra->addr > rb->addr ? ra->addr : rb->addr;
+        uint64_t hi = ea < eb ? ea : eb;
+
+        /* Overlap, when both runs are on the same word grid */
+        if (lo < hi && (ra->addr - rb->addr) % 4 == 0) {
+            size_t n = (size_t)(hi - lo) / 4;
+
+            if (diff_words(ra->v + (lo - ra->addr) / 4, rb->v + (lo - rb->addr) / 4, n,
+                           (uint32_t)lo, &c) != 0) {
+                free(c.v);
+                return -1;
+            }
+            *compared += n;
+        }
+        if (ea <= eb)
+            i++;
+        else
+            j++;
+    }
+    *out = c.v;
+    return (long)c.n;
+}
@@ -0,0 +1,54 @@
+/*
+ * SMN snapshots and diffs.
+ *
+ * A snapshot is a binary dump written by smn_scan (SMN_FMT_BIN): a header and
+ * runs of consecutive words, possibly from several address ranges. Loading
+ * reads the file in one go, sorts the runs by address and trims overlapping
+ * ones, so every address appears once. A diff walks two snapshots' runs in
+ * step and compares the overlapping words 16 at a time with SSE2, dropping
+ * to per-word work only for blocks that differ, so megabytes of unchanged
+ * registers cost little more than the memory reads.
+ */
+#ifndef SMN_SNAP_H
+#define SMN_SNAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "smn_scan.h"
+
+typedef struct {
+    uint32_t        addr;
+    uint32_t        n;              /* words */
+    const uint32_t *v;
+} smn_run_t;
+
+typedef struct {
+    smn_dump_header_t hdr;
+    smn_run_t        *runs;         /* sorted by addr, disjoint */
+    unsigned int      nruns;
+    uint64_t          nwords;       /* distinct words */
+    void             *buf;          /* file contents */
+} smn_snap_t;
+
+typedef struct {
+    uint32_t addr;
+    uint32_t bits;                  /* a ^ b */
+} smn_change_t;
+
+/* 0 ok; -1 with a message in err. */
+int  smn_snap_load(const char *path, smn_snap_t *s, char *err, size_t errlen);
+void smn_snap_free(smn_snap_t *s);
+
+/* Value at addr; 0 if the snapshot has it, -1 if not. */
+int  smn_snap_get(const smn_snap_t *s, uint32_t addr, uint32_t *v);
+
+/*
+ * Words that differ between a and b where both have data, sorted by address.
+ * *out is malloc'd (NULL when nothing changed); *compared counts the words
+ * present in both. Returns the number of changes, -1 if out of memory.
+ */
+long smn_snap_diff(const smn_snap_t *a, const smn_snap_t *b, smn_change_t **out,
+                   uint64_t *compared);
+
+#endif
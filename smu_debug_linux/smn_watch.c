@@ -0,0 +1,97 @@
+/*
+ * SMN watchpoints (see smn_watch.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "smn_watch.h"
+
+int smn_watch_parse(const char *spec, smn_watch_reg_t *r)
+{
+    const char *name = strchr(spec, '=');
+    char num[64], *end;
+    size_t len = name ? (size_t)(name - spec) : strlen(spec);
+    char *slash;
+    unsigned long v;
+
+    memset(r, 0, sizeof(*r));
+    if (len == 0 || len >= sizeof(num))
+        return -1;
+    memcpy(num, spec, len);
+    num[len] = '\0';
+    slash = strchr(num, '/');
+    if (slash)
+        *slash = '\0';
+
+    v = strtoul(num, &end, 16);
+    if (end == num || *end || v > 0xFFFFFFFFul || (v & 3))
+        return -1;
+    r->addr = (uint32_t)v;
+    r->mask = 0xFFFFFFFF;
+    if (slash) {
+        v = strtoul(slash + 1, &end, 16);
+        if (end == slash + 1 || *end || v == 0 || v > 0xFFFFFFFFul)
+            return -1;
+        r->mask = (uint32_t)v;
+    }
+    if (name)
+        snprintf(r->name, sizeof(r->name), "%s", name + 1);
+    return 0;
+}
+
+void smn_watch_init(smn_watch_t *w, const smn_watch_reg_t *regs, unsigned int n, double interval)
+{
+    memset(w, 0, sizeof(*w));
+    w->n = n < SMN_WATCH_MAX ? n : SMN_WATCH_MAX;
+    memcpy(w->reg, regs, w->n * sizeof(*regs));
+    w->interval = interval;
+}
+
+unsigned int smn_watch_sample(smn_watch_t *w, double t, const uint32_t *vals,
+                              const unsigned char *ok, smn_watch_edge_fn edge, void *ctx)
+{
+    unsigned int edges = 0;
+
+    if (w->cycles) {
+        double gap = t - w->t_last;
+
+        w->gap_sum += gap;
+        if (gap > w->gap_max)
+            w->gap_max = gap;
+        /* A cycle that took k intervals skipped k - 1 polls */
+        if (w->interval > 0 && gap >= 2 * w->interval)
+            w->missed += (unsigned long)(gap / w->interval) - 1;
+    } else {
+        w->t_first = t;
+    }
+    w->t_last = t;
+    w->cycles++;
+
+    for (unsigned int i = 0; i < w->n; i++) {
+        smn_watch_state_t *s = &w->st[i];
+        uint32_t v;
+
+        if (!ok[i]) {
+            s->errors++;
+            continue;
+        }
+        v = vals[i] & w->reg[i].mask;
+        if (s->have && v != s->last) {
+            s->edges++;
+            edges++;
+            if (edge)
+                edge(ctx, i, t, s->last, v);
+        }
+        s->last = v;
+        s->have = 1;
+    }
+    return edges;
+}
+
+double smn_watch_rate(const smn_watch_t *w)
+{
+    return w->cycles > 1 && w->t_last > w->t_first
+           ? (w->cycles - 1) / (w->t_last - w->t_first) : 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * SMN watchpoints.
+ *
+ * A set of SMN registers, each with a bit mask, sampled once per poll cycle
+ * (the caller reads them all in one batch). Only transitions of the masked
+ * value are reported, so a register that sits still costs nothing in the log
+ * however fast it is polled. The watcher also keeps the poll statistics:
+ * achieved rate, cycle gaps, and intervals missed because a cycle overran.
+ */
+#ifndef SMN_WATCH_H
+#define SMN_WATCH_H
+
+#include <stdint.h>
+
+#define SMN_WATCH_MAX   64
+
+typedef struct {
+    uint32_t addr;
+    uint32_t mask;              /* bits that count; 0xFFFFFFFF by default */
+    char     name[24];          /* optional */
+} smn_watch_reg_t;
+
+typedef struct {
+    uint32_t      last;         /* masked */
+    int           have;         /* last is valid */
+    unsigned long edges, errors;
+} smn_watch_state_t;
+
+typedef struct {
+    smn_watch_reg_t   reg[SMN_WATCH_MAX];
+    smn_watch_state_t st[SMN_WATCH_MAX];
+    unsigned int      n;
+    /* Poll statistics */
+    double            t_first, t_last, gap_max, gap_sum;
+    unsigned long     cycles, missed;
+    double            interval;     /* s; 0 = free-running */
+} smn_watch_t;
+
+/* Transition callback: reg index, time, old and new masked value. */
+typedef void (*smn_watch_edge_fn)(void *ctx, unsigned int i, double t, uint32_t old, uint32_t now);
+
+/* "ADDR[/MASK][=NAME]", hex; 0 ok, -1 malformed. */
+int  smn_watch_parse(const char *spec, smn_watch_reg_t *r);
+
+void smn_watch_init(smn_watch_t *w, const smn_watch_reg_t *regs, unsigned int n, double interval);
+
+/*
+ * One poll cycle at time t (s): vals/ok hold the batch read in reg order.
+ * The first good read of a register sets its baseline; after that every
+ * change of the masked value calls edge. Returns the transitions seen.
+ */
+unsigned int smn_watch_sample(smn_watch_t *w, double t, const uint32_t *vals,
+                              const unsigned char *ok, smn_watch_edge_fn edge, void *ctx);
+
+/* Achieved poll rate, Hz. */
+double smn_watch_rate(const smn_watch_t *w);
+
+#endif
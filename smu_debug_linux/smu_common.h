@@ -6,9 +6,16 @@
 
 #include <libsmu.h>
 
+#include "pbo_profile.h"
+#include "pm_expr.h"
+#include "pm_schema.h"
+
 /* Get the global SMU object (valid after smu_init). */
 smu_obj_t *smu_get_obj(void);
 
+/* Launcher: call once after smu_init; picks the codename's platform descriptor. */
+void smu_select_platform(void);
+
 /* Launcher: call before smu_init. */
 void smu_setup_signals(void);
 int smu_elevate_if_necessary(int argc, char **argv);
@@ -20,14 +27,55 @@ void smu_get_cpu_family_model(unsigned int *fam, unsigned int *model);
 int smu_get_topology(unsigned int *ccds, unsigned int *ccxs,
                      unsigned int *cores_per_ccx, unsigned int *phys_cores);
 int smu_get_if_version_int(void);
+/* PM per-core array index of each enabled core (pm_core_slots' slot map);
+ * the count, or -1 if the fuses can't be read. */
+int smu_get_core_slots(int *slot, unsigned int max);
 
 /* FMax (boost limit): Get 0x6E; Set: 0x5C (Zen2/Zen3), 0x70 SetBoostLimitFrequencyAllCores (Zen4/Zen5). Arg0 = MHz. */
 int smu_get_fmax(unsigned int *mhz_out);
 int smu_set_fmax(unsigned int mhz);
 
-/* Curve Optimizer (PSM margin). Command ID may be platform-specific (e.g. 0x76). */
+/* Curve Optimizer (PSM margin). Command ID may be platform-specific (e.g. 0x76).
+ * Both fail on platforms without CO (Zen/Zen+); a set outside the range does too. */
 int smu_set_curve_optimizer(int core_index, int margin);
 int smu_get_curve_optimizer(int core_index, int *margin_out);
+/* The platform's CO range (0, 0 without CO) and FMax cap. */
+void smu_get_tuning_bounds(int *co_min, int *co_max, unsigned int *fmax_max_mhz);
+
+/*
+ * PBO limits: PPT W, TDC/EDC A, THM C, scalar x. Set with the platform's RSMU
+ * command (Zen2/Zen3 or Zen4/Zen5 desktop); read back from PPT_LIMIT/TDC_LIMIT/
+ * EDC_LIMIT/THM_LIMIT in the PM table, the scalar by command. A set returns 0
+ * only once a PM snapshot shows the new value (firmware may clamp it).
+ */
+int smu_pbo_limit_supported(pbo_limit_id l);
+int smu_get_pbo_limit(pbo_limit_id l, unsigned int *value_out);
+int smu_set_pbo_limit(pbo_limit_id l, unsigned int value);
+
+/* CO/FMax/limit access for pbo_apply (ncores from the topology). */
+const pbo_ops_t *smu_pbo_ops(void);
+
+/* Named layout for the running PM table version (NULL if unknown). Cached
+ * until a field map is registered or the table version changes. */
+const pm_schema_t *smu_pm_schema(void);
+
+/* Derived metrics (built-ins, SMU_METRICS/--metrics file, --metric flags)
+ * compiled for the active layout. NULL without PM table support. */
+pm_expr_set_t *smu_metrics(void);
+
+/* PM table field name ("PPT_VALUE", "CORE_TEMP[3]") -> float index. Known layouts only. */
+int smu_pm_field_index(const char *name, unsigned int *index_out);
+
+/* Subcommands ("run", "smn-diff", ...). main gets argv[0] = the name and
+ * takes the rest of the command line verbatim (no GUI flag scan). */
+typedef struct {
+    const char *name;
+    int       (*main)(int argc, char **argv);
+    int         offline;        /* needs neither root nor smu_init */
+} smu_command_t;
+
+/* The subcommand named by argv[1], or NULL for the menu/GUI. */
+const smu_command_t *smu_find_command(int argc, char **argv);
 
 /* Entry points (launcher.c calls these). */
 int cli_main(int argc, char **argv);
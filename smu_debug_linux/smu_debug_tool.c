@@ -17,6 +17,7 @@
 #include <math.h>
 #include <time.h>
 #include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <cpuid.h>
 #include <stdio.h>
@@ -25,9 +26,12 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <signal.h>
+#include <grp.h>
+#include <pwd.h>
 #include <unistd.h>
 #include <string.h>
 #include <termios.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -35,12 +39,33 @@
 
 #include <libsmu.h>
 
+#include "smu_common.h"
+#include "pm_expr.h"
+#include "pm_infer.h"
+#include "pm_capture.h"
+#include "pm_limiter.h"
+#include "pm_rank.h"
+#include "pm_session.h"
+#include "pm_stats.h"
+#include "pm_compare.h"
+#include "co_tune.h"
+#include "pm_governor.h"
+#include "pm_watchdog.h"
+#include "smu_platform.h"
+#include "smu_mbox.h"
+#include "smn_scan.h"
+#include "smn_snap.h"
+#include "smn_watch.h"
+
 /* ═══════════════════════════════════════════════════════════════════════════ */
 /*  Constants                                                                 */
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
 #define TOOL_VERSION            "1.0.0"
-#define SMU_SCAN_RETRIES        8192
+#define SMU_CMD_DEADLINE_US     1000000 /* raw mailbox command: ready / completion */
+#define SMU_PROBE_DEADLINE_US   10000   /* scan probe reply (the old fixed sleep) */
+#define SMU_PROBE_MIN_US        1000    /* learned probe deadline never goes below */
+#define SMU_PROBE_MIN_SAMPLES   32      /* replies before the deadline is learned */
 
 /* Box-drawing characters for table output */
 #define BOX_TL  "╭"
@@ -61,6 +86,7 @@
 
 static smu_obj_t obj;
 static volatile sig_atomic_t g_running = 1;
+static volatile sig_atomic_t g_ext_trigger = 0;     /* SIGUSR1: capture trigger */
 
 /* Discovered mailbox addresses from scanning */
 typedef struct {
@@ -73,24 +99,17 @@ typedef struct {
 static mailbox_match_t g_matches[MAX_MAILBOX_MATCHES];
 static int g_match_count = 0;
 
-/* RSMU command IDs (see rsmu_commands.md, ZenStates-Core). FMax UI = boost limit (get 0x6E, set below). */
-#define SMU_CMD_GET_MAX_FREQUENCY      0x6E  /* GetBoostLimitFrequency */
-#define SMU_CMD_SET_FMAX_ALL_CORES    0x5C  /* Zen2/Zen3: SetOverclockFreqAllCores (same as boost there) */
-#define SMU_CMD_SET_BOOST_LIMIT_ALL   0x70  /* Zen4/Zen5: SetBoostLimitFrequencyAllCores (FMax = boost limit) */
-/* Curve Optimizer / PSM margin. Zen2/Zen3 SET = 0x76 (args[0]=mask, args[1]=margin).
- * Zen4/Zen5 use SET 0x6 with single combined arg (mask|margin in low 16 bits). */
-#define SMU_CMD_SET_PSM_MARGIN       0x76  /* Zen2/Zen3 */
-#define PSM_SET_ZEN4_ZEN5           0x6   /* Zen4, Zen5, Granite Ridge (Zen5Settings) */
-#define CO_MARGIN_MIN                (-60)
-#define CO_MARGIN_MAX                10
-/* RSMU GetDldoPsmMargin IDs from ZenStates-Core per platform */
-#define PSM_GET_ZEN3        0x7C  /* Matisse, Vermeer, Milan, Chagall (Zen3Settings) */
-#define PSM_GET_ZEN4_ZEN5   0xD5  /* Raphael, Granite Ridge, Zen5 (Zen4Settings, Zen5Settings, DragonRange) */
-#define PSM_GET_ZEN5_SP     0xA3  /* Shimada Peak (Zen5Settings_ShimadaPeak) */
-#define PSM_GET_PHOENIX     0xE1  /* Phoenix APU */
-#define PSM_GET_CEZANNE     0xC3  /* Cezanne APU */
-#define PSM_GET_LEGACY      0x77  /* fallback */
-#define PSM_GET_LEGACY_ALT  0x78  /* fallback */
+/* Platform descriptor, selected once after smu_init (smu_select_platform) */
+static const smu_platform_t *g_plat;
+
+/* Adaptive mailbox waits and their latency statistics (reset per scan) */
+static mbox_waiter_t g_mbox;
+
+#define PBO_LIMIT_CONFIRM_MS 250   /* wait this long for the PM table to show a new limit */
+#define SMU_CACHE_DIR        "/var/cache/smu_debug_tool"    /* SMU_CACHE_DIR overrides, not as root */
+#define CO_GET_CACHE_FILE    "co_get.cache"
+#define MAILBOX_CACHE_FILE   "mailbox.cache"
+#define SMN_SCAN_GRANULE     0x1000 /* hole-skip granularity; smn-scan -g overrides */
 
 /* ═══════════════════════════════════════════════════════════════════════════ */
 /*  Signal Handling                                                           */
@@ -104,6 +123,12 @@ static void signal_handler(int sig)
     fflush(stdout);
 }
 
+static void trigger_signal_handler(int sig)
+{
+    (void)sig;
+    g_ext_trigger = 1;
+}
+
 void smu_setup_signals(void)
 {
     struct sigaction sa;
@@ -114,6 +139,10 @@ void smu_setup_signals(void)
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
     sigaction(SIGABRT, &sa, NULL);
+
+    sa.sa_handler = trigger_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════ */
@@ -215,6 +244,24 @@ static void read_line(const char *prompt, char *buf, size_t len)
     buf[strcspn(buf, "\n\r")] = '\0';
 }
 
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Sleep until *next + period_ms (absolute, so sampling does not drift). */
+static void sleep_period(struct timespec *next, unsigned int period_ms)
+{
+    next->tv_nsec += (long)period_ms * 1000000L;
+    while (next->tv_nsec >= 1000000000L) {
+        next->tv_nsec -= 1000000000L;
+        next->tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL);
+}
+
 static int kbhit(void)
 {
     struct timeval tv = {0, 0};
@@ -293,11 +340,20 @@ static int get_topology_ex(unsigned int *ccds, unsigned int *ccxs,
     core_disable = core_fuse & 0xFF;
     smt = (core_fuse & (1 << 8)) != 0;
 
+    /* Per CCD: bit 25 of the fuse address selects the CCD; absent CCDs read
+     * as all-disabled. Bits 0-7 are the cores, bit 8 is SMT. */
     if (core_disable_map) {
-        core_disable_map[0] = core_disable & 0xFF;
-        core_disable_map[1] = (core_fuse >> 8) & 0xFF;
-        if (core_disable_map[1] == 0)
-            core_disable_map[1] = core_disable_map[0]; /* single CCD */
+        unsigned int base = core_fuse_addr & ~0x2000000u;
+
+        for (unsigned int ccd = 0; ccd < 2; ccd++) {
+            unsigned int on = (ccds_present >> ccd) & 1, fuse;
+
+            if (fam == 0x19)
+                on &= !((ccds_disabled >> ccd) & 1);
+            core_disable_map[ccd] = 0xFF;
+            if (on && smu_read_smn_addr(&obj, base | (ccd << 25), &fuse) == SMU_Return_OK)
+                core_disable_map[ccd] = fuse & 0xFF;
+        }
     }
 
     *ccds = count_set_bits(ccds_enabled);
@@ -323,11 +379,60 @@ static int get_topology(unsigned int *ccds, unsigned int *ccxs,
     return get_topology_ex(ccds, ccxs, cores_per_ccx, phys_cores, NULL);
 }
 
+/*
+ * Physical slots (ccd * 8 + core) of the enabled cores, in order: the index
+ * the SMU core masks and the PM per-core arrays use. Logical core i, as the
+ * kernel numbers them, sits in slot[i]. Count, -1 if the fuses can't be read.
+ */
+static int core_slots(int *slot, unsigned int max)
+{
+    unsigned int ccds, ccxs, cpc, phys, map[2];
+    int n = 0;
+
+    if (get_topology_ex(&ccds, &ccxs, &cpc, &phys, map) != 0)
+        return -1;
+    for (unsigned int s = 0; s < 16 && (unsigned int)n < max; s++)
+        if (!((map[s / 8] >> (s % 8)) & 1))
+            slot[n++] = (int)s;
+    return n;
+}
+
+/*
+ * Slots for the cores sysfs reports online, or NULL with a note when the
+ * fuses disagree with it (offlined cores, unreadable fuses); callers then
+ * treat the PM arrays as dense.
+ */
+static const int *online_slots(const char *what, int *slot, unsigned int max, unsigned int online)
+{
+    int n = core_slots(slot, max);
+
+    if (n > 0 && (unsigned int)n == online)
+        return slot;
+    if (n < 0)
+        fprintf(stderr, "%s: core fuses unreadable; assuming no cores are fused off.\n", what);
+    else
+        fprintf(stderr, "%s: core fuses list %d cores but %u are online; "
+                "assuming no cores are fused off.\n", what, n, online);
+    return NULL;
+}
+
+/* Slot map for the PM per-core arrays (see pm_core_slots), NULL if dense. */
+static const int *pm_slots(const char *what, int *slot, unsigned int cores)
+{
+    return cores ? online_slots(what, slot, PM_MAX_CORES, cores) : NULL;
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════ */
 /*  Shared API for GUI (see smu_common.h)                                      */
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
 smu_obj_t *smu_get_obj(void) { return &obj; }
+
+void smu_select_platform(void)
+{
+    g_plat = smu_platform_for(obj.codename);
+}
+
 const char *smu_get_processor_name(void) { return get_processor_name(); }
 void smu_get_cpu_family_model(unsigned int *fam, unsigned int *model) {
     get_cpu_family_model(fam, model);
@@ -338,16 +443,174 @@ int smu_get_topology(unsigned int *ccds, unsigned int *ccxs,
 }
 
 int smu_get_if_version_int(void) { return get_if_version_int(); }
+int smu_get_core_slots(int *slot, unsigned int max) { return core_slots(slot, max); }
+
+void smu_get_tuning_bounds(int *co_min, int *co_max, unsigned int *fmax_max_mhz) {
+    *co_min = g_plat->co_min;
+    *co_max = g_plat->co_max;
+    *fmax_max_mhz = g_plat->fmax_max_mhz;
+}
+
+/* Load a field map and register it for its table version. 0 on success. */
+static int load_pm_map(const char *path)
+{
+    pm_schema_t map;
+    unsigned int version = 0;
+    int rc = pm_schema_load_map(path, &version, &map);
+
+    if (rc < 0) {
+        fprintf(stderr, "  Cannot open field map %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (rc > 0) {
+        fprintf(stderr, "  Field map %s: bad entry on line %d\n", path, rc);
+        return -1;
+    }
+    if (version == 0)
+        version = obj.pm_table_version;
+    if (version != obj.pm_table_version)
+        fprintf(stderr, "  Field map %s is for PM table 0x%06X (running 0x%06X)\n",
+                path, version, obj.pm_table_version);
+    return pm_schema_register(version, &map);
+}
+
+const pm_schema_t *smu_pm_schema(void)
+{
+    static int env_map_done, cached;
+    static unsigned int cached_gen, cached_version, cached_size;
+    static const pm_schema_t *sch;
+
+    if (!smu_pm_tables_supported(&obj))
+        return NULL;
+    if (!env_map_done) {
+        const char *path = getenv("SMU_PM_MAP");
+        env_map_done = 1;
+        if (path && path[0])
+            load_pm_map(path);
+    }
+    /* Sampling loops call this per snapshot; look up again only when a map
+     * was registered or the table changed */
+    if (!cached || cached_gen != pm_schema_generation() ||
+        cached_version != obj.pm_table_version || cached_size != obj.pm_table_size) {
+        sch = pm_schema_lookup(obj.pm_table_version, obj.pm_table_size);
+        cached_gen = pm_schema_generation();
+        cached_version = obj.pm_table_version;
+        cached_size = obj.pm_table_size;
+        cached = 1;
+    }
+    return sch;
+}
+
+int smu_pm_field_index(const char *name, unsigned int *index_out)
+{
+    return pm_schema_resolve(smu_pm_schema(), name, index_out);
+}
+
+/* Built-in derived metrics (formerly hard-coded in the PM summary). Ones
+ * whose fields the active layout lacks are skipped. */
+static const char *const builtin_metrics[] = {
+    "pkg_sleep = PC6 / 100",
+    "avg_core_voltage = (CPU_TELEMETRY_VOLTAGE - 0.2 * pkg_sleep) / (1 - pkg_sleep)",
+    "core_volt = (1 - CORE_CC6 / 100) * avg_core_voltage + 0.2 * CORE_CC6 / 100",
+    "core_volt_avg = sum(CORE_FREQ != 0 ? core_volt : 0) / ncores",
+    "core_usage = sum(CORE_C0) / ncores",
+    "edc_scaled = max(EDC_VALUE * core_usage / 100, TDC_VALUE)",
+    "core_c6_avg = sum(CORE_CC6) / ncores",
+    "peak_core_freq = max(CORE_FREQEFF)",
+};
+
+#define MAX_METRIC_DEFS 64
+
+static const char *g_metric_defs[MAX_METRIC_DEFS];     /* --metric */
+static unsigned int g_metric_def_count;
+static const char *g_metric_file;                      /* --metrics, SMU_METRICS */
+static pm_expr_set_t *g_metrics;
+static unsigned int g_metrics_builtin;
+
+/*
+ * Fresh metric set for the active layout: built-ins, then the metrics file,
+ * then --metric flags. Works without a named layout too (pm[k] only).
+ */
+static pm_expr_set_t *metrics_build(int quiet)
+{
+    const pm_schema_t *sch = smu_pm_schema();
+    unsigned int ccds, ccxs, cpc, cores = 1;
+    pm_expr_set_t *mx;
+    char err[160];
+
+    if (get_topology(&ccds, &ccxs, &cpc, &cores) != 0 || cores == 0)
+        cores = 1;
+    if (pm_has(sch, PMF_CORE_FREQEFF) && pm_count(sch, PMF_CORE_FREQEFF) < cores)
+        cores = pm_count(sch, PMF_CORE_FREQEFF);
+
+    mx = pm_expr_new(sch, obj.pm_table_size, cores);
+    if (!mx)
+        return NULL;
+
+    for (size_t i = 0; i < sizeof(builtin_metrics) / sizeof(builtin_metrics[0]); i++)
+        pm_expr_add(mx, builtin_metrics[i], err, sizeof(err));
+    g_metrics_builtin = pm_expr_count(mx);
+
+    if (!g_metric_file)
+        g_metric_file = getenv("SMU_METRICS");
+    if (g_metric_file && g_metric_file[0] &&
+        pm_expr_load_file(mx, g_metric_file, err, sizeof(err)) != 0 && !quiet)
+        fprintf(stderr, "  Metrics: %s\n", err);
+    for (unsigned int i = 0; i < g_metric_def_count; i++) {
+        if (pm_expr_add(mx, g_metric_defs[i], err, sizeof(err)) != 0 && !quiet)
+            fprintf(stderr, "  Metric '%s': %s\n", g_metric_defs[i], err);
+    }
+    return mx;
+}
+
+/* Shared metrics for the active layout; rebuilt when the layout changes. */
+pm_expr_set_t *smu_metrics(void)
+{
+    static const pm_schema_t *built_for;
+    static unsigned int built_gen = ~0u;
+    const pm_schema_t *sch = smu_pm_schema();
+
+    if (!smu_pm_tables_supported(&obj))
+        return NULL;
+    if (g_metrics && sch == built_for && pm_schema_generation() == built_gen)
+        return g_metrics;
+
+    pm_expr_free(g_metrics);
+    built_for = sch;
+    built_gen = pm_schema_generation();
+    g_metrics = metrics_build(0);
+    return g_metrics;
+}
+
+/* One line per metric; per-core metrics list every core. */
+static void print_metrics(FILE *out, const pm_expr_set_t *mx, unsigned int first, const char *indent)
+{
+    for (unsigned int m = first; m < pm_expr_count(mx); m++) {
+        const float *v = pm_expr_values(mx, m);
+        fprintf(out, "%s%-22s", indent, pm_expr_name(mx, m));
+        for (unsigned int j = 0; j < pm_expr_width(mx, m); j++)
+            fprintf(out, " %10.4f", v[j]);
+        fputc('\n', out);
+    }
+}
+
+/* Slot of core index i among the enabled cores (see core_slots); cached. */
+static int core_index_slot(int core_index)
+{
+    static int slot[PBO_MAX_CORES], n = -2;
+
+    if (n == -2)
+        n = core_slots(slot, PBO_MAX_CORES);
+    return core_index >= 0 && core_index < n ? slot[core_index] : core_index;
+}
 
 static unsigned int smu_encode_core_mask(int core_index) {
-    /* APU: simple core index; Desktop: (ccd << 8 | local_core) << 20 */
-    if (obj.codename == CODENAME_RENOIR || obj.codename == CODENAME_CEZANNE ||
-        obj.codename == CODENAME_REMBRANDT || obj.codename == CODENAME_PHOENIX ||
-        obj.codename == CODENAME_RAVENRIDGE || obj.codename == CODENAME_PICASSO ||
-        obj.codename == CODENAME_LUCIENNE || obj.codename == CODENAME_DALI)
-        return (unsigned int)core_index;
-    int ccd = core_index / 8;
-    int local = core_index % 8;
+    /* APU: simple core index; Desktop: (ccd << 8 | local_core) << 20, by slot */
+    int s = core_index_slot(core_index);
+    if (g_plat->core_mask == SMU_CORE_MASK_INDEX)
+        return (unsigned int)s;
+    int ccd = s / 8;
+    int local = s % 8;
     return (unsigned int)((ccd << 8 | local) << 20);
 }
 
@@ -360,95 +623,38 @@ int smu_get_fmax(unsigned int *mhz_out) {
     return 0;
 }
 
-/* True if this codename uses Zen4/Zen5 boost-limit command 0x70 for FMax set (Raphael, Granite Ridge, etc.). */
-static int use_zen45_fmax_set(void) {
-    switch (obj.codename) {
-    case CODENAME_RAPHAEL:
-    case CODENAME_GRANITERIDGE:
-    case CODENAME_STORMPEAK:
-    case CODENAME_STRIXPOINT:
-    case CODENAME_STRIXHALO:
-    case CODENAME_HAWKPOINT:
-    case CODENAME_REMBRANDT:
-        return 1;
-    default:
-        return 0;
-    }
-}
-
 int smu_set_fmax(unsigned int mhz) {
     smu_arg_t args;
     /* ZenStates SetFMax = SetBoostLimitAllCore: 0x70 on Zen4/Zen5, 0x5C on Zen2/Zen3. */
-    unsigned int cmd = use_zen45_fmax_set() ? SMU_CMD_SET_BOOST_LIMIT_ALL : SMU_CMD_SET_FMAX_ALL_CORES;
     memset(&args, 0, sizeof(args));
     args.args[0] = mhz & 0xFFFFFu;  /* 20-bit (ZenStates: frequency & 0xfffff) */
-    return smu_send_command(&obj, cmd, &args, SMU_TYPE_RSMU) == SMU_Return_OK ? 0 : -1;
-}
-
-/* True if this codename uses Zen4/Zen5 PSM format: SET 0x6 with single combined arg. */
-static int use_zen45_psm_set(void) {
-    switch (obj.codename) {
-    case CODENAME_RAPHAEL:
-    case CODENAME_GRANITERIDGE:
-    case CODENAME_STORMPEAK:
-    case CODENAME_STRIXPOINT:
-    case CODENAME_STRIXHALO:
-    case CODENAME_HAWKPOINT:
-    case CODENAME_REMBRANDT:
-        return 1;
-    default:
-        return 0;
-    }
+    return smu_send_command(&obj, g_plat->fmax_set, &args, SMU_TYPE_RSMU) == SMU_Return_OK ? 0 : -1;
 }
 
 int smu_set_curve_optimizer(int core_index, int margin) {
     smu_arg_t args;
     unsigned int mask = smu_encode_core_mask(core_index);
+    if (!g_plat->psm_set || margin < g_plat->co_min || margin > g_plat->co_max)
+        return -1;              /* no Curve Optimizer (Zen/Zen+), or out of range */
     memset(&args, 0, sizeof(args));
-    if (use_zen45_psm_set()) {
+    if (g_plat->psm_combined) {
         /* Zen4/Zen5: single arg (coreMask & 0xfff00000) | margin (low 16 bits, signed). */
         args.args[0] = (mask & 0xfff00000u) | ((unsigned int)(int16_t)margin & 0xFFFFu);
-        return smu_send_command(&obj, PSM_SET_ZEN4_ZEN5, &args, SMU_TYPE_RSMU) == SMU_Return_OK ? 0 : -1;
-    }
-    args.args[0] = mask;
-    args.args[1] = (unsigned int)(int)margin;
-    return smu_send_command(&obj, SMU_CMD_SET_PSM_MARGIN, &args, SMU_TYPE_RSMU) == SMU_Return_OK ? 0 : -1;
-}
-
-/* Return preferred RSMU GetDldoPsmMargin command ID for current codename (ZenStates-Core mapping). 0 = use fallback list. */
-static unsigned int get_psm_get_cmd_for_codename(void) {
-    switch (obj.codename) {
-    case CODENAME_CASTLEPEAK:
-    case CODENAME_MATISSE:
-    case CODENAME_VERMEER:
-    case CODENAME_MILAN:
-    case CODENAME_CHAGALL:
-        return PSM_GET_ZEN3;      /* 0x7C */
-    case CODENAME_RAPHAEL:
-    case CODENAME_GRANITERIDGE:
-    case CODENAME_STORMPEAK:
-    case CODENAME_STRIXPOINT:
-    case CODENAME_STRIXHALO:
-    case CODENAME_HAWKPOINT:
-    case CODENAME_REMBRANDT:
-        return PSM_GET_ZEN4_ZEN5; /* 0xD5 */
-    case CODENAME_PHOENIX:
-        return PSM_GET_PHOENIX;   /* 0xE1 */
-    case CODENAME_CEZANNE:
-        return PSM_GET_CEZANNE;   /* 0xC3 */
-    default:
-        return 0;
+    } else {
+        args.args[0] = mask;
+        args.args[1] = (unsigned int)(int)margin;
     }
+    return smu_send_command(&obj, g_plat->psm_set, &args, SMU_TYPE_RSMU) == SMU_Return_OK ? 0 : -1;
 }
 
-/* Try one GET PSM command. Returns: 1 = OK + non-zero margin, 0 = OK + zero, -1 = failed. */
-/* Try one GET PSM command. Returns: 1 = OK + non-zero margin, 0 = OK + zero, -1 = failed/OOB. */
+/* Try one GET PSM command. Returns: 1 = OK + non-zero margin, 0 = OK + zero, -1 = out of
+ * range, -2 = the command failed. */
 static int try_get_psm(unsigned int cmd, unsigned int arg0, int *margin_out) {
     smu_arg_t args;
     memset(&args, 0, sizeof(args));
     args.args[0] = arg0;
     if (smu_send_command(&obj, cmd, &args, SMU_TYPE_RSMU) != SMU_Return_OK)
-        return -1;
+        return -2;
     /* ZenStates reads margin from args[0] as signed int32 (Cpu.cs: (int)result.args[0]). */
     int val = (int)args.args[0];
     if (val >= CO_MARGIN_MIN && val <= CO_MARGIN_MAX) {
@@ -464,38 +670,160 @@ static int try_get_psm(unsigned int cmd, unsigned int arg0, int *margin_out) {
     return -1;
 }
 
+/*
+ * CO GET discovery. A margin of 0 is what a wrong command often returns too,
+ * so only a non-zero margin identifies the working (command, arg0 format).
+ * Until one is seen every read probes the candidates; after that a read is
+ * one transaction. The result is kept per codename and SMU FW version in
+ * SMU_CACHE_DIR/co_get.cache.
+ */
+static struct {
+    int          loaded;        /* disk cache consulted */
+    unsigned int cmd;           /* 0 = not discovered */
+    int          variant;       /* arg0: 0 = encoded core mask, 1 = core index */
+    unsigned int dead;          /* bit per candidate * 2 + variant whose command failed */
+} g_co_get;
+
+/*
+ * Path of a cache file; NULL if the directory cannot be created or is not
+ * safe to trust. Cached commands are sent to the SMU, so as root the
+ * environment is ignored and the directory must be a real directory owned by
+ * us and writable by no one else.
+ */
+static const char *smu_cache_path(const char *name, char *buf, size_t len)
+{
+    const char *dir = geteuid() != 0 ? getenv("SMU_CACHE_DIR") : NULL;
+    struct stat st;
+
+    if (!dir || !dir[0])
+        dir = SMU_CACHE_DIR;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+        return NULL;
+    if (lstat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid() ||
+        (st.st_mode & (S_IWGRP | S_IWOTH)))
+        return NULL;
+    snprintf(buf, len, "%s/%s", dir, name);
+    return buf;
+}
+
+/* New temp file next to path, for a rename over it; NULL on failure. */
+static FILE *smu_cache_tmp(const char *path, char *tmp, size_t len)
+{
+    FILE *fp;
+    int fd;
+
+    snprintf(tmp, len, "%s.XXXXXX", path);
+    fd = mkstemp(tmp);
+    if (fd < 0)
+        return NULL;
+    if (fchmod(fd, 0644) != 0 || !(fp = fdopen(fd, "w"))) {
+        close(fd);
+        unlink(tmp);
+        return NULL;
+    }
+    return fp;
+}
+
+static void co_get_cache_load(void)
+{
+    char path[512], line[128];
+    FILE *fp;
+
+    g_co_get.loaded = 1;
+    if (!smu_cache_path(CO_GET_CACHE_FILE, path, sizeof(path)) || !(fp = fopen(path, "r")))
+        return;
+    while (fgets(line, sizeof(line), fp)) {
+        char name[32];
+        unsigned int fw, cmd;
+        int variant;
+
+        if (sscanf(line, "%31s %x %x %d", name, &fw, &cmd, &variant) == 4 &&
+            strcmp(name, smu_codename_to_str(&obj)) == 0 && fw == obj.smu_version &&
+            cmd != 0 && (variant == 0 || variant == 1)) {
+            g_co_get.cmd = cmd;
+            g_co_get.variant = variant;
+        }
+    }
+    fclose(fp);
+}
+
+/* Rewrite the cache with this CPU's entry replaced. Best effort. */
+static void co_get_cache_save(void)
+{
+    char path[512], tmp[520], line[128];
+    const char *name = smu_codename_to_str(&obj);
+    FILE *in, *out;
+
+    if (!smu_cache_path(CO_GET_CACHE_FILE, path, sizeof(path)))
+        return;
+    if (!(out = smu_cache_tmp(path, tmp, sizeof(tmp))))
+        return;
+    fprintf(out, "# codename smu_version cmd arg0_format (0 core mask, 1 core index)\n");
+    if ((in = fopen(path, "r"))) {
+        while (fgets(line, sizeof(line), in)) {
+            char n[32];
+            unsigned int fw;
+
+            if (line[0] == '#' ||
+                (sscanf(line, "%31s %x", n, &fw) == 2 && strcmp(n, name) == 0 &&
+                 fw == obj.smu_version))
+                continue;
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+    fprintf(out, "%s 0x%08X 0x%02X %d\n", name, obj.smu_version, g_co_get.cmd, g_co_get.variant);
+    if (fclose(out) != 0 || rename(tmp, path) != 0)
+        unlink(tmp);
+}
+
 int smu_get_curve_optimizer(int core_index, int *margin_out) {
     unsigned int mask = smu_encode_core_mask(core_index);
-    unsigned int preferred = get_psm_get_cmd_for_codename();
+    unsigned int preferred = g_plat->psm_get;
+
+    if (!g_plat->psm_set)
+        return -1;              /* nothing to read; do not probe unknown commands */
 
     /* Arg0 variants: encoded mask, 0-based core index. */
-    unsigned int arg0_v[2] = { mask, (unsigned int)core_index };
+    unsigned int arg0_v[2] = { mask, (unsigned int)core_index_slot(core_index) };
+    const unsigned int *cmds = preferred ? &preferred : smu_psm_get_probe;
+    unsigned int ncmds = preferred ? 1 : smu_psm_get_probe_count;
     int got_zero = 0;
 
+    if (!g_co_get.loaded)
+        co_get_cache_load();
+    if (g_co_get.cmd) {
+        int rc = try_get_psm(g_co_get.cmd, arg0_v[g_co_get.variant], margin_out);
+        if (rc >= 0)
+            return 0;
+        if (rc == -2)
+            g_co_get.cmd = 0;           /* stale (e.g. new firmware): discover again */
+        else
+            return -1;
+    }
+
     /*
      * When platform is known, ONLY use that command — trying other command IDs
      * can return stale/unrelated OK+0 or garbage that passes range-check,
      * hiding the real value from the correct command on a later arg variant.
+     * Unknown platform: try all known command IDs with both arg formats.
      */
-    if (preferred != 0) {
-        for (int pass = 0; pass < 2; pass++) {
-            int rc = try_get_psm(preferred, arg0_v[pass], margin_out);
-            if (rc > 0) return 0;
-            if (rc == 0) got_zero = 1;
-        }
-        if (got_zero) { *margin_out = 0; return 0; }
-        return -1;
-    }
-
-    /* Unknown platform: try all known command IDs with both arg formats. */
-    static const unsigned int all_cmds[] = {
-        PSM_GET_ZEN4_ZEN5, PSM_GET_ZEN3, PSM_GET_ZEN5_SP,
-        PSM_GET_PHOENIX, PSM_GET_CEZANNE, PSM_GET_LEGACY, PSM_GET_LEGACY_ALT
-    };
     for (int pass = 0; pass < 2; pass++) {
-        for (size_t i = 0; i < sizeof(all_cmds) / sizeof(all_cmds[0]); i++) {
-            int rc = try_get_psm(all_cmds[i], arg0_v[pass], margin_out);
-            if (rc > 0) return 0;
+        for (unsigned int i = 0; i < ncmds; i++) {
+            unsigned int bit = 1u << (i * 2 + (unsigned)pass);
+            int rc;
+
+            if (g_co_get.dead & bit)
+                continue;
+            rc = try_get_psm(cmds[i], arg0_v[pass], margin_out);
+            if (rc == -2)
+                g_co_get.dead |= bit;
+            if (rc > 0) {
+                g_co_get.cmd = cmds[i];
+                g_co_get.variant = pass;
+                co_get_cache_save();
+                return 0;
+            }
             if (rc == 0) got_zero = 1;
         }
     }
@@ -503,26 +831,193 @@ int smu_get_curve_optimizer(int core_index, int *margin_out) {
     return -1;
 }
 
+/* PM field that reports the limit in force (-1: scalar, read by command). */
+static int pbo_limit_pm_field(pbo_limit_id l) {
+    switch (l) {
+    case PBO_LIM_PPT: return PMF_PPT_LIMIT;
+    case PBO_LIM_TDC: return PMF_TDC_LIMIT;
+    case PBO_LIM_EDC: return PMF_EDC_LIMIT;
+    case PBO_LIM_THM: return PMF_THM_LIMIT;
+    default:          return -1;
+    }
+}
+
+/* Limit as the PM table reports it now, or NAN. */
+static float pbo_limit_from_pm(pbo_limit_id l) {
+    static unsigned char *buf;
+    static size_t buf_size;
+    const pm_schema_t *sch = smu_pm_schema();
+    int f = pbo_limit_pm_field(l);
+
+    if (f < 0 || !pm_has(sch, (pm_field_id)f))
+        return NAN;
+    if (buf_size < obj.pm_table_size) {
+        free(buf);
+        buf = calloc(obj.pm_table_size, 1);
+        buf_size = buf ? obj.pm_table_size : 0;
+        if (!buf)
+            return NAN;
+    }
+    if (smu_read_pm_table(&obj, buf, obj.pm_table_size) != SMU_Return_OK)
+        return NAN;
+    return pm_get(sch, buf, (pm_field_id)f);
+}
+
+int smu_pbo_limit_supported(pbo_limit_id l) {
+    const smu_limit_cmds_t *c = g_plat->limits;
+    const pm_schema_t *sch = smu_pm_schema();
+    int f = pbo_limit_pm_field(l);
+
+    if (!c || (unsigned)l >= PBO_LIM_COUNT || !c->set[l])
+        return 0;
+    return f < 0 ? c->get_scalar != 0 : pm_has(sch, (pm_field_id)f);
+}
+
+int smu_get_pbo_limit(pbo_limit_id l, unsigned int *value_out) {
+    const smu_limit_cmds_t *c = g_plat->limits;
+    float v;
+
+    if (!smu_pbo_limit_supported(l))
+        return -1;
+    if (l == PBO_LIM_SCALAR) {
+        smu_arg_t args;
+        memset(&args, 0, sizeof(args));
+        if (smu_send_command(&obj, c->get_scalar, &args, SMU_TYPE_RSMU) != SMU_Return_OK)
+            return -1;
+        /* ZenStates: the scalar comes back as float bits */
+        memcpy(&v, &args.args[0], sizeof(v));
+    } else {
+        v = pbo_limit_from_pm(l);
+    }
+    if (isnan(v) || v < 0.f || v > 100000.f)
+        return -1;
+    *value_out = (unsigned int)lroundf(v);
+    return 0;
+}
+
+int smu_set_pbo_limit(pbo_limit_id l, unsigned int value) {
+    const smu_limit_cmds_t *c = g_plat->limits;
+    double t0;
+    smu_arg_t args;
+    unsigned int got;
+
+    if (!smu_pbo_limit_supported(l) || value == 0 || value > pbo_limit_max(l))
+        return -1;
+    memset(&args, 0, sizeof(args));
+    args.args[0] = l == PBO_LIM_THM    ? value :
+                   l == PBO_LIM_SCALAR ? value * 100 : value * 1000;
+    if (smu_send_command(&obj, c->set[l], &args, SMU_TYPE_RSMU) != SMU_Return_OK)
+        return -1;
+
+    /* Firmware may clamp to board limits: only the next PM snapshots tell */
+    t0 = now_sec();
+    do {
+        if (smu_get_pbo_limit(l, &got) == 0 && got == value)
+            return 0;
+        usleep(5000);
+    } while ((now_sec() - t0) * 1000.0 < PBO_LIMIT_CONFIRM_MS);
+    return -1;
+}
+
+static int pbo_get_co(void *ctx, int core, int *margin)
+{
+    (void)ctx;
+    return smu_get_curve_optimizer(core, margin);
+}
+
+static int pbo_set_co(void *ctx, int core, int margin)
+{
+    (void)ctx;
+    return smu_set_curve_optimizer(core, margin);
+}
+
+static int pbo_get_fmax(void *ctx, unsigned int *mhz)
+{
+    (void)ctx;
+    return smu_get_fmax(mhz);
+}
+
+static int pbo_set_fmax(void *ctx, unsigned int mhz)
+{
+    (void)ctx;
+    return smu_set_fmax(mhz);
+}
+
+static int pbo_get_limit(void *ctx, pbo_limit_id l, unsigned int *value)
+{
+    (void)ctx;
+    return smu_get_pbo_limit(l, value);
+}
+
+static int pbo_set_limit(void *ctx, pbo_limit_id l, unsigned int value)
+{
+    (void)ctx;
+    return smu_set_pbo_limit(l, value);
+}
+
+const pbo_ops_t *smu_pbo_ops(void)
+{
+    static pbo_ops_t ops = { pbo_get_co, pbo_set_co, pbo_get_fmax, pbo_set_fmax,
+                             NULL, NULL, 0, NULL };
+    unsigned int ccds = 0, ccxs = 0, cpc = 0, phys = 0;
+
+    if (get_topology(&ccds, &ccxs, &cpc, &phys) != 0)
+        phys = 0;
+    ops.ncores = phys < PBO_MAX_CORES ? phys : PBO_MAX_CORES;
+    ops.get_limit = g_plat->limits ? pbo_get_limit : NULL;
+    ops.set_limit = g_plat->limits ? pbo_set_limit : NULL;
+    return &ops;
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════ */
 /*  Raw SMU Command (for mailbox scanning with arbitrary addresses)           */
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
+static int mbox_read_smn(void *ctx, uint32_t addr, uint32_t *val)
+{
+    return smu_read_smn_addr((smu_obj_t *)ctx, addr, val) == SMU_Return_OK ? 0 : -1;
+}
+
+static mbox_waiter_t *mbox_waiter(void)
+{
+    if (!g_mbox.read)
+        mbox_waiter_init(&g_mbox, mbox_read_smn, &obj);
+    return &g_mbox;
+}
+
+/*
+ * Deadline for a batch probe. Until SMU_PROBE_MIN_SAMPLES replies are seen it
+ * is the old fixed 10 ms; after that 8x the p99 reply (and at least twice the
+ * slowest), so non-mailbox addresses stop costing the full 10 ms while a slow
+ * SMU keeps the headroom it showed. Verifying a candidate that already
+ * answered always gets the full 10 ms (see scan_verify_pair).
+ */
+static unsigned int probe_deadline_us(void)
+{
+    const mbox_lat_t *all = &mbox_waiter()->all;
+    double d;
+
+    if (all->n < SMU_PROBE_MIN_SAMPLES)
+        return SMU_PROBE_DEADLINE_US;
+    d = mbox_lat_percentile(all, 0.99) * 8;
+    if (d < all->max_us * 2)
+        d = all->max_us * 2;
+    if (d < SMU_PROBE_MIN_US)
+        d = SMU_PROBE_MIN_US;
+    return d < SMU_PROBE_DEADLINE_US ? (unsigned int)d : SMU_PROBE_DEADLINE_US;
+}
+
 static int raw_smu_cmd(uint32_t msg_addr, uint32_t rsp_addr, uint32_t arg_addr,
                        uint32_t cmd, uint32_t *args, int nargs)
 {
+    mbox_waiter_t *w = mbox_waiter();
     uint32_t val;
-    int attempts;
+    int rc;
 
-    /* Wait for mailbox ready (RSP != 0) */
-    for (attempts = 0; attempts < SMU_SCAN_RETRIES; attempts++) {
-        if (smu_read_smn_addr(&obj, rsp_addr, &val) != SMU_Return_OK)
-            return -1;
-        if (val != 0)
-            break;
-        usleep(100);
-    }
-    if (attempts >= SMU_SCAN_RETRIES)
-        return 0xFB;
+    /* Wait for mailbox ready (RSP != 0); not a completion, so not recorded */
+    rc = mbox_poll(w, rsp_addr, MBOX_UNTIL_NE, 0, SMU_CMD_DEADLINE_US, &val);
+    if (rc != 0)
+        return rc < 0 ? -1 : 0xFB;
 
     /* Clear response register */
     smu_write_smn_addr(&obj, rsp_addr, 0);
@@ -537,15 +1032,9 @@ static int raw_smu_cmd(uint32_t msg_addr, uint32_t rsp_addr, uint32_t arg_addr,
     smu_write_smn_addr(&obj, msg_addr, cmd);
 
     /* Poll for response */
-    for (attempts = 0; attempts < SMU_SCAN_RETRIES; attempts++) {
-        if (smu_read_smn_addr(&obj, rsp_addr, &val) != SMU_Return_OK)
-            return -1;
-        if (val != 0)
-            break;
-        usleep(100);
-    }
-    if (attempts >= SMU_SCAN_RETRIES)
-        return 0xFB;
+    rc = mbox_wait(w, rsp_addr, MBOX_UNTIL_NE, 0, SMU_CMD_DEADLINE_US, &val);
+    if (rc != 0)
+        return rc < 0 ? -1 : 0xFB;
 
     /* Read back args on success */
     if (val == 0x01 && arg_addr != 0xFFFFFFFF && args) {
@@ -577,6 +1066,7 @@ static void show_system_info(void)
     printf("├──────────────────────────────────────────────────────────────────┤\n");
     printf("│ %-22s │ %-39s │\n", "CPU Model",         name);
     printf("│ %-22s │ %-39s │\n", "Codename",          codename);
+    printf("│ %-22s │ %-39s │\n", "Platform",          g_plat->family);
     printf("│ %-22s │ 0x%-37X │\n", "Family",           fam);
     printf("│ %-22s │ 0x%-37X │\n", "Model",            model);
     printf("│ %-22s │ v%-38s │\n", "SMU FW Version",   fw_ver);
@@ -680,6 +1170,49 @@ static void send_smu_command_interactive(void)
     printf("\n");
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Limiter Attribution (monitor, run/bench summaries)                        */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+/* Current primary limiter, what is engaged, and each limiter's % of its cap. */
+static void print_limiter_now(FILE *out, const pm_limiter_t *lc, const pm_limiter_state_t *st)
+{
+    char eng[64];
+
+    pm_limiter_format(st->engaged, eng, sizeof(eng));
+    fprintf(out, " Limiter: %-8s engaged %-16s", pm_limiter_class_name(st->primary), eng);
+    for (int l = 0; l < PM_LIM_COUNT; l++) {
+        if (!(lc->avail & (1u << l)) || isnan(st->pct[l]))
+            continue;
+        if (l == PM_LIM_PROCHOT)
+            fprintf(out, "  %s %s", pm_limit_name((pm_limit_id)l), st->pct[l] > 0 ? "on" : "off");
+        else
+            fprintf(out, "  %s %.0f%%", pm_limit_name((pm_limit_id)l), st->pct[l]);
+    }
+    fprintf(out, "\n   -> %s\n", pm_limiter_hint(st->primary));
+}
+
+/* Share of time each class was the primary limiter, and the advice for the
+ * one that dominated while loaded. */
+static void print_limiter_split(FILE *out, const pm_limiter_acc_t *a, const char *prefix)
+{
+    int top = -1;
+
+    if (a->seconds <= 0)
+        return;
+    fputs(prefix, out);
+    for (int c = 0; c < PM_LIM_CLASSES; c++) {
+        if (a->class_s[c] <= 0)
+            continue;
+        fprintf(out, " %s %.1f%%", pm_limiter_class_name(c), 100.0 * a->class_s[c] / a->seconds);
+        if (c != PM_LIM_IDLE && c != PM_LIM_UNKNOWN && (top < 0 || a->class_s[c] > a->class_s[top]))
+            top = c;
+    }
+    if (top >= 0)
+        fprintf(out, "  (mostly %s)", pm_limiter_hint(top));
+    fputc('\n', out);
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════ */
 /*  [3] PM Table Monitor (live, with max tracking)                            */
 /* ═══════════════════════════════════════════════════════════════════════════ */
@@ -691,6 +1224,15 @@ static void pm_table_monitor(void)
     unsigned int num_entries, page_size, page, total_pages, start_idx;
     unsigned char *pm_buf;
     float *table, *max_values;
+    char (*labels)[24];
+    const pm_schema_t *sch;
+    pm_expr_set_t *mx;
+    pm_limiter_t lim;
+    pm_limiter_state_t lim_now;
+    pm_limiter_acc_t lim_acc;
+    unsigned int ccds = 0, ccxs = 0, cpc = 0, cores = 0;
+    int slots[PM_MAX_CORES];
+    double t_prev = 0;
     int first_read = 1;
     struct termios oldt, newt;
 
@@ -717,15 +1259,26 @@ static void pm_table_monitor(void)
 
     pm_buf = calloc(obj.pm_table_size, 1);
     max_values = calloc(num_entries, sizeof(float));
-    if (!pm_buf || !max_values) {
+    labels = calloc(num_entries, sizeof(*labels));
+    if (!pm_buf || !max_values || !labels) {
         fprintf(stderr, "  Memory allocation failed.\n");
         free(pm_buf);
         free(max_values);
+        free(labels);
         return;
     }
 
-    for (unsigned i = 0; i < num_entries; i++)
+    /* Resolve names and compile metrics once; the draw loop only prints */
+    sch = smu_pm_schema();
+    mx = smu_metrics();
+    for (unsigned i = 0; i < num_entries; i++) {
         max_values[i] = -FLT_MAX;
+        pm_schema_index_label(sch, i, labels[i], sizeof(labels[i]));
+    }
+    if (get_topology(&ccds, &ccxs, &cpc, &cores) != 0)
+        cores = 0;
+    pm_limiter_init(&lim, sch, cores, pm_slots("monitor", slots, cores));
+    memset(&lim_acc, 0, sizeof(lim_acc));
 
     /* Set terminal to raw for single-keypress detection */
     tcgetattr(STDIN_FILENO, &oldt);
@@ -754,6 +1307,12 @@ static void pm_table_monitor(void)
             if (first_read || table[i] > max_values[i])
                 max_values[i] = table[i];
         }
+        if (lim.avail) {
+            double t = now_sec();
+            pm_limiter_classify(&lim, pm_buf, &lim_now);
+            pm_limiter_acc_add(&lim_acc, &lim_now, first_read ? 0 : t - t_prev);
+            t_prev = t;
+        }
         first_read = 0;
 
         /* Clear screen and draw table */
@@ -761,17 +1320,28 @@ static void pm_table_monitor(void)
         fprintf(stdout, "Ryzen SMU Debug - PM Table Monitor  |  "
                 "Page %u/%u  |  PM Version: 0x%06X  |  %u entries  |  [q]uit [n]ext [p]rev [r]eset\n",
                 page + 1, total_pages, obj.pm_table_version, num_entries);
-        fprintf(stdout, "──────┬──────────┬────────────────┬────────────────\n");
-        fprintf(stdout, " Idx  │  Offset  │     Value      │      Max\n");
-        fprintf(stdout, "──────┼──────────┼────────────────┼────────────────\n");
+        fprintf(stdout, "──────┬──────────┬────────────────┬────────────────┬──────────────────────\n");
+        fprintf(stdout, " Idx  │  Offset  │     Value      │      Max       │ Name\n");
+        fprintf(stdout, "──────┼──────────┼────────────────┼────────────────┼──────────────────────\n");
 
         start_idx = page * page_size;
         for (unsigned i = start_idx; i < start_idx + page_size && i < num_entries; i++) {
-            fprintf(stdout, " %04u │ 0x%04X   │ %14.6f │ %14.6f\n",
-                    i, i * 4, table[i], max_values[i]);
+            fprintf(stdout, " %04u │ 0x%04X   │ %14.6f │ %14.6f │ %s\n",
+                    i, i * 4, table[i], max_values[i], labels[i]);
         }
 
-        fprintf(stdout, "──────┴──────────┴────────────────┴────────────────\n");
+        fprintf(stdout, "──────┴──────────┴────────────────┴────────────────┴──────────────────────\n");
+        if (pm_expr_count(mx)) {
+            double t0 = now_sec();
+            pm_expr_eval(mx, pm_buf);
+            fprintf(stdout, " Derived metrics (%u, %.1f us)\n", pm_expr_count(mx),
+                    (now_sec() - t0) * 1e6);
+            print_metrics(stdout, mx, 0, " ");
+        }
+        if (lim.avail) {
+            print_limiter_now(stdout, &lim, &lim_now);
+            print_limiter_split(stdout, &lim_acc, " Since start:");
+        }
         fprintf(stdout, "\033[?25l");
         fflush(stdout);
 
@@ -793,6 +1363,7 @@ static void pm_table_monitor(void)
                 } else if (c == 'r' || c == 'R') {
                     for (unsigned j = 0; j < num_entries; j++)
                         max_values[j] = table[j];
+                    memset(&lim_acc, 0, sizeof(lim_acc));
                     break;
                 }
             }
@@ -808,6 +1379,7 @@ static void pm_table_monitor(void)
 
     free(pm_buf);
     free(max_values);
+    free(labels);
 
     printf("\n  Monitor stopped.\n");
 }
@@ -820,8 +1392,11 @@ static void pm_table_dump(void)
 {
     char buf[256];
     unsigned char *pm_buf;
+    char name[24];
     float *table;
     unsigned int num_entries;
+    const pm_schema_t *sch = smu_pm_schema();
+    pm_expr_set_t *mx = smu_metrics();
     FILE *fp = NULL;
 
     if (!smu_pm_tables_supported(&obj)) {
@@ -857,15 +1432,29 @@ static void pm_table_dump(void)
     }
 
     table = (float *)pm_buf;
+    if (mx)
+        pm_expr_eval(mx, pm_buf);
 
     read_line("  Format: [1] Table  [2] CSV  [3] Raw binary: ", buf, sizeof(buf));
     int fmt = buf[0] ? atoi(buf) : 1;
 
     switch (fmt) {
     case 2: /* CSV */
-        fprintf(out, "Index,Offset,Value\n");
-        for (unsigned i = 0; i < num_entries; i++)
-            fprintf(out, "%u,0x%04X,%.6f\n", i, i * 4, table[i]);
+        fprintf(out, "Index,Offset,Value,Name\n");
+        for (unsigned i = 0; i < num_entries; i++) {
+            pm_schema_index_label(sch, i, name, sizeof(name));
+            fprintf(out, "%u,0x%04X,%.6f,%s\n", i, i * 4, table[i], name);
+        }
+        /* Derived metrics: no index/offset; per-core ones as name[i] */
+        for (unsigned m = 0; m < pm_expr_count(mx); m++) {
+            const float *v = pm_expr_values(mx, m);
+            for (unsigned j = 0; j < pm_expr_width(mx, m); j++) {
+                if (pm_expr_width(mx, m) > 1)
+                    fprintf(out, ",,%.6f,%s[%u]\n", v[j], pm_expr_name(mx, m), j);
+                else
+                    fprintf(out, ",,%.6f,%s\n", v[j], pm_expr_name(mx, m));
+            }
+        }
         break;
     case 3: /* Raw binary */
         if (fp) {
@@ -880,14 +1469,21 @@ static void pm_table_dump(void)
         }
         break;
     default: /* Table */
-        fprintf(out, "\nPM Table Dump - Version 0x%06X - %u entries (%u bytes)\n",
-                obj.pm_table_version, num_entries, obj.pm_table_size);
-        fprintf(out, "──────┬──────────┬────────────────\n");
-        fprintf(out, " Idx  │  Offset  │     Value\n");
-        fprintf(out, "──────┼──────────┼────────────────\n");
-        for (unsigned i = 0; i < num_entries; i++)
-            fprintf(out, " %04u │ 0x%04X   │ %14.6f\n", i, i * 4, table[i]);
-        fprintf(out, "──────┴──────────┴────────────────\n");
+        fprintf(out, "\nPM Table Dump - Version 0x%06X (%s) - %u entries (%u bytes)\n",
+                obj.pm_table_version, sch ? sch->name : "unknown layout",
+                num_entries, obj.pm_table_size);
+        fprintf(out, "──────┬──────────┬────────────────┬──────────────────────\n");
+        fprintf(out, " Idx  │  Offset  │     Value      │ Name\n");
+        fprintf(out, "──────┼──────────┼────────────────┼──────────────────────\n");
+        for (unsigned i = 0; i < num_entries; i++) {
+            pm_schema_index_label(sch, i, name, sizeof(name));
+            fprintf(out, " %04u │ 0x%04X   │ %14.6f │ %s\n", i, i * 4, table[i], name);
+        }
+        fprintf(out, "──────┴──────────┴────────────────┴──────────────────────\n");
+        if (pm_expr_count(mx)) {
+            fprintf(out, "\nDerived metrics\n");
+            print_metrics(out, mx, 0, " ");
+        }
         break;
     }
 
@@ -967,11 +1563,89 @@ static void smn_write_interactive(void)
 /*  [7] SMN Range Scan                                                        */
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
+/*
+ * Read SMN words at base, base + stride, ... (or at addrs[i] when given) under
+ * one lock (smu_read_smn_block). n, or -1 when the driver is not open.
+ */
+static int smn_read_many(uint32_t base, uint32_t stride, const uint32_t *addrs,
+                         unsigned int n, uint32_t *out, unsigned char *ok)
+{
+    return smu_read_smn_block(&obj, base, stride, addrs, n, out, ok) == SMU_Return_Failed
+           ? -1 : (int)n;
+}
+
+static int smn_scan_read(void *ctx, uint32_t addr, unsigned int n, uint32_t *out,
+                         unsigned char *ok)
+{
+    (void)ctx;
+    if (!g_running)
+        return -1;
+    return smn_read_many(addr, 4, NULL, n, out, ok);
+}
+
+/* Header of a bin dump: this CPU, now, and a caller label. */
+static void smn_dump_header(smn_dump_header_t *h, const char *label)
+{
+    memset(h, 0, sizeof(*h));
+    h->smu_version = obj.smu_version;
+    h->codename = (uint32_t)obj.codename;
+    h->time = (int64_t)time(NULL);
+    snprintf(h->label, sizeof(h->label), "%s", label ? label : "");
+}
+
+/*
+ * Scan ranges [i][0]..[i][1] into one output: path (1 MiB buffer) or stdout.
+ * A bin dump gets one header with label; the summary goes to stderr.
+ */
+static int smn_scan_to(const smn_scan_opts_t *o, const uint32_t (*range)[2], unsigned int n,
+                       const char *label, const char *path)
+{
+    static char iobuf[1 << 20];
+    smn_scan_stats_t st, sum;
+    smn_dump_header_t hdr;
+    double t0 = now_sec();
+    FILE *out = path ? fopen(path, o->fmt == SMN_FMT_BIN ? "wb" : "w") : stdout;
+    int rc = 0;
+
+    if (!out) {
+        fprintf(stderr, "  Cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (path)
+        setvbuf(out, iobuf, _IOFBF, sizeof(iobuf));
+    smn_dump_header(&hdr, label);
+    memset(&sum, 0, sizeof(sum));
+    g_running = 1;      /* Ctrl-C stops the scan */
+    for (unsigned int i = 0; i < n && rc == 0; i++) {
+        smn_scan_opts_t r = *o;
+
+        r.start = range[i][0] & ~3u;
+        r.end = range[i][1];
+        r.hdr = i == 0 ? &hdr : NULL;
+        rc = smn_scan(&r, smn_scan_read, NULL, out, &st);
+        sum.words_read += st.words_read;
+        sum.words_live += st.words_live;
+        sum.errors += st.errors;
+        sum.bytes_skipped += st.bytes_skipped;
+        sum.holes += st.holes;
+    }
+    g_running = 1;
+    if (path && fclose(out) != 0)
+        rc = -1;
+    fprintf(stderr, "  %s: %llu words read, %llu live, %llu errors, %u hole(s) "
+            "skipping %llu KiB, %.2f s\n", rc == 0 ? "Scan complete" : "Scan failed",
+            (unsigned long long)sum.words_read, (unsigned long long)sum.words_live,
+            (unsigned long long)sum.errors, sum.holes,
+            (unsigned long long)(sum.bytes_skipped / 1024), now_sec() - t0);
+    return rc;
+}
+
 static void smn_range_scan(void)
 {
     char buf[64];
-    unsigned int start_addr, end_addr, value;
-    FILE *fp = NULL;
+    unsigned int start_addr, end_addr;
+    uint32_t range[1][2];
+    smn_scan_opts_t o = { 0, 0, SMN_SCAN_GRANULE, SMN_FMT_TABLE, NULL };
 
     printf("\n--- SMN Range Scan ---\n");
     read_line("  Start address (hex): ", buf, sizeof(buf));
@@ -990,43 +1664,22 @@ static void smn_range_scan(void)
         fprintf(stderr, "  End address must be greater than start.\n");
         return;
     }
+    range[0][0] = start_addr;
+    range[0][1] = end_addr;
 
-    read_line("  Output file (enter for stdout): ", buf, sizeof(buf));
-    if (buf[0]) {
-        fp = fopen(buf, "w");
-        if (!fp) {
-            perror("  Failed to open file");
-            return;
-        }
+    read_line("  Format [table/csv/bin] (enter for table): ", buf, sizeof(buf));
+    if (buf[0] && smn_fmt_parse(buf, &o.fmt) != 0) {
+        fprintf(stderr, "  Invalid format.\n");
+        return;
     }
 
-    FILE *out = fp ? fp : stdout;
-
-    fprintf(out, "\nSMN Range Scan: 0x%08X - 0x%08X\n", start_addr, end_addr);
-    fprintf(out, "──────────────┬────────────┬────────────────────────────────────\n");
-    fprintf(out, "  Address     │   Value    │   Binary\n");
-    fprintf(out, "──────────────┼────────────┼────────────────────────────────────\n");
-
-    for (unsigned int addr = start_addr; addr <= end_addr; addr += 4) {
-        if (smu_read_smn_addr(&obj, addr, &value) != SMU_Return_OK) {
-            fprintf(out, "  0x%08X  │ READ ERROR │\n", addr);
-            continue;
-        }
-
-        fprintf(out, "  0x%08X  │ 0x%08X │ ", addr, value);
-        for (int i = 31; i >= 0; i--) {
-            fprintf(out, "%d", (value >> i) & 1);
-            if (i % 8 == 0 && i > 0) fprintf(out, " ");
-        }
-        fprintf(out, "\n");
+    read_line("  Output file (enter for stdout): ", buf, sizeof(buf));
+    if (!buf[0] && o.fmt == SMN_FMT_BIN) {
+        fprintf(stderr, "  Binary output needs a file.\n");
+        return;
     }
-
-    fprintf(out, "──────────────┴────────────┴────────────────────────────────────\n");
-
-    if (fp) {
-        fclose(fp);
+    if (smn_scan_to(&o, range, 1, NULL, buf[0] ? buf : NULL) == 0 && buf[0])
         printf("  Scan exported to file.\n");
-    }
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════ */
@@ -1039,50 +1692,146 @@ typedef struct {
     uint32_t rsp;
 } msg_rsp_pair_t;
 
+#define SCAN_BATCH_MAX  16      /* CMD candidates probed together */
+
+typedef struct {
+    unsigned int total, done;   /* CMD candidates over all ranges */
+    int          pairs;
+    double       t0;
+    int          tty;
+} scan_progress_t;
+
+/* Progress line; redrawn in place on a terminal, otherwise only when final. */
+static void scan_progress(const scan_progress_t *pr, int final)
+{
+    double el = now_sec() - pr->t0;
+    double eta = pr->done ? el * (pr->total - pr->done) / pr->done : 0;
+
+    if (!pr->tty && !final)
+        return;
+    printf("%s    [%3u%%] %u/%u candidates, %d pair(s), %.1f s, ETA %.1f s%s",
+           pr->tty ? "\r\033[K" : "", pr->total ? pr->done * 100 / pr->total : 100,
+           pr->done, pr->total, pr->pairs, el, eta, final || !pr->tty ? "\n" : "");
+    fflush(stdout);
+}
+
+/*
+ * Write GetSMUVersion (0x02) to cmd and expect OK at rsp. Only candidates
+ * whose RSP already showed UnknownCmd get here, so the reply is waited for
+ * with the full deadline: a busy SMU must not lose a real mailbox.
+ */
+static int scan_verify_pair(uint32_t cmd, uint32_t rsp)
+{
+    uint32_t val;
+
+    smu_write_smn_addr(&obj, cmd, 0x02);
+    return mbox_wait(mbox_waiter(), rsp, MBOX_UNTIL_NE, 0xFE, SMU_PROBE_DEADLINE_US, &val) == 0 &&
+           val == 0x01;
+}
+
+/*
+ * Phase 1 probes up to SCAN_BATCH_MAX consecutive CMD candidates at once: 0xFF
+ * is written to all of them and their expected RSP registers are polled
+ * together, so a batch costs the slowest reply rather than a sleep per
+ * candidate. A batch never spans rsp_offset, so no candidate is another one's
+ * RSP register. The RSP window is then read in one pass: candidates whose own
+ * RSP answered are verified first, the rest walk the window for any other
+ * UnknownCmd (0xFE), and each candidate stops at its first validated pair.
+ */
 static void scan_smu_range(uint32_t start, uint32_t end, uint32_t step,
-                           uint32_t rsp_offset)
+                           uint32_t rsp_offset, scan_progress_t *pr)
 {
-    uint32_t rsp_val, addr;
+    uint32_t addr, win_base = start + rsp_offset, nwin;
+    uint32_t *win;
     msg_rsp_pair_t pairs[64];
     int pair_count = 0;
 
     printf("  Scanning 0x%08X - 0x%08X (step=%u, offset=0x%X) ...\n",
            start, end, step, rsp_offset);
 
+    nwin = win_base <= end ? (end - win_base) / step + 1 : 0;
+    win = calloc(nwin ? nwin : 1, sizeof(*win));
+    if (!win) {
+        printf("    Out of memory.\n");
+        return;
+    }
+
     /* Phase 1: Discover CMD-RSP pairs */
-    for (addr = start; addr <= end && pair_count < 64; addr += step) {
-        uint32_t reg_val;
-        if (smu_read_smn_addr(&obj, addr, &reg_val) != SMU_Return_OK)
-            continue;
-        if (reg_val == 0xFFFFFFFF)
+    addr = start;
+    while (addr <= end && pair_count < 64) {
+        uint32_t cand[SCAN_BATCH_MAX], rsp[SCAN_BATCH_MAX], vals[SCAN_BATCH_MAX];
+        unsigned char done[SCAN_BATCH_MAX], paired[SCAN_BATCH_MAX] = {0};
+        uint32_t first = addr;
+        unsigned int nb = 0;
+
+        for (; addr <= end && nb < SCAN_BATCH_MAX &&
+               (addr == first || addr - first < rsp_offset); addr += step) {
+            uint32_t reg_val;
+
+            pr->done++;
+            if (smu_read_smn_addr(&obj, addr, &reg_val) != SMU_Return_OK ||
+                reg_val == 0xFFFFFFFF)
+                continue;
+            cand[nb] = addr;
+            rsp[nb] = addr + rsp_offset;
+            nb++;
+        }
+        if (nb == 0) {
+            scan_progress(pr, 0);
             continue;
+        }
 
-        /* Write unknown command 0xFF */
-        smu_write_smn_addr(&obj, addr, 0xFF);
-        usleep(10000);
+        /* Write unknown command 0xFF; wait for UnknownCmd at the expected RSPs */
+        for (unsigned int i = 0; i < nb; i++)
+            smu_write_smn_addr(&obj, cand[i], 0xFF);
+        if (mbox_wait_many(mbox_waiter(), rsp, nb, MBOX_UNTIL_EQ, 0xFE,
+                           probe_deadline_us(), vals, done) < 0)
+            memset(done, 0, sizeof(done));
 
-        uint32_t rsp_addr = addr + rsp_offset;
-        while (rsp_addr <= end) {
-            if (smu_read_smn_addr(&obj, rsp_addr, &rsp_val) != SMU_Return_OK)
-                break;
+        for (uint32_t w = (first + rsp_offset - win_base) / step; w < nwin; w++) {
+            if (smu_read_smn_addr(&obj, win_base + w * step, &win[w]) != SMU_Return_OK)
+                win[w] = 0xFFFFFFFF;
+        }
+        /* A reply that came after the learned deadline still shows in the window */
+        for (unsigned int i = 0; i < nb; i++) {
+            uint32_t w = (rsp[i] - win_base) / step;
 
-            if (rsp_val == 0xFE) {
-                /* Got UnknownCmd - verify with GetSMUVersion (0x02) */
-                smu_write_smn_addr(&obj, addr, 0x02);
-                usleep(10000);
+            if (!done[i] && w < nwin && win[w] == 0xFE)
+                done[i] = 1;
+        }
 
-                if (smu_read_smn_addr(&obj, rsp_addr, &rsp_val) == SMU_Return_OK &&
-                    rsp_val == 0x01) {
-                    pairs[pair_count].msg = addr;
-                    pairs[pair_count].rsp = rsp_addr;
+        /* Got UnknownCmd - verify with GetSMUVersion (0x02); own RSP first */
+        for (int pass = 0; pass < 2; pass++) {
+            for (unsigned int i = 0; i < nb && pair_count < 64; i++) {
+                /* Pass 1 skips the own RSP already tried in pass 0 */
+                uint32_t r = pass && done[i] ? rsp[i] + step : rsp[i];
+
+                if (paired[i] || (pass == 0 && !done[i]))
+                    continue;
+                for (; r <= end; r += step) {
+                    uint32_t w = (r - win_base) / step;
+
+                    if (win[w] != 0xFE || !scan_verify_pair(cand[i], r)) {
+                        if (pass == 0)
+                            break;
+                        continue;
+                    }
+                    win[w] = 0x01;
+                    paired[i] = 1;
+                    pairs[pair_count].msg = cand[i];
+                    pairs[pair_count].rsp = r;
                     pair_count++;
-                    printf("    Found CMD/RSP pair: CMD=0x%08X RSP=0x%08X\n",
-                           addr, rsp_addr);
+                    pr->pairs++;
+                    printf("%s    Found CMD/RSP pair: CMD=0x%08X RSP=0x%08X\n",
+                           pr->tty ? "\r\033[K" : "", cand[i], r);
+                    break;
                 }
             }
-            rsp_addr += step;
         }
+        scan_progress(pr, 0);
     }
+    free(win);
+    scan_progress(pr, 1);
 
     if (pair_count == 0) {
         printf("    No mailbox pairs found in this range.\n");
@@ -1152,61 +1901,206 @@ static void scan_smu_range(uint32_t start, uint32_t end, uint32_t step,
     }
 }
 
-static void smu_mailbox_scan(void)
+/*
+ * Validated mailboxes are kept per codename, CPU family/model and SMU FW
+ * version in SMU_CACHE_DIR/mailbox.cache. Nothing is sent at startup: the
+ * first time option 8 or the JSON report needs them, and only after the same
+ * crash warning as a scan, each is checked with one TestMessage; the scan
+ * only runs again when one fails (or on request).
+ */
+static int g_mailbox_checked;   /* cache validated or scan run this session */
+
+static void mailbox_cache_key(char *name, size_t len, unsigned int *fam, unsigned int *model)
+{
+    snprintf(name, len, "%s", smu_codename_to_str(&obj));
+    get_cpu_family_model(fam, model);
+}
+
+/* TestMessage (0x01): the SMU answers OK with arg0 + 1. */
+static int mailbox_test(const mailbox_match_t *m)
+{
+    uint32_t args[6] = { 0xFAFAFAFA };
+
+    return raw_smu_cmd(m->msg_addr, m->rsp_addr, m->arg_addr, 0x01, args, 6) == 0x01 &&
+           args[0] == 0xFAFAFAFB;
+}
+
+/* CMD, RSP and ARG inside one of the platform's scan ranges: where a scan finds them. */
+static int mailbox_in_scan_ranges(const mailbox_match_t *m)
+{
+    for (unsigned int i = 0; i < g_plat->nscan; i++) {
+        const smu_scan_range_t *r = &g_plat->scan[i];
+
+        if (m->msg_addr >= r->start && m->msg_addr <= r->end &&
+            m->rsp_addr >= r->start && m->rsp_addr <= r->end &&
+            m->arg_addr >= r->start && m->arg_addr <= r->end)
+            return 1;
+    }
+    return 0;
+}
+
+/* This CPU's cached mailboxes, without touching the SMU. Count. */
+static int mailbox_cache_read(mailbox_match_t *out, int max)
 {
+    char path[512], line[160], key[32];
     unsigned int fam, model;
+    int n = 0;
+    FILE *fp;
 
-    printf("\n--- SMU Mailbox Scan ---\n");
+    mailbox_cache_key(key, sizeof(key), &fam, &model);
+    if (!smu_cache_path(MAILBOX_CACHE_FILE, path, sizeof(path)) || !(fp = fopen(path, "r")))
+        return 0;
+    while (fgets(line, sizeof(line), fp) && n < max) {
+        char name[32];
+        unsigned int f, m, fw;
+        mailbox_match_t mb;
+
+        if (sscanf(line, "%31s %x %x %x %x %x %x", name, &f, &m, &fw,
+                   &mb.msg_addr, &mb.rsp_addr, &mb.arg_addr) != 7 ||
+            strcmp(name, key) != 0 || f != fam || m != model || fw != obj.smu_version)
+            continue;
+        if (!mailbox_in_scan_ranges(&mb)) {
+            printf("  Cached mailbox CMD=0x%08X is outside this platform's scan ranges; "
+                   "ignored.\n", mb.msg_addr);
+            continue;
+        }
+        out[n++] = mb;
+    }
+    fclose(fp);
+    return n;
+}
+
+/* Validate this CPU's cached mailboxes into g_matches. -1 on a mismatch. */
+static int mailbox_cache_restore(void)
+{
+    mailbox_match_t cached[MAX_MAILBOX_MATCHES];
+    int n = mailbox_cache_read(cached, MAX_MAILBOX_MATCHES), bad = 0;
+
+    g_match_count = 0;
+    g_mailbox_checked = 1;
+    for (int i = 0; i < n; i++) {
+        if (!mailbox_test(&cached[i])) {
+            printf("  Cached mailbox CMD=0x%08X failed TestMessage; rescan needed.\n",
+                   cached[i].msg_addr);
+            bad = 1;
+            continue;
+        }
+        g_matches[g_match_count++] = cached[i];
+    }
+    if (bad) {
+        g_match_count = 0;
+        return -1;
+    }
+    return 0;
+}
+
+/* The crash warning before any mailbox write; 1 if the user agreed. */
+static int mailbox_confirm(void)
+{
     printf("  WARNING: This may crash the system. Continue? [y/N]: ");
     fflush(stdout);
 
     char c = (char)getchar();
-    while (getchar() != '\n');
-    if (c != 'y' && c != 'Y') {
+    if (c != '\n')
+        while (getchar() != '\n');
+    return c == 'y' || c == 'Y';
+}
+
+/* Rewrite the cache with this CPU's entries replaced by g_matches. Best effort. */
+static void mailbox_cache_save(void)
+{
+    char path[512], tmp[520], line[160], key[32];
+    unsigned int fam, model;
+    FILE *in, *out;
+
+    mailbox_cache_key(key, sizeof(key), &fam, &model);
+    if (!smu_cache_path(MAILBOX_CACHE_FILE, path, sizeof(path)))
+        return;
+    if (!(out = smu_cache_tmp(path, tmp, sizeof(tmp))))
+        return;
+    fprintf(out, "# codename family model smu_version cmd rsp arg\n");
+    if ((in = fopen(path, "r"))) {
+        while (fgets(line, sizeof(line), in)) {
+            char n[32];
+            unsigned int f, m, fw;
+
+            if (line[0] == '#' ||
+                (sscanf(line, "%31s %x %x %x", n, &f, &m, &fw) == 4 && strcmp(n, key) == 0 &&
+                 f == fam && m == model && fw == obj.smu_version))
+                continue;
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+    for (int i = 0; i < g_match_count; i++)
+        fprintf(out, "%s 0x%X 0x%X 0x%08X 0x%08X 0x%08X 0x%08X\n", key, fam, model,
+                obj.smu_version, g_matches[i].msg_addr, g_matches[i].rsp_addr,
+                g_matches[i].arg_addr);
+    if (fclose(out) != 0 || rename(tmp, path) != 0)
+        unlink(tmp);
+}
+
+static void smu_mailbox_scan(void)
+{
+    unsigned int fam, model;
+
+    printf("\n--- SMU Mailbox Scan ---\n");
+    if (!mailbox_confirm()) {
         printf("  Aborted.\n");
         return;
     }
+    if (!g_mailbox_checked && mailbox_cache_restore() == 0 && g_match_count > 0)
+        printf("  Restored %d cached SMU mailbox(es).\n", g_match_count);
+    if (g_match_count > 0) {
+        printf("  %d cached mailbox(es), validated:\n", g_match_count);
+        for (int i = 0; i < g_match_count; i++)
+            printf("    CMD: 0x%08X  RSP: 0x%08X  ARG: 0x%08X\n", g_matches[i].msg_addr,
+                   g_matches[i].rsp_addr, g_matches[i].arg_addr);
+        printf("  Rescan anyway? [y/N]: ");
+        fflush(stdout);
+
+        char r = (char)getchar();
+        if (r != '\n')
+            while (getchar() != '\n');
+        if (r != 'y' && r != 'Y')
+            return;
+    }
 
     g_match_count = 0;
+    g_mailbox_checked = 1;
+    mbox_waiter_init(&g_mbox, mbox_read_smn, &obj);
     get_cpu_family_model(&fam, &model);
 
-    /*
-     * Scan ranges from the Windows SMUDebugTool's SettingsForm.cs.
-     * The ranges and offsets are CPU-family/codename dependent.
-     */
-    switch (obj.codename) {
-    case CODENAME_RAVENRIDGE:
-    case CODENAME_RAVENRIDGE2:
-    case CODENAME_PICASSO:
-    case CODENAME_DALI:
-    case CODENAME_RENOIR:
-    case CODENAME_LUCIENNE:
-        scan_smu_range(0x03B10500, 0x03B10998, 8, 0x3C);
-        scan_smu_range(0x03B10A00, 0x03B10AFF, 4, 0x60);
-        break;
-    case CODENAME_PINNACLERIDGE:
-    case CODENAME_SUMMITRIDGE:
-    case CODENAME_MATISSE:
-    case CODENAME_COLFAX:
-    case CODENAME_THREADRIPPER:
-    case CODENAME_CASTLEPEAK:
-    case CODENAME_VERMEER:
-        scan_smu_range(0x03B10500, 0x03B10998, 8, 0x3C);
-        scan_smu_range(0x03B10500, 0x03B10AFF, 4, 0x4C);
-        break;
-    case CODENAME_RAPHAEL:
-    case CODENAME_GRANITERIDGE:
-        scan_smu_range(0x03B10500, 0x03B10998, 8, 0x3C);
-        break;
-    default:
+    if (!g_plat->scan_known) {
         printf("  No scan ranges defined for codename '%s'.\n",
                smu_codename_to_str(&obj));
         printf("  Trying generic ranges...\n");
-        scan_smu_range(0x03B10500, 0x03B10998, 8, 0x3C);
-        break;
     }
+    scan_progress_t pr = { 0, 0, 0, now_sec(), isatty(STDOUT_FILENO) };
+
+    for (unsigned int i = 0; i < g_plat->nscan; i++) {
+        const smu_scan_range_t *r = &g_plat->scan[i];
+        pr.total += (r->end - r->start) / r->step + 1;
+    }
+    for (unsigned int i = 0; i < g_plat->nscan; i++) {
+        const smu_scan_range_t *r = &g_plat->scan[i];
+        scan_smu_range(r->start, r->end, r->step, r->rsp_offset, &pr);
+    }
+
+    printf("\n  Scan complete. Found %d validated mailbox(es).\n", g_match_count);
+    mailbox_cache_save();
+    mbox_lat_print(stdout, &g_mbox.all, "  Completion latency");
+    for (int i = 0; i < g_match_count; i++) {
+        for (unsigned int b = 0; b < g_mbox.nbox; b++) {
+            char label[48];
 
-    printf("\n  Scan complete. Found %d validated mailbox(es).\n\n", g_match_count);
+            if (g_mbox.box[b].rsp_addr != g_matches[i].rsp_addr)
+                continue;
+            snprintf(label, sizeof(label), "    RSP 0x%08X", g_matches[i].rsp_addr);
+            mbox_lat_print(stdout, &g_mbox.box[b], label);
+        }
+    }
+    printf("\n");
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════ */
@@ -1308,6 +2202,18 @@ static void export_json_report(void)
     snprintf(filename, sizeof(filename), "SMUDebug_%ld.json", (long)now);
 
     printf("\n--- Export JSON Report ---\n");
+    if (!g_mailbox_checked) {
+        mailbox_match_t cached[MAX_MAILBOX_MATCHES];
+        int n = mailbox_cache_read(cached, MAX_MAILBOX_MATCHES);
+
+        if (n > 0) {
+            printf("  %d cached mailbox(es) are reported once checked with a TestMessage.\n", n);
+            if (!mailbox_confirm())
+                printf("  Mailboxes left out of the report.\n");
+            else if (mailbox_cache_restore() == 0)
+                printf("  Restored %d cached SMU mailbox(es).\n", g_match_count);
+        }
+    }
     printf("  Saving to: %s\n", filename);
 
     fp = fopen(filename, "w");
@@ -1324,6 +2230,7 @@ static void export_json_report(void)
     fprintf(fp, "  \"Timestamp\": %ld,\n", (long)now);
     fprintf(fp, "  \"CpuName\": \"%s\",\n", get_processor_name());
     fprintf(fp, "  \"Codename\": \"%s\",\n", smu_codename_to_str(&obj));
+    fprintf(fp, "  \"Platform\": \"%s\",\n", g_plat->family);
     fprintf(fp, "  \"Family\": \"0x%02X\",\n", fam);
     fprintf(fp, "  \"Model\": \"0x%02X\",\n", model);
     fprintf(fp, "  \"SmuVersion\": \"v%s\",\n", smu_get_fw_version(&obj));
@@ -1331,6 +2238,8 @@ static void export_json_report(void)
     fprintf(fp, "  \"Mp1IfVersion\": %d,\n", get_if_version_int());
     fprintf(fp, "  \"PmTableVersion\": \"0x%06X\",\n", obj.pm_table_version);
     fprintf(fp, "  \"PmTableSize\": %u,\n", obj.pm_table_size);
+    fprintf(fp, "  \"PmSchema\": %s%s%s,\n", smu_pm_schema() ? "\"" : "",
+            smu_pm_schema() ? smu_pm_schema()->name : "null", smu_pm_schema() ? "\"" : "");
     fprintf(fp, "  \"Topology\": {\n");
     fprintf(fp, "    \"CCDs\": %u,\n", ccds);
     fprintf(fp, "    \"CCXs\": %u,\n", ccxs);
@@ -1355,13 +2264,70 @@ static void export_json_report(void)
         if (pm_buf && smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) == SMU_Return_OK) {
             float *table = (float *)pm_buf;
             unsigned int num_entries = obj.pm_table_size / sizeof(float);
+            const pm_schema_t *sch = smu_pm_schema();
+            char name[24];
 
             fprintf(fp, "  \"PmTable\": [\n");
             for (unsigned i = 0; i < num_entries; i++) {
-                fprintf(fp, "    { \"index\": %u, \"offset\": \"0x%04X\", \"value\": %.6f }%s\n",
-                        i, i * 4, table[i], (i < num_entries - 1) ? "," : "");
+                if (pm_schema_index_label(sch, i, name, sizeof(name)))
+                    fprintf(fp, "    { \"index\": %u, \"offset\": \"0x%04X\", \"value\": %.6f, \"name\": \"%s\" }%s\n",
+                            i, i * 4, table[i], name, (i < num_entries - 1) ? "," : "");
+                else
+                    fprintf(fp, "    { \"index\": %u, \"offset\": \"0x%04X\", \"value\": %.6f }%s\n",
+                            i, i * 4, table[i], (i < num_entries - 1) ? "," : "");
+            }
+            fprintf(fp, "  ],\n");
+
+            pm_expr_set_t *mx = smu_metrics();
+            if (mx)
+                pm_expr_eval(mx, pm_buf);
+            fprintf(fp, "  \"Metrics\": {");
+            for (unsigned m = 0; m < pm_expr_count(mx); m++) {
+                const float *v = pm_expr_values(mx, m);
+                fprintf(fp, "%s\n    \"%s\": ", m ? "," : "", pm_expr_name(mx, m));
+                if (pm_expr_width(mx, m) > 1)
+                    fputc('[', fp);
+                for (unsigned j = 0; j < pm_expr_width(mx, m); j++) {
+                    if (isfinite(v[j]))
+                        fprintf(fp, "%s%.6f", j ? ", " : "", v[j]);
+                    else
+                        fprintf(fp, "%snull", j ? ", " : "");
+                }
+                if (pm_expr_width(mx, m) > 1)
+                    fputc(']', fp);
+            }
+            fprintf(fp, "%s},\n", pm_expr_count(mx) ? "\n  " : "");
+
+            unsigned int ccds_l, ccxs_l, cpc_l, cores_l;
+            int slots_l[PM_MAX_CORES];
+            pm_limiter_t lc;
+            pm_limiter_state_t ls;
+            if (get_topology(&ccds_l, &ccxs_l, &cpc_l, &cores_l) != 0)
+                cores_l = 0;
+            pm_limiter_init(&lc, sch, cores_l, pm_slots("report", slots_l, cores_l));
+            pm_limiter_classify(&lc, pm_buf, &ls);
+            fprintf(fp, "  \"Limiter\": ");
+            if (lc.avail) {
+                fprintf(fp, "{\n    \"Primary\": \"%s\",\n    \"Engaged\": [",
+                        pm_limiter_class_name(ls.primary));
+                for (int l = 0, sep = 0; l < PM_LIM_COUNT; l++) {
+                    if (ls.engaged & (1u << l)) {
+                        fprintf(fp, "%s\"%s\"", sep ? ", " : "", pm_limit_name((pm_limit_id)l));
+                        sep = 1;
+                    }
+                }
+                fprintf(fp, "],\n    \"LimitPct\": {");
+                for (int l = 0, sep = 0; l < PM_LIM_COUNT; l++) {
+                    if (!(lc.avail & (1u << l)) || !isfinite(ls.pct[l]))
+                        continue;
+                    fprintf(fp, "%s \"%s\": %.2f", sep ? "," : "", pm_limit_name((pm_limit_id)l),
+                            ls.pct[l]);
+                    sep = 1;
+                }
+                fprintf(fp, " },\n    \"Hint\": \"%s\"\n  }\n", pm_limiter_hint(ls.primary));
+            } else {
+                fprintf(fp, "null\n");
             }
-            fprintf(fp, "  ]\n");
         } else {
             fprintf(fp, "  \"PmTable\": null\n");
         }
@@ -1380,75 +2346,17 @@ static void export_json_report(void)
 /*  [B] PM Table Named Fields (for known versions - from monitor_cpu.c)       */
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
-/* Matisse/CastlePeak PM table version 0x240903 structure */
-typedef struct {
-    float PPT_LIMIT, PPT_VALUE, TDC_LIMIT, TDC_VALUE;
-    float THM_LIMIT, THM_VALUE, FIT_LIMIT, FIT_VALUE;
-    float EDC_LIMIT, EDC_VALUE, VID_LIMIT, VID_VALUE;
-    float PPT_WC, PPT_ACTUAL, TDC_WC, TDC_ACTUAL;
-    float THM_WC, THM_ACTUAL, FIT_WC, FIT_ACTUAL;
-    float EDC_WC, EDC_ACTUAL, VID_WC, VID_ACTUAL;
-    float VDDCR_CPU_POWER, VDDCR_SOC_POWER;
-    float VDDIO_MEM_POWER, VDD18_POWER, ROC_POWER, SOCKET_POWER;
-    float PPT_FREQUENCY, TDC_FREQUENCY, THM_FREQUENCY;
-    float PROCHOT_FREQUENCY, VOLTAGE_FREQUENCY, CCA_FREQUENCY;
-    float FIT_VOLTAGE, FIT_PRE_VOLTAGE, LATCHUP_VOLTAGE;
-    float CPU_SET_VOLTAGE, CPU_TELEMETRY_VOLTAGE;
-    float CPU_TELEMETRY_CURRENT, CPU_TELEMETRY_POWER, CPU_TELEMETRY_POWER_ALT;
-    float SOC_SET_VOLTAGE, SOC_TELEMETRY_VOLTAGE;
-    float SOC_TELEMETRY_CURRENT, SOC_TELEMETRY_POWER;
-    float FCLK_FREQ, FCLK_FREQ_EFF, UCLK_FREQ, MEMCLK_FREQ;
-    float FCLK_DRAM_SETPOINT, FCLK_DRAM_BUSY;
-    float FCLK_GMI_SETPOINT, FCLK_GMI_BUSY;
-    float FCLK_IOHC_SETPOINT, FCLK_IOHC_BUSY;
-    float FCLK_XGMI_SETPOINT, FCLK_XGMI_BUSY;
-    float CCM_READS, CCM_WRITES, IOMS, XGMI;
-    float CS_UMC_READS, CS_UMC_WRITES;
-    float FCLK_RESIDENCY[4], FCLK_FREQ_TABLE[4];
-    float UCLK_FREQ_TABLE[4], MEMCLK_FREQ_TABLE[4], FCLK_VOLTAGE[4];
-    float LCLK_SETPOINT_0, LCLK_BUSY_0, LCLK_FREQ_0, LCLK_FREQ_EFF_0;
-    float LCLK_MAX_DPM_0, LCLK_MIN_DPM_0;
-    float LCLK_SETPOINT_1, LCLK_BUSY_1, LCLK_FREQ_1, LCLK_FREQ_EFF_1;
-    float LCLK_MAX_DPM_1, LCLK_MIN_DPM_1;
-    float LCLK_SETPOINT_2, LCLK_BUSY_2, LCLK_FREQ_2, LCLK_FREQ_EFF_2;
-    float LCLK_MAX_DPM_2, LCLK_MIN_DPM_2;
-    float LCLK_SETPOINT_3, LCLK_BUSY_3, LCLK_FREQ_3, LCLK_FREQ_EFF_3;
-    float LCLK_MAX_DPM_3, LCLK_MIN_DPM_3;
-    float XGMI_SETPOINT, XGMI_BUSY, XGMI_LANE_WIDTH, XGMI_DATA_RATE;
-    float SOC_POWER, SOC_TEMP;
-    float DDR_VDDP_POWER, DDR_VDDIO_MEM_POWER;
-    float GMI2_VDDG_POWER, IO_VDDCR_SOC_POWER;
-    float IOD_VDDIO_MEM_POWER, IO_VDD18_POWER;
-    float TDP, DETERMINISM, V_VDDM, V_VDDP, V_VDDG;
-    float PEAK_TEMP, PEAK_VOLTAGE, AVG_CORE_COUNT, CCLK_LIMIT;
-    float MAX_VOLTAGE, DC_BTC, CSTATE_BOOST, PROCHOT, PC6, PWM;
-    float SOCCLK, SHUBCLK, MP0CLK, MP1CLK, MP5CLK;
-    float SMNCLK, TWIXCLK, WAFLCLK, DPM_BUSY, MP1_BUSY;
-    float CORE_POWER[8], CORE_VOLTAGE[8], CORE_TEMP[8], CORE_FIT[8];
-    float CORE_IDDMAX[8], CORE_FREQ[8], CORE_FREQEFF[8];
-    float CORE_C0[8], CORE_CC1[8], CORE_CC6[8];
-    float CORE_CKS_FDD[8], CORE_CI_FDD[8], CORE_IRM[8], CORE_PSTATE[8];
-    float CORE_CPPC_MAX[8], CORE_CPPC_MIN[8];
-    float CORE_SC_LIMIT[8], CORE_SC_CAC[8], CORE_SC_RESIDENCY[8];
-    float L3_LOGIC_POWER[2], L3_VDDM_POWER[2], L3_TEMP[2], L3_FIT[2];
-    float L3_IDDMAX[2], L3_FREQ[2], L3_CKS_FDD[2];
-    float L3_CCA_THRESHOLD[2], L3_CCA_CAC[2], L3_CCA_ACTIVATION[2];
-    float L3_EDC_LIMIT[2], L3_EDC_CAC[2], L3_EDC_RESIDENCY[2];
-    float MP5_BUSY[1];
-} pm_table_matisse_t;
-
 static void show_named_pm_summary(void)
 {
     unsigned char *pm_buf;
-    unsigned int ccds = 0, ccxs = 0, cores_per_ccx = 0, phys_cores = 0;
+    const pm_schema_t *sch = smu_pm_schema();
 
     if (!smu_pm_tables_supported(&obj)) {
         fprintf(stderr, "  PM Tables not supported on this platform.\n");
         return;
     }
 
-    /* Currently only Matisse 0x240903 has a named struct */
-    if (obj.pm_table_version != 0x240903) {
+    if (!sch) {
         printf("\n  Named PM table fields not available for version 0x%06X.\n",
                obj.pm_table_version);
         printf("  Use the PM Table Dump/Monitor for raw index+offset view.\n\n");
@@ -1467,194 +2375,3544 @@ static void show_named_pm_summary(void)
         return;
     }
 
-    pm_table_matisse_t *pmt = (pm_table_matisse_t *)pm_buf;
-    get_topology(&ccds, &ccxs, &cores_per_ccx, &phys_cores);
+#define HAS(id)     pm_has(sch, PMF_##id)
+#define F(id)       pm_get(sch, pm_buf, PMF_##id)
+#define FA(id, i)   pm_get_at(sch, pm_buf, PMF_##id, (i))
 
-    float total_usage = 0, total_c6 = 0, peak_freq = 0;
-    float total_core_voltage = 0;
-    float package_sleep_time = pmt->PC6 / 100.f;
-    float avg_voltage = (pmt->CPU_TELEMETRY_VOLTAGE - (0.2f * package_sleep_time)) /
-                        (1.0f - package_sleep_time);
+    pm_expr_set_t *mx = smu_metrics();
+    int m_core_v = pm_expr_find(mx, "core_volt");
+    unsigned int ncores = m_core_v >= 0 ? pm_expr_width(mx, (unsigned)m_core_v) : 0;
+    int have_cores = ncores > 0 && HAS(CORE_C0) && HAS(CORE_CC1) && HAS(CORE_POWER) &&
+                     HAS(CORE_TEMP) && pm_expr_find(mx, "peak_core_freq") >= 0;
 
-    printf("\n");
+    if (mx)
+        pm_expr_eval(mx, pm_buf);
+
+    printf("\n  PM table 0x%06X (%s layout)\n", obj.pm_table_version, sch->name);
+    if (!have_cores)
+        printf("  No per-core fields in this layout (see SMU_PM_MAP); package values only.\n");
     printf("╭────────────────────────────────────────────────┬─────────────────────────────────╮\n");
 
     /* Per-core info */
-    for (unsigned i = 0; i < phys_cores && i < 8; i++) {
-        float core_freq = pmt->CORE_FREQEFF[i] * 1000.f;
-        float core_sleep = pmt->CORE_CC6[i] / 100.f;
-        float core_v = ((1.0f - core_sleep) * avg_voltage) + (0.2f * core_sleep);
-
-        if (core_freq > peak_freq)
-            peak_freq = core_freq;
-        total_usage += pmt->CORE_C0[i];
-        total_c6 += pmt->CORE_CC6[i];
-        if (pmt->CORE_FREQ[i] != 0.f)
-            total_core_voltage += core_v;
-
-        if (pmt->CORE_C0[i] >= 6.f) {
-            printf("│ Core %u: %4.0f MHz │ %5.3f W │ %1.3f V │ %5.1f C │ C0:%5.1f%% C1:%5.1f%% C6:%5.1f%% │\n",
-                   i, core_freq, pmt->CORE_POWER[i], core_v, pmt->CORE_TEMP[i],
-                   pmt->CORE_C0[i], pmt->CORE_CC1[i], pmt->CORE_CC6[i]);
-        } else {
-            printf("│ Core %u: Sleeping │ %5.3f W │ %1.3f V │ %5.1f C │ C0:%5.1f%% C1:%5.1f%% C6:%5.1f%% │\n",
-                   i, pmt->CORE_POWER[i], core_v, pmt->CORE_TEMP[i],
-                   pmt->CORE_C0[i], pmt->CORE_CC1[i], pmt->CORE_CC6[i]);
-        }
-    }
-
-    printf("├────────────────────────────────────────────────┼─────────────────────────────────┤\n");
-
-    float edc_value = pmt->EDC_VALUE * (total_usage / (float)phys_cores / 100.f);
-    if (edc_value < pmt->TDC_VALUE)
-        edc_value = pmt->TDC_VALUE;
-    total_c6 /= (float)phys_cores;
-    float avg_core_v = total_core_voltage / (float)phys_cores;
-
-    printf("│ %-22s │ %8.0f MHz                     │\n", "Peak Core Freq",    peak_freq);
-    printf("│ %-22s │ %8.2f C                       │\n", "Peak Temperature",  pmt->PEAK_TEMP);
-    printf("│ %-22s │ %8.4f W                       │\n", "Package Power",     pmt->SOCKET_POWER);
-    printf("│ %-22s │ %8.6f V                       │\n", "Peak Core(s) Volt", pmt->CPU_TELEMETRY_VOLTAGE);
-    printf("│ %-22s │ %8.6f V                       │\n", "Average Core Volt", avg_core_v);
-    printf("│ %-22s │ %8.6f %%                       │\n", "Package C6",        pmt->PC6);
-    printf("│ %-22s │ %8.6f %%                       │\n", "Core C6 Avg",       total_c6);
-    printf("├────────────────────────────────────────────────┼─────────────────────────────────┤\n");
-    printf("│ %-22s │ %8.2f C                       │\n", "Tjunction Limit",   pmt->THM_LIMIT);
-    printf("│ %-22s │ %8.2f C                       │\n", "Current Temp",      pmt->THM_VALUE);
-    printf("│ %-22s │ %8.2f C                       │\n", "SoC Temperature",   pmt->SOC_TEMP);
-    printf("│ %-22s │ %8.4f W                       │\n", "Core Power",        pmt->VDDCR_CPU_POWER);
-    printf("│ %-22s │ %8.4f W │ %6.4f A │ %6.4f V  │\n", "SoC Power",
-           pmt->SOC_TELEMETRY_POWER, pmt->SOC_TELEMETRY_CURRENT, pmt->SOC_TELEMETRY_VOLTAGE);
-    printf("│ %-22s │ %7.2f W / %5.0f W (%5.1f%%)    │\n", "PPT",
-           pmt->PPT_VALUE, pmt->PPT_LIMIT, pmt->PPT_VALUE / pmt->PPT_LIMIT * 100.f);
-    printf("│ %-22s │ %7.2f A / %5.0f A (%5.1f%%)    │\n", "TDC",
-           pmt->TDC_VALUE, pmt->TDC_LIMIT, pmt->TDC_VALUE / pmt->TDC_LIMIT * 100.f);
-    printf("│ %-22s │ %7.2f A / %5.0f A (%5.1f%%)    │\n", "EDC",
-           edc_value, pmt->EDC_LIMIT, edc_value / pmt->EDC_LIMIT * 100.f);
-    printf("│ %-22s │ %8.0f MHz                     │\n", "Frequency Limit",   pmt->CCLK_LIMIT * 1000.f);
-    printf("├────────────────────────────────────────────────┼─────────────────────────────────┤\n");
-    printf("│ %-22s │ %8s                         │\n", "Coupled Mode",
-           pmt->UCLK_FREQ == pmt->MEMCLK_FREQ ? "ON" : "OFF");
-    printf("│ %-22s │ %5.0f MHz                        │\n", "Fabric Clock (Avg)",pmt->FCLK_FREQ_EFF);
-    printf("│ %-22s │ %5.0f MHz                        │\n", "Fabric Clock",      pmt->FCLK_FREQ);
-    printf("│ %-22s │ %5.0f MHz                        │\n", "Uncore Clock",      pmt->UCLK_FREQ);
-    printf("│ %-22s │ %5.0f MHz                        │\n", "Memory Clock",      pmt->MEMCLK_FREQ);
-    printf("│ %-22s │ %8.3f GiB/s                   │\n", "DRAM Read BW",      pmt->CS_UMC_READS);
-    printf("│ %-22s │ %8.3f GiB/s                   │\n", "DRAM Write BW",     pmt->CS_UMC_WRITES);
-    printf("│ %-22s │ %8.4f V                       │\n", "VDDCR_SoC",         pmt->SOC_SET_VOLTAGE);
-    printf("│ %-22s │ %8.4f V                       │\n", "cLDO_VDDM",         pmt->V_VDDM);
-    printf("│ %-22s │ %8.4f V                       │\n", "cLDO_VDDP",         pmt->V_VDDP);
-    printf("│ %-22s │ %8.4f V                       │\n", "cLDO_VDDG",         pmt->V_VDDG);
+    if (have_cores) {
+        const float *core_volts = pm_expr_values(mx, (unsigned)m_core_v);
+
+        for (unsigned i = 0; i < ncores; i++) {
+            float core_freq = FA(CORE_FREQEFF, i);
+            float core_v = core_volts[i];
+
+            if (FA(CORE_C0, i) >= 6.f) {
+                printf("│ Core %u: %4.0f MHz │ %5.3f W │ %1.3f V │ %5.1f C │ C0:%5.1f%% C1:%5.1f%% C6:%5.1f%% │\n",
+                       i, core_freq, FA(CORE_POWER, i), core_v, FA(CORE_TEMP, i),
+                       FA(CORE_C0, i), FA(CORE_CC1, i), FA(CORE_CC6, i));
+            } else {
+                printf("│ Core %u: Sleeping │ %5.3f W │ %1.3f V │ %5.1f C │ C0:%5.1f%% C1:%5.1f%% C6:%5.1f%% │\n",
+                       i, FA(CORE_POWER, i), core_v, FA(CORE_TEMP, i),
+                       FA(CORE_C0, i), FA(CORE_CC1, i), FA(CORE_CC6, i));
+            }
+        }
+
+        printf("├────────────────────────────────────────────────┼─────────────────────────────────┤\n");
+
+        printf("│ %-22s │ %8.0f MHz                     │\n", "Peak Core Freq",
+               pm_expr_get(mx, "peak_core_freq"));
+        if (HAS(PEAK_TEMP))
+            printf("│ %-22s │ %8.2f C                       │\n", "Peak Temperature",  F(PEAK_TEMP));
+        if (HAS(SOCKET_POWER))
+            printf("│ %-22s │ %8.4f W                       │\n", "Package Power",     F(SOCKET_POWER));
+        printf("│ %-22s │ %8.6f V                       │\n", "Peak Core(s) Volt", F(CPU_TELEMETRY_VOLTAGE));
+        printf("│ %-22s │ %8.6f V                       │\n", "Average Core Volt",
+               pm_expr_get(mx, "core_volt_avg"));
+        printf("│ %-22s │ %8.6f %%                       │\n", "Package C6",        F(PC6));
+        printf("│ %-22s │ %8.6f %%                       │\n", "Core C6 Avg",
+               pm_expr_get(mx, "core_c6_avg"));
+        printf("├────────────────────────────────────────────────┼─────────────────────────────────┤\n");
+    }
+
+    if (HAS(THM_LIMIT))
+        printf("│ %-22s │ %8.2f C                       │\n", "Tjunction Limit",   F(THM_LIMIT));
+    if (HAS(THM_VALUE))
+        printf("│ %-22s │ %8.2f C                       │\n", "Current Temp",      F(THM_VALUE));
+    if (HAS(SOC_TEMP))
+        printf("│ %-22s │ %8.2f C                       │\n", "SoC Temperature",   F(SOC_TEMP));
+    if (!have_cores && HAS(SOCKET_POWER))
+        printf("│ %-22s │ %8.4f W                       │\n", "Package Power",     F(SOCKET_POWER));
+    if (HAS(VDDCR_CPU_POWER))
+        printf("│ %-22s │ %8.4f W                       │\n", "Core Power",        F(VDDCR_CPU_POWER));
+    if (HAS(SOC_TELEMETRY_POWER) && HAS(SOC_TELEMETRY_CURRENT) && HAS(SOC_TELEMETRY_VOLTAGE))
+        printf("│ %-22s │ %8.4f W │ %6.4f A │ %6.4f V  │\n", "SoC Power",
+               F(SOC_TELEMETRY_POWER), F(SOC_TELEMETRY_CURRENT), F(SOC_TELEMETRY_VOLTAGE));
+    if (HAS(STAPM_VALUE) && HAS(STAPM_LIMIT))
+        printf("│ %-22s │ %7.2f W / %5.0f W (%5.1f%%)    │\n", "STAPM",
+               F(STAPM_VALUE), F(STAPM_LIMIT), F(STAPM_VALUE) / F(STAPM_LIMIT) * 100.f);
+    if (HAS(PPT_VALUE_FAST) && HAS(PPT_LIMIT_FAST))
+        printf("│ %-22s │ %7.2f W / %5.0f W (%5.1f%%)    │\n", "PPT Fast",
+               F(PPT_VALUE_FAST), F(PPT_LIMIT_FAST), F(PPT_VALUE_FAST) / F(PPT_LIMIT_FAST) * 100.f);
+    if (HAS(PPT_VALUE) && HAS(PPT_LIMIT))
+        printf("│ %-22s │ %7.2f W / %5.0f W (%5.1f%%)    │\n", HAS(PPT_VALUE_FAST) ? "PPT Slow" : "PPT",
+               F(PPT_VALUE), F(PPT_LIMIT), F(PPT_VALUE) / F(PPT_LIMIT) * 100.f);
+    if (HAS(PPT_VALUE_APU) && HAS(PPT_LIMIT_APU))
+        printf("│ %-22s │ %7.2f W / %5.0f W (%5.1f%%)    │\n", "PPT APU",
+               F(PPT_VALUE_APU), F(PPT_LIMIT_APU), F(PPT_VALUE_APU) / F(PPT_LIMIT_APU) * 100.f);
+    if (HAS(TDC_VALUE) && HAS(TDC_LIMIT))
+        printf("│ %-22s │ %7.2f A / %5.0f A (%5.1f%%)    │\n", "TDC",
+               F(TDC_VALUE), F(TDC_LIMIT), F(TDC_VALUE) / F(TDC_LIMIT) * 100.f);
+    if (HAS(TDC_VALUE_SOC) && HAS(TDC_LIMIT_SOC))
+        printf("│ %-22s │ %7.2f A / %5.0f A (%5.1f%%)    │\n", "TDC SoC",
+               F(TDC_VALUE_SOC), F(TDC_LIMIT_SOC), F(TDC_VALUE_SOC) / F(TDC_LIMIT_SOC) * 100.f);
+    if (HAS(EDC_VALUE) && HAS(EDC_LIMIT)) {
+        /* Desktop EDC is reported at full load; the edc_scaled metric scales it by usage. */
+        float edc_value = pm_expr_find(mx, "edc_scaled") >= 0 ? pm_expr_get(mx, "edc_scaled")
+                                                              : F(EDC_VALUE);
+        printf("│ %-22s │ %7.2f A / %5.0f A (%5.1f%%)    │\n", "EDC",
+               edc_value, F(EDC_LIMIT), edc_value / F(EDC_LIMIT) * 100.f);
+    }
+    if (HAS(EDC_VALUE_SOC) && HAS(EDC_LIMIT_SOC))
+        printf("│ %-22s │ %7.2f A / %5.0f A (%5.1f%%)    │\n", "EDC SoC",
+               F(EDC_VALUE_SOC), F(EDC_LIMIT_SOC), F(EDC_VALUE_SOC) / F(EDC_LIMIT_SOC) * 100.f);
+    if (HAS(CCLK_LIMIT))
+        printf("│ %-22s │ %8.0f MHz                     │\n", "Frequency Limit",   F(CCLK_LIMIT));
+
+    if (HAS(FCLK_FREQ)) {
+        printf("├────────────────────────────────────────────────┼─────────────────────────────────┤\n");
+        printf("│ %-22s │ %8s                         │\n", "Coupled Mode",
+               F(UCLK_FREQ) == F(MEMCLK_FREQ) ? "ON" : "OFF");
+        printf("│ %-22s │ %5.0f MHz                        │\n", "Fabric Clock (Avg)", F(FCLK_FREQ_EFF));
+        printf("│ %-22s │ %5.0f MHz                        │\n", "Fabric Clock",      F(FCLK_FREQ));
+        printf("│ %-22s │ %5.0f MHz                        │\n", "Uncore Clock",      F(UCLK_FREQ));
+        printf("│ %-22s │ %5.0f MHz                        │\n", "Memory Clock",      F(MEMCLK_FREQ));
+    }
+    if (HAS(CS_UMC_READS)) {
+        printf("│ %-22s │ %8.3f GiB/s                   │\n", "DRAM Read BW",      F(CS_UMC_READS));
+        printf("│ %-22s │ %8.3f GiB/s                   │\n", "DRAM Write BW",     F(CS_UMC_WRITES));
+    }
+    if (HAS(SOC_SET_VOLTAGE))
+        printf("│ %-22s │ %8.4f V                       │\n", "VDDCR_SoC",         F(SOC_SET_VOLTAGE));
+    if (HAS(V_VDDM)) {
+        printf("│ %-22s │ %8.4f V                       │\n", "cLDO_VDDM",         F(V_VDDM));
+        printf("│ %-22s │ %8.4f V                       │\n", "cLDO_VDDP",         F(V_VDDP));
+        printf("│ %-22s │ %8.4f V                       │\n", "cLDO_VDDG",         F(V_VDDG));
+    }
     printf("╰────────────────────────────────────────────────┴─────────────────────────────────╯\n\n");
 
+    if (pm_expr_count(mx) > g_metrics_builtin) {
+        printf("  User metrics:\n");
+        print_metrics(stdout, mx, g_metrics_builtin, "    ");
+        printf("\n");
+    }
+
+#undef HAS
+#undef F
+#undef FA
+
     free(pm_buf);
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════ */
-/*  Privilege Elevation                                                       */
+/*  [C] PM Layout Inference (correlate with hwmon/cpufreq/RAPL/proc)          */
 /* ═══════════════════════════════════════════════════════════════════════════ */
 
-/*
- * Query a gsettings key, strip quotes/newline, return pointer to static buf.
- * Returns NULL on failure or empty result.
- */
-static const char *query_gsetting(const char *key, char *buf, size_t bufsz)
+static int infer_read_pm(void *ctx, void *buf, unsigned int size)
 {
-    char cmd[256];
-    char *p;
-    size_t tlen;
-    FILE *fp;
-
-    snprintf(cmd, sizeof(cmd),
-             "gsettings get org.gnome.desktop.interface %s 2>/dev/null", key);
-    fp = popen(cmd, "r");
-    if (!fp)
-        return NULL;
-    if (!fgets(buf, (int)bufsz, fp)) {
-        pclose(fp);
-        return NULL;
-    }
-    pclose(fp);
+    (void)ctx;
+    return smu_read_pm_table(&obj, buf, size) == SMU_Return_OK ? 0 : -1;
+}
 
-    p = buf;
-    if (*p == '\'') p++;
-    tlen = strlen(p);
-    while (tlen > 0 && (p[tlen-1] == '\n' || p[tlen-1] == '\'' || p[tlen-1] == '\r'))
-        p[--tlen] = '\0';
-    return *p ? p : NULL;
+static void infer_progress(void *ctx, const char *phase, unsigned int done, unsigned int total)
+{
+    (void)ctx;
+    printf("\r  [%3u/%3u] %-12s", done, total, phase);
+    fflush(stdout);
 }
 
-int smu_elevate_if_necessary(int argc, char **argv)
+static void pm_layout_inference(void)
 {
-    char self[1024];
-    ssize_t len;
-    pid_t pid;
-    int status;
+    char buf[256];
+    pm_infer_opts_t opts = { 0 };
+    pm_infer_result_t res;
+    pm_schema_t merged;
+    float conf[PMF_COUNT];
+    const pm_schema_t *base;
+    unsigned int found = 0;
+    int rc;
 
-    if (geteuid() == 0)
-        return 1;
+    if (!smu_pm_tables_supported(&obj)) {
+        fprintf(stderr, "  PM Tables not supported on this platform.\n");
+        return;
+    }
 
-    len = readlink("/proc/self/exe", self, sizeof(self) - 1);
-    if (len <= 0) {
-        fprintf(stderr, "This tool must be run as root.\n");
-        return 0;
+    read_line("\n  [1] Run inference  [2] Load field map file: ", buf, sizeof(buf));
+    if (buf[0] == '2') {
+        read_line("  Field map file: ", buf, sizeof(buf));
+        if (buf[0] && load_pm_map(buf) == 0)
+            printf("  Loaded. Named views now use '%s'.\n\n",
+                   smu_pm_schema() ? smu_pm_schema()->name : "?");
+        return;
     }
-    self[len] = '\0';
 
-    /*
-     * Use pkexec for graphical privilege elevation.
-     * pkexec strips the environment, so we pass display variables as
-     * --env-VAR=VALUE arguments.  The binary restores them via
-     * smu_restore_env() before GTK init.
-     *
-     * We use fork/execvp instead of system() to avoid shell injection.
-     */
+    read_line("  Stimulus time per core (ms, default 1500): ", buf, sizeof(buf));
+    opts.phase_ms = buf[0] ? (unsigned)atoi(buf) : 1500;
+    if (opts.phase_ms < 500)
+        opts.phase_ms = 500;
+    read_line("  Cores to stimulate (0=all, default 0): ", buf, sizeof(buf));
+    opts.max_cores = buf[0] ? (unsigned)atoi(buf) : 0;
 
-    /* Query GTK theme from gsettings if not already set */
-    static char theme_buf[256];
-    if (!getenv("GTK_THEME")) {
-        const char *theme = query_gsetting("gtk-theme", theme_buf, sizeof(theme_buf));
-        if (theme)
-            setenv("GTK_THEME", theme, 1);
-    }
+    opts.table_size = obj.pm_table_size;
+    opts.sample_ms = 100;
+    opts.read_pm = infer_read_pm;
+    opts.progress = infer_progress;
+    opts.running = &g_running;
 
-    /* Query dark mode preference */
-    static char scheme_buf[64];
-    if (!getenv("ADW_DEBUG_COLOR_SCHEME")) {
-        const char *scheme = query_gsetting("color-scheme", scheme_buf, sizeof(scheme_buf));
-        if (scheme && strstr(scheme, "prefer-dark"))
-            setenv("ADW_DEBUG_COLOR_SCHEME", "prefer-dark", 1);
+    printf("  Loading one core at a time; keep the system otherwise idle. Ctrl+C aborts.\n");
+    g_running = 1;
+    rc = pm_infer_run(&opts, &res);
+    printf("\n");
+    g_running = 1;
+    if (rc == -2) {
+        printf("  Inference cancelled.\n\n");
+        return;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "  Inference failed (no samples or no CPU topology).\n");
+        return;
     }
 
-    /* Build argv for: pkexec <self> --env-VAR=VALUE ... <original args> */
-    const char *env_vars[] = {
-        "DISPLAY", "WAYLAND_DISPLAY", "XDG_RUNTIME_DIR",
-        "XAUTHORITY", "DBUS_SESSION_BUS_ADDRESS",
-        "GTK_THEME", "ADW_DEBUG_COLOR_SCHEME",
-        "XDG_CONFIG_HOME", "HOME", NULL
-    };
-
-    /* Max args: "pkexec" + self + 9 env vars + (argc-1) original args + NULL */
-    int max_args = 2 + 9 + argc;
-    char **new_argv = calloc((size_t)max_args, sizeof(char *));
-    if (!new_argv) {
-        fprintf(stderr, "Memory allocation failed.\n");
-        return 0;
+    printf("\n  %u samples, %u cores, %u constant floats. Sources:%s%s%s%s\n",
+           res.samples, res.cores, res.constant_indices,
+           (res.sources & PM_INFER_SRC_HWMON) ? " hwmon" : "",
+           (res.sources & PM_INFER_SRC_CPUFREQ) ? " cpufreq" : "",
+           (res.sources & PM_INFER_SRC_RAPL) ? " RAPL" : "",
+           (res.sources & PM_INFER_SRC_PROCSTAT) ? " /proc/stat" : "");
+
+    base = smu_pm_schema();
+    printf("╭──────────────────┬────────┬──────────┬───────┬──────┬──────────────────────────┬───────────╮\n");
+    printf("│ Field            │ Offset │ Count×St │ Scale │ Conf │ Evidence                 │ Known     │\n");
+    printf("├──────────────────┼────────┼──────────┼───────┼──────┼──────────────────────────┼───────────┤\n");
+    for (int f = 0; f < PMF_COUNT; f++) {
+        const pm_field_loc_t *l = &res.schema.loc[f];
+        const char *known = "-";
+
+        if (!l->count)
+            continue;
+        found++;
+        if (pm_has(base, (pm_field_id)f))
+            known = base->loc[f].offset == l->offset &&
+                    (l->count == 1 ? base->loc[f].count == 1
+                                   : base->loc[f].stride == l->stride &&
+                                     l->count <= base->loc[f].count) ? "agrees" : "CONFLICT";
+        printf("│ %-16s │ 0x%04X │ %3u × %-2u │ %5g │ %4.2f │ %-24s │ %-9s │\n",
+               pm_field_name((pm_field_id)f), l->offset, l->count, l->stride, l->scale,
+               res.field[f].confidence, res.field[f].evidence, known);
+    }
+    printf("╰──────────────────┴────────┴──────────┴───────┴──────┴──────────────────────────┴───────────╯\n");
+    if (!found) {
+        printf("  No field reached the confidence threshold.\n\n");
+        return;
     }
 
-    /* Static buffers for --env-VAR=VALUE strings */
-    static char env_bufs[9][512];
+    read_line("  Minimum confidence to keep (default 0.6): ", buf, sizeof(buf));
+    pm_infer_merge(&res, base, buf[0] ? (float)atof(buf) : 0.6f, &merged, conf);
 
-    int n = 0;
-    new_argv[n++] = "pkexec";
-    new_argv[n++] = self;
+    read_line("  Use for this session? [y/N]: ", buf, sizeof(buf));
+    if ((buf[0] == 'y' || buf[0] == 'Y') &&
+        pm_schema_register(obj.pm_table_version, &merged) == 0)
+        printf("  Registered '%s' for PM table 0x%06X.\n", merged.name, obj.pm_table_version);
 
-    for (int e = 0; env_vars[e]; e++) {
-        const char *val = getenv(env_vars[e]);
-        if (val) {
-            snprintf(env_bufs[e], sizeof(env_bufs[e]), "--env-%s=%s", env_vars[e], val);
-            new_argv[n++] = env_bufs[e];
-        }
+    printf("  Save field map (enter to skip, or filename, e.g. pm_map_%06X.txt): ",
+           obj.pm_table_version);
+    read_line("", buf, sizeof(buf));
+    if (buf[0]) {
+        FILE *fp = fopen(buf, "w");
+        if (!fp) {
+            perror("  Failed to open file");
+            return;
+        }
+        if (pm_schema_save_map(fp, obj.pm_table_version, &merged, conf) == 0)
+            printf("  Saved %s (load with SMU_PM_MAP=%s or option C).\n", buf, buf);
+        fclose(fp);
+    }
+    printf("\n");
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  [D] PM Trigger Capture (pre-trigger ring, "oscilloscope mode")            */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+/* One finished capture: a private copy of its window, written off the sampling loop. */
+typedef struct {
+    pm_ring_t          ring;
+    const pm_schema_t *schema;
+    double             t_trig;
+    unsigned int       n;
+    char               prefix[200];
+    char               info[640];
+} capture_job_t;
+
+static void *write_capture(void *p)
+{
+    capture_job_t *j = p;
+    char path[320], stamp[32];
+    time_t now = time(NULL);
+    FILE *fp;
+
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+    snprintf(path, sizeof(path), "%s_%s_%u.csv", j->prefix, stamp, j->n);
+    fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "\n  Cannot write %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    if (pm_capture_write_csv(fp, &j->ring, 0, j->ring.seq, j->t_trig, j->schema, j->info) != 0)
+        fprintf(stderr, "\n  Write error on %s\n", path);
+    fclose(fp);
+    printf("\r\033[K  Capture %u: %llu samples -> %s\n", j->n, j->ring.seq, path);
+    return NULL;
+}
+
+/*
+ * Copy [from, to) out of the live ring and write it on a helper thread, so
+ * sampling does not stall for the file write. A previous write still in
+ * flight is waited for first; without a thread the write runs inline.
+ */
+static void start_capture_write(capture_job_t *j, pthread_t *tid, int *busy,
+                                const pm_ring_t *ring, unsigned long long from,
+                                unsigned long long to, double t_trig, const char *prefix,
+                                unsigned int n, const char *info)
+{
+    if (*busy) {
+        pthread_join(*tid, NULL);
+        *busy = 0;
+    }
+    pm_ring_free(&j->ring);
+    if (pm_ring_copy(&j->ring, ring, from, to) != 0) {
+        fprintf(stderr, "\n  Capture %u dropped: out of memory\n", n);
+        return;
+    }
+    j->schema = smu_pm_schema();
+    j->t_trig = t_trig;
+    j->n = n;
+    snprintf(j->prefix, sizeof(j->prefix), "%s", prefix);
+    snprintf(j->info, sizeof(j->info), "%s", info);
+    if (pthread_create(tid, NULL, write_capture, j) == 0)
+        *busy = 1;
+    else
+        write_capture(j);
+}
+
+static void pm_trigger_capture(void)
+{
+    enum { TRIG_LEVEL = 1, TRIG_RATE, TRIG_EXTERNAL };
+    char buf[256], expr[200] = "", prefix[200], reason[240] = "", info[640];
+    char def[240], err[160];
+    int mode, interval_ms = 20, pre_ms = 5000, post_ms = 2000;
+    unsigned int max_captures = 0, captures = 0, pre_n, post_n, post_left = 0;
+    float rate_limit = 0;
+    pm_expr_set_t *mx = NULL;
+    int trig_m = -1, armed = 1, level_prev = 0, have_prev = 0;
+    float v_prev = 0;
+    double t_prev = 0, t_trig = 0, t_status = 0;
+    unsigned long long trig_seq = 0;
+    unsigned char *pm_buf;
+    pm_ring_t ring;
+    capture_job_t job;
+    pthread_t writer;
+    int writing = 0;
+    struct termios oldt, newt;
+    struct timespec next;
+
+    if (!smu_pm_tables_supported(&obj)) {
+        fprintf(stderr, "  PM Tables not supported on this platform.\n");
+        return;
+    }
+    memset(&job, 0, sizeof(job));
+
+    read_line("\n  Trigger: [1] Condition  [2] Rate of change  [3] External only: ", buf, sizeof(buf));
+    mode = buf[0] ? atoi(buf) : TRIG_LEVEL;
+    if (mode < TRIG_LEVEL || mode > TRIG_EXTERNAL)
+        mode = TRIG_LEVEL;
+
+    if (mode != TRIG_EXTERNAL) {
+        read_line(mode == TRIG_LEVEL ? "  Condition (e.g. PROCHOT > 0, EDC_VALUE > 140): "
+                                     : "  Watch expression (e.g. CPU_TELEMETRY_VOLTAGE): ",
+                  expr, sizeof(expr));
+        if (!expr[0])
+            return;
+        if (mode == TRIG_RATE) {
+            read_line("  Trigger when |d/dt| exceeds (units per second): ", buf, sizeof(buf));
+            rate_limit = (float)atof(buf);
+        }
+        /* Private set so the trigger does not show up in every exporter.
+         * max() folds per-core expressions to "any core". */
+        mx = metrics_build(1);
+        snprintf(def, sizeof(def), "trigger_ = max(%s)", expr);
+        if (!mx || pm_expr_add(mx, def, err, sizeof(err)) != 0) {
+            fprintf(stderr, "  Bad expression: %s\n", mx ? err : "out of memory");
+            pm_expr_free(mx);
+            return;
+        }
+        trig_m = pm_expr_find(mx, "trigger_");
+    }
+
+    read_line("  Sample interval (ms, default 20): ", buf, sizeof(buf));
+    if (buf[0]) interval_ms = atoi(buf);
+    if (interval_ms < 1) interval_ms = 1;
+    read_line("  Pre-trigger window (ms, default 5000): ", buf, sizeof(buf));
+    if (buf[0]) pre_ms = atoi(buf);
+    if (pre_ms < 0) pre_ms = 0;
+    read_line("  Post-trigger window (ms, default 2000): ", buf, sizeof(buf));
+    if (buf[0]) post_ms = atoi(buf);
+    if (post_ms < 0) post_ms = 0;
+    read_line("  Stop after N captures (0 = until quit): ", buf, sizeof(buf));
+    max_captures = buf[0] ? (unsigned)atoi(buf) : 0;
+    read_line("  File prefix (default capture): ", prefix, sizeof(prefix));
+    if (!prefix[0])
+        snprintf(prefix, sizeof(prefix), "capture");
+
+    pre_n = (unsigned)(pre_ms / interval_ms);
+    post_n = (unsigned)(post_ms / interval_ms);
+    pm_buf = calloc(obj.pm_table_size, 1);
+    if (!pm_buf || pm_ring_init(&ring, obj.pm_table_size / 4, pre_n + post_n + 1) != 0) {
+        fprintf(stderr, "  Memory allocation failed.\n");
+        free(pm_buf);
+        pm_expr_free(mx);
+        return;
+    }
+
+    printf("  Ring: %u samples x %u bytes = %.1f MiB (fixed). "
+           "[t] trigger  [q] quit  (or kill -USR1 %d)\n",
+           ring.capacity, obj.pm_table_size,
+           (double)ring.capacity * (obj.pm_table_size + sizeof(double)) / (1024.0 * 1024.0),
+           (int)getpid());
+
+    tcgetattr(STDIN_FILENO, &oldt);
+    newt = oldt;
+    newt.c_lflag &= ~(ICANON | ECHO);
+    newt.c_cc[VMIN] = 0;
+    newt.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+
+    g_running = 1;
+    g_ext_trigger = 0;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (g_running) {
+        int fire = 0, key;
+        double t;
+
+        sleep_period(&next, (unsigned)interval_ms);
+        /* Keys first, so a failing PM read cannot make the loop unstoppable */
+        key = kbhit() ? getchar() : 0;
+        if (key == 'q' || key == 'Q')
+            break;
+        if (smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) != SMU_Return_OK)
+            continue;
+        t = now_sec();
+        memcpy(pm_ring_push(&ring, t), pm_buf, obj.pm_table_size);
+
+        if (mx) {
+            float v;
+            int level;
+
+            pm_expr_eval(mx, pm_buf);
+            v = pm_expr_values(mx, (unsigned)trig_m)[0];
+            if (mode == TRIG_LEVEL) {
+                level = !isnan(v) && v != 0.f;
+            } else {
+                level = have_prev && t > t_prev &&
+                        fabsf((v - v_prev) / (float)(t - t_prev)) > rate_limit;
+                v_prev = v;
+                t_prev = t;
+                have_prev = 1;
+            }
+            /* Edge-triggered: a condition that stays true fires once */
+            if (level && !level_prev) {
+                fire = 1;
+                snprintf(reason, sizeof(reason), "%s%s (value %g)",
+                         mode == TRIG_RATE ? "d/dt " : "", expr, v);
+            }
+            level_prev = level;
+        }
+        if (g_ext_trigger) {
+            g_ext_trigger = 0;
+            fire = 1;
+            snprintf(reason, sizeof(reason), "SIGUSR1");
+        }
+        if (key == 't' || key == 'T') {
+            fire = 1;
+            snprintf(reason, sizeof(reason), "manual");
+        }
+
+        if (armed && fire) {
+            armed = 0;
+            trig_seq = ring.seq - 1;
+            t_trig = t;
+            post_left = post_n;
+            snprintf(info, sizeof(info),
+                     "PM trigger capture, PM table 0x%06X (%s)\n"
+                     "trigger: %s\n"
+                     "interval %d ms, pre %d ms, post %d ms; t_ms is relative to the trigger",
+                     obj.pm_table_version, smu_pm_schema() ? smu_pm_schema()->name : "unnamed",
+                     reason, interval_ms, pre_ms, post_ms);
+        }
+        if (!armed && post_left-- == 0) {
+            start_capture_write(&job, &writer, &writing, &ring,
+                                trig_seq > pre_n ? trig_seq - pre_n : 0, ring.seq,
+                                t_trig, prefix, ++captures, info);
+            armed = 1;
+            if (max_captures && captures >= max_captures)
+                break;
+        }
+
+        if (t - t_status >= 0.25) {
+            t_status = t;
+            printf("\r\033[K  %s | %llu samples | captures %u",
+                   armed ? "armed" : "capturing", ring.seq, captures);
+            if (mx)
+                printf(" | %s = %g", mode == TRIG_RATE ? "watch" : "trigger",
+                       pm_expr_values(mx, (unsigned)trig_m)[0]);
+            fflush(stdout);
+        }
+    }
+
+    /* Quit mid-capture: keep what we have */
+    if (!armed)
+        start_capture_write(&job, &writer, &writing, &ring,
+                            trig_seq > pre_n ? trig_seq - pre_n : 0, ring.seq,
+                            t_trig, prefix, ++captures, info);
+    if (writing)
+        pthread_join(writer, NULL);
+    pm_ring_free(&job.ring);
+
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    g_running = 1;
+    printf("\n  Trigger capture stopped (%u captures).\n\n", captures);
+
+    pm_ring_free(&ring);
+    free(pm_buf);
+    pm_expr_free(mx);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Command Wrapper: run / bench [options] -- cmd args...                     */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+#define RUN_DEFAULT_INTERVAL_MS     20
+#define BENCH_SETTLE_INTERVAL_MS    100
+
+typedef struct {
+    int          interval_ms;
+    int          as_root;
+    int          quiet;
+    int          series;
+    const char  *out_path;
+} run_opts_t;
+
+typedef struct {
+    int    exit_code;
+    double elapsed_s;
+    double score;       /* "score=VALUE" written to the marker FIFO, NAN if none */
+} run_result_t;
+
+static void run_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool run [options] -- command [args...]\n"
+        "       smu_debug_tool bench [options] [bench options] -- command [args...]\n"
+        "  -i, --interval MS        PM table sample period (default %d ms)\n"
+        "  -o, --output FILE        write the JSON report to FILE (default: stdout)\n"
+        "  -s, --series             include the sampled time series in the report\n"
+        "  -q, --quiet              no human-readable summary on stderr\n"
+        "      --as-root            do not drop privileges for the command\n"
+        "bench:\n"
+        "  -n, --runs N             measured runs (default 5)\n"
+        "  -w, --warmup N           unmeasured runs first (default 0)\n"
+        "      --settle-window S    steady-state window (default 10 s)\n"
+        "      --settle-temp C      allowed THM above the idle baseline (default 2.0)\n"
+        "      --settle-power W     allowed power above the idle baseline (default 3.0)\n"
+        "      --settle-timeout S   give up waiting and run anyway (default 300 s)\n"
+        "      --no-settle          start runs back to back\n"
+        "Phase markers: the command may write a phase name per line to the FIFO\n"
+        "in $SMU_RUN_MARK (\"score=VALUE\" records a benchmark score instead), or\n"
+        "send SIGUSR1 to $SMU_RUN_PID for an unnamed mark.\n",
+        RUN_DEFAULT_INTERVAL_MS);
+}
+
+static void json_str(FILE *fp, const char *s)
+{
+    fputc('"', fp);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+static void json_num(FILE *fp, double v, int prec)
+{
+    if (isfinite(v))
+        fprintf(fp, "%.*f", prec, v);
+    else
+        fputs("null", fp);
+}
+
+/* The user pkexec/sudo elevated us from, so the command does not run as root. */
+static int invoking_user(uid_t *uid, gid_t *gid)
+{
+    const char *u = getenv("PKEXEC_UID");
+    struct passwd *pw;
+
+    if (!u)
+        u = getenv("SUDO_UID");
+    if (!u || geteuid() != 0)
+        return 0;
+    pw = getpwuid((uid_t)strtoul(u, NULL, 10));
+    if (!pw || pw->pw_uid == 0)
+        return 0;
+    *uid = pw->pw_uid;
+    *gid = pw->pw_gid;
+    return 1;
+}
+
+/* Ctrl-C reaches the command through the process group; we only note it,
+ * so the report is still written (and nothing is printed to stdout). */
+static void run_sigint_handler(int sig)
+{
+    (void)sig;
+    g_running = 0;
+}
+
+/* SIGTERM/SIGHUP usually reach us alone (kill, a closed session): run_sampled
+ * passes them on to the command and keeps sampling until it exits. */
+static volatile sig_atomic_t g_run_fwd_sig;
+
+static void run_forward_handler(int sig)
+{
+    g_run_fwd_sig = sig;
+    g_running = 0;
+}
+
+/* Read complete lines from the marker FIFO into phase marks or the score. */
+static void run_drain_marks(int fd, char *buf, size_t *used, size_t size,
+                            pm_session_t *ses, double t, double *score)
+{
+    ssize_t n;
+
+    while ((n = read(fd, buf + *used, size - 1 - *used)) > 0) {
+        char *line = buf, *nl;
+
+        *used += (size_t)n;
+        buf[*used] = '\0';
+        while ((nl = strchr(line, '\n')) != NULL) {
+            *nl = '\0';
+            line[strcspn(line, "\r")] = '\0';
+            if (strncmp(line, "score=", 6) == 0)
+                *score = strtod(line + 6, NULL);
+            else if (line[0])
+                pm_session_mark(ses, t, line);
+            line = nl + 1;
+        }
+        *used = strlen(line);
+        memmove(buf, line, *used);
+        if (*used == size - 1)
+            *used = 0;          /* overlong line: drop it */
+    }
+}
+
+/* Options shared by run and bench; 1 if argv[*i] (and its value) was consumed. */
+static int run_parse_opt(int argc, char **argv, int *i, run_opts_t *o)
+{
+    const char *a = argv[*i];
+
+    if ((strcmp(a, "-i") == 0 || strcmp(a, "--interval") == 0) && *i + 1 < argc)
+        o->interval_ms = atoi(argv[++*i]);
+    else if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && *i + 1 < argc)
+        o->out_path = argv[++*i];
+    else if (strcmp(a, "-s") == 0 || strcmp(a, "--series") == 0)
+        o->series = 1;
+    else if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0)
+        o->quiet = 1;
+    else if (strcmp(a, "--as-root") == 0)
+        o->as_root = 1;
+    else
+        return 0;
+    return 1;
+}
+
+/*
+ * Fork cmd and feed PM samples into ses every interval until it exits.
+ * One sample is taken before the fork so short commands still integrate.
+ */
+static int run_sampled(char **cmd, const run_opts_t *o, pm_session_t *ses, void *pm_buf,
+                       run_result_t *res)
+{
+    char fifo_dir[] = "/tmp/smu_run.XXXXXX", fifo[64] = "", pidbuf[16], markbuf[256];
+    size_t mark_used = 0;
+    int fifo_rd = -1, fifo_wr = -1, status = 0;
+    unsigned int marks = 0;
+    uid_t uid = 0;
+    gid_t gid = 0;
+    struct timespec next;
+    struct sigaction sa, sa_term, sa_hup;
+    double t_start;
+    pid_t pid;
+    int forwarded = 0;
+
+    res->exit_code = 1;
+    res->elapsed_s = 0;
+    res->score = NAN;
+
+    if (!o->as_root && !invoking_user(&uid, &gid))
+        uid = 0;
+
+    /* Marker FIFO; a spare writer keeps read() from reporting EOF between writers */
+    if (mkdtemp(fifo_dir)) {
+        snprintf(fifo, sizeof(fifo), "%s/mark", fifo_dir);
+        if (mkfifo(fifo, 0600) == 0) {
+            if (uid && (chown(fifo_dir, uid, gid) != 0 || chown(fifo, uid, gid) != 0))
+                fprintf(stderr, "run: cannot hand the marker FIFO to uid %u.\n", (unsigned)uid);
+            fifo_rd = open(fifo, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            fifo_wr = open(fifo, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        } else {
+            fifo[0] = '\0';
+        }
+    } else {
+        fifo_dir[0] = '\0';
+    }
+    snprintf(pidbuf, sizeof(pidbuf), "%d", (int)getpid());
+
+    g_ext_trigger = 0;
+    if (ses->schema && smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) == SMU_Return_OK)
+        pm_session_add(ses, now_sec(), pm_buf);
+    t_start = now_sec();
+
+    g_run_fwd_sig = 0;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = run_forward_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, &sa_term);
+    sigaction(SIGHUP, &sa, &sa_hup);
+
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0) {
+        perror("run: fork");
+        goto out;
+    }
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGHUP, SIG_DFL);
+        signal(SIGUSR1, SIG_DFL);
+        if (fifo_rd >= 0)
+            setenv("SMU_RUN_MARK", fifo, 1);
+        setenv("SMU_RUN_PID", pidbuf, 1);
+        if (uid && (setgroups(0, NULL) != 0 || setgid(gid) != 0 || setuid(uid) != 0)) {
+            perror("run: dropping privileges");
+            _exit(126);
+        }
+        execvp(cmd[0], cmd);
+        fprintf(stderr, "run: %s: %s\n", cmd[0], strerror(errno));
+        _exit(127);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (1) {
+        double t;
+        pid_t r;
+
+        sleep_period(&next, (unsigned int)o->interval_ms);
+        t = now_sec();
+        if (ses->schema && smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) == SMU_Return_OK)
+            pm_session_add(ses, t, pm_buf);
+        if (fifo_rd >= 0)
+            run_drain_marks(fifo_rd, markbuf, &mark_used, sizeof(markbuf), ses, t, &res->score);
+        if (g_ext_trigger) {
+            char name[24];
+            g_ext_trigger = 0;
+            snprintf(name, sizeof(name), "mark%u", ++marks);
+            pm_session_mark(ses, t, name);
+        }
+        /* Ctrl-C already reached the command through the process group */
+        if (g_run_fwd_sig && !forwarded) {
+            kill(pid, g_run_fwd_sig);
+            forwarded = 1;
+        }
+        r = waitpid(pid, &status, WNOHANG);
+        if (r == pid || (r < 0 && errno != EINTR))
+            break;
+    }
+    res->elapsed_s = now_sec() - t_start;
+    res->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) :
+                     WIFSIGNALED(status) ? 128 + WTERMSIG(status) : 1;
+
+out:
+    sigaction(SIGTERM, &sa_term, NULL);
+    sigaction(SIGHUP, &sa_hup, NULL);
+    if (fifo_wr >= 0)
+        close(fifo_wr);
+    if (fifo_rd >= 0)
+        close(fifo_rd);
+    if (fifo[0])
+        unlink(fifo);
+    if (fifo_dir[0])
+        rmdir(fifo_dir);
+    return pid < 0 ? -1 : 0;
+}
+
+static void run_write_header(FILE *fp, const pm_schema_t *sch, char **cmd,
+                             const run_opts_t *o)
+{
+    fprintf(fp, "  \"ToolVersion\": \"%s\",\n", TOOL_VERSION);
+    fprintf(fp, "  \"CpuName\": \"%s\",\n", get_processor_name());
+    fprintf(fp, "  \"Codename\": \"%s\",\n", smu_codename_to_str(&obj));
+    fprintf(fp, "  \"PmTableVersion\": \"0x%06X\",\n", obj.pm_table_version);
+    fprintf(fp, "  \"PmSchema\": ");
+    if (sch)
+        json_str(fp, sch->name);
+    else
+        fputs("null", fp);
+    fprintf(fp, ",\n  \"Command\": [");
+    for (int i = 0; cmd[i]; i++) {
+        fputs(i ? ", " : "", fp);
+        json_str(fp, cmd[i]);
+    }
+    fprintf(fp, "],\n");
+    fprintf(fp, "  \"IntervalMs\": %d,\n", o->interval_ms);
+}
+
+static void run_print_summary(const pm_session_t *ses, const run_result_t *res)
+{
+    const pm_acc_t *a = &ses->total;
+
+    fprintf(stderr, "  Elapsed:      %.3f s, %lu samples\n", res->elapsed_s, a->samples);
+    if (ses->power_field >= 0 && a->seconds > 0)
+        fprintf(stderr, "  Energy:       %.2f J (avg %.2f W, peak %.2f W, %s)\n",
+                a->energy_j, pm_acc_avg_power(a), a->power_peak_w,
+                pm_field_name((pm_field_id)ses->power_field));
+    if (a->clk_n)
+        fprintf(stderr, "  Clocks:       avg %.0f MHz, peak %.0f MHz\n",
+                pm_acc_avg_clock(a), a->clk_peak_mhz);
+    if (a->temp_n)
+        fprintf(stderr, "  Temperature:  avg %.1f C, peak %.1f C\n",
+                pm_acc_avg_temp(a), a->temp_peak);
+    if (a->seconds > 0 && ses->limiter.avail) {
+        fprintf(stderr, "  At limit:    ");
+        for (int l = 0; l < PM_LIM_COUNT; l++) {
+            if (ses->limiter.avail & (1u << l))
+                fprintf(stderr, " %s %.1f%%", pm_limit_name((pm_limit_id)l),
+                        100.0 * a->lim.engaged_s[l] / a->seconds);
+        }
+        fputc('\n', stderr);
+        print_limiter_split(stderr, &a->lim, "  Limited by:  ");
+    }
+    if (a->cstate_n)
+        fprintf(stderr, "  Residency:    C0 %.1f%%  CC1 %.1f%%  CC6 %.1f%%  PC6 %.1f%%\n",
+                a->c0_sum / a->cstate_n, a->cc1_sum / a->cstate_n,
+                a->cc6_sum / a->cstate_n, a->pc6_sum / a->cstate_n);
+    if (ses->nphases > 1) {
+        for (unsigned int i = 0; i < ses->nphases; i++) {
+            const pm_phase_t *ph = &ses->phases[i];
+            fprintf(stderr, "  Phase %-16s %8.3f s  %9.2f J  %7.0f MHz\n", ph->name,
+                    ph->acc.seconds, ph->acc.energy_j, pm_acc_avg_clock(&ph->acc));
+        }
+    }
+    if (!isnan(res->score))
+        fprintf(stderr, "  Score:        %g\n", res->score);
+}
+
+/*
+ * Only the Matisse layout maps the per-core arrays; Vermeer, Zen4/Zen5 and
+ * APU tables need a field map (SMU_PM_MAP) for them. Commands built on them
+ * call this up front: it says what is lost (unless without is NULL) and
+ * returns whether CORE_FREQEFF and CORE_C0 are there.
+ */
+static int pm_core_fields(const char *what, const pm_schema_t *sch, const char *without)
+{
+    if (pm_has(sch, PMF_CORE_FREQEFF) && pm_has(sch, PMF_CORE_C0))
+        return 1;
+    if (sch && without)
+        fprintf(stderr, "%s: the %s PM layout (v0x%06X) has no per-core fields; %s "
+                "(see SMU_PM_MAP).\n", what, sch->name, obj.pm_table_version, without);
+    return 0;
+}
+
+/* Common setup for run and bench: PM support, layout, buffer, core count. */
+static void *run_prepare(const char *what, const pm_schema_t **sch, unsigned int *cores)
+{
+    unsigned int ccds = 0, ccxs = 0, cpc = 0;
+
+    if (!smu_pm_tables_supported(&obj)) {
+        fprintf(stderr, "%s: PM tables are not supported on this CPU.\n", what);
+        return NULL;
+    }
+    *sch = smu_pm_schema();
+    if (!*sch)
+        fprintf(stderr, "%s: no PM layout for v0x%06X; only timing is reported "
+                "(see SMU_PM_MAP).\n", what, obj.pm_table_version);
+    if (get_topology(&ccds, &ccxs, &cpc, cores) != 0)
+        *cores = 0;
+    return calloc(obj.pm_table_size, 1);
+}
+
+static int run_command(int argc, char **argv)
+{
+    run_opts_t o = { RUN_DEFAULT_INTERVAL_MS, 0, 0, 0, NULL };
+    const pm_schema_t *sch = NULL;
+    pm_session_t ses;
+    run_result_t res;
+    struct sigaction sa, sa_int;
+    unsigned int cores = 0;
+    int slots[PM_MAX_CORES];
+    void *pm_buf;
+    int first;
+    FILE *fp;
+
+    for (first = 1; first < argc; first++) {
+        if (strcmp(argv[first], "--") == 0) {
+            first++;
+            break;
+        }
+        if (run_parse_opt(argc, argv, &first, &o))
+            continue;
+        if (argv[first][0] == '-') {
+            run_usage();
+            return 2;
+        }
+        break;
+    }
+    if (first >= argc) {
+        run_usage();
+        return 2;
+    }
+    if (o.interval_ms < 1)
+        o.interval_ms = 1;
+
+    pm_buf = run_prepare("run", &sch, &cores);
+    if (!pm_buf)
+        return 1;
+    pm_core_fields("run", sch, "per-core clocks and C-state residency are not reported");
+    pm_session_init(&ses, sch, cores, pm_slots("run", slots, cores), o.series);
+
+    sa.sa_handler = run_sigint_handler;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &sa_int);
+    if (run_sampled(argv + first, &o, &ses, pm_buf, &res) != 0) {
+        res.exit_code = 1;
+        goto out;
+    }
+
+    fp = o.out_path ? fopen(o.out_path, "w") : stdout;
+    if (!fp) {
+        fprintf(stderr, "run: cannot write %s: %s\n", o.out_path, strerror(errno));
+        goto out;
+    }
+    fprintf(fp, "{\n");
+    run_write_header(fp, sch, argv + first, &o);
+    fprintf(fp, "  \"ExitCode\": %d,\n", res.exit_code);
+    fprintf(fp, "  \"ElapsedS\": %.3f,\n", res.elapsed_s);
+    fprintf(fp, "  \"Score\": ");
+    json_num(fp, res.score, 6);
+    fprintf(fp, ",\n");
+    pm_session_write_json(fp, &ses, "  ");
+    fprintf(fp, "}\n");
+    if (o.out_path)
+        fclose(fp);
+    else
+        fflush(fp);
+
+    if (!o.quiet) {
+        fprintf(stderr, "\n── run: %s (exit %d) ──\n", argv[first], res.exit_code);
+        run_print_summary(&ses, &res);
+    }
+
+out:
+    sigaction(SIGINT, &sa_int, NULL);
+    g_running = 1;
+    pm_session_free(&ses);
+    free(pm_buf);
+    return res.exit_code;
+}
+
+/* ─── bench: repeated runs gated on thermal steady state ─── */
+
+typedef struct {
+    int     warmup;
+    int     settled;        /* 1 settled, 0 timed out / skipped */
+    double  settle_s;
+    float   start_temp, start_power;
+    int     exit_code;
+    double  elapsed_s, score;
+    pm_session_t ses;
+} bench_run_t;
+
+/* Per-run scalars that get mean / CI / outlier treatment. */
+enum {
+    BM_ELAPSED, BM_ENERGY, BM_POWER, BM_CLOCK, BM_CLOCK_PEAK, BM_TEMP_PEAK,
+    BM_RUNS_PER_KJ, BM_SCORE, BM_SCORE_PER_W, BM_PPT, BM_TDC, BM_EDC, BM_THM, BM_FIT,
+    BM_PROCHOT, BM_CEILING, BM_COUNT
+};
+
+static const struct {
+    const char *key;        /* JSON */
+    const char *label;      /* terminal */
+    int         prec;
+} bench_metrics[BM_COUNT] = {
+    [BM_ELAPSED]     = { "ElapsedS",      "Elapsed (s)",    3 },
+    [BM_ENERGY]      = { "EnergyJ",       "Energy (J)",     2 },
+    [BM_POWER]       = { "PowerAvgW",     "Power avg (W)",  2 },
+    [BM_CLOCK]       = { "ClockAvgMHz",   "Clock avg (MHz)", 1 },
+    [BM_CLOCK_PEAK]  = { "ClockPeakMHz",  "Clock peak (MHz)", 1 },
+    [BM_TEMP_PEAK]   = { "TempPeakC",     "Temp peak (C)",  2 },
+    [BM_RUNS_PER_KJ] = { "RunsPerKJ",     "Runs per kJ",    4 },
+    [BM_SCORE]       = { "Score",         "Score",          4 },
+    [BM_SCORE_PER_W] = { "ScorePerW",     "Score per W",    4 },
+    [BM_PPT]         = { "PptLimitPct",   "At PPT (%)",     2 },
+    [BM_TDC]         = { "TdcLimitPct",   "At TDC (%)",     2 },
+    [BM_EDC]         = { "EdcLimitPct",   "At EDC (%)",     2 },
+    [BM_THM]         = { "ThmLimitPct",   "At THM (%)",     2 },
+    [BM_FIT]         = { "FitLimitPct",   "At FIT (%)",     2 },
+    [BM_PROCHOT]     = { "ProchotPct",    "PROCHOT (%)",    2 },
+    [BM_CEILING]     = { "CeilingPct",    "At ceiling (%)", 2 },
+};
+
+static double bench_metric(const bench_run_t *r, int m)
+{
+    const pm_acc_t *a = &r->ses.total;
+    int have_power = r->ses.power_field >= 0 && a->seconds > 0;
+
+    switch (m) {
+    case BM_ELAPSED:     return r->elapsed_s;
+    case BM_ENERGY:      return have_power ? a->energy_j : NAN;
+    case BM_POWER:       return have_power ? pm_acc_avg_power(a) : NAN;
+    case BM_CLOCK:       return pm_acc_avg_clock(a);
+    case BM_CLOCK_PEAK:  return a->clk_n ? a->clk_peak_mhz : NAN;
+    case BM_TEMP_PEAK:   return a->temp_n ? a->temp_peak : NAN;
+    case BM_RUNS_PER_KJ: return have_power && a->energy_j > 0 ? 1000.0 / a->energy_j : NAN;
+    case BM_SCORE:       return r->score;
+    case BM_SCORE_PER_W: return have_power ? r->score / pm_acc_avg_power(a) : NAN;
+    case BM_PPT: case BM_TDC: case BM_EDC: case BM_THM: case BM_FIT: case BM_PROCHOT:
+        return a->seconds > 0 && (r->ses.limiter.avail & (1u << (m - BM_PPT)))
+               ? 100.0 * a->lim.engaged_s[m - BM_PPT] / a->seconds : NAN;
+    case BM_CEILING:
+        return a->seconds > 0 ? 100.0 * a->lim.class_s[PM_LIM_NONE] / a->seconds : NAN;
+    }
+    return NAN;
+}
+
+/*
+ * Sample until the window is flat and, once a baseline exists, within the
+ * tolerances above it. 1 settled, 0 timed out, -1 interrupted.
+ */
+static int bench_settle(const pm_session_t *ses, void *pm_buf, pm_steady_t *det,
+                        float base_temp, float base_power, float temp_tol, float power_tol,
+                        double timeout_s, float *temp_out, float *power_out, int quiet)
+{
+    struct timespec next;
+    double t0 = now_sec();
+    int rc = 0;
+
+    pm_steady_reset(det);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (g_running) {
+        double t = now_sec();
+        float temp = NAN, power = NAN;
+        int steady;
+
+        if (smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) == SMU_Return_OK) {
+            temp = pm_get(ses->schema, pm_buf, PMF_THM_VALUE);
+            if (ses->power_field >= 0)
+                power = pm_get(ses->schema, pm_buf, (pm_field_id)ses->power_field);
+        }
+        pm_steady_push(det, t, temp, power);
+        steady = pm_steady_check(det, temp_out, power_out);
+        if (steady && !isnan(base_temp) && !isnan(*temp_out) && *temp_out > base_temp + temp_tol)
+            steady = 0;
+        if (steady && !isnan(base_power) && !isnan(*power_out) &&
+            *power_out > base_power + power_tol)
+            steady = 0;
+        if (!quiet)
+            fprintf(stderr, "\r\033[K  settling %5.1f s: THM %.1f C, power %.1f W",
+                    t - t0, *temp_out, *power_out);
+        if (steady) {
+            rc = 1;
+            break;
+        }
+        if (t - t0 >= timeout_s)
+            break;
+        sleep_period(&next, BENCH_SETTLE_INTERVAL_MS);
+    }
+    if (!quiet)
+        fputs("\r\033[K", stderr);
+    return g_running ? rc : -1;
+}
+
+static int bench_command(int argc, char **argv)
+{
+    run_opts_t o = { RUN_DEFAULT_INTERVAL_MS, 0, 0, 0, NULL };
+    int runs = 5, warmup = 0, settle = 1, first, rc = 0, done = 0;
+    double window_s = 10, timeout_s = 300;
+    float temp_tol = 2.0f, power_tol = 3.0f, base_temp = NAN, base_power = NAN;
+    const pm_schema_t *sch = NULL;
+    unsigned int cores = 0;
+    int slots[PM_MAX_CORES];
+    const int *slot;
+    bench_run_t *br = NULL;
+    pm_steady_t *det = NULL;
+    struct sigaction sa, sa_int;
+    void *pm_buf;
+    FILE *fp;
+
+    for (first = 1; first < argc; first++) {
+        const char *a = argv[first];
+        int has_val = first + 1 < argc;
+
+        if (strcmp(a, "--") == 0) {
+            first++;
+            break;
+        }
+        if (run_parse_opt(argc, argv, &first, &o))
+            continue;
+        if ((strcmp(a, "-n") == 0 || strcmp(a, "--runs") == 0) && has_val)
+            runs = atoi(argv[++first]);
+        else if ((strcmp(a, "-w") == 0 || strcmp(a, "--warmup") == 0) && has_val)
+            warmup = atoi(argv[++first]);
+        else if (strcmp(a, "--settle-window") == 0 && has_val)
+            window_s = atof(argv[++first]);
+        else if (strcmp(a, "--settle-temp") == 0 && has_val)
+            temp_tol = (float)atof(argv[++first]);
+        else if (strcmp(a, "--settle-power") == 0 && has_val)
+            power_tol = (float)atof(argv[++first]);
+        else if (strcmp(a, "--settle-timeout") == 0 && has_val)
+            timeout_s = atof(argv[++first]);
+        else if (strcmp(a, "--no-settle") == 0)
+            settle = 0;
+        else if (a[0] == '-') {
+            run_usage();
+            return 2;
+        } else
+            break;
+    }
+    if (first >= argc || runs < 1 || warmup < 0) {
+        run_usage();
+        return 2;
+    }
+    if (o.interval_ms < 1)
+        o.interval_ms = 1;
+    if (window_s < 1)
+        window_s = 1;
+
+    pm_buf = run_prepare("bench", &sch, &cores);
+    if (!pm_buf)
+        return 1;
+    pm_core_fields("bench", sch, "per-core clocks and C-state residency are not reported");
+    slot = pm_slots("bench", slots, cores);
+    if (!sch && settle) {
+        fprintf(stderr, "bench: steady-state gating needs a PM layout; running back to back.\n");
+        settle = 0;
+    }
+    br = calloc((size_t)(warmup + runs), sizeof(*br));
+    det = malloc(sizeof(*det));
+    if (!br || !det) {
+        free(br);
+        free(det);
+        free(pm_buf);
+        return 1;
+    }
+    pm_steady_init(det, window_s, 0.5f, 2.0f);
+
+    sa.sa_handler = run_sigint_handler;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &sa_int);
+
+    for (int i = 0; i < warmup + runs && g_running; i++) {
+        bench_run_t *r = &br[i];
+        run_result_t res;
+        double t_settle = now_sec();
+        int s = 0;
+
+        r->warmup = i < warmup;
+        r->start_temp = r->start_power = NAN;
+        pm_session_init(&r->ses, sch, cores, slot, o.series);
+
+        if (settle) {
+            /* The first settle establishes the idle baseline */
+            s = bench_settle(&r->ses, pm_buf, det, base_temp, base_power, temp_tol, power_tol,
+                             timeout_s, &r->start_temp, &r->start_power, o.quiet);
+            if (s < 0) {
+                pm_session_free(&r->ses);
+                break;
+            }
+            if (i == 0) {
+                base_temp = r->start_temp;
+                base_power = r->start_power;
+            }
+            if (s == 0 && !o.quiet)
+                fprintf(stderr, "  run %d: not settled after %.0f s, starting anyway\n",
+                        i + 1, timeout_s);
+        }
+        r->settled = s;
+        r->settle_s = now_sec() - t_settle;
+
+        if (!o.quiet)
+            fprintf(stderr, "  %s %d/%d (THM %.1f C) ...", r->warmup ? "warmup" : "run",
+                    r->warmup ? i + 1 : i - warmup + 1, r->warmup ? warmup : runs,
+                    r->start_temp);
+        if (run_sampled(argv + first, &o, &r->ses, pm_buf, &res) != 0) {
+            pm_session_free(&r->ses);
+            rc = 1;
+            break;
+        }
+        r->exit_code = res.exit_code;
+        r->elapsed_s = res.elapsed_s;
+        r->score = res.score;
+        done = i + 1;
+        if (!o.quiet)
+            fprintf(stderr, " %.3f s, %.1f J\n", r->elapsed_s,
+                    bench_metric(r, BM_ENERGY));
+        if (res.exit_code != 0) {
+            fprintf(stderr, "bench: command failed (exit %d); stopping.\n", res.exit_code);
+            rc = res.exit_code;
+            break;
+        }
+    }
+    if (!g_running && !o.quiet)
+        fprintf(stderr, "\nbench: interrupted after %d runs.\n", done);
+
+    /* Statistics over the measured runs */
+    {
+        int nm = done > warmup ? done - warmup : 0;
+        double *vals = calloc((size_t)(nm ? nm : 1), sizeof(double));
+        unsigned char *out_flags = calloc((size_t)(nm ? nm : 1), 1);
+        pm_stats_t st[BM_COUNT];
+        unsigned char *outl[BM_COUNT];
+
+        memset(outl, 0, sizeof(outl));
+        for (int m = 0; m < BM_COUNT && vals && out_flags; m++) {
+            for (int k = 0; k < nm; k++)
+                vals[k] = bench_metric(&br[warmup + k], m);
+            pm_stats_summarize(vals, (unsigned int)nm, &st[m], out_flags);
+            outl[m] = malloc((size_t)(nm ? nm : 1));
+            if (outl[m])
+                memcpy(outl[m], out_flags, (size_t)(nm ? nm : 1));
+        }
+
+        fp = o.out_path ? fopen(o.out_path, "w") : stdout;
+        if (!fp)
+            fprintf(stderr, "bench: cannot write %s: %s\n", o.out_path, strerror(errno));
+        if (fp && vals && out_flags) {
+            fprintf(fp, "{\n");
+            run_write_header(fp, sch, argv + first, &o);
+            fprintf(fp, "  \"Settle\": ");
+            if (settle) {
+                fprintf(fp, "{ \"WindowS\": %.1f, \"TempTolC\": %.2f, \"PowerTolW\": %.2f, "
+                        "\"TimeoutS\": %.0f, \"BaselineTempC\": ", window_s, temp_tol,
+                        power_tol, timeout_s);
+                json_num(fp, base_temp, 2);
+                fputs(", \"BaselinePowerW\": ", fp);
+                json_num(fp, base_power, 2);
+                fputs(" },\n", fp);
+            } else {
+                fputs("null,\n", fp);
+            }
+            fprintf(fp, "  \"Warmup\": %d,\n  \"Runs\": [", warmup);
+            for (int i = 0; i < done; i++) {
+                const bench_run_t *r = &br[i];
+                fprintf(fp, "%s\n    {\n", i ? "," : "");
+                fprintf(fp, "      \"Index\": %d,\n", i);
+                fprintf(fp, "      \"Warmup\": %s,\n", r->warmup ? "true" : "false");
+                fprintf(fp, "      \"Settled\": %s,\n", r->settled ? "true" : "false");
+                fprintf(fp, "      \"SettleS\": %.1f,\n", r->settle_s);
+                fprintf(fp, "      \"StartTempC\": ");
+                json_num(fp, r->start_temp, 2);
+                fprintf(fp, ",\n      \"StartPowerW\": ");
+                json_num(fp, r->start_power, 2);
+                fprintf(fp, ",\n      \"ExitCode\": %d,\n", r->exit_code);
+                fprintf(fp, "      \"ElapsedS\": %.3f,\n", r->elapsed_s);
+                fprintf(fp, "      \"Score\": ");
+                json_num(fp, r->score, 6);
+                fprintf(fp, ",\n      \"Outlier\": [");
+                for (int m = 0, sep = 0; m < BM_COUNT && !r->warmup; m++) {
+                    if (outl[m] && outl[m][i - warmup]) {
+                        fprintf(fp, "%s\"%s\"", sep ? ", " : "", bench_metrics[m].key);
+                        sep = 1;
+                    }
+                }
+                fprintf(fp, "],\n");
+                pm_session_write_json(fp, &r->ses, "      ");
+                fprintf(fp, "    }");
+            }
+            fprintf(fp, "%s],\n  \"Stats\": {", done ? "\n  " : "");
+            for (int m = 0, sep = 0; m < BM_COUNT; m++) {
+                const pm_stats_t *s = &st[m];
+                int p = bench_metrics[m].prec;
+                if (s->n == 0)
+                    continue;
+                fprintf(fp, "%s\n    \"%s\": { \"N\": %u, \"Mean\": ", sep ? "," : "",
+                        bench_metrics[m].key, s->n);
+                json_num(fp, s->mean, p);
+                fputs(", \"Sd\": ", fp);
+                json_num(fp, s->sd, p);
+                fputs(", \"Ci95\": [", fp);
+                json_num(fp, s->ci_lo, p);
+                fputs(", ", fp);
+                json_num(fp, s->ci_hi, p);
+                fputs("], \"Median\": ", fp);
+                json_num(fp, s->median, p);
+                fputs(", \"Min\": ", fp);
+                json_num(fp, s->min, p);
+                fputs(", \"Max\": ", fp);
+                json_num(fp, s->max, p);
+                fputs(", \"Outliers\": [", fp);
+                for (int k = 0, sep2 = 0; k < nm; k++) {
+                    if (outl[m] && outl[m][k]) {
+                        fprintf(fp, "%s%d", sep2 ? ", " : "", warmup + k);
+                        sep2 = 1;
+                    }
+                }
+                fputs("] }", fp);
+                sep = 1;
+            }
+            fprintf(fp, "\n  }\n}\n");
+            if (o.out_path)
+                fclose(fp);
+            else
+                fflush(fp);
+        }
+
+        if (!o.quiet && nm > 0 && vals && out_flags) {
+            fprintf(stderr, "\n── bench: %s, %d runs", argv[first], nm);
+            if (settle)
+                fprintf(stderr, ", baseline THM %.1f C / %.1f W", base_temp, base_power);
+            fprintf(stderr, " ──\n");
+            fprintf(stderr, "  %-17s %12s %12s %12s %12s %12s  %s\n", "Metric", "Mean",
+                    "±CI95", "Sd", "Min", "Max", "Outlier runs");
+            for (int m = 0; m < BM_COUNT; m++) {
+                const pm_stats_t *s = &st[m];
+                if (s->n == 0)
+                    continue;
+                fprintf(stderr, "  %-17s %12.*f %12.*f %12.*f %12.*f %12.*f ",
+                        bench_metrics[m].label, bench_metrics[m].prec, s->mean,
+                        bench_metrics[m].prec, isnan(s->ci_hi) ? 0 : s->ci_hi - s->mean,
+                        bench_metrics[m].prec, isnan(s->sd) ? 0 : s->sd,
+                        bench_metrics[m].prec, s->min, bench_metrics[m].prec, s->max);
+                for (int k = 0; k < nm; k++) {
+                    if (outl[m] && outl[m][k])
+                        fprintf(stderr, " %d", k + 1);
+                }
+                fputc('\n', stderr);
+            }
+        }
+
+        for (int m = 0; m < BM_COUNT; m++)
+            free(outl[m]);
+        free(vals);
+        free(out_flags);
+    }
+
+    sigaction(SIGINT, &sa_int, NULL);
+    g_running = 1;
+    for (int i = 0; i < done; i++)
+        pm_session_free(&br[i].ses);
+    free(br);
+    free(det);
+    free(pm_buf);
+    return rc;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Preferred-Core Ranking: rank [options]                                    */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+#define RANK_DEFAULT_STATE  "smu_rank.state"
+
+static void rank_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool rank [options]\n"
+        "  -t, --load MS        single-thread load per core (default 6000)\n"
+        "  -w, --warm MS        start of the load left out of the sustained clock (default 1000)\n"
+        "  -c, --cool MS        idle before each core (default 2000)\n"
+        "  -i, --interval MS    PM table sample period (default 50)\n"
+        "  -n, --top N          cores in the recommended masks (default 2)\n"
+        "      --cores N        measure only the first N cores\n"
+        "  -s, --state FILE     checkpoint for resuming (default " RANK_DEFAULT_STATE ")\n"
+        "      --no-state       do not checkpoint\n"
+        "      --fresh          ignore an existing checkpoint\n"
+        "  -o, --output FILE    write the JSON report to FILE (default: stdout)\n"
+        "  -q, --quiet          no table or progress on stderr\n");
+}
+
+static void rank_progress(void *ctx, unsigned int core, const char *phase,
+                          unsigned int done_ms, unsigned int total_ms)
+{
+    (void)ctx;
+    fprintf(stderr, "\r\033[K  core %2u  %-9s  %3u%%  ~%u s left", core, phase,
+            total_ms ? (unsigned)((unsigned long long)done_ms * 100 / total_ms) : 100,
+            (total_ms - done_ms) / 1000);
+}
+
+static void rank_json_group(FILE *fp, const char *key, const pm_rank_result_t *r,
+                            const int *order, unsigned int n, int last)
+{
+    char buf[512];
+
+    fprintf(fp, "    \"%s\": {\n      \"Cores\": [", key);
+    for (unsigned int i = 0; i < n; i++)
+        fprintf(fp, "%s%d", i ? ", " : "", order[i]);
+    pm_rank_mask(&r->topo, order, n, 1, buf, sizeof(buf));
+    fprintf(fp, "],\n      \"Mask\": \"%s\",\n", buf);
+    pm_rank_cpulist(&r->topo, order, n, 1, buf, sizeof(buf));
+    fprintf(fp, "      \"CpuList\": \"%s\",\n", buf);
+    pm_rank_mask(&r->topo, order, n, 0, buf, sizeof(buf));
+    fprintf(fp, "      \"MaskFirstThread\": \"%s\",\n", buf);
+    pm_rank_cpulist(&r->topo, order, n, 0, buf, sizeof(buf));
+    fprintf(fp, "      \"CpuListFirstThread\": \"%s\"\n    }%s\n", buf, last ? "" : ",");
+}
+
+static void rank_print_group(const char *what, const pm_rank_result_t *r, const int *order,
+                             unsigned int n)
+{
+    char mask[300], list[512];
+
+    fprintf(stderr, "  Best %u by %s: core", n, what);
+    for (unsigned int i = 0; i < n; i++)
+        fprintf(stderr, "%s %d", i ? "," : "", order[i]);
+    pm_rank_mask(&r->topo, order, n, 1, mask, sizeof(mask));
+    pm_rank_cpulist(&r->topo, order, n, 1, list, sizeof(list));
+    fprintf(stderr, "\n    taskset %-20s cpuset %s\n", mask, list);
+    pm_rank_mask(&r->topo, order, n, 0, mask, sizeof(mask));
+    pm_rank_cpulist(&r->topo, order, n, 0, list, sizeof(list));
+    fprintf(stderr, "    taskset %-20s cpuset %s   (one thread per core)\n", mask, list);
+}
+
+static int rank_command(int argc, char **argv)
+{
+    pm_rank_opts_t ro;
+    pm_rank_result_t *res;
+    const pm_schema_t *sch = NULL;
+    const char *out_path = NULL;
+    unsigned int cores = 0;
+    void *pm_buf;
+    int top = 2, quiet = 0, rc;
+    int boost_pos[PM_RANK_MAX_CORES], eff_pos[PM_RANK_MAX_CORES], slots[PM_RANK_MAX_CORES];
+    struct sigaction sa, sa_int;
+    FILE *fp;
+
+    memset(&ro, 0, sizeof(ro));
+    ro.state_path = RANK_DEFAULT_STATE;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has_val = i + 1 < argc;
+
+        if ((strcmp(a, "-t") == 0 || strcmp(a, "--load") == 0) && has_val)
+            ro.load_ms = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-w") == 0 || strcmp(a, "--warm") == 0) && has_val)
+            ro.warm_ms = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-c") == 0 || strcmp(a, "--cool") == 0) && has_val)
+            ro.cool_ms = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-i") == 0 || strcmp(a, "--interval") == 0) && has_val)
+            ro.sample_ms = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-n") == 0 || strcmp(a, "--top") == 0) && has_val)
+            top = atoi(argv[++i]);
+        else if (strcmp(a, "--cores") == 0 && has_val)
+            ro.max_cores = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-s") == 0 || strcmp(a, "--state") == 0) && has_val)
+            ro.state_path = argv[++i];
+        else if (strcmp(a, "--no-state") == 0)
+            ro.state_path = NULL;
+        else if (strcmp(a, "--fresh") == 0)
+            ro.fresh = 1;
+        else if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && has_val)
+            out_path = argv[++i];
+        else if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0)
+            quiet = 1;
+        else {
+            rank_usage();
+            return 2;
+        }
+    }
+    if (top < 1)
+        top = 1;
+
+    /* pm_rank reads into its own buffer; this only checks PM support */
+    pm_buf = run_prepare("rank", &sch, &cores);
+    if (!pm_buf)
+        return 1;
+    free(pm_buf);
+    if (!sch)
+        return 1;
+    if (!pm_core_fields("rank", sch, "cannot rank cores")) {
+        return 1;
+    }
+    res = calloc(1, sizeof(*res));
+    if (!res)
+        return 1;
+
+    pm_rank_topology(&res->topo, 0);
+    ro.nslots = res->topo.nfound;
+    ro.slot = online_slots("rank", slots, PM_RANK_MAX_CORES, ro.nslots);
+    ro.schema = sch;
+    ro.table_size = obj.pm_table_size;
+    ro.version = obj.pm_table_version;
+    ro.read_pm = infer_read_pm;
+    ro.progress = quiet ? NULL : rank_progress;
+    ro.running = &g_running;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = run_sigint_handler;
+    sigaction(SIGINT, &sa, &sa_int);
+    g_running = 1;
+    rc = pm_rank_run(&ro, res);
+    sigaction(SIGINT, &sa_int, NULL);
+    g_running = 1;
+    if (!quiet)
+        fputs("\r\033[K", stderr);
+
+    if (rc == -2) {
+        unsigned int done = 0;
+        for (unsigned int c = 0; c < res->topo.ncores; c++)
+            done += res->core[c].done;
+        fprintf(stderr, "rank: interrupted after %u of %u cores", done, res->topo.ncores);
+        if (ro.state_path)
+            fprintf(stderr, "; run again to resume from %s", ro.state_path);
+        fputc('\n', stderr);
+        free(res);
+        return 130;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "rank: measurement failed (topology, PM reads or checkpoint %s).\n",
+                ro.state_path ? ro.state_path : "-");
+        free(res);
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < res->topo.ncores; i++) {
+        boost_pos[res->by_boost[i]] = (int)i + 1;
+        eff_pos[i] = 0;
+    }
+    for (unsigned int i = 0; i < res->neff; i++)
+        eff_pos[res->by_eff[i]] = (int)i + 1;
+
+    if (!quiet) {
+        fprintf(stderr, "── rank: %u cores", res->topo.ncores);
+        if (res->resumed)
+            fprintf(stderr, ", %u from checkpoint", res->resumed);
+        fprintf(stderr, " ──\n  %4s %-9s %10s %8s %7s %7s %7s %6s %8s %6s %6s\n", "Core", "CPUs",
+                "Sustained", "Peak", "Volt", "Power", "MHz/W", "Temp", "CPPC", "Boost", "Eff");
+        for (unsigned int c = 0; c < res->topo.ncores; c++) {
+            const pm_rank_core_t *k = &res->core[c];
+            char cpus[24];
+            int one = (int)c;
+
+            pm_rank_cpulist(&res->topo, &one, 1, 1, cpus, sizeof(cpus));
+            fprintf(stderr, "  %4u %-9s %6.0f MHz %8.0f %7.3f %7.2f ", c, cpus,
+                    k->freq_mhz, k->freq_peak_mhz, k->volt, k->power_w);
+            if (isnan(k->mhz_per_w))
+                fprintf(stderr, "%7s %6.1f ", "-", k->temp_c);
+            else
+                fprintf(stderr, "%7.0f %6.1f ", k->mhz_per_w, k->temp_c);
+            if (k->cppc_kernel >= 0)
+                fprintf(stderr, "%8d", k->cppc_kernel);
+            else if (!isnan(k->cppc_pm))
+                fprintf(stderr, "%7.0f*", k->cppc_pm);
+            else
+                fprintf(stderr, "%8s", "-");
+            fprintf(stderr, " %6d ", boost_pos[c]);
+            if (eff_pos[c])
+                fprintf(stderr, "%6d", eff_pos[c]);
+            else
+                fprintf(stderr, "%6s", "-");
+            fprintf(stderr, "%s\n", k->disturbed ? "  disturbed" : "");
+        }
+        if (!res->topo.ncores || res->core[0].cppc_kernel < 0)
+            fprintf(stderr, "  CPPC: * = PM table CORE_CPPC_MAX (no kernel ranking)\n");
+        rank_print_group("sustained boost", res, res->by_boost,
+                         (unsigned)top < res->topo.ncores ? (unsigned)top : res->topo.ncores);
+        if (res->neff)
+            rank_print_group("MHz per W", res, res->by_eff,
+                             (unsigned)top < res->neff ? (unsigned)top : res->neff);
+    }
+
+    fp = out_path ? fopen(out_path, "w") : stdout;
+    if (!fp) {
+        fprintf(stderr, "rank: cannot write %s: %s\n", out_path, strerror(errno));
+        free(res);
+        return 1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"ToolVersion\": \"%s\",\n", TOOL_VERSION);
+    fprintf(fp, "  \"CpuName\": \"%s\",\n", get_processor_name());
+    fprintf(fp, "  \"Codename\": \"%s\",\n", smu_codename_to_str(&obj));
+    fprintf(fp, "  \"PmTableVersion\": \"0x%06X\",\n", obj.pm_table_version);
+    fprintf(fp, "  \"PmSchema\": ");
+    json_str(fp, sch->name);
+    fprintf(fp, ",\n  \"LoadMs\": %u,\n  \"WarmMs\": %u,\n  \"CoolMs\": %u,\n",
+            ro.load_ms ? ro.load_ms : 6000, ro.warm_ms ? ro.warm_ms : 1000,
+            ro.cool_ms ? ro.cool_ms : 2000);
+    fprintf(fp, "  \"PowerSource\": ");
+    if (res->power_src)
+        json_str(fp, res->power_src);
+    else
+        fputs("null", fp);
+    fprintf(fp, ",\n  \"Resumed\": %u,\n  \"Cores\": [", res->resumed);
+    for (unsigned int c = 0; c < res->topo.ncores; c++) {
+        const pm_rank_core_t *k = &res->core[c];
+
+        fprintf(fp, "%s\n    { \"Core\": %u, \"Cpus\": [", c ? "," : "", c);
+        for (unsigned int j = 0; j < res->topo.nthreads[c]; j++)
+            fprintf(fp, "%s%d", j ? ", " : "", res->topo.cpu[c][j]);
+        fprintf(fp, "], \"SustainedMHz\": ");
+        json_num(fp, k->freq_mhz, 1);
+        fputs(", \"PeakMHz\": ", fp);
+        json_num(fp, k->freq_peak_mhz, 1);
+        fputs(", \"VoltageV\": ", fp);
+        json_num(fp, k->volt, 4);
+        fputs(", \"PowerW\": ", fp);
+        json_num(fp, k->power_w, 3);
+        fputs(", \"MHzPerW\": ", fp);
+        json_num(fp, k->mhz_per_w, 1);
+        fputs(", \"TempC\": ", fp);
+        json_num(fp, k->temp_c, 2);
+        fputs(", \"TempPeakC\": ", fp);
+        json_num(fp, k->temp_peak_c, 2);
+        fputs(", \"C0Pct\": ", fp);
+        json_num(fp, k->c0_pct, 1);
+        fputs(", \"BackgroundC0Pct\": ", fp);
+        json_num(fp, k->others_c0_pct, 1);
+        fputs(", \"CppcPm\": ", fp);
+        json_num(fp, k->cppc_pm, 0);
+        fputs(", \"CppcKernel\": ", fp);
+        if (k->cppc_kernel >= 0)
+            fprintf(fp, "%d", k->cppc_kernel);
+        else
+            fputs("null", fp);
+        fprintf(fp, ", \"Disturbed\": %s, \"BoostRank\": %d, \"EfficiencyRank\": ",
+                k->disturbed ? "true" : "false", boost_pos[c]);
+        if (eff_pos[c])
+            fprintf(fp, "%d }", eff_pos[c]);
+        else
+            fputs("null }", fp);
+    }
+    fprintf(fp, "\n  ],\n  \"Recommendations\": {\n");
+    rank_json_group(fp, "Boost", res, res->by_boost,
+                    (unsigned)top < res->topo.ncores ? (unsigned)top : res->topo.ncores,
+                    res->neff == 0);
+    if (res->neff)
+        rank_json_group(fp, "Efficiency", res, res->by_eff,
+                        (unsigned)top < res->neff ? (unsigned)top : res->neff, 1);
+    fprintf(fp, "  }\n}\n");
+    if (out_path)
+        fclose(fp);
+    else
+        fflush(fp);
+    free(res);
+    return 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  PBO Profile Apply: apply [options] PROFILE                                */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+/* Outcome of pbo_apply on stderr; every item with verbose. */
+static void print_pbo_apply(const char *what, int rc, const pbo_apply_result_t *r, int verbose,
+                            int dry)
+{
+    for (unsigned int i = 0; i < r->n && (verbose || rc != 0); i++) {
+        const pbo_item_t *it = &r->item[i];
+        char label[32];
+
+        pbo_item_label(it, label, sizeof(label));
+        fprintf(stderr, "  %-12s ", label);
+        if (it->known)
+            fprintf(stderr, "%6ld -> ", it->before);
+        else
+            fprintf(stderr, "%6s -> ", "?");
+        fprintf(stderr, "%6ld  %s\n", it->target,
+                !it->changed ? (it->known && it->before == it->target ? "unchanged" : "planned") :
+                r->rolled_back ? (it->after == it->before ? "rolled back" : "ROLLBACK FAILED") :
+                it->ok ? "ok" : "FAILED");
+    }
+    if (rc == 0)
+        fprintf(stderr, "%s: %u of %u setting(s) %s in %.1f ms%s.\n", what, r->nchanged, r->n,
+                dry ? "would change" : "changed", r->ms,
+                r->n && !r->item[0].known ? " (not verified)" : "");
+    else if (rc == -1)
+        fprintf(stderr, "%s: %s; all changes rolled back.\n", what, r->error);
+    else if (rc == -2)
+        fprintf(stderr, "%s: %s; ROLLBACK INCOMPLETE, check the values above.\n", what,
+                r->error);
+    else
+        fprintf(stderr, "%s: %s; nothing changed.\n", what, r->error);
+}
+
+static void apply_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool apply [options] PROFILE\n"
+        "  -n, --dry-run        read the current values and show the plan\n"
+        "      --no-verify      no snapshot, readback or rollback (CO GET unsupported)\n"
+        "      --save FILE      write the current CO and FMax as a profile first\n"
+        "  -v, --verbose        list every setting\n"
+        "  -q, --quiet          only report failures\n");
+}
+
+/* Profile values this CPU accepts (g_plat). 1 ok; 0 after saying why. */
+static int profile_fits(const char *what, const char *path, const pbo_profile_t *p)
+{
+    char err[160];
+
+    if (pbo_profile_check(p, g_plat->co_min, g_plat->co_max, g_plat->fmax_max_mhz,
+                          err, sizeof(err)) == 0)
+        return 1;
+    fprintf(stderr, "%s: %s: %s\n", what, path, err);
+    return 0;
+}
+
+/* Current CO of every core, FMax and PBO limits as a profile. Settings that cannot be read
+ * are left out. */
+static void pbo_read_current(const pbo_ops_t *ops, pbo_profile_t *p)
+{
+    unsigned int mhz;
+
+    memset(p, 0, sizeof(*p));
+    for (int l = 0; l < PBO_LIM_COUNT && ops->get_limit; l++) {
+        if (ops->get_limit(ops->ctx, (pbo_limit_id)l, &p->limit[l]) == 0)
+            p->lim_mask |= 1u << l;
+    }
+    for (unsigned int c = 0; c < ops->ncores; c++) {
+        if (ops->get_co(ops->ctx, (int)c, &p->co[c]) == 0)
+            p->co_mask |= 1ULL << c;
+    }
+    if (ops->get_fmax(ops->ctx, &mhz) == 0) {
+        p->has_fmax = 1;
+        p->fmax_mhz = mhz;
+    }
+}
+
+static int apply_command(int argc, char **argv)
+{
+    const pbo_ops_t *ops = smu_pbo_ops();
+    const char *path = NULL, *save = NULL;
+    unsigned int flags = 0;
+    int verbose = 0, quiet = 0, rc;
+    pbo_profile_t p;
+    pbo_apply_result_t r;
+    char err[256];
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+
+        if (strcmp(a, "-n") == 0 || strcmp(a, "--dry-run") == 0)
+            flags |= PBO_APPLY_DRY_RUN;
+        else if (strcmp(a, "--no-verify") == 0)
+            flags |= PBO_APPLY_NO_VERIFY;
+        else if (strcmp(a, "--save") == 0 && i + 1 < argc)
+            save = argv[++i];
+        else if (strcmp(a, "-v") == 0 || strcmp(a, "--verbose") == 0)
+            verbose = 1;
+        else if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0)
+            quiet = 1;
+        else if (a[0] != '-' && !path)
+            path = a;
+        else {
+            apply_usage();
+            return 2;
+        }
+    }
+    if (!path) {
+        apply_usage();
+        return 2;
+    }
+    if (pbo_profile_load(path, &p, err, sizeof(err)) != 0) {
+        fprintf(stderr, "apply: %s\n", err);
+        return 2;
+    }
+    if (!profile_fits("apply", path, &p))
+        return 2;
+    if (ops->ncores == 0) {
+        fprintf(stderr, "apply: cannot read the core topology.\n");
+        return 1;
+    }
+    if (save) {
+        pbo_profile_t cur;
+        pbo_read_current(ops, &cur);
+        if (pbo_profile_save(save, &cur, "smu_debug_tool apply --save (values before apply)") != 0) {
+            fprintf(stderr, "apply: cannot write %s: %s\n", save, strerror(errno));
+            return 1;
+        }
+    }
+
+    rc = pbo_apply(ops, &p, flags, &r);
+    if (!quiet || rc != 0)
+        print_pbo_apply("apply", rc, &r, verbose || (flags & PBO_APPLY_DRY_RUN),
+                        (flags & PBO_APPLY_DRY_RUN) != 0);
+    return rc == 0 ? 0 : rc == -3 ? 2 : 1;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  PBO Limits: limits [options] [ppt W] [tdc A] [edc A] [thm C] [scalar x]    */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+static void limits_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool limits [options] [ppt W] [tdc A] [edc A] [thm C] [scalar x]\n"
+        "  Without settings, shows the limits in force. Settings are applied together\n"
+        "  and rolled back if any is not confirmed by the PM table.\n"
+        "  -n, --dry-run        read the current values and show the plan\n"
+        "  -q, --quiet          only report failures\n");
+}
+
+static int limits_command(int argc, char **argv)
+{
+    const pbo_ops_t *ops = smu_pbo_ops();
+    unsigned int flags = 0;
+    int quiet = 0, rc;
+    pbo_profile_t p;
+    pbo_apply_result_t r;
+
+    memset(&p, 0, sizeof(p));
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int l;
+
+        if (strcmp(a, "-n") == 0 || strcmp(a, "--dry-run") == 0) {
+            flags |= PBO_APPLY_DRY_RUN;
+            continue;
+        }
+        if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0) {
+            quiet = 1;
+            continue;
+        }
+        for (l = 0; l < PBO_LIM_COUNT; l++) {
+            if (strcmp(a, pbo_limit_key((pbo_limit_id)l)) == 0)
+                break;
+        }
+        if (l == PBO_LIM_COUNT || i + 1 >= argc) {
+            limits_usage();
+            return 2;
+        }
+        a = argv[++i];
+        p.limit[l] = (unsigned)strtoul(a, NULL, 10);
+        if (p.limit[l] == 0 || p.limit[l] > pbo_limit_max((pbo_limit_id)l)) {
+            fprintf(stderr, "limits: %s must be 1..%u\n", pbo_limit_name((pbo_limit_id)l),
+                    pbo_limit_max((pbo_limit_id)l));
+            return 2;
+        }
+        p.lim_mask |= 1u << l;
+    }
+    if (!ops->set_limit) {
+        fprintf(stderr, "limits: PBO limits are not supported on %s.\n", smu_get_processor_name());
+        return 1;
+    }
+
+    if (!p.lim_mask) {
+        static const char *units[PBO_LIM_COUNT] = { "W", "A", "A", "C", "x" };
+
+        for (int l = 0; l < PBO_LIM_COUNT; l++) {
+            unsigned int v;
+
+            if (!smu_pbo_limit_supported((pbo_limit_id)l))
+                printf("  %-8s n/a\n", pbo_limit_name((pbo_limit_id)l));
+            else if (smu_get_pbo_limit((pbo_limit_id)l, &v) == 0)
+                printf("  %-8s %u %s\n", pbo_limit_name((pbo_limit_id)l), v, units[l]);
+            else
+                printf("  %-8s read failed\n", pbo_limit_name((pbo_limit_id)l));
+        }
+        return 0;
+    }
+    for (int l = 0; l < PBO_LIM_COUNT; l++) {
+        if ((p.lim_mask & (1u << l)) && !smu_pbo_limit_supported((pbo_limit_id)l)) {
+            fprintf(stderr, "limits: %s cannot be set and verified on this CPU or PM layout.\n",
+                    pbo_limit_name((pbo_limit_id)l));
+            return 2;
+        }
+    }
+
+    rc = pbo_apply(ops, &p, flags, &r);
+    if (!quiet || rc != 0)
+        print_pbo_apply("limits", rc, &r, 1, (flags & PBO_APPLY_DRY_RUN) != 0);
+    return rc == 0 ? 0 : rc == -3 ? 2 : 1;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  SMN Range Scan: smn-scan [options] START END                              */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+static void smnscan_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool smn-scan [options] START END\n"
+        "  START and END are hex SMN addresses (END inclusive).\n"
+        "  -f, --format FMT     table, csv or bin (default table)\n"
+        "  -o, --output FILE    write to FILE (default stdout; bin needs a file)\n"
+        "  -g, --granule HEX    hole-skip granularity, a power of two (default 0x%X);\n"
+        "                       0 reads every word\n"
+        "  -l, --label TEXT     label stored in a bin dump header\n", SMN_SCAN_GRANULE);
+}
+
+static int smnscan_command(int argc, char **argv)
+{
+    smn_scan_opts_t o = { 0, 0, SMN_SCAN_GRANULE, SMN_FMT_TABLE, NULL };
+    const char *path = NULL, *label = NULL;
+    uint32_t addr[1][2];
+    int na = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has = i + 1 < argc;
+
+        if ((strcmp(a, "-f") == 0 || strcmp(a, "--format") == 0) && has) {
+            if (smn_fmt_parse(argv[++i], &o.fmt) != 0) {
+                smnscan_usage();
+                return 2;
+            }
+        } else if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && has) {
+            path = argv[++i];
+        } else if ((strcmp(a, "-g") == 0 || strcmp(a, "--granule") == 0) && has) {
+            if (parse_hex(argv[++i], &o.granule) != 0 ||
+                (o.granule && (o.granule < 4 || (o.granule & (o.granule - 1))))) {
+                fprintf(stderr, "smn-scan: granule must be 0 or a power of two >= 4\n");
+                return 2;
+            }
+        } else if ((strcmp(a, "-l") == 0 || strcmp(a, "--label") == 0) && has) {
+            label = argv[++i];
+        } else if (na < 2 && parse_hex(a, &addr[0][na]) == 0) {
+            na++;
+        } else {
+            smnscan_usage();
+            return 2;
+        }
+    }
+    if (na != 2 || addr[0][1] < addr[0][0]) {
+        smnscan_usage();
+        return 2;
+    }
+    if (o.fmt == SMN_FMT_BIN && !path) {
+        fprintf(stderr, "smn-scan: bin output needs -o FILE\n");
+        return 2;
+    }
+    return smn_scan_to(&o, addr, 1, label, path) == 0 ? 0 : 1;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  SMN Snapshot / Diff: smn-snap, smn-diff                                   */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+#define SMN_SNAP_MAX_RANGES 64
+#define SMN_DIFF_MAX_SNAPS  8
+
+static void smnsnap_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool smn-snap [options] -o FILE START-END [START-END ...]\n"
+        "  Captures SMN ranges (hex, END inclusive) into one binary dump for smn-diff.\n"
+        "  -o, --output FILE    snapshot file (required)\n"
+        "  -l, --label TEXT     label stored in the header, e.g. idle or load\n"
+        "  -g, --granule HEX    hole-skip granularity (default 0x%X); 0 reads every word\n",
+        SMN_SCAN_GRANULE);
+}
+
+static int smnsnap_command(int argc, char **argv)
+{
+    smn_scan_opts_t o = { 0, 0, SMN_SCAN_GRANULE, SMN_FMT_BIN, NULL };
+    uint32_t range[SMN_SNAP_MAX_RANGES][2];
+    const char *path = NULL, *label = NULL;
+    unsigned int n = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has = i + 1 < argc;
+        char lo[32];
+        const char *dash;
+
+        if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && has) {
+            path = argv[++i];
+        } else if ((strcmp(a, "-l") == 0 || strcmp(a, "--label") == 0) && has) {
+            label = argv[++i];
+        } else if ((strcmp(a, "-g") == 0 || strcmp(a, "--granule") == 0) && has) {
+            if (parse_hex(argv[++i], &o.granule) != 0 ||
+                (o.granule && (o.granule < 4 || (o.granule & (o.granule - 1))))) {
+                fprintf(stderr, "smn-snap: granule must be 0 or a power of two >= 4\n");
+                return 2;
+            }
+        } else if ((dash = strchr(a, '-')) && dash != a && (size_t)(dash - a) < sizeof(lo) &&
+                   n < SMN_SNAP_MAX_RANGES) {
+            snprintf(lo, sizeof(lo), "%.*s", (int)(dash - a), a);
+            if (parse_hex(lo, &range[n][0]) != 0 || parse_hex(dash + 1, &range[n][1]) != 0 ||
+                range[n][1] < range[n][0]) {
+                fprintf(stderr, "smn-snap: bad range '%s'\n", a);
+                return 2;
+            }
+            n++;
+        } else {
+            smnsnap_usage();
+            return 2;
+        }
+    }
+    if (!path || n == 0) {
+        smnsnap_usage();
+        return 2;
+    }
+    return smn_scan_to(&o, range, n, label, path) == 0 ? 0 : 1;
+}
+
+static void smndiff_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool smn-diff [options] BASE SNAP [SNAP ...]\n"
+        "  Lists the SMN words that differ between snapshots (smn-snap) and their\n"
+        "  changed bits; every SNAP is compared against BASE. Up to %d files.\n"
+        "  Snapshots from different CPUs are refused: the same SMN address need\n"
+        "  not be the same register there.\n"
+        "  -o, --output FILE    also write the changes as CSV\n"
+        "  -q, --quiet          summary only\n"
+        "      --force          diff snapshots from different CPUs anyway\n", SMN_DIFF_MAX_SNAPS);
+}
+
+/* "0, 4-7, 31" for the set bits of m */
+static void format_bits(uint32_t m, char *buf, size_t len)
+{
+    size_t used = 0;
+
+    buf[0] = '\0';
+    for (int b = 0; b < 32 && used < len; b++) {
+        int e = b;
+
+        if (!(m & (1u << b)))
+            continue;
+        while (e + 1 < 32 && (m & (1u << (e + 1))))
+            e++;
+        used += (size_t)snprintf(buf + used, len - used, e > b ? "%s%d-%d" : "%s%d",
+                                 used ? ", " : "", b, e);
+        b = e;
+    }
+}
+
+static int smn_diff_main(int argc, char **argv)
+{
+    smn_snap_t snap[SMN_DIFF_MAX_SNAPS];
+    smn_change_t *chg[SMN_DIFF_MAX_SNAPS] = { NULL };
+    long nchg[SMN_DIFF_MAX_SNAPS] = { 0 };
+    size_t pos[SMN_DIFF_MAX_SNAPS] = { 0 };
+    const char *path[SMN_DIFF_MAX_SNAPS], *csv_path = NULL;
+    char err[512];
+    int n = 0, quiet = 0, force = 0, rc = 0;
+    unsigned long rows = 0;
+    FILE *csv = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "--force") == 0) {
+            force = 1;
+        } else if (argv[i][0] != '-' && n < SMN_DIFF_MAX_SNAPS) {
+            path[n++] = argv[i];
+        } else {
+            smndiff_usage();
+            return 2;
+        }
+    }
+    if (n < 2) {
+        smndiff_usage();
+        return 2;
+    }
+
+    for (int i = 0; i < n; i++) {
+        smu_obj_t cpu;
+        char when[32];
+        time_t t;
+
+        if (smn_snap_load(path[i], &snap[i], err, sizeof(err)) != 0) {
+            fprintf(stderr, "smn-diff: %s\n", err);
+            while (i-- > 0)
+                smn_snap_free(&snap[i]);
+            return 1;
+        }
+        memset(&cpu, 0, sizeof(cpu));
+        cpu.codename = (smu_processor_codename)snap[i].hdr.codename;
+        t = (time_t)snap[i].hdr.time;
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&t));
+        printf("  [%d] %s  \"%s\"  %s  %s fw 0x%08X  %llu words\n", i, path[i],
+               snap[i].hdr.label, when, smu_codename_to_str(&cpu), snap[i].hdr.smu_version,
+               (unsigned long long)snap[i].nwords);
+        fflush(stdout);
+        if (i && snap[i].hdr.codename != snap[0].hdr.codename) {
+            fprintf(stderr, "smn-diff: [%d] was taken on a different CPU than [0]%s\n", i,
+                    force ? "; addresses may not name the same registers" : " (--force to diff anyway)");
+            if (!force) {
+                n = i + 1;
+                rc = 1;
+                goto out;
+            }
+        } else if (i && snap[i].hdr.smu_version != snap[0].hdr.smu_version) {
+            fprintf(stderr, "smn-diff: warning: [%d] has SMU firmware 0x%08X, [0] has 0x%08X; "
+                    "some changes may come from the firmware\n",
+                    i, snap[i].hdr.smu_version, snap[0].hdr.smu_version);
+        }
+    }
+
+    for (int i = 1; i < n; i++) {
+        uint64_t compared, bits = 0;
+        double t0 = now_sec();
+
+        nchg[i] = smn_snap_diff(&snap[0], &snap[i], &chg[i], &compared);
+        if (nchg[i] < 0) {
+            fprintf(stderr, "smn-diff: out of memory\n");
+            rc = 1;
+            goto out;
+        }
+        for (long k = 0; k < nchg[i]; k++)
+            bits += (uint64_t)__builtin_popcount(chg[i][k].bits);
+        printf("  [%d] vs [0]: %llu words compared, %ld changed, %llu bit(s), %.2f ms\n", i,
+               (unsigned long long)compared, nchg[i], (unsigned long long)bits,
+               (now_sec() - t0) * 1000.0);
+    }
+
+    if (csv_path && !(csv = fopen(csv_path, "w"))) {
+        fprintf(stderr, "smn-diff: %s: %s\n", csv_path, strerror(errno));
+        rc = 1;
+        goto out;
+    }
+    if (csv) {
+        fprintf(csv, "Address");
+        for (int i = 0; i < n; i++)
+            fprintf(csv, ",%s", snap[i].hdr.label[0] ? snap[i].hdr.label : path[i]);
+        fprintf(csv, ",ChangedMask\n");
+    }
+    if (!quiet) {
+        printf("\n  Address     ");
+        for (int i = 0; i < n; i++)
+            printf("│    [%d]     ", i);
+        printf("│ Changed bits\n");
+    }
+
+    /* Merge the per-snapshot change lists into one row per address */
+    for (;;) {
+        uint32_t addr = 0, mask = 0;
+        int any = 0;
+        char bits[128];
+
+        for (int i = 1; i < n; i++) {
+            if (pos[i] < (size_t)nchg[i] && (!any || chg[i][pos[i]].addr < addr)) {
+                addr = chg[i][pos[i]].addr;
+                any = 1;
+            }
+        }
+        if (!any)
+            break;
+        for (int i = 1; i < n; i++) {
+            if (pos[i] < (size_t)nchg[i] && chg[i][pos[i]].addr == addr)
+                mask |= chg[i][pos[i]++].bits;
+        }
+        rows++;
+        format_bits(mask, bits, sizeof(bits));
+        if (!quiet)
+            printf("  0x%08X  ", addr);
+        if (csv)
+            fprintf(csv, "0x%08X", addr);
+        for (int i = 0; i < n; i++) {
+            uint32_t v = 0;
+            int have = smn_snap_get(&snap[i], addr, &v) == 0;
+
+            if (!quiet)
+                printf(have ? "│ 0x%08X " : "│     --     ", v);
+            if (csv)
+                fprintf(csv, have ? ",0x%08X" : ",", v);
+        }
+        if (!quiet)
+            printf("│ %s\n", bits);
+        if (csv)
+            fprintf(csv, ",0x%08X\n", mask);
+    }
+    printf("\n  %lu address(es) changed.\n", rows);
+
+out:
+    if (csv && fclose(csv) != 0)
+        rc = 1;
+    for (int i = 0; i < n; i++) {
+        free(chg[i]);
+        smn_snap_free(&snap[i]);
+    }
+    return rc;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  SMN Watchpoints: smn-watch [options] ADDR[/MASK][=NAME] ...               */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+/* UMC registers read by Memory Timings (show_memory_timings) */
+static const uint32_t smn_watch_umc[] = {
+    0x50050, 0x50058, 0x500D0, 0x500D4, 0x50200, 0x50204, 0x50208, 0x5020C, 0x50210,
+    0x50214, 0x50218, 0x50220, 0x50224, 0x50228, 0x50254, 0x50260, 0x50264,
+};
+
+static void smnwatch_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool smn-watch [options] ADDR[/MASK][=NAME] ...\n"
+        "  Polls the registers (hex) in one batched read per cycle and logs only\n"
+        "  changes of the masked value, as CSV: Time,Address,Name,Old,New,Changed.\n"
+        "  -i, --interval US    poll period in microseconds (default 1000; 0 = flat out)\n"
+        "  -d, --duration S     stop after S seconds (default: until Ctrl-C)\n"
+        "  -o, --output FILE    transition log (default: stdout)\n"
+        "      --umc            add the UMC registers shown by Memory Timings\n"
+        "  Up to %d registers.\n", SMN_WATCH_MAX);
+}
+
+typedef struct {
+    FILE                  *out;
+    const smn_watch_reg_t *reg;
+} smnwatch_log_t;
+
+static void smnwatch_edge(void *ctx, unsigned int i, double t, uint32_t old, uint32_t now)
+{
+    smnwatch_log_t *l = ctx;
+
+    fprintf(l->out, "%.6f,0x%08X,%s,0x%08X,0x%08X,0x%08X\n", t, l->reg[i].addr,
+            l->reg[i].name, old, now, old ^ now);
+    fflush(l->out);
+}
+
+static int smnwatch_command(int argc, char **argv)
+{
+    smn_watch_t w;
+    smn_watch_reg_t regs[SMN_WATCH_MAX];
+    uint32_t addrs[SMN_WATCH_MAX], vals[SMN_WATCH_MAX];
+    unsigned char ok[SMN_WATCH_MAX];
+    unsigned int n = 0, interval_us = 1000;
+    double duration = 0, t0, t;
+    const char *path = NULL;
+    smnwatch_log_t log;
+    struct timespec next;
+    unsigned long edges = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has = i + 1 < argc;
+
+        if ((strcmp(a, "-i") == 0 || strcmp(a, "--interval") == 0) && has) {
+            interval_us = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if ((strcmp(a, "-d") == 0 || strcmp(a, "--duration") == 0) && has) {
+            duration = atof(argv[++i]);
+        } else if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && has) {
+            path = argv[++i];
+        } else if (strcmp(a, "--umc") == 0) {
+            unsigned int v, off = 0;
+
+            /* Same channel offset as Memory Timings */
+            if (smu_read_smn_addr(&obj, 0x50200, &v) == SMU_Return_OK && v == 0x300)
+                off = 0x100000;
+            for (size_t k = 0; k < sizeof(smn_watch_umc) / sizeof(smn_watch_umc[0]); k++) {
+                if (n == SMN_WATCH_MAX)
+                    break;
+                regs[n].addr = smn_watch_umc[k] + off;
+                regs[n].mask = 0xFFFFFFFF;
+                snprintf(regs[n].name, sizeof(regs[n].name), "UMC_%05X", smn_watch_umc[k]);
+                n++;
+            }
+        } else if (a[0] != '-' && n < SMN_WATCH_MAX && smn_watch_parse(a, &regs[n]) == 0) {
+            n++;
+        } else {
+            if (a[0] != '-')
+                fprintf(stderr, "smn-watch: bad register '%s' (ADDR[/MASK][=NAME], hex, "
+                        "word-aligned)\n", a);
+            smnwatch_usage();
+            return 2;
+        }
+    }
+    if (n == 0) {
+        smnwatch_usage();
+        return 2;
+    }
+
+    log.out = path ? fopen(path, "w") : stdout;
+    if (!log.out) {
+        fprintf(stderr, "smn-watch: %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    log.reg = w.reg;
+    smn_watch_init(&w, regs, n, interval_us / 1e6);
+    for (unsigned int i = 0; i < n; i++)
+        addrs[i] = regs[i].addr;
+
+    fprintf(log.out, "Time,Address,Name,Old,New,Changed\n");
+    fprintf(stderr, "  Watching %u register(s) every %u us%s. Ctrl-C to stop.\n", n, interval_us,
+            interval_us ? "" : " (flat out)");
+
+    g_running = 1;
+    t0 = now_sec();
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (g_running) {
+        if (smn_read_many(0, 0, addrs, n, vals, ok) < 0) {
+            fprintf(stderr, "smn-watch: SMN access failed\n");
+            break;
+        }
+        t = now_sec() - t0;
+        edges += smn_watch_sample(&w, t, vals, ok, smnwatch_edge, &log);
+        if (duration > 0 && t >= duration)
+            break;
+        if (!interval_us)
+            continue;
+        /* Absolute deadlines; after an overrun, resync rather than burst */
+        next.tv_nsec += (long)interval_us * 1000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        {
+            struct timespec now;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec > next.tv_sec ||
+                (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+                next = now;
+            else
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+    }
+    g_running = 1;
+    if (path && fclose(log.out) != 0)
+        fprintf(stderr, "smn-watch: error writing %s\n", path);
+
+    fprintf(stderr, "\n  %lu cycle(s) in %.2f s: %.0f Hz achieved", w.cycles,
+            w.t_last - w.t_first, smn_watch_rate(&w));
+    if (w.cycles > 1)
+        fprintf(stderr, ", gap mean %.1f us, max %.1f us",
+                w.gap_sum / (w.cycles - 1) * 1e6, w.gap_max * 1e6);
+    if (interval_us)
+        fprintf(stderr, ", %lu missed interval(s) (%.2f%%)", w.missed,
+                w.cycles ? 100.0 * w.missed / (w.cycles + w.missed) : 0.0);
+    fprintf(stderr, "\n  %lu transition(s)\n", edges);
+    for (unsigned int i = 0; i < n; i++) {
+        if (w.st[i].edges || w.st[i].errors)
+            fprintf(stderr, "    0x%08X %-12s %lu edge(s), %lu read error(s)\n",
+                    w.reg[i].addr, w.reg[i].name, w.st[i].edges, w.st[i].errors);
+    }
+    return 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Curve Optimizer Auto-Tune: co-tune [options]                              */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+#define COTUNE_DEFAULT_STATE    "smu_cotune.state"
+#define COTUNE_DEFAULT_PROFILE  "smu_co.profile"
+
+static void cotune_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool co-tune [options]\n"
+        "  -t, --test MS        validation per search step (default 30000)\n"
+        "      --confirm MS     validation of the final margin (default 2 x test)\n"
+        "      --min M          most negative margin to try (default %d)\n"
+        "      --step N         search granularity (default 1)\n"
+        "      --backoff N      added to the most negative pass (default 2)\n"
+        "      --cores LIST     cores to tune, e.g. 0-3,8 (default all)\n"
+        "  -j, --parallel N     CCDs tested at once (default: all)\n"
+        "      --smt            load every SMT thread of the core\n"
+        "      --assume-orig M  original margin where CO GET fails (default: refuse)\n"
+        "  -s, --state FILE     checkpoint for resuming (default " COTUNE_DEFAULT_STATE ")\n"
+        "      --no-state       do not checkpoint\n"
+        "      --fresh          ignore an existing checkpoint\n"
+        "  -p, --profile FILE   tuned profile (default " COTUNE_DEFAULT_PROFILE ")\n"
+        "      --apply          leave the tuned margins applied\n"
+        "  -o, --output FILE    write the JSON report to FILE (default: stdout)\n"
+        "  -q, --quiet          no progress on stderr\n", g_plat->co_min);
+}
+
+/* "0-3,8" -> bit mask; -1 on a malformed list. */
+static int parse_core_list(const char *s, unsigned long long *mask)
+{
+    *mask = 0;
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10), b = a;
+
+        if (end == s || a < 0 || a >= CO_TUNE_MAX_CORES)
+            return -1;
+        s = end;
+        if (*s == '-') {
+            b = strtol(s + 1, &end, 10);
+            if (end == s + 1 || b < a || b >= CO_TUNE_MAX_CORES)
+                return -1;
+            s = end;
+        }
+        for (long c = a; c <= b; c++)
+            *mask |= 1ULL << c;
+        if (*s == ',')
+            s++;
+        else if (*s)
+            return -1;
+    }
+    return *mask ? 0 : -1;
+}
+
+static int cotune_set_co(void *ctx, int core, int margin)
+{
+    (void)ctx;
+    return smu_set_curve_optimizer(core, margin);
+}
+
+static int cotune_get_co(void *ctx, int core, int *margin)
+{
+    (void)ctx;
+    return smu_get_curve_optimizer(core, margin);
+}
+
+static void cotune_log(void *ctx, const char *line)
+{
+    (void)ctx;
+    fprintf(stderr, "\r\033[K  %s\n", line);
+}
+
+static void cotune_progress(void *ctx, const char *status)
+{
+    (void)ctx;
+    fprintf(stderr, "\r\033[K  %.*s", 150, status);
+}
+
+static const char *cotune_status_name(co_tune_status_t st)
+{
+    return st == CO_TUNE_DONE ? "Tuned" : st == CO_TUNE_SKIPPED ? "Skipped" : "Pending";
+}
+
+static int cotune_command(int argc, char **argv)
+{
+    co_tune_opts_t co;
+    co_tune_result_t *res;
+    pm_rank_topo_t topo;
+    const pm_schema_t *sch = NULL;
+    pbo_profile_t prof;
+    const char *out_path = NULL, *profile = COTUNE_DEFAULT_PROFILE;
+    unsigned int ccds = 0, ccxs = 0, cpc = 0, phys = 0;
+    int quiet = 0, apply = 0, applied = 0, rc, slots[PM_RANK_MAX_CORES];
+    const int *slot;
+    struct sigaction sa, sa_int;
+    FILE *fp;
+
+    memset(&co, 0, sizeof(co));
+    co.margin_min = g_plat->co_min;
+    co.backoff = 2;
+    co.state_path = COTUNE_DEFAULT_STATE;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has_val = i + 1 < argc;
+
+        if ((strcmp(a, "-t") == 0 || strcmp(a, "--test") == 0) && has_val)
+            co.test_ms = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--confirm") == 0 && has_val)
+            co.confirm_ms = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--min") == 0 && has_val)
+            co.margin_min = atoi(argv[++i]);
+        else if (strcmp(a, "--step") == 0 && has_val)
+            co.step = atoi(argv[++i]);
+        else if (strcmp(a, "--backoff") == 0 && has_val)
+            co.backoff = atoi(argv[++i]);
+        else if (strcmp(a, "--cores") == 0 && has_val) {
+            if (parse_core_list(argv[++i], &co.select) != 0) {
+                fprintf(stderr, "co-tune: bad core list '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if ((strcmp(a, "-j") == 0 || strcmp(a, "--parallel") == 0) && has_val)
+            co.lanes = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--smt") == 0)
+            co.smt = 1;
+        else if (strcmp(a, "--assume-orig") == 0 && has_val) {
+            co.assume_orig = 1;
+            co.orig_margin = atoi(argv[++i]);
+        } else if ((strcmp(a, "-s") == 0 || strcmp(a, "--state") == 0) && has_val)
+            co.state_path = argv[++i];
+        else if (strcmp(a, "--no-state") == 0)
+            co.state_path = NULL;
+        else if (strcmp(a, "--fresh") == 0)
+            co.fresh = 1;
+        else if ((strcmp(a, "-p") == 0 || strcmp(a, "--profile") == 0) && has_val)
+            profile = argv[++i];
+        else if (strcmp(a, "--apply") == 0)
+            apply = 1;
+        else if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && has_val)
+            out_path = argv[++i];
+        else if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0)
+            quiet = 1;
+        else {
+            cotune_usage();
+            return 2;
+        }
+    }
+    if (!g_plat->psm_set) {
+        fprintf(stderr, "co-tune: %s has no Curve Optimizer.\n", g_plat->family);
+        return 1;
+    }
+    if (co.margin_min < g_plat->co_min)
+        co.margin_min = g_plat->co_min;
+    if (co.margin_min > 0 || co.backoff < 0 ||
+        (co.assume_orig && (co.orig_margin < g_plat->co_min || co.orig_margin > g_plat->co_max))) {
+        cotune_usage();
+        return 2;
+    }
+
+    if (get_topology(&ccds, &ccxs, &cpc, &phys) != 0 || phys == 0 ||
+        pm_rank_topology(&topo, phys) == 0) {
+        fprintf(stderr, "co-tune: cannot read the core topology.\n");
+        return 1;
+    }
+    /* Logical core -> slot for the CO mask and the PM arrays */
+    slot = online_slots("co-tune", slots, PM_RANK_MAX_CORES, topo.nfound);
+    if (slot)
+        memcpy(topo.slot, slot, topo.ncores * sizeof(slot[0]));
+    /* PM data only sharpens the checks (clock stretch); tuning works without it */
+    if (smu_pm_tables_supported(&obj))
+        sch = smu_pm_schema();
+
+    res = calloc(1, sizeof(*res));
+    if (!res)
+        return 1;
+    co.schema = pm_core_fields("co-tune", sch, "clock-stretch checks are off") ? sch : NULL;
+    co.table_size = obj.pm_table_size;
+    co.version = obj.pm_table_version;
+    co.topo = &topo;
+    co.ncores = topo.ncores;
+    co.group_cores = ccds > 1 ? (slot ? 8 : topo.ncores / ccds) : 0;
+    co.set_co = cotune_set_co;
+    co.get_co = cotune_get_co;
+    co.read_pm = co.schema ? infer_read_pm : NULL;
+    co.log = cotune_log;
+    co.progress = quiet ? NULL : cotune_progress;
+    co.running = &g_running;
+
+    fprintf(stderr, "co-tune: %u cores, %u CCD(s); searching CO down to %d. Unstable steps can "
+            "crash or reboot the machine;\n  rerun the same command afterwards to resume.\n",
+            co.ncores, ccds ? ccds : 1, co.margin_min);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = run_sigint_handler;
+    sigaction(SIGINT, &sa, &sa_int);
+    g_running = 1;
+    rc = co_tune_run(&co, res);
+    sigaction(SIGINT, &sa_int, NULL);
+    g_running = 1;
+    if (!quiet)
+        fputs("\r\033[K", stderr);
+
+    if (res->orig_unknown && !co.assume_orig) {
+        fprintf(stderr, "co-tune: CO GET failed on this platform, so there is no original margin "
+                "to revert to.\n  Refusing to tune; pass --assume-orig M with the BIOS margin "
+                "(0 if unchanged).\n");
+        free(res);
+        return 1;
+    }
+    if (res->orig_unknown)
+        fprintf(stderr, "co-tune: CO GET failed on this platform; original margins assumed %+d.\n",
+                co.orig_margin);
+    if (!res->reverted)
+        fprintf(stderr, "co-tune: WARNING: not every core could be put back on its original "
+                "margin.\n");
+    if (rc == -2) {
+        fprintf(stderr, "co-tune: interrupted; margins restored");
+        if (co.state_path)
+            fprintf(stderr, ", run again to resume from %s", co.state_path);
+        fputc('\n', stderr);
+        free(res);
+        return 130;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "co-tune: tuning failed (CO set or checkpoint %s).\n",
+                co.state_path ? co.state_path : "-");
+        free(res);
+        return 1;
+    }
+
+    fprintf(stderr, "── co-tune ──\n  %4s %8s %6s %10s %10s %6s %6s  %s\n", "Core", "Original",
+            "Tuned", "Base MHz", "Tuned MHz", "Tests", "Fails", "Status");
+    for (unsigned int c = 0; c < co.ncores; c++) {
+        const co_tune_core_t *k = &res->core[c];
+
+        if (co.select && !(co.select & (1ULL << c)))
+            continue;
+        fprintf(stderr, "  %4u %+8d %+6d ", c, k->orig, k->final);
+        if (isnan(k->baseline_mhz))
+            fprintf(stderr, "%10s ", "-");
+        else
+            fprintf(stderr, "%10.0f ", k->baseline_mhz);
+        if (isnan(k->final_mhz))
+            fprintf(stderr, "%10s ", "-");
+        else
+            fprintf(stderr, "%10.0f ", k->final_mhz);
+        fprintf(stderr, "%6u %6u  %s%s%s\n", k->tests, k->fails, cotune_status_name(k->status),
+                k->last_fail[0] ? ", last fail: " : "", k->last_fail);
+    }
+    co_tune_profile(&co, res, &prof);
+    if (profile) {
+        char header[96];
+        snprintf(header, sizeof(header), "smu_debug_tool co-tune, %s, table v0x%06X",
+                 smu_codename_to_str(&obj), obj.pm_table_version);
+        if (pbo_profile_save(profile, &prof, header) == 0)
+            fprintf(stderr, "  Profile: %s\n", profile);
+        else
+            fprintf(stderr, "co-tune: cannot write %s: %s\n", profile, strerror(errno));
+    }
+    if (apply && prof.co_mask) {
+        pbo_apply_result_t ar;
+        rc = pbo_apply(smu_pbo_ops(), &prof, 0, &ar);
+        applied = rc == 0;
+        print_pbo_apply("co-tune", rc, &ar, 0, 0);
+    }
+
+    fp = out_path ? fopen(out_path, "w") : stdout;
+    if (!fp) {
+        fprintf(stderr, "co-tune: cannot write %s: %s\n", out_path, strerror(errno));
+        free(res);
+        return 1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"ToolVersion\": \"%s\",\n", TOOL_VERSION);
+    fprintf(fp, "  \"CpuName\": \"%s\",\n", get_processor_name());
+    fprintf(fp, "  \"Codename\": \"%s\",\n", smu_codename_to_str(&obj));
+    fprintf(fp, "  \"PmTableVersion\": \"0x%06X\",\n", obj.pm_table_version);
+    fprintf(fp, "  \"TestMs\": %u,\n  \"ConfirmMs\": %u,\n",
+            co.test_ms ? co.test_ms : 30000,
+            co.confirm_ms ? co.confirm_ms : 2 * (co.test_ms ? co.test_ms : 30000));
+    fprintf(fp, "  \"MarginMin\": %d,\n  \"Step\": %d,\n  \"Backoff\": %d,\n  \"Smt\": %s,\n",
+            co.margin_min, co.step > 0 ? co.step : 1, co.backoff, co.smt ? "true" : "false");
+    fprintf(fp, "  \"OriginalKnown\": %s,\n  \"Reverted\": %s,\n  \"Applied\": %s,\n",
+            res->orig_unknown ? "false" : "true", res->reverted ? "true" : "false",
+            applied ? "true" : "false");
+    fprintf(fp, "  \"Profile\": ");
+    if (profile)
+        json_str(fp, profile);
+    else
+        fputs("null", fp);
+    fprintf(fp, ",\n  \"Cores\": [");
+    for (unsigned int c = 0, n = 0; c < co.ncores; c++) {
+        const co_tune_core_t *k = &res->core[c];
+
+        if (co.select && !(co.select & (1ULL << c)))
+            continue;
+        fprintf(fp, "%s\n    { \"Core\": %u, \"Slot\": %d, \"Status\": \"%s\", \"Original\": %d, "
+                "\"Tuned\": %d, \"MostNegativePass\": %d, \"LeastNegativeFail\": ",
+                n++ ? "," : "", c, topo.slot[c], cotune_status_name(k->status), k->orig, k->final,
+                k->good);
+        if (k->bad >= co.margin_min)
+            fprintf(fp, "%d", k->bad);
+        else
+            fputs("null", fp);
+        fputs(", \"BaselineMHz\": ", fp);
+        json_num(fp, k->baseline_mhz, 1);
+        fputs(", \"TunedMHz\": ", fp);
+        json_num(fp, k->final_mhz, 1);
+        fprintf(fp, ", \"Tests\": %u, \"Fails\": %u, \"LastFail\": ", k->tests, k->fails);
+        if (k->last_fail[0])
+            json_str(fp, k->last_fail);
+        else
+            fputs("null", fp);
+        fputs(" }", fp);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    if (out_path)
+        fclose(fp);
+    else
+        fflush(fp);
+    free(res);
+    return 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Boost Governor: govern [options]                                          */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+#define GOVERN_DEFAULT_INTERVAL_MS  100
+
+static void govern_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool govern [options]\n"
+        "  -l, --law pid|rules  control law (default pid)\n"
+        "  -r, --rules FILE     rule table for the rules law (default: built-in)\n"
+        "      --min MHz        lowest boost limit (default: max - 500)\n"
+        "      --max MHz        highest boost limit (default: current FMax)\n"
+        "      --target PCT     PID: headroom to hold (default 5)\n"
+        "      --kp K --ki K --kd K   PID gains (default 10, 20, 0)\n"
+        "      --hysteresis MHz no write for smaller changes (default 50)\n"
+        "      --max-step MHz   largest change per write (default 200)\n"
+        "      --min-write MS   at most one FMax write per MS (default 500)\n"
+        "      --no-idle-max    hold the limit when idle instead of raising it\n"
+        "  -i, --interval MS    sample period (default %d)\n"
+        "  -d, --duration S     stop after S seconds (default: until Ctrl-C/SIGTERM)\n"
+        "  -o, --log FILE       decision log (CSV)\n"
+        "      --log-all        log every sample, not only decisions\n"
+        "  -n, --dry-run        decide and log, never write FMax\n"
+        "      --keep           leave the last FMax on exit (default: restore)\n"
+        "  -q, --quiet          no status line\n", GOVERN_DEFAULT_INTERVAL_MS);
+}
+
+static void govern_csv_num(FILE *fp, float v, int prec)
+{
+    if (!isnan(v))
+        fprintf(fp, "%.*f", prec, v);
+}
+
+static int govern_command(int argc, char **argv)
+{
+    pm_gov_config_t cfg;
+    pm_gov_t gov;
+    pm_limiter_t lim;
+    const pm_schema_t *sch = NULL;
+    const char *rules_path = NULL, *log_path = NULL;
+    unsigned int interval = GOVERN_DEFAULT_INTERVAL_MS, cores = 0, start_mhz = 0;
+    unsigned int min_mhz = 0, max_mhz = 0, duration = 0;
+    int slots[PM_MAX_CORES];
+    int law = PM_GOV_PID, log_all = 0, dry = 0, keep = 0, quiet = 0, idle_max = 1;
+    float target = NAN, kp = NAN, ki = NAN, kd = NAN;
+    long hyst = -1, max_step = -1, min_write = -1;
+    struct sigaction sa, sa_int, sa_term;
+    struct timespec next;
+    double t0, t_prev = 0, last_status = 0, loaded_s = 0, limited_s = 0, clk_s = 0;
+    double fmax_s = 0, run_s = 0;
+    unsigned long failed = 0;
+    FILE *log = NULL;
+    void *pm_buf;
+    char err[256];
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has_val = i + 1 < argc;
+
+        if ((strcmp(a, "-l") == 0 || strcmp(a, "--law") == 0) && has_val) {
+            a = argv[++i];
+            if (strcmp(a, "pid") == 0)
+                law = PM_GOV_PID;
+            else if (strcmp(a, "rules") == 0)
+                law = PM_GOV_RULES;
+            else {
+                govern_usage();
+                return 2;
+            }
+        } else if ((strcmp(a, "-r") == 0 || strcmp(a, "--rules") == 0) && has_val) {
+            rules_path = argv[++i];
+            law = PM_GOV_RULES;
+        } else if (strcmp(a, "--min") == 0 && has_val)
+            min_mhz = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--max") == 0 && has_val)
+            max_mhz = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--target") == 0 && has_val)
+            target = strtof(argv[++i], NULL);
+        else if (strcmp(a, "--kp") == 0 && has_val)
+            kp = strtof(argv[++i], NULL);
+        else if (strcmp(a, "--ki") == 0 && has_val)
+            ki = strtof(argv[++i], NULL);
+        else if (strcmp(a, "--kd") == 0 && has_val)
+            kd = strtof(argv[++i], NULL);
+        else if (strcmp(a, "--hysteresis") == 0 && has_val)
+            hyst = atol(argv[++i]);
+        else if (strcmp(a, "--max-step") == 0 && has_val)
+            max_step = atol(argv[++i]);
+        else if (strcmp(a, "--min-write") == 0 && has_val)
+            min_write = atol(argv[++i]);
+        else if (strcmp(a, "--no-idle-max") == 0)
+            idle_max = 0;
+        else if ((strcmp(a, "-i") == 0 || strcmp(a, "--interval") == 0) && has_val)
+            interval = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-d") == 0 || strcmp(a, "--duration") == 0) && has_val)
+            duration = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-o") == 0 || strcmp(a, "--log") == 0) && has_val)
+            log_path = argv[++i];
+        else if (strcmp(a, "--log-all") == 0)
+            log_all = 1;
+        else if (strcmp(a, "-n") == 0 || strcmp(a, "--dry-run") == 0)
+            dry = 1;
+        else if (strcmp(a, "--keep") == 0)
+            keep = 1;
+        else if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0)
+            quiet = 1;
+        else {
+            govern_usage();
+            return 2;
+        }
+    }
+    if (interval < 10)
+        interval = 10;
+
+    pm_buf = run_prepare("govern", &sch, &cores);
+    if (!pm_buf)
+        return 1;
+    if (!sch) {
+        free(pm_buf);
+        return 1;
+    }
+    pm_core_fields("govern", sch, "active/clock stay empty and the idle boost is off");
+    if (smu_get_fmax(&start_mhz) != 0 || start_mhz == 0) {
+        fprintf(stderr, "govern: cannot read the current FMax.\n");
+        free(pm_buf);
+        return 1;
+    }
+    if (!max_mhz)
+        max_mhz = start_mhz;
+    if (!min_mhz)
+        min_mhz = max_mhz > 900 ? max_mhz - 500 : 400;
+    if (min_mhz >= max_mhz || max_mhz > g_plat->fmax_max_mhz) {
+        fprintf(stderr, "govern: need --min < --max <= %u MHz (got %u, %u).\n", g_plat->fmax_max_mhz,
+                min_mhz, max_mhz);
+        free(pm_buf);
+        return 2;
+    }
+
+    pm_gov_defaults(&cfg, min_mhz, max_mhz);
+    cfg.law = (pm_gov_law_t)law;
+    cfg.idle_max = idle_max;
+    if (!isnan(target))
+        cfg.target_headroom = target;
+    if (!isnan(kp))
+        cfg.kp = kp;
+    if (!isnan(ki))
+        cfg.ki = ki;
+    if (!isnan(kd))
+        cfg.kd = kd;
+    if (hyst >= 0)
+        cfg.hysteresis_mhz = (unsigned)hyst;
+    if (max_step >= 0)
+        cfg.max_step_mhz = (unsigned)max_step;
+    if (min_write >= 0)
+        cfg.min_write_ms = (unsigned)min_write;
+    if (law == PM_GOV_RULES) {
+        if (rules_path && pm_gov_load_rules(rules_path, &cfg, err, sizeof(err)) != 0) {
+            fprintf(stderr, "govern: %s\n", err);
+            free(pm_buf);
+            return 2;
+        }
+        if (!rules_path)
+            pm_gov_default_rules(&cfg);
+    }
+    pm_limiter_init(&lim, sch, cores, pm_slots("govern", slots, cores));
+    if (!(lim.avail & ((1u << PM_LIM_PPT) | (1u << PM_LIM_TDC) | (1u << PM_LIM_EDC) |
+                       (1u << PM_LIM_THM)))) {
+        fprintf(stderr, "govern: the PM layout has no PPT/TDC/EDC/THM fields.\n");
+        free(pm_buf);
+        return 1;
+    }
+    pm_gov_init(&gov, &cfg, start_mhz);
+
+    if (log_path) {
+        log = fopen(log_path, "w");
+        if (!log) {
+            fprintf(stderr, "govern: cannot write %s: %s\n", log_path, strerror(errno));
+            free(pm_buf);
+            return 1;
+        }
+        fprintf(log, "# smu_debug_tool govern: law %s, %u-%u MHz, hysteresis %u, max step %u, "
+                "min write %u ms%s\n", law == PM_GOV_PID ? "pid" : "rules", min_mhz, max_mhz,
+                cfg.hysteresis_mhz, cfg.max_step_mhz, cfg.min_write_ms, dry ? ", dry run" : "");
+        fprintf(log, "Time,FmaxMHz,ProposedMHz,Written,Reason,Rule,HeadroomPct,PptPct,TdcPct,EdcPct,"
+                "ThmPct,ThmMarginC,Active,LoadPct,ClockMHz,Limiter\n");
+    }
+
+    fprintf(stderr, "govern: %s law, FMax %u-%u MHz (was %u)%s. Ctrl-C or SIGTERM stops and "
+            "%s.\n", law == PM_GOV_PID ? "PID" : "rule-table", min_mhz, max_mhz, start_mhz,
+            dry ? ", dry run" : "", keep ? "keeps the last FMax" : "restores the original");
+    if (law == PM_GOV_RULES && !quiet) {
+        for (unsigned int i = 0; i < cfg.nrules; i++) {
+            char buf[64];
+            pm_gov_rule_format(&cfg.rules[i], buf, sizeof(buf));
+            fprintf(stderr, "  rule %u: %s\n", i, buf);
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = run_sigint_handler;
+    sigaction(SIGINT, &sa, &sa_int);
+    sigaction(SIGTERM, &sa, &sa_term);
+    g_running = 1;
+    t0 = now_sec();
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (g_running && (!duration || now_sec() - t0 < duration)) {
+        pm_gov_inputs_t in;
+        pm_gov_decision_t d;
+        double t;
+        int wrote = 0;
+
+        sleep_period(&next, interval);
+        if (smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) != SMU_Return_OK)
+            continue;
+        t = now_sec() - t0;
+        pm_gov_inputs(&lim, pm_buf, &in);
+
+        /* Account the interval that just ended at the limit it ran with */
+        if (t_prev > 0) {
+            double dt = t - t_prev;
+            run_s += dt;
+            fmax_s += dt * gov.applied_mhz;
+            if (in.m[PM_GOV_M_ACTIVE] > 0) {
+                loaded_s += dt;
+                if (!isnan(in.m[PM_GOV_M_CLOCK]))
+                    clk_s += dt * in.m[PM_GOV_M_CLOCK];
+                if (in.primary < PM_LIM_COUNT)
+                    limited_s += dt;
+            }
+        }
+        t_prev = t;
+
+        pm_gov_step(&gov, t, &in, &d);
+        if (d.write) {
+            if (dry || smu_set_fmax(d.target) == 0) {
+                pm_gov_committed(&gov, t, d.target);
+                wrote = 1;
+            } else {
+                failed++;
+            }
+        }
+        if (log && (log_all || d.write || d.proposed != gov.applied_mhz)) {
+            fprintf(log, "%.3f,%u,%u,%d,%s,", t, gov.applied_mhz, d.proposed, wrote,
+                    d.write && !wrote ? "write failed" : d.reason);
+            if (d.rule >= 0)
+                fprintf(log, "%d", d.rule);
+            fputc(',', log);
+            govern_csv_num(log, in.m[PM_GOV_M_HEADROOM], 2);
+            for (int m = PM_GOV_M_PPT; m <= PM_GOV_M_THM_MARGIN; m++) {
+                fputc(',', log);
+                govern_csv_num(log, in.m[m], m == PM_GOV_M_THM_MARGIN ? 2 : 1);
+            }
+            fputc(',', log);
+            govern_csv_num(log, in.m[PM_GOV_M_ACTIVE], 0);
+            fputc(',', log);
+            govern_csv_num(log, in.m[PM_GOV_M_LOAD], 1);
+            fputc(',', log);
+            govern_csv_num(log, in.m[PM_GOV_M_CLOCK], 0);
+            fprintf(log, ",%s\n", pm_limiter_class_name(in.primary));
+        }
+        if (!quiet && t - last_status >= 1.0) {
+            fprintf(stderr, "\r\033[K  FMax %4u (%4u)  headroom %5.1f%% %-7s  active %2.0f",
+                    gov.applied_mhz, d.proposed, in.m[PM_GOV_M_HEADROOM],
+                    pm_limiter_class_name(in.primary), in.m[PM_GOV_M_ACTIVE]);
+            if (!isnan(in.m[PM_GOV_M_CLOCK]))
+                fprintf(stderr, " @ %4.0f MHz", in.m[PM_GOV_M_CLOCK]);
+            fprintf(stderr, "  writes %lu", gov.writes);
+            last_status = t;
+        }
+    }
+    sigaction(SIGINT, &sa_int, NULL);
+    sigaction(SIGTERM, &sa_term, NULL);
+    g_running = 1;
+    if (!quiet)
+        fputs("\r\033[K", stderr);
+
+    if (!keep && !dry && gov.applied_mhz != start_mhz) {
+        if (smu_set_fmax(start_mhz) == 0)
+            fprintf(stderr, "govern: FMax restored to %u MHz.\n", start_mhz);
+        else
+            fprintf(stderr, "govern: WARNING: could not restore FMax to %u MHz.\n", start_mhz);
+    }
+    fprintf(stderr, "── govern: %.0f s ──\n", run_s);
+    fprintf(stderr, "  FMax writes:  %lu%s (%.1f/min)", gov.writes, dry ? " (dry run)" : "",
+            run_s > 0 ? gov.writes * 60.0 / run_s : 0.0);
+    if (failed)
+        fprintf(stderr, ", %lu failed", failed);
+    fputc('\n', stderr);
+    if (run_s > 0)
+        fprintf(stderr, "  Mean FMax:    %.0f MHz\n", fmax_s / run_s);
+    if (loaded_s > 0)
+        fprintf(stderr, "  Under load:   %.0f s, mean clock %.0f MHz, limit-bound %.0f%%\n",
+                loaded_s, clk_s / loaded_s, limited_s * 100.0 / loaded_s);
+    if (log)
+        fclose(log);
+    free(pm_buf);
+    return failed ? 1 : 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Safety Watchdog: watchdog [options] [PROFILE]                             */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+#define WATCHDOG_DEFAULT_INTERVAL_MS  50
+
+static void watchdog_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool watchdog [options] [PROFILE]\n"
+        "  Records the current CO, FMax and PBO limits, applies PROFILE (if given), then\n"
+        "  restores the recorded values as soon as a check trips.\n"
+        "  Checks, VALUE[:MS] (past VALUE for MS ms) or 'off':\n"
+        "      --temp C         THM temperature (default 95:1000)\n"
+        "      --core-temp C    hottest core\n"
+        "      --prochot MS     PROCHOT asserted (default 0)\n"
+        "      --vcore V        core rail telemetry voltage\n"
+        "      --core-volt V    highest per-core voltage\n"
+        "      --ppt PCT --tdc PCT --edc PCT   use as %% of limit\n"
+        "  Options:\n"
+        "      --safe FILE      restore this profile instead of the recorded values\n"
+        "      --save FILE      write the recorded values as a profile\n"
+        "  -i, --interval MS    sample period (default %d)\n"
+        "  -d, --duration S     stop after S seconds (default: until Ctrl-C/SIGTERM)\n"
+        "  -o, --log FILE       append events to FILE (CSV)\n"
+        "  -n, --dry-run        detect and log, never restore\n"
+        "  -q, --quiet          no status line\n", WATCHDOG_DEFAULT_INTERVAL_MS);
+}
+
+static void watchdog_log(FILE *log, double t, const char *event, int k, float value,
+                         const pm_wd_config_t *cfg, const char *detail)
+{
+    if (!log)
+        return;
+    fprintf(log, "%.3f,%s,", t, event);
+    if (k >= 0) {
+        fprintf(log, "%s,", pm_wd_check_name((pm_wd_check_t)k));
+        if (!isnan(value))
+            fprintf(log, "%.3f", value);
+        fprintf(log, ",%g,%u", cfg->rule[k].threshold, cfg->rule[k].persist_ms);
+    } else {
+        fputs(",,,", log);
+    }
+    fprintf(log, ",%s\n", detail ? detail : "");
+    fflush(log);
+}
+
+static int watchdog_command(int argc, char **argv)
+{
+    static const struct { const char *opt; pm_wd_check_t k; } check_opts[] = {
+        { "--temp", PM_WD_TEMP },   { "--core-temp", PM_WD_CORE_TEMP },
+        { "--prochot", PM_WD_PROCHOT }, { "--vcore", PM_WD_VCORE },
+        { "--core-volt", PM_WD_CORE_VOLT }, { "--ppt", PM_WD_PPT },
+        { "--tdc", PM_WD_TDC },     { "--edc", PM_WD_EDC },
+    };
+    const pbo_ops_t *ops = smu_pbo_ops();
+    const pm_schema_t *sch = NULL;
+    const char *profile_path = NULL, *safe_path = NULL, *save_path = NULL, *log_path = NULL;
+    unsigned int interval = WATCHDOG_DEFAULT_INTERVAL_MS, duration = 0, cores = 0;
+    int dry = 0, quiet = 0, rc = 0, slots[PM_MAX_CORES];
+    pm_wd_config_t cfg;
+    pm_wd_t wd;
+    pbo_profile_t safe, tuned;
+    pbo_apply_result_t ar;
+    struct sigaction sa, sa_int, sa_term;
+    struct timespec next;
+    double t0, last_status = 0;
+    unsigned long samples = 0;
+    FILE *log = NULL;
+    void *pm_buf;
+    char err[256];
+
+    pm_wd_defaults(&cfg);
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        int has_val = i + 1 < argc, matched = 0;
+
+        for (size_t c = 0; c < sizeof(check_opts) / sizeof(check_opts[0]); c++) {
+            pm_wd_rule_t *r = &cfg.rule[check_opts[c].k];
+
+            if (strcmp(a, check_opts[c].opt) != 0)
+                continue;
+            matched = 1;
+            if (!has_val) {
+                watchdog_usage();
+                return 2;
+            }
+            a = argv[++i];
+            if (strcmp(a, "off") == 0) {
+                r->enabled = 0;
+            } else if (pm_wd_parse_rule(check_opts[c].k, a, r) != 0) {
+                fprintf(stderr, "watchdog: bad %s '%s'\n", check_opts[c].opt, a);
+                return 2;
+            }
+        }
+        if (matched)
+            continue;
+        if (strcmp(a, "--safe") == 0 && has_val)
+            safe_path = argv[++i];
+        else if (strcmp(a, "--save") == 0 && has_val)
+            save_path = argv[++i];
+        else if ((strcmp(a, "-i") == 0 || strcmp(a, "--interval") == 0) && has_val)
+            interval = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-d") == 0 || strcmp(a, "--duration") == 0) && has_val)
+            duration = (unsigned)atoi(argv[++i]);
+        else if ((strcmp(a, "-o") == 0 || strcmp(a, "--log") == 0) && has_val)
+            log_path = argv[++i];
+        else if (strcmp(a, "-n") == 0 || strcmp(a, "--dry-run") == 0)
+            dry = 1;
+        else if (strcmp(a, "-q") == 0 || strcmp(a, "--quiet") == 0)
+            quiet = 1;
+        else if (a[0] != '-' && !profile_path)
+            profile_path = a;
+        else {
+            watchdog_usage();
+            return 2;
+        }
+    }
+    if (interval < 5)
+        interval = 5;
+    if (profile_path && pbo_profile_load(profile_path, &tuned, err, sizeof(err)) != 0) {
+        fprintf(stderr, "watchdog: %s\n", err);
+        return 2;
+    }
+    if (safe_path && pbo_profile_load(safe_path, &safe, err, sizeof(err)) != 0) {
+        fprintf(stderr, "watchdog: %s\n", err);
+        return 2;
+    }
+    if ((profile_path && !profile_fits("watchdog", profile_path, &tuned)) ||
+        (safe_path && !profile_fits("watchdog", safe_path, &safe)))
+        return 2;
+    if (ops->ncores == 0) {
+        fprintf(stderr, "watchdog: cannot read the core topology.\n");
+        return 1;
+    }
+
+    pm_buf = run_prepare("watchdog", &sch, &cores);
+    if (!pm_buf)
+        return 1;
+    pm_wd_init(&wd, &cfg, sch, cores, pm_slots("watchdog", slots, cores));
+    for (int k = 0; k < PM_WD_COUNT; k++) {
+        if (cfg.rule[k].enabled && !(wd.avail & (1u << k)))
+            fprintf(stderr, "watchdog: the PM layout has no reading for %s; check disabled.\n",
+                    pm_wd_check_name((pm_wd_check_t)k));
+    }
+    if (!wd.avail) {
+        fprintf(stderr, "watchdog: no check can run on this PM layout.\n");
+        free(pm_buf);
+        return 1;
+    }
+
+    /* The values to fall back to, recorded before any tuning */
+    if (!safe_path) {
+        pbo_read_current(ops, &safe);
+        safe.lim_mask = 0;          /* tuning is CO and FMax; a trip must not wait on limits */
+        if (!safe.has_fmax && !safe.co_mask) {
+            fprintf(stderr, "watchdog: cannot read CO or FMax; give the safe values with --safe.\n");
+            free(pm_buf);
+            return 1;
+        }
+        if (!safe.has_fmax || safe.co_mask != (ops->ncores >= 64 ? ~0ULL :
+                                               (1ULL << ops->ncores) - 1))
+            fprintf(stderr, "watchdog: some settings could not be read and will not be "
+                    "restored (use --safe for a complete profile).\n");
+    }
+    if (save_path && pbo_profile_save(save_path, &safe,
+                                      "smu_debug_tool watchdog --save (safe values)") != 0) {
+        fprintf(stderr, "watchdog: cannot write %s: %s\n", save_path, strerror(errno));
+        free(pm_buf);
+        return 1;
+    }
+    if (log_path) {
+        log = fopen(log_path, "a");
+        if (!log) {
+            fprintf(stderr, "watchdog: cannot write %s: %s\n", log_path, strerror(errno));
+            free(pm_buf);
+            return 1;
+        }
+        if (ftell(log) == 0)
+            fprintf(log, "Time,Event,Check,Value,Threshold,PersistMs,Detail\n");
+    }
+    if (profile_path) {
+        rc = pbo_apply(ops, &tuned, 0, &ar);
+        print_pbo_apply("watchdog: apply", rc, &ar, 0, 0);
+        if (rc != 0) {
+            if (log)
+                fclose(log);
+            free(pm_buf);
+            return rc == -3 ? 2 : 1;
+        }
+    }
+
+    fprintf(stderr, "watchdog: armed, %u ms period%s. Checks:", interval, dry ? ", dry run" : "");
+    for (int k = 0; k < PM_WD_COUNT; k++) {
+        const pm_wd_rule_t *r = &cfg.rule[k];
+
+        if (!(wd.avail & (1u << k)))
+            continue;
+        if (k == PM_WD_PROCHOT)
+            fprintf(stderr, " prochot");
+        else
+            fprintf(stderr, " %s>%g%s", pm_wd_check_name((pm_wd_check_t)k), r->threshold,
+                    pm_wd_check_unit((pm_wd_check_t)k));
+        if (r->persist_ms)
+            fprintf(stderr, "/%ums", r->persist_ms);
+    }
+    fputc('\n', stderr);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = run_sigint_handler;
+    sigaction(SIGINT, &sa, &sa_int);
+    sigaction(SIGTERM, &sa, &sa_term);
+    g_running = 1;
+    t0 = now_sec();
+    watchdog_log(log, 0.0, "start", -1, NAN, &cfg, profile_path);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    rc = 0;
+    while (g_running && (!duration || now_sec() - t0 < duration)) {
+        pm_wd_result_t res;
+        double t;
+
+        sleep_period(&next, interval);
+        if (smu_read_pm_table(&obj, pm_buf, obj.pm_table_size) != SMU_Return_OK)
+            continue;
+        t = now_sec() - t0;
+        samples++;
+        pm_wd_sample(&wd, t, pm_buf, &res);
+        for (int k = 0; k < PM_WD_COUNT; k++) {
+            if (res.onset_mask & (1u << k))
+                watchdog_log(log, t, "onset", k, res.value[k], &cfg, NULL);
+            if (res.clear_mask & (1u << k))
+                watchdog_log(log, t, "clear", k, res.value[k], &cfg, NULL);
+        }
+
+        if (res.tripped >= 0) {
+            pm_wd_check_t k = (pm_wd_check_t)res.tripped;
+            double detect_ms = (t - res.onset) * 1000.0, restore_ms = 0, total_ms;
+            pbo_apply_result_t vr;
+            char detail[256];
+            int arc = 0, vrc = 0;
+
+            if (!quiet)
+                fputs("\r\033[K", stderr);
+            watchdog_log(log, t, "trip", (int)k, res.peak, &cfg, NULL);
+            /* Blind set first, FMax and CO before any limit, past any failure:
+             * reading back comes after the reaction is timed */
+            if (!dry) {
+                arc = pbo_apply(ops, &safe, PBO_APPLY_RESTORE, &ar);
+                restore_ms = ar.ms;
+                if (arc != 0) {
+                    char first[sizeof(ar.error)];
+                    snprintf(first, sizeof(first), "%s", ar.error);
+                    snprintf(ar.error, sizeof(ar.error), "%u of %u settings not restored (%.100s)",
+                             ar.nfailed, ar.n, first);
+                }
+            }
+            total_ms = (now_sec() - t0 - res.onset) * 1000.0;
+            if (!dry && arc == 0) {
+                vrc = pbo_apply(ops, &safe, PBO_APPLY_DRY_RUN, &vr);
+                if (vrc == 0 && vr.nchanged)
+                    vrc = -1;
+            }
+            snprintf(detail, sizeof(detail), "%s; detect %.0f ms; restore %.1f ms; total %.0f ms",
+                     dry ? "dry run" : arc != 0 ? ar.error :
+                     vrc == 0 ? "restored and verified" : "restored, readback differs",
+                     detect_ms, restore_ms, total_ms);
+            watchdog_log(log, now_sec() - t0, dry ? "detected" : "restore", (int)k, res.peak,
+                         &cfg, detail);
+            fprintf(stderr, "watchdog: %s %.2f%s past %g%s at %.1f s; %s.\n",
+                    pm_wd_check_name(k), res.peak, pm_wd_check_unit(k),
+                    cfg.rule[k].threshold, pm_wd_check_unit(k), t, detail);
+            if (!dry) {
+                fprintf(stderr, "  reaction bound: %.0f ms (persistence %u + period %u + restore)\n",
+                        cfg.rule[k].persist_ms + interval + restore_ms, cfg.rule[k].persist_ms,
+                        interval);
+                rc = arc == 0 && vrc == 0 ? 3 : 1;
+                break;
+            }
+            /* Dry run: re-arm so every excursion is reported once */
+            wd.onset[k] = -1.0;
+            continue;
+        }
+        if (!quiet && t - last_status >= 1.0) {
+            fprintf(stderr, "\r\033[K ");
+            for (int k = 0; k < PM_WD_COUNT; k++) {
+                if (!isnan(res.value[k]))
+                    fprintf(stderr, " %s %.*f%s%s", pm_wd_check_name((pm_wd_check_t)k),
+                            k == PM_WD_VCORE || k == PM_WD_CORE_VOLT ? 3 : 1, res.value[k],
+                            pm_wd_check_unit((pm_wd_check_t)k), wd.onset[k] >= 0 ? "!" : "");
+            }
+            last_status = t;
+        }
+    }
+    sigaction(SIGINT, &sa_int, NULL);
+    sigaction(SIGTERM, &sa_term, NULL);
+    g_running = 1;
+    if (!quiet && rc == 0)
+        fputs("\r\033[K", stderr);
+    if (rc == 0)
+        fprintf(stderr, "watchdog: stopped after %.0f s, %lu samples, no intervention; "
+                "tuning left in place.\n", now_sec() - t0, samples);
+    watchdog_log(log, now_sec() - t0, "stop", -1, NAN, &cfg, NULL);
+    if (log)
+        fclose(log);
+    free(pm_buf);
+    return rc;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  A/B Compare: compare [options] A-inputs... --vs B-inputs...               */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+static void compare_usage(void)
+{
+    fprintf(stderr,
+        "Usage: smu_debug_tool compare [options] A.json|A.csv... --vs B.json|B.csv...\n"
+        "  Inputs: run/bench reports (one sample per measured run) or PM capture\n"
+        "  CSVs (one sample per file). Do not mix the two kinds on one side.\n"
+        "  -o, --output FILE   write the JSON report to FILE ('-' for stdout)\n"
+        "  -t, --test T        auto (default), mw (Mann-Whitney) or bootstrap\n"
+        "  -r, --resamples N   bootstrap resamples (default 2000)\n"
+        "  -a, --alpha A       significance level (default 0.05)\n"
+        "  -j, --threads N     worker threads (default: online CPUs)\n");
+}
+
+static int compare_main(int argc, char **argv)
+{
+    pm_cmp_opts_t o = { PM_CMP_TEST_AUTO, 2000, 0.05, 1, 0x5EED };
+    pm_cmp_set_t set[2];
+    pm_cmp_result_t res[PM_CMP_COUNT];
+    const char *out_path = NULL, *tests[] = { "auto", "mw", "bootstrap" };
+    char err[512];
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int side = 0, rc = 0;
+    double t0;
+    FILE *tab, *fp;
+
+    o.threads = ncpu > 0 ? (unsigned int)ncpu : 1;
+    pm_cmp_set_init(&set[0]);
+    pm_cmp_set_init(&set[1]);
+    if (getenv("SMU_PM_MAP"))
+        load_pm_map(getenv("SMU_PM_MAP"));     /* scales for captures of custom layouts */
+
+    t0 = now_sec();
+    for (int i = 1; i < argc && rc == 0; i++) {
+        const char *a = argv[i];
+        int has_val = i + 1 < argc;
+
+        if (strcmp(a, "--vs") == 0) {
+            side = 1;
+        } else if ((strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0) && has_val) {
+            out_path = argv[++i];
+        } else if ((strcmp(a, "-t") == 0 || strcmp(a, "--test") == 0) && has_val) {
+            const char *t = argv[++i];
+            o.test = strcmp(t, "mw") == 0 ? PM_CMP_TEST_MW :
+                     strcmp(t, "bootstrap") == 0 ? PM_CMP_TEST_BOOTSTRAP : PM_CMP_TEST_AUTO;
+        } else if ((strcmp(a, "-r") == 0 || strcmp(a, "--resamples") == 0) && has_val) {
+            o.resamples = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if ((strcmp(a, "-a") == 0 || strcmp(a, "--alpha") == 0) && has_val) {
+            o.alpha = atof(argv[++i]);
+        } else if ((strcmp(a, "-j") == 0 || strcmp(a, "--threads") == 0) && has_val) {
+            o.threads = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (a[0] == '-' && a[1] != '\0') {
+            compare_usage();
+            rc = 2;
+        } else if (pm_cmp_load(&set[side], a, o.threads, err, sizeof(err)) != 0) {
+            fprintf(stderr, "compare: %s\n", err);
+            rc = 1;
+        }
+    }
+    if (rc == 0 && (set[0].files == 0 || set[1].files == 0)) {
+        compare_usage();
+        rc = 2;
+    }
+    if (rc != 0)
+        goto out;
+    if (set[0].source != set[1].source)
+        fprintf(stderr, "compare: comparing run reports with captures; only shared "
+                "metrics are meaningful.\n");
+    if (o.resamples < 100)
+        o.resamples = 100;
+
+    pm_cmp_run(&set[0], &set[1], &o, res);
+
+    /* Table on stdout, unless the JSON goes there */
+    tab = out_path && strcmp(out_path, "-") == 0 ? stderr : stdout;
+    fprintf(tab, "\n  A: %u file(s)   B: %u file(s)   test %s, alpha %g, %.2f s\n\n",
+            set[0].files, set[1].files, tests[o.test], o.alpha, now_sec() - t0);
+    fprintf(tab, "  %-18s %8s %8s %12s %12s %11s %8s  %-25s %8s\n", "Metric", "N(A)", "N(B)",
+            "A mean", "B mean", "Delta", "Delta%", "95% CI of delta", "p");
+    for (int m = 0; m < PM_CMP_COUNT; m++) {
+        const pm_cmp_result_t *r = &res[m];
+        int sense = pm_cmp_metric_sense((pm_cmp_metric)m);
+        char ci[48], pct[16];
+
+        if (r->na == 0 && r->nb == 0)
+            continue;
+        snprintf(ci, sizeof(ci), "[%.4g, %.4g]", r->ci_lo, r->ci_hi);
+        if (isnan(r->delta_pct))
+            snprintf(pct, sizeof(pct), "-");
+        else
+            snprintf(pct, sizeof(pct), "%+.2f%%", r->delta_pct);
+        fprintf(tab, "  %-18s %8zu %8zu %12.4g %12.4g %+11.4g %8s  %-25s %8.2g  %s\n",
+                pm_cmp_metric_label((pm_cmp_metric)m), r->na, r->nb, r->mean_a, r->mean_b,
+                r->delta, pct, ci, r->p,
+                !r->significant ? "" : sense == 0 ? "* changed" :
+                (r->delta > 0) == (sense > 0) ? "* better" : "* worse");
+    }
+    fputc('\n', tab);
+
+    if (out_path) {
+        fp = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "w");
+        if (!fp) {
+            fprintf(stderr, "compare: cannot write %s: %s\n", out_path, strerror(errno));
+            rc = 1;
+            goto out;
+        }
+        fprintf(fp, "{\n");
+        fprintf(fp, "  \"ToolVersion\": \"%s\",\n", TOOL_VERSION);
+        fprintf(fp, "  \"Test\": \"%s\",\n", tests[o.test]);
+        fprintf(fp, "  \"Alpha\": %g,\n", o.alpha);
+        fprintf(fp, "  \"Resamples\": %u,\n", o.resamples);
+        fprintf(fp, "  \"Inputs\": { \"A\": [");
+        for (int n = 0, i = 1; i < argc; i++) {
+            const char *a = argv[i];
+            if (strcmp(a, "--vs") == 0) {
+                fputs("], \"B\": [", fp);
+                n = 0;
+                continue;
+            }
+            if (a[0] == '-' && a[1] != '\0') {
+                if (strcmp(a, "-o") == 0 || strcmp(a, "--output") == 0 ||
+                    strcmp(a, "-t") == 0 || strcmp(a, "--test") == 0 ||
+                    strcmp(a, "-r") == 0 || strcmp(a, "--resamples") == 0 ||
+                    strcmp(a, "-a") == 0 || strcmp(a, "--alpha") == 0 ||
+                    strcmp(a, "-j") == 0 || strcmp(a, "--threads") == 0)
+                    i++;
+                continue;
+            }
+            fputs(n++ ? ", " : "", fp);
+            json_str(fp, a);
+        }
+        fprintf(fp, "] },\n  \"Metrics\": {");
+        for (int m = 0, sep = 0; m < PM_CMP_COUNT; m++) {
+            const pm_cmp_result_t *r = &res[m];
+            if (r->na == 0 && r->nb == 0)
+                continue;
+            fprintf(fp, "%s\n    \"%s\": { \"NA\": %zu, \"NB\": %zu, \"MeanA\": ", sep ? "," : "",
+                    pm_cmp_metric_key((pm_cmp_metric)m), r->na, r->nb);
+            json_num(fp, r->mean_a, 6);
+            fputs(", \"MeanB\": ", fp);
+            json_num(fp, r->mean_b, 6);
+            fputs(", \"Delta\": ", fp);
+            json_num(fp, r->delta, 6);
+            fputs(", \"DeltaPct\": ", fp);
+            json_num(fp, r->delta_pct, 4);
+            fputs(", \"Ci95\": [", fp);
+            json_num(fp, r->ci_lo, 6);
+            fputs(", ", fp);
+            json_num(fp, r->ci_hi, 6);
+            fprintf(fp, "], \"CiMethod\": \"%s\", \"U\": ", r->ci ? r->ci : "none");
+            json_num(fp, r->u, 1);
+            fputs(", \"P\": ", fp);
+            json_num(fp, r->p, 6);
+            fprintf(fp, ", \"PMethod\": \"%s\", \"Significant\": %s }",
+                    r->test ? r->test : "none", r->significant ? "true" : "false");
+            sep = 1;
+        }
+        fprintf(fp, "\n  }\n}\n");
+        if (fp != stdout)
+            fclose(fp);
+        else
+            fflush(fp);
+    }
+
+out:
+    pm_cmp_set_free(&set[0]);
+    pm_cmp_set_free(&set[1]);
+    return rc;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════ */
+/*  Privilege Elevation                                                       */
+/* ═══════════════════════════════════════════════════════════════════════════ */
+
+/*
+ * Query a gsettings key, strip quotes/newline, return pointer to static buf.
+ * Returns NULL on failure or empty result.
+ */
+static const char *query_gsetting(const char *key, char *buf, size_t bufsz)
+{
+    char cmd[256];
+    char *p;
+    size_t tlen;
+    FILE *fp;
+
+    snprintf(cmd, sizeof(cmd),
+             "gsettings get org.gnome.desktop.interface %s 2>/dev/null", key);
+    fp = popen(cmd, "r");
+    if (!fp)
+        return NULL;
+    if (!fgets(buf, (int)bufsz, fp)) {
+        pclose(fp);
+        return NULL;
+    }
+    pclose(fp);
+
+    p = buf;
+    if (*p == '\'') p++;
+    tlen = strlen(p);
+    while (tlen > 0 && (p[tlen-1] == '\n' || p[tlen-1] == '\'' || p[tlen-1] == '\r'))
+        p[--tlen] = '\0';
+    return *p ? p : NULL;
+}
+
+int smu_elevate_if_necessary(int argc, char **argv)
+{
+    char self[1024];
+    ssize_t len;
+    pid_t pid;
+    int status;
+
+    if (geteuid() == 0)
+        return 1;
+
+    len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len <= 0) {
+        fprintf(stderr, "This tool must be run as root.\n");
+        return 0;
+    }
+    self[len] = '\0';
+
+    /*
+     * Use pkexec for graphical privilege elevation.
+     * pkexec strips the environment, so we pass display variables as
+     * --env-VAR=VALUE arguments.  The binary restores them via
+     * smu_restore_env() before GTK init.
+     *
+     * We use fork/execvp instead of system() to avoid shell injection.
+     */
+
+    /* Query GTK theme from gsettings if not already set */
+    static char theme_buf[256];
+    if (!getenv("GTK_THEME")) {
+        const char *theme = query_gsetting("gtk-theme", theme_buf, sizeof(theme_buf));
+        if (theme)
+            setenv("GTK_THEME", theme, 1);
+    }
+
+    /* Query dark mode preference */
+    static char scheme_buf[64];
+    if (!getenv("ADW_DEBUG_COLOR_SCHEME")) {
+        const char *scheme = query_gsetting("color-scheme", scheme_buf, sizeof(scheme_buf));
+        if (scheme && strstr(scheme, "prefer-dark"))
+            setenv("ADW_DEBUG_COLOR_SCHEME", "prefer-dark", 1);
+    }
+
+    /* Build argv for: pkexec <self> --env-VAR=VALUE ... <original args> */
+    const char *env_vars[] = {
+        "DISPLAY", "WAYLAND_DISPLAY", "XDG_RUNTIME_DIR",
+        "XAUTHORITY", "DBUS_SESSION_BUS_ADDRESS",
+        "GTK_THEME", "ADW_DEBUG_COLOR_SCHEME",
+        "XDG_CONFIG_HOME", "HOME", NULL
+    };
+
+    /* Max args: "pkexec" + self + 9 env vars + (argc-1) original args + NULL */
+    int max_args = 2 + 9 + argc;
+    char **new_argv = calloc((size_t)max_args, sizeof(char *));
+    if (!new_argv) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 0;
+    }
+
+    /* Static buffers for --env-VAR=VALUE strings */
+    static char env_bufs[9][512];
+
+    int n = 0;
+    new_argv[n++] = "pkexec";
+    new_argv[n++] = self;
+
+    for (int e = 0; env_vars[e]; e++) {
+        const char *val = getenv(env_vars[e]);
+        if (val) {
+            snprintf(env_bufs[e], sizeof(env_bufs[e]), "--env-%s=%s", env_vars[e], val);
+            new_argv[n++] = env_bufs[e];
+        }
     }
 
     for (int i = 1; i < argc; i++)
@@ -1739,15 +5997,60 @@ static void print_menu(void)
     printf("│  [9] Memory Timings                  │\n");
     printf("│  [A] Export JSON Report              │\n");
     printf("│  [B] PM Table Named Summary          │\n");
+    printf("│  [C] PM Layout Inference             │\n");
+    printf("│  [D] PM Trigger Capture              │\n");
     printf("│  [0] Exit                            │\n");
     printf("╰──────────────────────────────────────╯\n");
 }
 
+static const smu_command_t commands[] = {
+    { "run",       run_command,      0 },
+    { "bench",     bench_command,    0 },
+    { "rank",      rank_command,     0 },
+    { "co-tune",   cotune_command,   0 },
+    { "apply",     apply_command,    0 },
+    { "limits",    limits_command,   0 },
+    { "govern",    govern_command,   0 },
+    { "watchdog",  watchdog_command, 0 },
+    { "smn-scan",  smnscan_command,  0 },
+    { "smn-snap",  smnsnap_command,  0 },
+    { "smn-watch", smnwatch_command, 0 },
+    { "smn-diff",  smn_diff_main,    1 },
+    { "compare",   compare_main,     1 },
+};
+
+const smu_command_t *smu_find_command(int argc, char **argv)
+{
+    if (argc < 2)
+        return NULL;
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(argv[1], commands[i].name) == 0)
+            return &commands[i];
+    }
+    return NULL;
+}
+
 int cli_main(int argc, char **argv)
 {
+    const smu_command_t *cmd = smu_find_command(argc, argv);
     char choice[16];
-    (void)argc;
-    (void)argv;
+
+    if (cmd) {
+        int rc = cmd->main(argc - 1, argv + 1);
+        smu_free(&obj);
+        return rc;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--metric") == 0 && i + 1 < argc) {
+            if (g_metric_def_count < MAX_METRIC_DEFS)
+                g_metric_defs[g_metric_def_count++] = argv[++i];
+            else
+                fprintf(stderr, "Too many --metric options (max %d).\n", MAX_METRIC_DEFS);
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            g_metric_file = argv[++i];
+        }
+    }
 
     print_banner();
 
@@ -1770,6 +6073,8 @@ int cli_main(int argc, char **argv)
         case '9': show_memory_timings();             break;
         case 'A': case 'a': export_json_report();    break;
         case 'B': case 'b': show_named_pm_summary(); break;
+        case 'C': case 'c': pm_layout_inference();   break;
+        case 'D': case 'd': pm_trigger_capture();    break;
         default:
             printf("  Unknown option.\n");
             break;
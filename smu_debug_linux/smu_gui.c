@@ -4,6 +4,7 @@
  */
 #define _GNU_SOURCE
 
+#include <time.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
@@ -12,12 +13,20 @@
 #include <gtk/gtk.h>
 #include <libsmu.h>
 #include "smu_common.h"
+#include "pm_limiter.h"
 
 #define CO_MAX_CORES  16
-#define CO_MIN_MARGIN -60
-#define CO_MAX_MARGIN  10
 #define FMAX_MIN       0
-#define FMAX_MAX       6000
+
+/* Auto-refresh rates offered in the PM tab (ms); default is the old fixed 2 s. */
+static const guint pm_rates_ms[] = { 50, 100, 250, 500, 1000, 2000, 5000 };
+#define PM_RATE_DEFAULT_IDX 5
+
+#define LOG_CAPACITY      2000   /* log ring entries; oldest are dropped */
+#define LOG_TEXT_MAX      240
+
+#define CHART_MAX_SERIES  8
+#define CHART_HISTORY     1024   /* samples kept per series (fixed ring) */
 
 /* ─── PmRow GObject for ColumnView ─── */
 
@@ -30,6 +39,7 @@ struct _PmRow {
     char offset[16];
     char value[24];
     char max[24];
+    char name[24];
 };
 
 G_DEFINE_TYPE(PmRow, pm_row, G_TYPE_OBJECT)
@@ -37,46 +47,271 @@ G_DEFINE_TYPE(PmRow, pm_row, G_TYPE_OBJECT)
 static void pm_row_class_init(PmRowClass *klass) { (void)klass; }
 static void pm_row_init(PmRow *self) { (void)self; }
 
-static PmRow *pm_row_new(const char *idx, const char *offset, const char *value, const char *max)
+static PmRow *pm_row_new(const char *idx, const char *offset, const char *value, const char *max,
+                          const char *name)
 {
     PmRow *r = g_object_new(PM_ROW_TYPE, NULL);
     g_strlcpy(r->idx, idx, sizeof(r->idx));
     g_strlcpy(r->offset, offset, sizeof(r->offset));
     g_strlcpy(r->value, value, sizeof(r->value));
     g_strlcpy(r->max, max, sizeof(r->max));
+    g_strlcpy(r->name, name, sizeof(r->name));
     return r;
 }
 
 /* ─── Globals ─── */
 
-static GtkWidget *log_text;
 static GListStore *pm_store;
 static GtkWidget *co_spins[CO_MAX_CORES];
 static GtkWidget *co_set_buttons[CO_MAX_CORES];
 static GtkWidget *fmax_spin;
-static gboolean pm_timer_active;
+static GtkWidget *status_label;
 static float *pm_max_values;
+static char (*pm_labels)[24];   /* schema names per index, rebuilt on size change */
 static unsigned int pm_num_entries;
 
+/*
+ * The single owner of periodic PM table reads. Only one GSource exists at a
+ * time: start/stop/set_interval always remove the previous source by ID
+ * instead of waiting for a stale callback to notice a flag.
+ */
+typedef struct {
+    guint          source_id;     /* 0 = stopped */
+    guint          interval_ms;
+    unsigned char *buf;           /* last PM snapshot (pm_table_size bytes) */
+    gboolean       valid;         /* buf holds a successful read */
+    gint64         last_tick_us;  /* monotonic time of previous sample */
+    double         read_ms;       /* latency of last smu_read_pm_table() */
+    double         read_ms_avg;   /* EWMA of read latency */
+    double         rate_hz;       /* EWMA of achieved sample rate */
+    guint64        samples;
+    guint64        failures;
+} pm_sampler_t;
+
+static pm_sampler_t pm_sampler;
+
+/* Limiter attribution of the sampler's snapshots, residency since start/reset. */
+static struct {
+    GtkWidget         *label;
+    pm_limiter_t       lc;
+    gboolean           ready;
+    pm_limiter_state_t now;
+    pm_limiter_acc_t   acc;
+    gint64             prev_us;
+} limiter;
+
+/*
+ * One pinned chart series. The ring never grows: redraw walks at most
+ * CHART_HISTORY samples plus one min/max bucket per pixel column, so the
+ * cost does not depend on how long the session has been sampling.
+ */
+typedef struct {
+    char         label[40];
+    unsigned int index;                /* float index into the PM table */
+    float        ring[CHART_HISTORY];
+    unsigned int head;                 /* next write slot */
+    unsigned int count;                /* valid samples (<= CHART_HISTORY) */
+} chart_series_t;
+
+static chart_series_t chart_series[CHART_MAX_SERIES];
+static unsigned int chart_num_series;
+static GtkWidget *chart_area;
+
 /* ─── Log ─── */
 
+typedef enum { LOG_INFO, LOG_WARN, LOG_ERROR } log_level_t;
+
+/*
+ * Fixed-capacity log ring. The GListModel below exposes it to a GtkListView,
+ * which only creates row widgets for visible lines; LogLine items are built on
+ * demand in get_item(), so memory stays at LOG_CAPACITY entries.
+ */
+typedef struct {
+    gint64      time_us;     /* wall clock of the latest occurrence */
+    log_level_t level;
+    guint       repeat;      /* identical consecutive messages are folded */
+    char        text[LOG_TEXT_MAX];
+} log_entry_t;
+
+static log_entry_t log_ring[LOG_CAPACITY];
+static guint log_head;       /* next write slot */
+static guint log_count;
+static guint log_pending;    /* newest entry not yet announced to the model */
+
+#define LOG_LINE_TYPE (log_line_get_type())
+G_DECLARE_FINAL_TYPE(LogLine, log_line, LOG, LINE, GObject)
+
+struct _LogLine {
+    GObject     parent;
+    log_level_t level;
+    char        text[LOG_TEXT_MAX + 48];
+};
+
+G_DEFINE_TYPE(LogLine, log_line, G_TYPE_OBJECT)
+
+static void log_line_class_init(LogLineClass *klass) { (void)klass; }
+static void log_line_init(LogLine *self) { (void)self; }
+
+#define LOG_MODEL_TYPE (log_model_get_type())
+G_DECLARE_FINAL_TYPE(LogModel, log_model, LOG, MODEL, GObject)
+
+struct _LogModel {
+    GObject parent;
+};
+
+static const log_entry_t *log_entry_at(guint pos)
+{
+    return &log_ring[(log_head + LOG_CAPACITY - log_count + pos) % LOG_CAPACITY];
+}
+
+static GType log_model_get_item_type(GListModel *model) { (void)model; return LOG_LINE_TYPE; }
+static guint log_model_get_n_items(GListModel *model) { (void)model; return log_count - log_pending; }
+
+static gpointer log_model_get_item(GListModel *model, guint pos)
+{
+    (void)model;
+    if (pos >= log_count - log_pending)
+        return NULL;
+    const log_entry_t *e = log_entry_at(pos);
+    static const char *const tags[] = { "INFO", "WARN", "ERR " };
+    LogLine *line = g_object_new(LOG_LINE_TYPE, NULL);
+    time_t t = (time_t)(e->time_us / G_USEC_PER_SEC);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    line->level = e->level;
+    if (e->repeat > 1)
+        snprintf(line->text, sizeof(line->text), "%02d:%02d:%02d.%03d %s %s (x%u)",
+                 tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(e->time_us % G_USEC_PER_SEC / 1000),
+                 tags[e->level], e->text, e->repeat);
+    else
+        snprintf(line->text, sizeof(line->text), "%02d:%02d:%02d.%03d %s %s",
+                 tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(e->time_us % G_USEC_PER_SEC / 1000),
+                 tags[e->level], e->text);
+    return line;
+}
+
+static void log_model_iface_init(GListModelInterface *iface)
+{
+    iface->get_item_type = log_model_get_item_type;
+    iface->get_n_items = log_model_get_n_items;
+    iface->get_item = log_model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE(LogModel, log_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, log_model_iface_init))
+
+static void log_model_class_init(LogModelClass *klass) { (void)klass; }
+static void log_model_init(LogModel *self) { (void)self; }
+
+static LogModel *log_model;
+static GtkFilter *log_filter;
+static GtkWidget *log_scroller;
+static GtkWidget *log_count_label;
+static log_level_t log_min_level = LOG_INFO;
+static char log_search[64];
+static guint log_scroll_idle;
+
+static gboolean log_scroll_to_end(gpointer data)
+{
+    (void)data;
+    log_scroll_idle = 0;
+    if (log_scroller) {
+        GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(log_scroller));
+        gtk_adjustment_set_value(adj, gtk_adjustment_get_upper(adj));
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void log_count_update(void)
+{
+    char buf[64];
+    if (!log_count_label) return;
+    snprintf(buf, sizeof(buf), "%u / %u lines", log_count, LOG_CAPACITY);
+    gtk_label_set_text(GTK_LABEL(log_count_label), buf);
+}
+
+static void log_add(log_level_t level, const char *msg)
+{
+    gint64 now = g_get_real_time();
+    guint removed = 0;
+
+    if (log_count > 0) {
+        log_entry_t *last = &log_ring[(log_head + LOG_CAPACITY - 1) % LOG_CAPACITY];
+        /* Compare what would be stored: long messages are kept truncated */
+        if (last->level == level && strncmp(last->text, msg, sizeof(last->text) - 1) == 0) {
+            last->repeat++;
+            last->time_us = now;
+            if (log_model)
+                g_list_model_items_changed(G_LIST_MODEL(log_model), log_count - 1, 1, 1);
+            return;
+        }
+    }
+
+    log_entry_t *e = &log_ring[log_head];
+    e->time_us = now;
+    e->level = level;
+    e->repeat = 1;
+    g_strlcpy(e->text, msg, sizeof(e->text));
+    log_head = (log_head + 1) % LOG_CAPACITY;
+    if (log_count < LOG_CAPACITY)
+        log_count++;
+    else
+        removed = 1;
+
+    if (log_model) {
+        /* Overwrite = drop oldest, then append; announce each step with the model consistent. */
+        if (removed) {
+            log_pending = 1;
+            g_list_model_items_changed(G_LIST_MODEL(log_model), 0, 1, 0);
+            log_pending = 0;
+        }
+        g_list_model_items_changed(G_LIST_MODEL(log_model), log_count - 1, 0, 1);
+    }
+    log_count_update();
+
+    /* Follow the tail only if the user has not scrolled up. */
+    if (log_scroller && !log_scroll_idle) {
+        GtkAdjustment *adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(log_scroller));
+        if (gtk_adjustment_get_value(adj) + gtk_adjustment_get_page_size(adj) >=
+            gtk_adjustment_get_upper(adj) - 1.0)
+            log_scroll_idle = g_idle_add(log_scroll_to_end, NULL);
+    }
+}
+
 static void log_append(const char *msg)
 {
-    GtkTextBuffer *buf = gtk_text_view_get_buffer(GTK_TEXT_VIEW(log_text));
-    GtkTextIter end;
-    gtk_text_buffer_get_end_iter(buf, &end);
-    gtk_text_buffer_insert(buf, &end, msg, -1);
-    gtk_text_buffer_insert(buf, &end, "\n", 1);
+    log_add(LOG_INFO, msg);
 }
 
-static void log_appendf(const char *fmt, ...)
+static void log_vadd(log_level_t level, const char *fmt, va_list ap)
 {
     char buf[512];
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    log_add(level, buf);
+}
+
+static void log_appendf(const char *fmt, ...)
+{
     va_list ap;
     va_start(ap, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, ap);
+    log_vadd(LOG_INFO, fmt, ap);
+    va_end(ap);
+}
+
+static void log_warnf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    log_vadd(LOG_WARN, fmt, ap);
+    va_end(ap);
+}
+
+static void log_errorf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    log_vadd(LOG_ERROR, fmt, ap);
     va_end(ap);
-    log_append(buf);
 }
 
 /* ─── System Info ─── */
@@ -123,55 +358,208 @@ static GtkWidget *build_system_info_tab(void)
 
 /* ─── PM Table ─── */
 
-static void pm_table_refresh(void)
+static void charts_push(const float *table);
+
+static void status_update(void)
 {
-    smu_obj_t *obj = smu_get_obj();
-    if (!smu_pm_tables_supported(obj) || !pm_store)
-        return;
-    unsigned char *pm_buf = calloc(obj->pm_table_size, 1);
-    if (!pm_buf) return;
-    if (smu_read_pm_table(obj, pm_buf, obj->pm_table_size) != SMU_Return_OK) {
-        log_append("PM table read failed.");
-        free(pm_buf);
+    char buf[192];
+    pm_sampler_t *ps = &pm_sampler;
+    if (!status_label) return;
+    if (!ps->samples) {
+        gtk_label_set_text(GTK_LABEL(status_label), "PM sampling idle.");
         return;
     }
-    float *table = (float *)pm_buf;
-    unsigned int n = obj->pm_table_size / sizeof(float);
+    if (ps->source_id)
+        snprintf(buf, sizeof(buf),
+                 "Sampling every %u ms: %.2f Hz achieved | PM read %.3f ms (avg %.3f ms) | %llu samples, %llu failed",
+                 ps->interval_ms, ps->rate_hz, ps->read_ms, ps->read_ms_avg,
+                 (unsigned long long)ps->samples, (unsigned long long)ps->failures);
+    else
+        snprintf(buf, sizeof(buf),
+                 "Sampling stopped | PM read %.3f ms (avg %.3f ms) | %llu samples, %llu failed",
+                 ps->read_ms, ps->read_ms_avg,
+                 (unsigned long long)ps->samples, (unsigned long long)ps->failures);
+    gtk_label_set_text(GTK_LABEL(status_label), buf);
+}
+
+/* Read one PM snapshot into pm_sampler.buf and update latency/rate stats. */
+static gboolean pm_sampler_read(void)
+{
+    smu_obj_t *obj = smu_get_obj();
+    pm_sampler_t *ps = &pm_sampler;
+    if (!smu_pm_tables_supported(obj))
+        return FALSE;
+    if (!ps->buf) {
+        ps->buf = calloc(obj->pm_table_size, 1);
+        if (!ps->buf) return FALSE;
+    }
+
+    gint64 t0 = g_get_monotonic_time();
+    smu_return_val rc = smu_read_pm_table(obj, ps->buf, obj->pm_table_size);
+    gint64 t1 = g_get_monotonic_time();
+
+    ps->read_ms = (double)(t1 - t0) / 1000.0;
+    ps->read_ms_avg = ps->samples ? 0.9 * ps->read_ms_avg + 0.1 * ps->read_ms : ps->read_ms;
+    if (ps->last_tick_us && t0 > ps->last_tick_us) {
+        double hz = 1e6 / (double)(t0 - ps->last_tick_us);
+        ps->rate_hz = ps->rate_hz > 0 ? 0.8 * ps->rate_hz + 0.2 * hz : hz;
+    }
+    ps->last_tick_us = t0;
+    ps->samples++;
+    if (rc != SMU_Return_OK) {
+        ps->failures++;
+        ps->valid = FALSE;
+        return FALSE;
+    }
+    ps->valid = TRUE;
+    return TRUE;
+}
+
+/* Rebuild the PM table view from the sampler's latest snapshot. */
+static void pm_view_update(void)
+{
+    if (!pm_store || !pm_sampler.valid)
+        return;
+    float *table = (float *)pm_sampler.buf;
+    unsigned int n = smu_get_obj()->pm_table_size / sizeof(float);
     if (pm_max_values && n == pm_num_entries) {
         for (unsigned int i = 0; i < n; i++) {
             if (table[i] > pm_max_values[i])
                 pm_max_values[i] = table[i];
         }
     } else {
+        const pm_schema_t *sch = smu_pm_schema();
         free(pm_max_values);
+        free(pm_labels);
         pm_num_entries = n;
         pm_max_values = malloc(n * sizeof(float));
+        pm_labels = calloc(n, sizeof(*pm_labels));
         if (pm_max_values)
             for (unsigned int i = 0; i < n; i++)
                 pm_max_values[i] = table[i];
+        if (pm_labels)
+            for (unsigned int i = 0; i < n; i++)
+                pm_schema_index_label(sch, i, pm_labels[i], sizeof(pm_labels[i]));
     }
-    g_list_store_remove_all(pm_store);
+    /* One splice = one items-changed emission, instead of n+1 at fast rates. */
+    gpointer *rows = g_new(gpointer, n);
     for (unsigned int i = 0; i < n; i++) {
         char idx[16], off[16], val[24], max[24];
         snprintf(idx, sizeof(idx), "%04u", i);
         snprintf(off, sizeof(off), "0x%04X", i * 4);
         snprintf(val, sizeof(val), "%.6f", table[i]);
         snprintf(max, sizeof(max), "%.6f", pm_max_values ? pm_max_values[i] : table[i]);
-        PmRow *row = pm_row_new(idx, off, val, max);
-        g_list_store_append(pm_store, row);
-        g_object_unref(row);
+        rows[i] = pm_row_new(idx, off, val, max, pm_labels ? pm_labels[i] : "");
+    }
+    g_list_store_splice(pm_store, 0, g_list_model_get_n_items(G_LIST_MODEL(pm_store)), rows, n);
+    for (unsigned int i = 0; i < n; i++)
+        g_object_unref(rows[i]);
+    g_free(rows);
+}
+
+static void limiter_update(void)
+{
+    char text[512], eng[64];
+    size_t n;
+    gint64 now = pm_sampler.last_tick_us;
+    double dt;
+
+    if (!limiter.label || !pm_sampler.valid)
+        return;
+    if (!limiter.ready) {
+        unsigned int ccds = 0, ccxs = 0, cpc = 0, cores = 0;
+        int slots[PM_MAX_CORES];
+        if (smu_get_topology(&ccds, &ccxs, &cpc, &cores) != 0)
+            cores = 0;
+        /* Fused-off cores leave gaps in the PM arrays; dense if unsure */
+        pm_limiter_init(&limiter.lc, smu_pm_schema(), cores,
+                        cores && smu_get_core_slots(slots, PM_MAX_CORES) == (int)cores
+                        ? slots : NULL);
+        limiter.ready = TRUE;
+    }
+    if (!limiter.lc.avail) {
+        gtk_label_set_text(GTK_LABEL(limiter.label),
+                           "Limiter attribution needs a named PM layout.");
+        return;
+    }
+
+    /* A gap longer than a few intervals means sampling was paused: don't count it */
+    dt = limiter.prev_us ? (double)(now - limiter.prev_us) / 1e6 : 0;
+    if (dt > 3.0 * pm_sampler.interval_ms / 1000.0)
+        dt = 0;
+    limiter.prev_us = now;
+    pm_limiter_classify(&limiter.lc, pm_sampler.buf, &limiter.now);
+    pm_limiter_acc_add(&limiter.acc, &limiter.now, dt);
+
+    pm_limiter_format(limiter.now.engaged, eng, sizeof(eng));
+    n = (size_t)snprintf(text, sizeof(text), "Limiter: %s (%s) | engaged %s",
+                         pm_limiter_class_name(limiter.now.primary),
+                         pm_limiter_hint(limiter.now.primary), eng);
+    if (limiter.acc.seconds > 0 && n < sizeof(text)) {
+        n += (size_t)snprintf(text + n, sizeof(text) - n, " | %.0f s:", limiter.acc.seconds);
+        for (int c = 0; c < PM_LIM_CLASSES && n < sizeof(text); c++) {
+            if (limiter.acc.class_s[c] > 0)
+                n += (size_t)snprintf(text + n, sizeof(text) - n, " %s %.1f%%",
+                                      pm_limiter_class_name(c),
+                                      100.0 * limiter.acc.class_s[c] / limiter.acc.seconds);
+        }
+    }
+    gtk_label_set_text(GTK_LABEL(limiter.label), text);
+}
+
+static void limiter_reset_clicked(GtkButton *btn, gpointer data)
+{
+    (void)btn; (void)data;
+    memset(&limiter.acc, 0, sizeof(limiter.acc));
+    limiter.prev_us = 0;
+}
+
+static void pm_table_refresh(void)
+{
+    if (!pm_sampler_read()) {
+        if (smu_pm_tables_supported(smu_get_obj()))
+            log_errorf("PM table read failed.");
+        status_update();
+        return;
     }
-    free(pm_buf);
+    pm_view_update();
+    limiter_update();
+    charts_push((const float *)pm_sampler.buf);
+    status_update();
 }
 
-static gboolean pm_timer_cb(gpointer data)
+static gboolean pm_sampler_tick(gpointer data)
 {
     (void)data;
-    if (!pm_timer_active) return G_SOURCE_REMOVE;
     pm_table_refresh();
     return G_SOURCE_CONTINUE;
 }
 
+static void pm_sampler_stop(void)
+{
+    if (pm_sampler.source_id) {
+        g_source_remove(pm_sampler.source_id);
+        pm_sampler.source_id = 0;
+    }
+    pm_sampler.last_tick_us = 0;
+    pm_sampler.rate_hz = 0;
+    status_update();
+}
+
+static void pm_sampler_start(void)
+{
+    pm_sampler_stop();
+    pm_sampler.source_id = g_timeout_add(pm_sampler.interval_ms, pm_sampler_tick, NULL);
+    pm_table_refresh();
+}
+
+static void pm_sampler_set_interval(guint ms)
+{
+    pm_sampler.interval_ms = ms;
+    if (pm_sampler.source_id)
+        pm_sampler_start();
+}
+
 static void pm_refresh_clicked(GtkButton *btn, gpointer data)
 {
     (void)btn; (void)data;
@@ -182,9 +570,18 @@ static void pm_refresh_clicked(GtkButton *btn, gpointer data)
 static void pm_auto_toggled(GtkCheckButton *cb, gpointer data)
 {
     (void)data;
-    pm_timer_active = gtk_check_button_get_active(cb);
-    if (pm_timer_active)
-        g_timeout_add(2000, pm_timer_cb, NULL);
+    if (gtk_check_button_get_active(cb))
+        pm_sampler_start();
+    else
+        pm_sampler_stop();
+}
+
+static void pm_rate_changed(GObject *dd, GParamSpec *pspec, gpointer data)
+{
+    (void)pspec; (void)data;
+    guint sel = gtk_drop_down_get_selected(GTK_DROP_DOWN(dd));
+    if (sel < G_N_ELEMENTS(pm_rates_ms))
+        pm_sampler_set_interval(pm_rates_ms[sel]);
 }
 
 /* Column factory helpers */
@@ -224,6 +621,13 @@ static void bind_max_cb(GtkSignalListItemFactory *f, GtkListItem *item, gpointer
     gtk_label_set_text(GTK_LABEL(gtk_list_item_get_child(item)), row->max);
 }
 
+static void bind_name_cb(GtkSignalListItemFactory *f, GtkListItem *item, gpointer data)
+{
+    (void)f; (void)data;
+    PmRow *row = gtk_list_item_get_item(item);
+    gtk_label_set_text(GTK_LABEL(gtk_list_item_get_child(item)), row->name);
+}
+
 static void add_pm_column(GtkColumnView *cv, const char *title, GCallback bind_cb)
 {
     GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
@@ -239,13 +643,40 @@ static GtkWidget *build_pm_table_tab(void)
     GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
     GtkWidget *toolbar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
     GtkWidget *btn_refresh = gtk_button_new_with_label("Refresh");
-    GtkWidget *btn_auto = gtk_check_button_new_with_label("Auto-refresh (2 s)");
+    GtkWidget *btn_auto = gtk_check_button_new_with_label("Auto-refresh every");
+    const char *rates[G_N_ELEMENTS(pm_rates_ms) + 1];
+    char rate_labels[G_N_ELEMENTS(pm_rates_ms)][16];
+    for (unsigned int i = 0; i < G_N_ELEMENTS(pm_rates_ms); i++) {
+        if (pm_rates_ms[i] < 1000)
+            snprintf(rate_labels[i], sizeof(rate_labels[i]), "%u ms", pm_rates_ms[i]);
+        else
+            snprintf(rate_labels[i], sizeof(rate_labels[i]), "%u s", pm_rates_ms[i] / 1000);
+        rates[i] = rate_labels[i];
+    }
+    rates[G_N_ELEMENTS(pm_rates_ms)] = NULL;
+    GtkStringList *rate_sl = gtk_string_list_new(rates);
+    GtkWidget *rate_dd = gtk_drop_down_new(G_LIST_MODEL(rate_sl), NULL);
+    gtk_drop_down_set_selected(GTK_DROP_DOWN(rate_dd), PM_RATE_DEFAULT_IDX);
+    pm_sampler.interval_ms = pm_rates_ms[PM_RATE_DEFAULT_IDX];
     g_signal_connect(btn_refresh, "clicked", G_CALLBACK(pm_refresh_clicked), NULL);
     g_signal_connect(btn_auto, "toggled", G_CALLBACK(pm_auto_toggled), NULL);
+    g_signal_connect(rate_dd, "notify::selected", G_CALLBACK(pm_rate_changed), NULL);
     gtk_box_append(GTK_BOX(toolbar), btn_refresh);
     gtk_box_append(GTK_BOX(toolbar), btn_auto);
+    gtk_box_append(GTK_BOX(toolbar), rate_dd);
     gtk_box_append(GTK_BOX(box), toolbar);
 
+    GtkWidget *lim_row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    GtkWidget *btn_lim_reset = gtk_button_new_with_label("Reset residency");
+    limiter.label = gtk_label_new("Limiter: waiting for a sample.");
+    gtk_label_set_xalign(GTK_LABEL(limiter.label), 0.f);
+    gtk_label_set_wrap(GTK_LABEL(limiter.label), TRUE);
+    gtk_widget_set_hexpand(limiter.label, TRUE);
+    g_signal_connect(btn_lim_reset, "clicked", G_CALLBACK(limiter_reset_clicked), NULL);
+    gtk_box_append(GTK_BOX(lim_row), limiter.label);
+    gtk_box_append(GTK_BOX(lim_row), btn_lim_reset);
+    gtk_box_append(GTK_BOX(box), lim_row);
+
     pm_store = g_list_store_new(PM_ROW_TYPE);
     GtkNoSelection *sel = gtk_no_selection_new(G_LIST_MODEL(pm_store));
     GtkWidget *cv = gtk_column_view_new(GTK_SELECTION_MODEL(sel));
@@ -254,6 +685,7 @@ static GtkWidget *build_pm_table_tab(void)
     add_pm_column(GTK_COLUMN_VIEW(cv), "Offset", G_CALLBACK(bind_offset_cb));
     add_pm_column(GTK_COLUMN_VIEW(cv), "Value", G_CALLBACK(bind_value_cb));
     add_pm_column(GTK_COLUMN_VIEW(cv), "Max", G_CALLBACK(bind_max_cb));
+    add_pm_column(GTK_COLUMN_VIEW(cv), "Name", G_CALLBACK(bind_name_cb));
 
     GtkWidget *sw = gtk_scrolled_window_new();
     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(sw), cv);
@@ -264,6 +696,211 @@ static GtkWidget *build_pm_table_tab(void)
     return box;
 }
 
+/* ─── Charts ─── */
+
+static void charts_push(const float *table)
+{
+    unsigned int n = smu_get_obj()->pm_table_size / sizeof(float);
+    if (chart_num_series == 0)
+        return;
+    for (unsigned int i = 0; i < chart_num_series; i++) {
+        chart_series_t *cs = &chart_series[i];
+        cs->ring[cs->head] = cs->index < n ? table[cs->index] : 0.f;
+        cs->head = (cs->head + 1) % CHART_HISTORY;
+        if (cs->count < CHART_HISTORY)
+            cs->count++;
+    }
+    if (chart_area)
+        gtk_widget_queue_draw(chart_area);
+}
+
+/* Sample at window position pos (0 = oldest slot, CHART_HISTORY-1 = newest). */
+static int chart_sample_at(const chart_series_t *cs, unsigned int pos, float *v)
+{
+    unsigned int age = CHART_HISTORY - 1 - pos;
+    if (age >= cs->count)
+        return 0;
+    *v = cs->ring[(cs->head + CHART_HISTORY - 1 - age) % CHART_HISTORY];
+    return 1;
+}
+
+static const double chart_colors[CHART_MAX_SERIES][3] = {
+    {0.20, 0.60, 1.00}, {1.00, 0.45, 0.20}, {0.30, 0.85, 0.40}, {0.95, 0.30, 0.55},
+    {0.75, 0.55, 1.00}, {0.95, 0.80, 0.20}, {0.25, 0.85, 0.85}, {0.80, 0.80, 0.80},
+};
+
+static void chart_draw(GtkDrawingArea *area, cairo_t *cr, int width, int height, gpointer data)
+{
+    (void)area; (void)data;
+    float col_min[4096], col_max[4096];
+    int label_w = 150;
+    int plot_w = width - label_w;
+
+    cairo_set_source_rgb(cr, 0.10, 0.10, 0.12);
+    cairo_paint(cr);
+    if (chart_num_series == 0 || plot_w < 8) {
+        cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
+        cairo_move_to(cr, 12, 24);
+        cairo_show_text(cr, "Pin a PM index or field name to start charting.");
+        return;
+    }
+    if (plot_w > (int)G_N_ELEMENTS(col_min))
+        plot_w = (int)G_N_ELEMENTS(col_min);
+
+    double lane_h = (double)height / chart_num_series;
+    cairo_set_font_size(cr, 11);
+    cairo_set_line_width(cr, 1.0);
+
+    for (unsigned int s_i = 0; s_i < chart_num_series; s_i++) {
+        const chart_series_t *cs = &chart_series[s_i];
+        double top = lane_h * s_i;
+        float lo = G_MAXFLOAT, hi = -G_MAXFLOAT, last = 0.f;
+        int have_last = 0;
+
+        /* Min/max decimation: one bucket per pixel column over the fixed window. */
+        for (int x = 0; x < plot_w; x++) {
+            unsigned int p0 = (unsigned int)((guint64)x * CHART_HISTORY / (guint64)plot_w);
+            unsigned int p1 = (unsigned int)((guint64)(x + 1) * CHART_HISTORY / (guint64)plot_w);
+            if (p1 <= p0) p1 = p0 + 1;
+            col_min[x] = G_MAXFLOAT;
+            col_max[x] = -G_MAXFLOAT;
+            for (unsigned int p = p0; p < p1 && p < CHART_HISTORY; p++) {
+                float v;
+                if (!chart_sample_at(cs, p, &v)) continue;
+                if (v < col_min[x]) col_min[x] = v;
+                if (v > col_max[x]) col_max[x] = v;
+            }
+            if (col_min[x] <= col_max[x]) {
+                if (col_min[x] < lo) lo = col_min[x];
+                if (col_max[x] > hi) hi = col_max[x];
+            }
+        }
+        if (chart_sample_at(cs, CHART_HISTORY - 1, &last))
+            have_last = 1;
+
+        /* Lane frame and labels */
+        cairo_set_source_rgb(cr, 0.25, 0.25, 0.28);
+        cairo_rectangle(cr, label_w + 0.5, top + 0.5, plot_w - 1, lane_h - 1);
+        cairo_stroke(cr);
+        cairo_set_source_rgb(cr, chart_colors[s_i][0], chart_colors[s_i][1], chart_colors[s_i][2]);
+        char txt[64];
+        cairo_move_to(cr, 6, top + 14);
+        cairo_show_text(cr, cs->label);
+        if (have_last) {
+            snprintf(txt, sizeof(txt), "now %.3f", last);
+            cairo_move_to(cr, 6, top + 28);
+            cairo_show_text(cr, txt);
+            snprintf(txt, sizeof(txt), "min %.3f", lo);
+            cairo_move_to(cr, 6, top + 42);
+            cairo_show_text(cr, txt);
+            snprintf(txt, sizeof(txt), "max %.3f", hi);
+            cairo_move_to(cr, 6, top + 56);
+            cairo_show_text(cr, txt);
+        }
+        if (lo > hi)
+            continue;
+
+        double pad = 4.0;
+        double span = (hi - lo) > 1e-6f ? (double)(hi - lo) : 1.0;
+        double scale = (lane_h - 2 * pad) / span;
+        double base = top + lane_h - pad;
+
+        /* One vertical min..max stroke per column, joined to the next column. */
+        int pen_down = 0;
+        for (int x = 0; x < plot_w; x++) {
+            if (col_min[x] > col_max[x]) { pen_down = 0; continue; }
+            double px = label_w + x + 0.5;
+            double y_lo = base - (col_min[x] - lo) * scale;
+            double y_hi = base - (col_max[x] - lo) * scale;
+            if (pen_down)
+                cairo_line_to(cr, px, y_lo);
+            else
+                cairo_move_to(cr, px, y_lo);
+            cairo_line_to(cr, px, y_hi);
+            pen_down = 1;
+        }
+        cairo_stroke(cr);
+    }
+}
+
+static void chart_pin_clicked(GtkButton *btn, gpointer data)
+{
+    (void)btn;
+    GtkWidget *entry = (GtkWidget *)data;
+    const char *text = gtk_editable_get_text(GTK_EDITABLE(entry));
+    unsigned int n = smu_get_obj()->pm_table_size / sizeof(float);
+    unsigned int index;
+    char *end;
+
+    while (*text == ' ') text++;
+    if (!*text) return;
+    if (chart_num_series >= CHART_MAX_SERIES) {
+        log_warnf("Chart: at most %d series can be pinned.", CHART_MAX_SERIES);
+        return;
+    }
+    unsigned long v = strtoul(text, &end, 0);
+    if (end != text && *end == '\0')
+        index = (unsigned int)v;
+    else if (smu_pm_field_index(text, &index) != 0) {
+        log_warnf("Chart: unknown PM field '%s' for table 0x%06X.", text,
+                    smu_get_obj()->pm_table_version);
+        return;
+    }
+    if (index >= n) {
+        log_warnf("Chart: index %u out of range (table has %u entries).", index, n);
+        return;
+    }
+
+    chart_series_t *cs = &chart_series[chart_num_series++];
+    memset(cs, 0, sizeof(*cs));
+    cs->index = index;
+    if (end != text && *end == '\0')
+        snprintf(cs->label, sizeof(cs->label), "[%04u] 0x%04X", index, index * 4);
+    else
+        snprintf(cs->label, sizeof(cs->label), "%s", text);
+    log_appendf("Chart: pinned %s (index %u).", cs->label, index);
+    gtk_widget_queue_draw(chart_area);
+}
+
+static void chart_clear_clicked(GtkButton *btn, gpointer data)
+{
+    (void)btn; (void)data;
+    chart_num_series = 0;
+    gtk_widget_queue_draw(chart_area);
+}
+
+static GtkWidget *build_charts_tab(void)
+{
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+    GtkWidget *toolbar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    GtkWidget *entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(entry), "Index (e.g. 1, 0x1D) or field (PPT_VALUE, CORE_TEMP[0])");
+    gtk_widget_set_hexpand(entry, TRUE);
+    GtkWidget *btn_pin = gtk_button_new_with_label("Pin");
+    GtkWidget *btn_clear = gtk_button_new_with_label("Clear");
+    g_signal_connect(btn_pin, "clicked", G_CALLBACK(chart_pin_clicked), entry);
+    g_signal_connect(entry, "activate", G_CALLBACK(chart_pin_clicked), entry);
+    g_signal_connect(btn_clear, "clicked", G_CALLBACK(chart_clear_clicked), NULL);
+    gtk_box_append(GTK_BOX(toolbar), entry);
+    gtk_box_append(GTK_BOX(toolbar), btn_pin);
+    gtk_box_append(GTK_BOX(toolbar), btn_clear);
+    gtk_box_append(GTK_BOX(box), toolbar);
+
+    chart_area = gtk_drawing_area_new();
+    gtk_drawing_area_set_draw_func(GTK_DRAWING_AREA(chart_area), chart_draw, NULL, NULL);
+    gtk_widget_set_vexpand(chart_area, TRUE);
+    gtk_widget_set_hexpand(chart_area, TRUE);
+    gtk_box_append(GTK_BOX(box), chart_area);
+
+    char hint[128];
+    snprintf(hint, sizeof(hint), "Charts follow the PM tab auto-refresh; each series keeps the last %d samples.",
+             CHART_HISTORY);
+    GtkWidget *l = gtk_label_new(hint);
+    gtk_widget_set_halign(l, GTK_ALIGN_START);
+    gtk_box_append(GTK_BOX(box), l);
+    return box;
+}
+
 /* ─── PBO (Curve Optimizer + FMax) ─── */
 static void fmax_apply_clicked(GtkButton *btn, gpointer data)
 {
@@ -275,7 +912,7 @@ static void fmax_apply_clicked(GtkButton *btn, gpointer data)
         if (smu_get_fmax(&read_back) == 0)
             gtk_spin_button_set_value(GTK_SPIN_BUTTON(fmax_spin), (double)read_back);
     } else {
-        log_append("FMax set failed (check RSMU / platform).");
+        log_errorf("FMax set failed (check RSMU / platform).");
     }
 }
 
@@ -287,7 +924,7 @@ static void fmax_read_clicked(GtkButton *btn, gpointer data)
         gtk_spin_button_set_value(GTK_SPIN_BUTTON(fmax_spin), (double)mhz);
         log_appendf("FMax read: %u MHz.", mhz);
     } else {
-        log_append("FMax read failed.");
+        log_errorf("FMax read failed.");
     }
 }
 
@@ -302,13 +939,15 @@ static void co_value_changed(GtkSpinButton *spin, gpointer data)
 static void co_apply_single(int core_index)
 {
     gdouble v = gtk_spin_button_get_value(GTK_SPIN_BUTTON(co_spins[core_index]));
-    int val = (int)v;
-    if (val < CO_MIN_MARGIN) val = CO_MIN_MARGIN;
-    if (val > CO_MAX_MARGIN) val = CO_MAX_MARGIN;
+    int val = (int)v, co_min, co_max;
+    unsigned int fmax_max;
+    smu_get_tuning_bounds(&co_min, &co_max, &fmax_max);
+    if (val < co_min) val = co_min;
+    if (val > co_max) val = co_max;
     if (smu_set_curve_optimizer(core_index, val) == 0)
         log_appendf("Core %d: set CO to %d.", core_index, val);
     else
-        log_appendf("Core %d: CO set failed.", core_index);
+        log_errorf("Core %d: CO set failed.", core_index);
 }
 
 static void co_apply_one_clicked(GtkButton *btn, gpointer data)
@@ -335,7 +974,42 @@ static void co_read_all_clicked(GtkButton *btn, gpointer data)
     if (read_ok > 0)
         log_appendf("Curve Optimizer: read %d core(s).", read_ok);
     else
-        log_append("CO read not supported on this platform (GET failed). Set values and click Apply all CO.");
+        log_warnf("CO read not supported on this platform (GET failed). Set values and click Apply all CO.");
+}
+
+/* All enabled spins as one transaction: snapshot, apply, readback, rollback. */
+static void co_apply_all_clicked(GtkButton *btn, gpointer data)
+{
+    (void)btn; (void)data;
+    const pbo_ops_t *ops = smu_pbo_ops();
+    pbo_profile_t p;
+    pbo_apply_result_t r;
+    int rc;
+
+    memset(&p, 0, sizeof(p));
+    for (unsigned int i = 0; i < ops->ncores && i < CO_MAX_CORES; i++) {
+        p.co_mask |= 1ULL << i;
+        p.co[i] = (int)gtk_spin_button_get_value(GTK_SPIN_BUTTON(co_spins[i]));
+    }
+    if (!p.co_mask) {
+        log_errorf("Curve Optimizer: core topology unknown.");
+        return;
+    }
+    rc = pbo_apply(ops, &p, 0, &r);
+    if (rc == 0) {
+        log_appendf("Curve Optimizer: %u of %u core(s) changed and verified in %.1f ms.",
+                    r.nchanged, r.n, r.ms);
+        for (unsigned int i = 0; i < CO_MAX_CORES; i++) {
+            if (co_set_buttons[i] != NULL)
+                gtk_widget_set_sensitive(co_set_buttons[i], FALSE);
+        }
+    } else if (rc == -1) {
+        log_errorf("Curve Optimizer: %s; all cores rolled back.", r.error);
+    } else if (rc == -2) {
+        log_errorf("Curve Optimizer: %s; rollback incomplete, read current CO.", r.error);
+    } else {
+        log_warnf("Curve Optimizer: %s; nothing changed.", r.error);
+    }
 }
 
 static GtkWidget *build_pbo_tab(void)
@@ -345,6 +1019,9 @@ static GtkWidget *build_pbo_tab(void)
     gtk_grid_set_row_spacing(GTK_GRID(grid), 8);
     gtk_grid_set_column_spacing(GTK_GRID(grid), 8);
     g_object_set(grid, "margin-top", 16, NULL);
+    int co_min, co_max;
+    unsigned int fmax_max;
+    smu_get_tuning_bounds(&co_min, &co_max, &fmax_max);
 
     /* FMax */
     GtkWidget *fmax_label = gtk_label_new("FMax override (MHz):");
@@ -352,7 +1029,7 @@ static GtkWidget *build_pbo_tab(void)
     gtk_grid_attach(GTK_GRID(grid), fmax_label, 0, 0, 7, 1);
     GtkWidget *fmax_row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
     gtk_widget_set_halign(fmax_row, GTK_ALIGN_CENTER);
-    fmax_spin = gtk_spin_button_new_with_range((gdouble)FMAX_MIN, (gdouble)FMAX_MAX, 25.0);
+    fmax_spin = gtk_spin_button_new_with_range((gdouble)FMAX_MIN, (gdouble)fmax_max, 25.0);
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(fmax_spin), 0.0);
     gtk_box_append(GTK_BOX(fmax_row), fmax_spin);
     GtkWidget *btn_fmax_read = gtk_button_new_with_label("Read");
@@ -388,7 +1065,7 @@ static GtkWidget *build_pbo_tab(void)
         snprintf(buf, sizeof(buf), "Core %u", i);
         gtk_label_set_text(GTK_LABEL(l), buf);
         gtk_grid_attach(GTK_GRID(grid), l, col_base, row, 1, 1);
-        co_spins[i] = gtk_spin_button_new_with_range((gdouble)CO_MIN_MARGIN, (gdouble)CO_MAX_MARGIN, 1.0);
+        co_spins[i] = gtk_spin_button_new_with_range((gdouble)co_min, (gdouble)co_max, 1.0);
         gtk_spin_button_set_value(GTK_SPIN_BUTTON(co_spins[i]), 0.0);
         gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(co_spins[i]), TRUE);
         gtk_editable_set_editable(GTK_EDITABLE(co_spins[i]), TRUE);
@@ -414,7 +1091,12 @@ static GtkWidget *build_pbo_tab(void)
     int btn_row = 4 + 8;
     GtkWidget *btn_co_read = gtk_button_new_with_label("Read current CO");
     g_signal_connect(btn_co_read, "clicked", G_CALLBACK(co_read_all_clicked), NULL);
-    gtk_grid_attach(GTK_GRID(grid), btn_co_read, 2, btn_row, 3, 1);
+    gtk_grid_attach(GTK_GRID(grid), btn_co_read, 0, btn_row, 3, 1);
+    GtkWidget *btn_co_apply = gtk_button_new_with_label("Apply all CO");
+    gtk_widget_set_tooltip_text(btn_co_apply,
+        "Apply every core at once; read back and roll back all cores if any fails.");
+    g_signal_connect(btn_co_apply, "clicked", G_CALLBACK(co_apply_all_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(grid), btn_co_apply, 4, btn_row, 3, 1);
 
     gtk_widget_set_halign(grid, GTK_ALIGN_CENTER);
     gtk_box_append(GTK_BOX(box), grid);
@@ -437,7 +1119,7 @@ static void smu_cmd_send_clicked(GtkButton *btn, gpointer data)
     if (!cmd_entry || !arg_entries || !combo || !resp_tv) return;
     unsigned int cmd_val;
     if (sscanf(gtk_editable_get_text(GTK_EDITABLE(cmd_entry)), "%x", &cmd_val) != 1) {
-        log_append("Invalid command (use hex).");
+        log_warnf("Invalid command (use hex).");
         return;
     }
     smu_arg_t args;
@@ -528,7 +1210,7 @@ static void smn_read_clicked(GtkButton *btn, gpointer data)
     GtkWidget *resp = (GtkWidget *)g_object_get_data(G_OBJECT(win), "smn_resp");
     unsigned int addr, val;
     if (sscanf(gtk_editable_get_text(GTK_EDITABLE(addr_e)), "%x", &addr) != 1) {
-        log_append("Invalid SMN address.");
+        log_warnf("Invalid SMN address.");
         return;
     }
     if (smu_read_smn_addr(smu_get_obj(), addr, &val) != SMU_Return_OK) {
@@ -552,7 +1234,7 @@ static void smn_write_clicked(GtkButton *btn, gpointer data)
     unsigned int addr, val;
     if (sscanf(gtk_editable_get_text(GTK_EDITABLE(addr_e)), "%x", &addr) != 1 ||
         sscanf(gtk_editable_get_text(GTK_EDITABLE(val_e)), "%x", &val) != 1) {
-        log_append("Invalid SMN address or value.");
+        log_warnf("Invalid SMN address or value.");
         return;
     }
     if (smu_write_smn_addr(smu_get_obj(), addr, val) != SMU_Return_OK) {
@@ -589,23 +1271,109 @@ static GtkWidget *build_smn_tab(GtkWidget *window)
 }
 
 /* ─── Log ─── */
+static gboolean log_filter_match(gpointer item, gpointer data)
+{
+    (void)data;
+    LogLine *line = item;
+    if (line->level < log_min_level)
+        return FALSE;
+    return log_search[0] == '\0' || strcasestr(line->text, log_search) != NULL;
+}
+
+static void log_level_changed(GObject *dd, GParamSpec *pspec, gpointer data)
+{
+    (void)pspec; (void)data;
+    log_min_level = (log_level_t)gtk_drop_down_get_selected(GTK_DROP_DOWN(dd));
+    gtk_filter_changed(log_filter, GTK_FILTER_CHANGE_DIFFERENT);
+}
+
+static void log_search_changed(GtkSearchEntry *entry, gpointer data)
+{
+    (void)data;
+    g_strlcpy(log_search, gtk_editable_get_text(GTK_EDITABLE(entry)), sizeof(log_search));
+    gtk_filter_changed(log_filter, GTK_FILTER_CHANGE_DIFFERENT);
+}
+
+static void log_clear_clicked(GtkButton *btn, gpointer data)
+{
+    (void)btn; (void)data;
+    guint n = log_count;
+    log_count = 0;
+    log_head = 0;
+    if (log_model && n)
+        g_list_model_items_changed(G_LIST_MODEL(log_model), 0, n, 0);
+    log_count_update();
+}
+
+static void log_bind_cb(GtkSignalListItemFactory *f, GtkListItem *item, gpointer data)
+{
+    (void)f; (void)data;
+    LogLine *line = gtk_list_item_get_item(item);
+    GtkWidget *label = gtk_list_item_get_child(item);
+    gtk_label_set_text(GTK_LABEL(label), line->text);
+    gtk_widget_remove_css_class(label, "warning");
+    gtk_widget_remove_css_class(label, "error");
+    if (line->level == LOG_WARN)
+        gtk_widget_add_css_class(label, "warning");
+    else if (line->level == LOG_ERROR)
+        gtk_widget_add_css_class(label, "error");
+}
+
 static GtkWidget *build_log_tab(void)
 {
-    log_text = gtk_text_view_new();
-    gtk_text_view_set_editable(GTK_TEXT_VIEW(log_text), FALSE);
-    gtk_text_view_set_monospace(GTK_TEXT_VIEW(log_text), TRUE);
-    GtkWidget *sw = gtk_scrolled_window_new();
-    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(sw), log_text);
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
+    GtkWidget *toolbar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    const char *levels[] = {"All", "Warnings + errors", "Errors only", NULL};
+    GtkWidget *level_dd = gtk_drop_down_new(G_LIST_MODEL(gtk_string_list_new(levels)), NULL);
+    GtkWidget *search = gtk_search_entry_new();
+    gtk_widget_set_hexpand(search, TRUE);
+    GtkWidget *btn_clear = gtk_button_new_with_label("Clear");
+    log_count_label = gtk_label_new("");
+    g_signal_connect(level_dd, "notify::selected", G_CALLBACK(log_level_changed), NULL);
+    g_signal_connect(search, "search-changed", G_CALLBACK(log_search_changed), NULL);
+    g_signal_connect(btn_clear, "clicked", G_CALLBACK(log_clear_clicked), NULL);
+    gtk_box_append(GTK_BOX(toolbar), level_dd);
+    gtk_box_append(GTK_BOX(toolbar), search);
+    gtk_box_append(GTK_BOX(toolbar), btn_clear);
+    gtk_box_append(GTK_BOX(toolbar), log_count_label);
+    gtk_box_append(GTK_BOX(box), toolbar);
+
+    log_model = g_object_new(LOG_MODEL_TYPE, NULL);
+    log_filter = GTK_FILTER(gtk_custom_filter_new(log_filter_match, NULL, NULL));
+    GtkFilterListModel *filtered = gtk_filter_list_model_new(G_LIST_MODEL(log_model), log_filter);
+    GtkNoSelection *sel = gtk_no_selection_new(G_LIST_MODEL(filtered));
+
+    GtkListItemFactory *factory = gtk_signal_list_item_factory_new();
+    g_signal_connect(factory, "setup", G_CALLBACK(setup_label_cb), NULL);
+    g_signal_connect(factory, "bind", G_CALLBACK(log_bind_cb), NULL);
+    GtkWidget *lv = gtk_list_view_new(GTK_SELECTION_MODEL(sel), factory);
+    gtk_widget_add_css_class(lv, "monospace");
+
+    log_scroller = gtk_scrolled_window_new();
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(log_scroller), lv);
+    gtk_widget_set_vexpand(log_scroller, TRUE);
+    gtk_box_append(GTK_BOX(box), log_scroller);
+
     log_append("Ryzen SMU Debug Tool GUI ready.");
-    return sw;
+    log_count_update();
+    return box;
 }
 
 static gboolean on_close_request(GtkWindow *win, gpointer data)
 {
     (void)win; (void)data;
-    pm_timer_active = FALSE;
+    pm_sampler_stop();
+    free(pm_sampler.buf);
+    pm_sampler.buf = NULL;
     free(pm_max_values);
     pm_max_values = NULL;
+    free(pm_labels);
+    pm_labels = NULL;
+    if (log_scroll_idle) {
+        g_source_remove(log_scroll_idle);
+        log_scroll_idle = 0;
+    }
+    log_scroller = NULL;
     smu_free(smu_get_obj());
     return FALSE;
 }
@@ -621,8 +1389,15 @@ static void activate(GtkApplication *app, gpointer user_data)
     gtk_window_set_resizable(GTK_WINDOW(window), FALSE);
     g_signal_connect(window, "close-request", G_CALLBACK(on_close_request), NULL);
 
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
     notebook = gtk_notebook_new();
-    gtk_window_set_child(GTK_WINDOW(window), notebook);
+    gtk_widget_set_vexpand(notebook, TRUE);
+    gtk_box_append(GTK_BOX(vbox), notebook);
+    status_label = gtk_label_new("PM sampling idle.");
+    gtk_widget_set_halign(status_label, GTK_ALIGN_START);
+    g_object_set(status_label, "margin-start", 6, "margin-top", 2, "margin-bottom", 2, NULL);
+    gtk_box_append(GTK_BOX(vbox), status_label);
+    gtk_window_set_child(GTK_WINDOW(window), vbox);
 
     /* System Info tab */
     GtkWidget *sys_scroll = gtk_scrolled_window_new();
@@ -635,6 +1410,9 @@ static void activate(GtkApplication *app, gpointer user_data)
     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(pm_sw), build_pm_table_tab());
     gtk_notebook_append_page(GTK_NOTEBOOK(notebook), pm_sw, gtk_label_new("PM Table"));
 
+    /* Charts tab */
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), build_charts_tab(), gtk_label_new("Charts"));
+
     /* PBO tab */
     GtkWidget *pbo_sw = gtk_scrolled_window_new();
     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(pbo_sw), build_pbo_tab());
@@ -0,0 +1,196 @@
+/*
+ * Adaptive SMU mailbox completion waits (see smu_mbox.h).
+ */
+
+#include <time.h>
+#include <string.h>
+
+#include "smu_mbox.h"
+
+#define SPIN_MIN_US     20.0
+#define SPIN_MAX_US     200.0
+#define SPIN_EST_MUL    1.5         /* spin through 1.5x the usual latency */
+#define SLEEP_MIN_US    10.0
+#define SLEEP_MAX_US    1000.0
+#define EWMA_ALPHA      0.2
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void sleep_us(double us)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(us / 1e6);
+    ts.tv_nsec = (long)((us - ts.tv_sec * 1e6) * 1e3);
+    nanosleep(&ts, NULL);
+}
+
+void mbox_waiter_init(mbox_waiter_t *w, mbox_read_fn read, void *ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->read = read;
+    w->ctx = ctx;
+}
+
+/*
+ * Tracking slot for a mailbox. Slots are only created for addresses that have
+ * answered, so scan probes of non-mailbox registers do not fill the table.
+ * NULL if absent (or the table is full).
+ */
+static mbox_lat_t *slot(mbox_waiter_t *w, uint32_t addr, int create)
+{
+    for (unsigned int i = 0; i < w->nbox; i++) {
+        if (w->box[i].rsp_addr == addr)
+            return &w->box[i];
+    }
+    if (!create || w->nbox == MBOX_MAX_TRACKED)
+        return NULL;
+    w->box[w->nbox].rsp_addr = addr;
+    return &w->box[w->nbox++];
+}
+
+static void record(mbox_lat_t *l, double us)
+{
+    unsigned int b = 0;
+
+    while (b + 1 < MBOX_LAT_BUCKETS && us >= (double)(1u << b))
+        b++;
+    l->hist[b]++;
+    l->n++;
+    if (us > l->max_us)
+        l->max_us = us;
+    l->est_us = l->est_us > 0 ? l->est_us + EWMA_ALPHA * (us - l->est_us) : us;
+}
+
+/* The wait itself; rec 0 leaves the statistics alone. */
+static int wait_many(mbox_waiter_t *w, const uint32_t *addr, unsigned int n,
+                     mbox_until_t until, uint32_t ref, unsigned int deadline_us,
+                     uint32_t *vals, unsigned char *done, int rec)
+{
+    mbox_lat_t *l[MBOX_WAIT_MAX];
+    double est = 0, spin, nap;
+    double t0 = now_us(), t;
+    unsigned int ndone = 0;
+
+    if (n > MBOX_WAIT_MAX)
+        return -1;
+    for (unsigned int i = 0; i < n; i++) {
+        double e;
+
+        l[i] = slot(w, addr[i], 0);
+        e = l[i] && l[i]->est_us > 0 ? l[i]->est_us : w->all.est_us;
+        if (e > est)
+            est = e;
+        done[i] = 0;
+    }
+    spin = est * SPIN_EST_MUL;
+    if (spin < SPIN_MIN_US)
+        spin = SPIN_MIN_US;
+    if (spin > SPIN_MAX_US)
+        spin = SPIN_MAX_US;
+    nap = est / 4 > SLEEP_MIN_US ? est / 4 : SLEEP_MIN_US;
+
+    for (;;) {
+        for (unsigned int i = 0; i < n; i++) {
+            if (done[i])
+                continue;
+            if (w->read(w->ctx, addr[i], &vals[i]) != 0)
+                return -1;
+            if ((until == MBOX_UNTIL_EQ) == (vals[i] == ref)) {
+                t = now_us() - t0;
+                if (rec && (l[i] || (l[i] = slot(w, addr[i], 1))))
+                    record(l[i], t);
+                if (rec)
+                    record(&w->all, t);
+                done[i] = 1;
+                ndone++;
+            }
+        }
+        t = now_us() - t0;
+        if (ndone == n || t >= deadline_us)
+            break;
+        if (t < spin)
+            continue;
+        /* Back off, but never sleep past the deadline */
+        if (t + nap > deadline_us)
+            nap = deadline_us - t;
+        sleep_us(nap);
+        nap *= 2;
+        if (nap > SLEEP_MAX_US)
+            nap = SLEEP_MAX_US;
+    }
+    for (unsigned int i = 0; i < n && rec; i++) {
+        if (done[i])
+            continue;
+        if (l[i])
+            l[i]->timeouts++;
+        w->all.timeouts++;
+    }
+    return (int)ndone;
+}
+
+int mbox_wait_many(mbox_waiter_t *w, const uint32_t *addr, unsigned int n,
+                   mbox_until_t until, uint32_t ref, unsigned int deadline_us,
+                   uint32_t *vals, unsigned char *done)
+{
+    return wait_many(w, addr, n, until, ref, deadline_us, vals, done, 1);
+}
+
+static int wait_one(mbox_waiter_t *w, uint32_t addr, mbox_until_t until, uint32_t ref,
+                    unsigned int deadline_us, uint32_t *val_out, int rec)
+{
+    uint32_t val;
+    unsigned char done;
+    int rc = wait_many(w, &addr, 1, until, ref, deadline_us, &val, &done, rec);
+
+    if (rc < 0)
+        return -1;
+    if (val_out)
+        *val_out = val;
+    return done ? 0 : 1;
+}
+
+int mbox_wait(mbox_waiter_t *w, uint32_t addr, mbox_until_t until, uint32_t ref,
+              unsigned int deadline_us, uint32_t *val_out)
+{
+    return wait_one(w, addr, until, ref, deadline_us, val_out, 1);
+}
+
+int mbox_poll(mbox_waiter_t *w, uint32_t addr, mbox_until_t until, uint32_t ref,
+              unsigned int deadline_us, uint32_t *val_out)
+{
+    return wait_one(w, addr, until, ref, deadline_us, val_out, 0);
+}
+
+double mbox_lat_percentile(const mbox_lat_t *l, double q)
+{
+    unsigned long want, seen = 0;
+
+    if (!l->n)
+        return 0;
+    want = (unsigned long)(q * (double)l->n + 0.5);
+    if (want < 1)
+        want = 1;
+    for (unsigned int b = 0; b < MBOX_LAT_BUCKETS; b++) {
+        seen += l->hist[b];
+        if (seen >= want)
+            return b + 1 < MBOX_LAT_BUCKETS ? (double)(1u << b) : l->max_us;
+    }
+    return l->max_us;
+}
+
+void mbox_lat_print(FILE *out, const mbox_lat_t *l, const char *label)
+{
+    if (!l->n) {
+        fprintf(out, "%s: no completions, %lu timeout(s)\n", label, l->timeouts);
+        return;
+    }
+    fprintf(out, "%s: n %lu, p50 <%.0f us, p90 <%.0f us, p99 <%.0f us, max %.1f us, "
+            "%lu timeout(s)\n", label, l->n, mbox_lat_percentile(l, 0.50),
+            mbox_lat_percentile(l, 0.90), mbox_lat_percentile(l, 0.99), l->max_us, l->timeouts);
+}
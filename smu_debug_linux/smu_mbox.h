@@ -0,0 +1,75 @@
+/*
+ * Adaptive SMU mailbox completion waits.
+ *
+ * A wait polls a response register until it reaches (or leaves) a value:
+ * first a short busy-spin sized from the mailbox's learned latency, then
+ * sleeps that double up to a cap, until a hard deadline. Each mailbox
+ * (response address) keeps an EWMA of its completion latency and a log2
+ * histogram, so the spin covers the usual case and slow replies are still
+ * caught before the deadline. Register access goes through a callback.
+ */
+#ifndef SMU_MBOX_H
+#define SMU_MBOX_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define MBOX_MAX_TRACKED    32
+#define MBOX_WAIT_MAX       32      /* addresses per mbox_wait_many */
+#define MBOX_LAT_BUCKETS    22      /* [0,1) [1,2) [2,4) ... us; last is open-ended */
+
+typedef int (*mbox_read_fn)(void *ctx, uint32_t addr, uint32_t *val);
+
+typedef enum { MBOX_UNTIL_NE, MBOX_UNTIL_EQ } mbox_until_t;
+
+typedef struct {
+    uint32_t      rsp_addr;
+    double        est_us;           /* EWMA of completion latency; 0 = none yet */
+    double        max_us;
+    unsigned long n, timeouts;
+    unsigned long hist[MBOX_LAT_BUCKETS];
+} mbox_lat_t;
+
+typedef struct {
+    mbox_read_fn  read;
+    void         *ctx;
+    mbox_lat_t    box[MBOX_MAX_TRACKED];
+    unsigned int  nbox;
+    mbox_lat_t    all;              /* every wait, for the overall distribution */
+} mbox_waiter_t;
+
+void mbox_waiter_init(mbox_waiter_t *w, mbox_read_fn read, void *ctx);
+
+/*
+ * Poll addr until its value is != ref (MBOX_UNTIL_NE) or == ref (MBOX_UNTIL_EQ),
+ * for at most deadline_us. 0 done (*val_out holds the value), 1 timed out,
+ * -1 read error.
+ */
+int  mbox_wait(mbox_waiter_t *w, uint32_t addr, mbox_until_t until, uint32_t ref,
+               unsigned int deadline_us, uint32_t *val_out);
+
+/*
+ * mbox_wait that records nothing: for checks that are not a completion, such
+ * as the ready poll before a command, which an idle mailbox passes at once
+ * and would otherwise drag the latency estimate and percentiles down.
+ */
+int  mbox_poll(mbox_waiter_t *w, uint32_t addr, mbox_until_t until, uint32_t ref,
+               unsigned int deadline_us, uint32_t *val_out);
+
+/*
+ * Wait on several registers at once. One spin/backoff loop reads every address
+ * not yet done, so the whole wait lasts as long as the slowest reply (or the
+ * deadline). done[i] and vals[i] are filled per address. Returns how many
+ * completed, -1 on a read error or n > MBOX_WAIT_MAX.
+ */
+int  mbox_wait_many(mbox_waiter_t *w, const uint32_t *addr, unsigned int n,
+                    mbox_until_t until, uint32_t ref, unsigned int deadline_us,
+                    uint32_t *vals, unsigned char *done);
+
+/* Latency percentile (0..1) from a histogram: the bucket's upper bound, us. */
+double mbox_lat_percentile(const mbox_lat_t *l, double q);
+
+/* "label: n 120, p50 <4 us, p90 <8 us, p99 <64 us, max 51.2 us, 0 timeouts" */
+void mbox_lat_print(FILE *out, const mbox_lat_t *l, const char *label);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Per-codename platform descriptors (see smu_platform.h).
+ */
+
+#include <stddef.h>
+
+#include <libsmu.h>
+
+#include "smu_platform.h"
+
+static const smu_limit_cmds_t limits_zen3 = {
+    { PBO_SET_PPT_ZEN3, PBO_SET_TDC_ZEN3, PBO_SET_EDC_ZEN3, PBO_SET_HTC_ZEN3,
+      PBO_SET_SCALAR_ZEN3 }, PBO_GET_SCALAR_ZEN3
+};
+
+static const smu_limit_cmds_t limits_zen45 = {
+    { PBO_SET_PPT_ZEN45, PBO_SET_TDC_ZEN45, PBO_SET_EDC_ZEN45, PBO_SET_HTC_ZEN45,
+      PBO_SET_SCALAR_ZEN45 }, PBO_GET_SCALAR_ZEN45
+};
+
+/* Scan ranges from the Windows SMUDebugTool's SettingsForm.cs */
+static const smu_scan_range_t scan_apu[] = {
+    { 0x03B10500, 0x03B10998, 8, 0x3C },
+    { 0x03B10A00, 0x03B10AFF, 4, 0x60 },
+};
+static const smu_scan_range_t scan_desktop[] = {
+    { 0x03B10500, 0x03B10998, 8, 0x3C },
+    { 0x03B10500, 0x03B10AFF, 4, 0x4C },
+};
+static const smu_scan_range_t scan_zen4[] = {
+    { 0x03B10500, 0x03B10998, 8, 0x3C },
+};
+
+/* FMax set, CO set, combined CO arg */
+#define CMDS_ZEN1       SMU_CMD_SET_FMAX_ALL_CORES, 0, 0          /* no Curve Optimizer */
+#define CMDS_ZEN2_3     SMU_CMD_SET_FMAX_ALL_CORES, SMU_CMD_SET_PSM_MARGIN, 0
+#define CMDS_ZEN4_5     SMU_CMD_SET_BOOST_LIMIT_ALL, PSM_SET_ZEN4_ZEN5, 1
+#define SCAN(r)         r, sizeof(r) / sizeof(r[0]), 1
+#define SCAN_GENERIC    scan_zen4, 1, 0
+
+/* CO range: the BIOS PBO2 range, positive side capped at CO_MARGIN_MAX
+ * (Zen4/Zen5 desktop AGESA goes to -50; -60 only exists in the profile format) */
+#define CO_NONE         0, 0
+#define CO_30           (-30), CO_MARGIN_MAX
+#define CO_50           (-50), CO_MARGIN_MAX
+
+#define MASK_CCD        SMU_CORE_MASK_CCD
+#define MASK_INDEX      SMU_CORE_MASK_INDEX
+
+/* FMax cap: fastest SKU's rated boost plus the 200 MHz boost override */
+static const smu_platform_t platforms[] = {
+    /* codename               family            core mask   commands     CO GET             limits         scan                CO range FMax */
+    { CODENAME_SUMMITRIDGE,   "Zen desktop",    MASK_CCD,   CMDS_ZEN1,   0,                 NULL,          SCAN(scan_desktop), CO_NONE, 4300 },
+    { CODENAME_PINNACLERIDGE, "Zen+ desktop",   MASK_CCD,   CMDS_ZEN1,   0,                 NULL,          SCAN(scan_desktop), CO_NONE, 4550 },
+    { CODENAME_THREADRIPPER,  "Zen HEDT",       MASK_CCD,   CMDS_ZEN1,   0,                 NULL,          SCAN(scan_desktop), CO_NONE, 4400 },
+    { CODENAME_COLFAX,        "Zen+ HEDT",      MASK_CCD,   CMDS_ZEN1,   0,                 NULL,          SCAN(scan_desktop), CO_NONE, 4600 },
+    { CODENAME_NAPLES,        "Zen server",     MASK_CCD,   CMDS_ZEN1,   0,                 NULL,          SCAN_GENERIC,       CO_NONE, 3400 },
+    { CODENAME_RAVENRIDGE,    "Zen APU",        MASK_INDEX, CMDS_ZEN1,   0,                 NULL,          SCAN(scan_apu),     CO_NONE, 4100 },
+    { CODENAME_RAVENRIDGE2,   "Zen APU",        MASK_CCD,   CMDS_ZEN1,   0,                 NULL,          SCAN(scan_apu),     CO_NONE, 4100 },
+    { CODENAME_DALI,          "Zen APU",        MASK_INDEX, CMDS_ZEN1,   0,                 NULL,          SCAN(scan_apu),     CO_NONE, 3700 },
+    { CODENAME_PICASSO,       "Zen+ APU",       MASK_INDEX, CMDS_ZEN1,   0,                 NULL,          SCAN(scan_apu),     CO_NONE, 4400 },
+    { CODENAME_MATISSE,       "Zen2 desktop",   MASK_CCD,   CMDS_ZEN2_3, PSM_GET_ZEN3,      &limits_zen3,  SCAN(scan_desktop), CO_30,   4900 },
+    { CODENAME_CASTLEPEAK,    "Zen2 HEDT",      MASK_CCD,   CMDS_ZEN2_3, PSM_GET_ZEN3,      &limits_zen3,  SCAN(scan_desktop), CO_30,   4700 },
+    { CODENAME_RENOIR,        "Zen2 APU",       MASK_INDEX, CMDS_ZEN2_3, 0,                 NULL,          SCAN(scan_apu),     CO_30,   4600 },
+    { CODENAME_LUCIENNE,      "Zen2 APU",       MASK_INDEX, CMDS_ZEN2_3, 0,                 NULL,          SCAN(scan_apu),     CO_30,   4500 },
+    { CODENAME_VANGOGH,       "Zen2 APU",       MASK_CCD,   CMDS_ZEN2_3, 0,                 NULL,          SCAN_GENERIC,       CO_30,   3700 },
+    { CODENAME_VERMEER,       "Zen3 desktop",   MASK_CCD,   CMDS_ZEN2_3, PSM_GET_ZEN3,      &limits_zen3,  SCAN(scan_desktop), CO_30,   5100 },
+    { CODENAME_CHAGALL,       "Zen3 HEDT",      MASK_CCD,   CMDS_ZEN2_3, PSM_GET_ZEN3,      &limits_zen3,  SCAN_GENERIC,       CO_30,   4700 },
+    { CODENAME_MILAN,         "Zen3 server",    MASK_CCD,   CMDS_ZEN2_3, PSM_GET_ZEN3,      NULL,          SCAN_GENERIC,       CO_30,   4300 },
+    { CODENAME_CEZANNE,       "Zen3 APU",       MASK_INDEX, CMDS_ZEN2_3, PSM_GET_CEZANNE,   NULL,          SCAN_GENERIC,       CO_30,   5000 },
+    { CODENAME_REMBRANDT,     "Zen3+ APU",      MASK_INDEX, CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, NULL,          SCAN_GENERIC,       CO_30,   5200 },
+    { CODENAME_RAPHAEL,       "Zen4 desktop",   MASK_CCD,   CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, &limits_zen45, SCAN(scan_zen4),    CO_50,   5900 },
+    { CODENAME_STORMPEAK,     "Zen4 HEDT",      MASK_CCD,   CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, &limits_zen45, SCAN_GENERIC,       CO_50,   5300 },
+    { CODENAME_PHOENIX,       "Zen4 APU",       MASK_INDEX, CMDS_ZEN2_3, PSM_GET_PHOENIX,   NULL,          SCAN_GENERIC,       CO_30,   5400 },
+    { CODENAME_HAWKPOINT,     "Zen4 APU",       MASK_CCD,   CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, NULL,          SCAN_GENERIC,       CO_30,   5400 },
+    { CODENAME_GRANITERIDGE,  "Zen5 desktop",   MASK_CCD,   CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, &limits_zen45, SCAN(scan_zen4),    CO_50,   5900 },
+    { CODENAME_STRIXPOINT,    "Zen5 APU",       MASK_CCD,   CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, NULL,          SCAN_GENERIC,       CO_30,   5300 },
+    { CODENAME_STRIXHALO,     "Zen5 APU",       MASK_CCD,   CMDS_ZEN4_5, PSM_GET_ZEN4_ZEN5, NULL,          SCAN_GENERIC,       CO_30,   5300 },
+};
+
+/* Unknown parts keep the format bounds; pbo_profile_check still applies them */
+static const smu_platform_t platform_unknown = {
+    CODENAME_UNDEFINED, "unknown", MASK_CCD, CMDS_ZEN2_3, 0, NULL, SCAN_GENERIC,
+    CO_MARGIN_MIN, CO_MARGIN_MAX, PBO_FMAX_MAX
+};
+
+const unsigned int smu_psm_get_probe[] = {
+    PSM_GET_ZEN4_ZEN5, PSM_GET_ZEN3, PSM_GET_ZEN5_SP,
+    PSM_GET_PHOENIX, PSM_GET_CEZANNE, PSM_GET_LEGACY, PSM_GET_LEGACY_ALT
+};
+const unsigned int smu_psm_get_probe_count =
+    sizeof(smu_psm_get_probe) / sizeof(smu_psm_get_probe[0]);
+
+const smu_platform_t *smu_platform_for(int codename)
+{
+    for (size_t i = 0; i < sizeof(platforms) / sizeof(platforms[0]); i++) {
+        if (platforms[i].codename == codename)
+            return &platforms[i];
+    }
+    return &platform_unknown;
+}
@@ -0,0 +1,89 @@
+/*
+ * Per-codename platform descriptors.
+ *
+ * Everything that differs between CPU generations -- RSMU command IDs and
+ * their argument formats, the Curve Optimizer core-mask scheme, mailbox scan
+ * ranges and safe tuning bounds -- lives in one immutable row per codename in
+ * smu_platform.c. The CLI selects the row once after smu_init; the SMU paths
+ * then read fields straight from it. Adding a platform is adding a row.
+ *
+ * PM table layouts are not here: they are keyed by table version, which the
+ * schema registry (pm_schema.h) resolves on its own.
+ */
+#ifndef SMU_PLATFORM_H
+#define SMU_PLATFORM_H
+
+#include "pbo_profile.h"
+
+/* RSMU command IDs (see rsmu_commands.md, ZenStates-Core). FMax UI = boost limit. */
+#define SMU_CMD_GET_MAX_FREQUENCY   0x6E  /* GetBoostLimitFrequency */
+#define SMU_CMD_SET_FMAX_ALL_CORES  0x5C  /* Zen2/Zen3: SetOverclockFreqAllCores (same as boost there) */
+#define SMU_CMD_SET_BOOST_LIMIT_ALL 0x70  /* Zen4/Zen5: SetBoostLimitFrequencyAllCores */
+/* Curve Optimizer / PSM margin. Zen2/Zen3 SET = 0x76 (args[0]=mask, args[1]=margin).
+ * Zen4/Zen5 use SET 0x6 with single combined arg (mask|margin in low 16 bits). */
+#define SMU_CMD_SET_PSM_MARGIN      0x76  /* Zen2/Zen3 */
+#define PSM_SET_ZEN4_ZEN5           0x6   /* Zen4, Zen5, Granite Ridge (Zen5Settings) */
+#define CO_MARGIN_MIN               (-60) /* widest any platform reads back; rows narrow it */
+#define CO_MARGIN_MAX               10
+/* RSMU GetDldoPsmMargin IDs from ZenStates-Core per platform */
+#define PSM_GET_ZEN3        0x7C  /* Matisse, Vermeer, Milan, Chagall (Zen3Settings) */
+#define PSM_GET_ZEN4_ZEN5   0xD5  /* Raphael, Granite Ridge, Zen5 (Zen4Settings, Zen5Settings, DragonRange) */
+#define PSM_GET_ZEN5_SP     0xA3  /* Shimada Peak (Zen5Settings_ShimadaPeak) */
+#define PSM_GET_PHOENIX     0xE1  /* Phoenix APU */
+#define PSM_GET_CEZANNE     0xC3  /* Cezanne APU */
+#define PSM_GET_LEGACY      0x77  /* fallback */
+#define PSM_GET_LEGACY_ALT  0x78  /* fallback */
+/* RSMU PBO limit IDs from ZenStates-Core. Args: PPT mW, TDC/EDC mA, HTC C, scalar x100. */
+#define PBO_SET_PPT_ZEN3     0x53  /* Matisse, Vermeer, Castle Peak, Chagall (Zen3Settings) */
+#define PBO_SET_TDC_ZEN3     0x54
+#define PBO_SET_EDC_ZEN3     0x55
+#define PBO_SET_HTC_ZEN3     0x56
+#define PBO_SET_SCALAR_ZEN3  0x58
+#define PBO_GET_SCALAR_ZEN3  0x6C
+#define PBO_SET_PPT_ZEN45    0x56  /* Raphael, Granite Ridge, Storm Peak (Zen4Settings, Zen5Settings) */
+#define PBO_SET_TDC_ZEN45    0x57
+#define PBO_SET_EDC_ZEN45    0x58
+#define PBO_SET_HTC_ZEN45    0x59
+#define PBO_SET_SCALAR_ZEN45 0x5B
+#define PBO_GET_SCALAR_ZEN45 0x6D
+
+typedef enum {
+    SMU_CORE_MASK_CCD,      /* (ccd << 8 | local core) << 20 */
+    SMU_CORE_MASK_INDEX,    /* APUs: plain core index */
+} smu_core_mask_t;
+
+/* RSMU PBO limit commands of one platform family; 0 = not settable. */
+typedef struct {
+    unsigned int set[PBO_LIM_COUNT];
+    unsigned int get_scalar;
+} smu_limit_cmds_t;
+
+/* One ScanSmuRange call of the Windows SMUDebugTool (SettingsForm.cs). */
+typedef struct {
+    unsigned int start, end, step, rsp_offset;
+} smu_scan_range_t;
+
+typedef struct {
+    int                     codename;       /* CODENAME_* (libsmu.h) */
+    const char             *family;         /* "Zen3 desktop" */
+    smu_core_mask_t         core_mask;
+    unsigned int            fmax_set;       /* SetBoostLimit command */
+    unsigned int            psm_set;        /* CO SET command; 0 = no Curve Optimizer */
+    int                     psm_combined;   /* SET arg0 = mask | margin (Zen4/Zen5) */
+    unsigned int            psm_get;        /* CO GET command; 0 = probe every known ID */
+    const smu_limit_cmds_t *limits;         /* NULL: no PBO limit path (APUs use MP1) */
+    const smu_scan_range_t *scan;
+    unsigned int            nscan;
+    int                     scan_known;     /* 0: generic ranges, not from the Windows tool */
+    int                     co_min, co_max; /* CO range the firmware takes; 0, 0 without CO */
+    unsigned int            fmax_max_mhz;   /* highest FMax accepted */
+} smu_platform_t;
+
+/* Row for a codename; unknown codenames get a generic row (never NULL). */
+const smu_platform_t *smu_platform_for(int codename);
+
+/* CO GET IDs tried in order when the row has no psm_get. */
+extern const unsigned int smu_psm_get_probe[];
+extern const unsigned int smu_psm_get_probe_count;
+
+#endif